@@ -32,10 +32,48 @@
  * @brief Opaque epio instance type.
  *
  * All API functions operate on a pointer to this type.  Create with
- * epio_init() or epio_from_apio(), and destroy with epio_free().
+ * epio_init(), epio_init_in() or epio_from_apio(), and destroy with
+ * epio_free().
  */
 typedef struct epio_t epio_t;
 
+/**
+ * @brief Opaque epio template type.
+ *
+ * An immutable, fully configured machine state from which any number of
+ * epio instances can be cheaply created.  Create with
+ * epio_template_from_epio() or epio_template_from_apio(), and destroy with
+ * epio_template_free().
+ */
+typedef struct epio_template_t epio_template_t;
+
+/**
+ * @brief Opaque GPIO stimulus type.
+ *
+ * A file of timestamped GPIO edges, streamed from disk and applied to an
+ * instance as it is stepped.  Create with epio_stimulus_open_vcd() or
+ * epio_stimulus_open_edges().
+ */
+typedef struct epio_stimulus_t epio_stimulus_t;
+
+/**
+ * @brief A captured apio configuration.
+ *
+ * apio's assembler macros build a PIO configuration in process-wide globals.
+ * This holds a private copy of that configuration, so that an epio instance
+ * can be created from it without reference to those globals - for example,
+ * on another thread, after the globals have been reused for the next
+ * configuration.
+ *
+ * Populate with epio_apio_ctx_capture().
+ */
+typedef struct {
+    /** Copy of apio's PIO configuration */
+    __typeof__(_apio_emulated_pio) pio;
+    /** Copy of apio's GPIO configuration */
+    __typeof__(_apio_emulated_gpios) gpios;
+} epio_apio_ctx_t;
+
 /**
  * @brief Debug information for a single PIO state machine
  *
@@ -93,9 +131,51 @@ typedef struct {
  */
 EPIO_EXPORT epio_t *epio_init(void);
 
+/**
+ * @brief Return the number of bytes of memory required for an epio instance.
+ *
+ * Use this to size caller-provided memory for epio_init_in().
+ *
+ * @return Size of an epio instance, in bytes.
+ * @see epio_init_in()
+ */
+EPIO_EXPORT size_t epio_sizeof(void);
+
+/**
+ * @brief Initialise a new epio instance in caller-provided memory.
+ *
+ * As epio_init(), but the instance is placed in @p mem rather than being
+ * allocated, so instances can live in arenas, static buffers or on the
+ * stack, including on bare-metal targets.  @p mem must be suitably aligned
+ * for any type (e.g. as returned by malloc()).
+ *
+ * SRAM is still allocated lazily, a page at a time, when first written.
+ *
+ * @param mem   Memory in which to place the instance.
+ * @param size  Size of @p mem in bytes.  Must be at least epio_sizeof().
+ * @return      Pointer to the new epio instance, which is at @p mem.
+ * @see epio_sizeof(), epio_reset(), epio_free()
+ */
+EPIO_EXPORT epio_t *epio_init_in(void *mem, size_t size);
+
+/**
+ * @brief Return an epio instance to its power-on state.
+ *
+ * Puts the instance back into the state returned by epio_init(), without
+ * freeing or reallocating it.  Any SRAM pages which have been allocated are
+ * kept, to avoid reallocating them, but their contents are zeroed.
+ *
+ * @param epio  The epio instance to reset.
+ * @see epio_init(), epio_init_in()
+ */
+EPIO_EXPORT void epio_reset(epio_t *epio);
+
 /**
  * @brief Free an epio instance and all associated resources.
  *
+ * If the instance was created with epio_init_in(), its resources are freed
+ * but the caller-provided memory is not.
+ *
  * @param epio  The epio instance to free.  Must not be used after this call.
  */
 EPIO_EXPORT void epio_free(epio_t *epio);
@@ -114,161 +194,1897 @@ EPIO_EXPORT void epio_free(epio_t *epio);
 EPIO_EXPORT void epio_set_sm_debug(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_debug_t *debug);
 
 /**
- * @brief Gets the debug information for a specific state machine.
- *
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
- * @param debug Pointer to a caller-allocated structure to receive the debug
- *              information for this SM.
+ * @brief Gets the debug information for a specific state machine.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param debug Pointer to a caller-allocated structure to receive the debug
+ *              information for this SM.
+ */
+EPIO_EXPORT void epio_get_sm_debug(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_debug_t *debug);
+
+/**
+ * @brief Set the GPIO base for a PIO block.
+ *
+ * The RP2350 supports GPIOBASE values of 0 and 16 per PIO block, shifting
+ * the block's GPIO mapping accordingly.  This must match the GPIOBASE
+ * configuration of the PIO block under test.
+ *
+ * @param epio      The epio instance.
+ * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param gpio_base GPIO base offset (0 or 16).
+ */
+EPIO_EXPORT void epio_set_gpiobase(epio_t *epio, uint8_t block, uint32_t gpio_base);
+
+/**
+ * @brief Get the GPIO base for a PIO block.
+ * 
+ * @param epio The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @return The GPIO base offset for this block.
+ */
+EPIO_EXPORT uint32_t epio_get_gpiobase(epio_t *epio, uint8_t block);
+
+/**
+ * @brief Set the SM configuration registers for a state machine.
+ *
+ * Copies the register state from @p reg into the specified SM.  This
+ * configures the SM's PINCTRL, EXECCTRL, SHIFTCTRL, and CLKDIV registers
+ * to match a known hardware or intended configuration.
+ *
+ * As on hardware, changing any of SHIFTCTRL's FJOIN bits flushes both of
+ * the SM's FIFOs, and sets their capacities - see epio_tx_fifo_capacity().
+ * Asserts if FJOIN_TX and FJOIN_RX are both set, or either is set with
+ * FJOIN_RX_PUT or FJOIN_RX_GET.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param reg   Pointer to the register state to apply.
+ * @see epio_get_sm_reg()
+ */
+EPIO_EXPORT void epio_set_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg);
+
+/**
+ * @brief Read the current SM configuration registers for a state machine.
+ *
+ * Copies the current register state of the specified SM into @p reg.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param reg   Pointer to a caller-allocated structure to receive the state.
+ * @see epio_set_sm_reg()
+ */
+EPIO_EXPORT void epio_get_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg);
+
+/**
+ * @brief Enable a state machine for execution.
+ *
+ * Marks the specified SM as enabled.  Only enabled SMs are advanced by
+ * epio_step_cycles().  The SM must be fully configured before enabling.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ */
+EPIO_EXPORT void epio_enable_sm(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Check if a state machine is enabled.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-
+ * 1).
+ * @return      1 if the SM is enabled, 0 otherwise.
+ */
+EPIO_EXPORT uint8_t epio_is_sm_enabled(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Disable a state machine.
+ * 
+ * Marks the specified SM as disabled.  Disabled SMs are not advanced by
+ * epio_step_cycles() and do not execute instructions until re-enabled.
+ * 
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-
+ * 1).
+ */
+EPIO_EXPORT void epio_disable_sm(epio_t *epio, uint8_t block, uint8_t sm);
+
+/** @} */
+
+/**
+ * @defgroup execution Execution API
+ * @brief Functions for loading instructions and stepping execution.
+ * @{
+ */
+
+/**
+ * @brief Write a PIO instruction into the instruction memory of a block.
+ *
+ * @param epio      The epio instance.
+ * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param instr_num Instruction slot (0 to NUM_INSTRS_PER_BLOCK-1).
+ * @param instr     Encoded 16-bit PIO instruction.
+ * @see epio_get_instr()
+ */
+EPIO_EXPORT void epio_set_instr(epio_t *epio, uint8_t block, uint8_t instr_num, uint16_t instr);
+
+/**
+ * @brief Read a PIO instruction from the instruction memory of a block.
+ *
+ * @param epio      The epio instance.
+ * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param instr_num Instruction slot (0 to NUM_INSTRS_PER_BLOCK-1).
+ * @return          The encoded 16-bit PIO instruction at that slot.
+ * @see epio_set_instr()
+ */
+EPIO_EXPORT uint16_t epio_get_instr(epio_t *epio, uint8_t block, uint8_t instr_num);
+
+/**
+ * @brief Advance all enabled state machines by a number of clock cycles.
+ *
+ * Each enabled SM is stepped exactly @p cycles clock cycles.  SMs stalled
+ * on a FIFO condition or IRQ consume cycles but make no forward progress.
+ * The global cycle count is incremented by @p cycles after each call.
+ *
+ * @param epio   The epio instance.
+ * @param cycles Number of cycles to advance.
+ * @see epio_get_cycle_count()
+ */
+EPIO_EXPORT void epio_step_cycles(epio_t *epio, uint32_t cycles);
+
+/**
+ * @brief Return the total number of cycles executed since last reset.
+ *
+ * @param epio  The epio instance.
+ * @return      Total cycle count.
+ * @see epio_reset_cycle_count()
+ */
+EPIO_EXPORT uint64_t epio_get_cycle_count(epio_t *epio);
+
+/**
+ * @brief Reset the cycle counter to zero.
+ *
+ * Also disables history, if enabled, as it is indexed by cycle count.
+ *
+ * @param epio  The epio instance.
+ * @see epio_get_cycle_count()
+ */
+EPIO_EXPORT void epio_reset_cycle_count(epio_t *epio);
+
+/**
+ * @brief Set the emulated system clock frequency.
+ *
+ * Each cycle is one system clock cycle.  The frequency is only used to
+ * convert between cycles and real time, for example for the timestamps in
+ * a VCD stimulus file.  Defaults to EPIO_DEFAULT_SYS_CLOCK_HZ.
+ *
+ * @param epio  The epio instance.
+ * @param hz    System clock frequency, in Hz.
+ * @see epio_get_sys_clock_hz()
+ */
+EPIO_EXPORT void epio_set_sys_clock_hz(epio_t *epio, uint32_t hz);
+
+/**
+ * @brief Return the emulated system clock frequency.
+ *
+ * @param epio  The epio instance.
+ * @return      System clock frequency, in Hz.
+ * @see epio_set_sys_clock_hz()
+ */
+EPIO_EXPORT uint32_t epio_get_sys_clock_hz(epio_t *epio);
+
+/** @} */
+
+/**
+ * @defgroup history History API
+ * @brief Functions for reverse execution - returning to an earlier cycle.
+ *
+ * While history is enabled, epio takes a checkpoint of the instance's state
+ * every @c interval cycles, storing only the SRAM pages which changed since
+ * the previous checkpoint.  Any external inputs made between calls to
+ * epio_step_cycles() - driving GPIOs, pushing or popping FIFOs, setting IRQs,
+ * writing SRAM, changing configuration, etc - are also recorded.
+ *
+ * epio_seek() and epio_step_back() then restore the nearest checkpoint at or
+ * before the target cycle and replay forward from it, so cost at most
+ * @c interval cycles of emulation, however long the run.
+ *
+ * It is possible to seek both backwards and forwards within the recorded
+ * history.  However, calling epio_step_cycles() after seeking backwards
+ * starts a new timeline from the current cycle, and the history after it is
+ * discarded.
+ *
+ * History is disabled by epio_reset() and epio_reset_cycle_count().
+ * @{
+ */
+
+/**
+ * @brief Start recording history.
+ *
+ * Takes the first checkpoint at the current cycle - it is not possible to
+ * seek to an earlier cycle.  If history is already enabled, it is discarded
+ * and recording restarts.
+ *
+ * @param epio      The epio instance.
+ * @param interval  Number of cycles between checkpoints.  Seeking costs up
+ *                  to this many cycles of emulation, and memory use is
+ *                  inversely proportional to it.
+ * @return          0 on success, -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_history_enable(epio_t *epio, uint32_t interval);
+
+/**
+ * @brief Stop recording history, and free it.
+ *
+ * Does nothing if history is not enabled.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_history_disable(epio_t *epio);
+
+/**
+ * @brief Return the instance to its state at the given cycle.
+ *
+ * The instance is left exactly as it was when it was previously at @p cycle,
+ * including any external inputs made at that cycle.  @p cycle may be after
+ * the end of the recorded history, in which case the instance is stepped
+ * forward from the end.
+ *
+ * @param epio  The epio instance.
+ * @param cycle Cycle to seek to.
+ * @return      0 on success, -1 if history is not enabled, @p cycle is
+ *              before history was enabled, any FIFO stream or device model
+ *              is attached, or @p cycle is before the end of a step with
+ *              either attached.
+ * @see epio_step_back()
+ */
+EPIO_EXPORT int epio_seek(epio_t *epio, uint64_t cycle);
+
+/**
+ * @brief Return the instance to its state a number of cycles ago.
+ *
+ * Equivalent to epio_seek() to the current cycle count less @p cycles.
+ *
+ * @param epio   The epio instance.
+ * @param cycles Number of cycles to step back.
+ * @return       0 on success, -1 if epio_seek() to the target cycle
+ *               fails.
+ * @see epio_seek()
+ */
+EPIO_EXPORT int epio_step_back(epio_t *epio, uint64_t cycles);
+
+/** @} */
+
+/**
+ * @defgroup stimulus Stimulus API
+ * @brief Functions for driving GPIOs from a file of timestamped edges.
+ *
+ * A stimulus is played back by epio_step_cycles(), which applies each edge
+ * at exactly the cycle it is timestamped with, so long runs can be stepped
+ * with a single call.  Edges are applied before the SMs execute that cycle.
+ * The file is streamed from disk as it is played, so may be arbitrarily
+ * large.
+ *
+ * Two formats are supported:
+ * - VCD, as written by most simulators and logic analysers.  Timestamps are
+ *   converted to cycles using the VCD's timescale and the instance's system
+ *   clock - see epio_set_sys_clock_hz() - rounding down.  Each signal to be
+ *   played is mapped to a GPIO with epio_stimulus_map().  A value of 0 or 1
+ *   drives the GPIO, and x or z releases it, so it is pulled up.
+ * - A compact binary edge list, which addresses GPIOs and cycles directly.
+ *   It is the 8 bytes "EPIOEDGE", a 32-bit little-endian version of 1, then
+ *   one record per cycle at which GPIOs change.  Each record is four
+ *   unsigned LEB128 values - the number of cycles since the previous record
+ *   (or the start of playback), a mask of GPIOs to drive, the levels to drive
+ *   them to, and a mask of GPIOs to release.
+ *
+ * Timestamps are relative to the cycle at which the stimulus is attached.
+ * Only the GPIOs the stimulus changes are affected - others may be driven
+ * with epio_drive_gpios_ext() as usual, although that also releases any
+ * GPIOs it does not drive.
+ *
+ * When recording history, edges are recorded as external inputs.  However,
+ * the stimulus itself is not rewound by epio_seek(), so stepping after
+ * seeking continues playback from where it had reached.
+ *
+ * The stimulus is detached by epio_reset() and epio_reset_cycle_count().
+ * @{
+ */
+
+/**
+ * @brief Open a VCD file as a stimulus.
+ *
+ * Reads the VCD's header, so its signals can be mapped to GPIOs with
+ * epio_stimulus_map(), but none of its value changes.
+ *
+ * @param path  Path of the VCD file.
+ * @return      The stimulus, or NULL if the file could not be read or its
+ *              header is malformed.
+ * @see epio_stimulus_attach(), epio_stimulus_free()
+ */
+EPIO_EXPORT epio_stimulus_t *epio_stimulus_open_vcd(const char *path);
+
+/**
+ * @brief Open a binary edge list file as a stimulus.
+ *
+ * @param path  Path of the edge list file.
+ * @return      The stimulus, or NULL if the file could not be read or is not
+ *              an edge list.
+ * @see epio_stimulus_attach(), epio_stimulus_free()
+ */
+EPIO_EXPORT epio_stimulus_t *epio_stimulus_open_edges(const char *path);
+
+/**
+ * @brief Map a VCD signal to a GPIO.
+ *
+ * @p signal is either the signal's full hierarchical name, such as
+ * @c top.bus.cs, or just its reference, such as @c cs, in which case the
+ * first signal declared with that reference is used.  Single bits of vector
+ * signals are mapped by index, such as @c top.data[3].  Signals which are
+ * not mapped are ignored.
+ *
+ * Must be called before the stimulus is attached.
+ *
+ * @param stim      The stimulus.
+ * @param signal    Name of the signal.
+ * @param gpio      GPIO to drive from the signal.
+ * @return          0 on success, -1 if the stimulus is not a VCD, there is
+ *                  no such single-bit signal, or the GPIO is already mapped.
+ */
+EPIO_EXPORT int epio_stimulus_map(epio_stimulus_t *stim, const char *signal, uint8_t gpio);
+
+/**
+ * @brief Start playing a stimulus.
+ *
+ * The instance takes ownership of the stimulus, and frees it when it is
+ * detached or the instance is freed.  Any edges at cycle 0 are applied
+ * immediately.  Any stimulus already attached is detached first.
+ *
+ * @param epio  The epio instance.
+ * @param stim  The stimulus, which must not be attached to any instance.
+ * @see epio_stimulus_detach()
+ */
+EPIO_EXPORT void epio_stimulus_attach(epio_t *epio, epio_stimulus_t *stim);
+
+/**
+ * @brief Stop playing the attached stimulus, and free it.
+ *
+ * GPIOs are left as the stimulus last drove them.  Does nothing if no
+ * stimulus is attached.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_stimulus_detach(epio_t *epio);
+
+/**
+ * @brief Return whether the attached stimulus has edges still to play.
+ *
+ * @param epio  The epio instance.
+ * @return      1 if there are edges still to be applied, 0 if all edges
+ *              have been applied or no stimulus is attached, -1 if playback
+ *              stopped because the file is malformed or could not be read.
+ */
+EPIO_EXPORT int epio_stimulus_status(epio_t *epio);
+
+/**
+ * @brief Free a stimulus which has not been attached.
+ *
+ * @param stim  The stimulus.
+ */
+EPIO_EXPORT void epio_stimulus_free(epio_stimulus_t *stim);
+
+/** @} */
+
+/**
+ * @defgroup device Device Model API
+ * @brief Functions for modelling external devices connected to the GPIOs.
+ *
+ * A device model is a set of callbacks, attached to an instance against a
+ * mask of GPIOs, and called by epio_step_cycles() after each cycle's SMs and
+ * DMA have executed.  A model which responds to its pins changing, such as
+ * a memory or a peripheral chip, therefore runs inside the step loop, and a
+ * long run can be stepped with a single call.
+ *
+ * GPIO levels, as returned by epio_read_pin_states(), are compared once per
+ * cycle, and a model's pins_changed callback is called only on cycles when
+ * any of its GPIOs changed.  Its step callback, if any, is called every
+ * cycle.  Models drive GPIOs with epio_device_drive() and
+ * epio_device_release(), which only affect the GPIOs given, so models and
+ * any stimulus do not interfere with each other.  Levels driven by a model
+ * are seen by the SMs on the next cycle, and by the models - including the
+ * one which drove them - as changes after it.
+ *
+ * Models are called in order of their IDs, and are kept by epio_reset().
+ * GPIOs driven by models are not recorded by history, so epio_seek() fails
+ * while any model is attached, and cannot return to a cycle before the end
+ * of a step with one attached.
+ * @{
+ */
+
+/** @brief Maximum number of device models attached to an instance. */
+#define EPIO_MAX_DEVICES            16
+
+/**
+ * @brief Callbacks implementing a device model.
+ *
+ * Any callback may be NULL.  Callbacks may drive or release GPIOs, and
+ * attach or detach models, including their own.
+ */
+typedef struct {
+    /**
+     * @brief Called after every cycle.
+     *
+     * @param ctx   Context passed to epio_device_attach().
+     * @param epio  The epio instance.  Its cycle count is that of the cycle
+     *              which has just executed.
+     */
+    void (*step)(void *ctx, epio_t *epio);
+
+    /**
+     * @brief Called after a cycle in which any of the model's GPIOs changed
+     * level.
+     *
+     * @param ctx       Context passed to epio_device_attach().
+     * @param epio      The epio instance.
+     * @param levels    Levels of all GPIOs (bit N = GPIO N).
+     * @param changed   Which of the model's GPIOs changed (bit N = GPIO N).
+     */
+    void (*pins_changed)(void *ctx, epio_t *epio, uint64_t levels, uint64_t changed);
+
+    /**
+     * @brief Called when the model is detached, or the instance freed.
+     *
+     * @param ctx   Context passed to epio_device_attach().
+     */
+    void (*free)(void *ctx);
+} epio_device_ops_t;
+
+/**
+ * @brief Attach a device model.
+ *
+ * @param epio  The epio instance.
+ * @param mask  GPIOs whose changes are passed to pins_changed (bit N =
+ *              GPIO N).
+ * @param ops   The model's callbacks, which are copied.
+ * @param ctx   Context passed to the callbacks.
+ * @return      ID of the model, for epio_device_detach(), or -1 if
+ *              EPIO_MAX_DEVICES are already attached, or on allocation
+ *              failure.
+ */
+EPIO_EXPORT int epio_device_attach(epio_t *epio, uint64_t mask, const epio_device_ops_t *ops, void *ctx);
+
+/**
+ * @brief Detach a device model, calling its free callback.
+ *
+ * GPIOs it drove are left driven.
+ *
+ * @param epio  The epio instance.
+ * @param id    ID returned by epio_device_attach().
+ */
+EPIO_EXPORT void epio_device_detach(epio_t *epio, int id);
+
+/**
+ * @brief Drive GPIOs from a device model.
+ *
+ * Unlike epio_drive_gpios_ext(), GPIOs not in @p gpios are unaffected.
+ *
+ * @param epio  The epio instance.
+ * @param gpios GPIOs to drive (bit N = GPIO N).
+ * @param level Levels to drive them to (bit N = GPIO N).
+ */
+EPIO_EXPORT void epio_device_drive(epio_t *epio, uint64_t gpios, uint64_t level);
+
+/**
+ * @brief Stop driving GPIOs from a device model, so they are pulled up.
+ *
+ * GPIOs not in @p gpios are unaffected.
+ *
+ * @param epio  The epio instance.
+ * @param gpios GPIOs to release (bit N = GPIO N).
+ */
+EPIO_EXPORT void epio_device_release(epio_t *epio, uint64_t gpios);
+
+/** @} */
+
+/**
+ * @defgroup mem Memory Responder API
+ * @brief A built-in device model of a parallel ROM or SRAM being read.
+ *
+ * The responder watches a set of address GPIOs, and optional active low
+ * chip select and output enable GPIOs.  When both are asserted it drives
+ * the data GPIOs with the word at the current address of a backing image,
+ * and otherwise it releases them, so they are pulled up.  It allows PIO
+ * programs which serve or read a parallel bus to be soak-tested for
+ * millions of bus cycles within a single epio_step_cycles() call.
+ *
+ * Address and data GPIOs may be any GPIOs, in any order.  Address and
+ * data words are translated to and from GPIO levels with lookup tables
+ * built when the responder is attached, so a bus cycle costs a few table
+ * lookups, and a cycle in which none of its GPIOs change costs nothing
+ * beyond the device model's compare.
+ *
+ * Word N of the image is the N'th group of (data bits + 7) / 8 bytes, little
+ * endian.  Addresses past the end of the image read as all ones, like
+ * erased flash.
+ *
+ * The responder is a device model, detached with epio_device_detach().
+ * @{
+ */
+
+/** @brief Maximum number of address GPIOs of a memory responder. */
+#define EPIO_MEM_MAX_ADDR_PINS      32
+
+/** @brief Maximum number of data GPIOs of a memory responder. */
+#define EPIO_MEM_MAX_DATA_PINS      32
+
+/** @brief Value of a control GPIO which the memory responder does not use. */
+#define EPIO_MEM_NO_PIN             0xFF
+
+/**
+ * @brief Configuration of a memory responder.
+ */
+typedef struct {
+    /** @brief GPIO of each address bit, least significant first. */
+    uint8_t addr_pins[EPIO_MEM_MAX_ADDR_PINS];
+
+    /** @brief Number of address bits, 1 to EPIO_MEM_MAX_ADDR_PINS. */
+    uint8_t num_addr_pins;
+
+    /** @brief GPIO of each data bit, least significant first. */
+    uint8_t data_pins[EPIO_MEM_MAX_DATA_PINS];
+
+    /** @brief Number of data bits, 1 to EPIO_MEM_MAX_DATA_PINS. */
+    uint8_t num_data_pins;
+
+    /** @brief Active low chip select GPIO, or EPIO_MEM_NO_PIN if always
+     * selected. */
+    uint8_t cs_pin;
+
+    /** @brief Active low output enable GPIO, or EPIO_MEM_NO_PIN if always
+     * enabled. */
+    uint8_t oe_pin;
+
+    /**
+     * @brief Access time, in cycles.
+     *
+     * The data GPIOs are updated this many cycles after the last change to
+     * the address or control GPIOs, and hold their previous levels until
+     * then.  With 0, they are updated straight after the cycle which changed
+     * them, so the SMs see the new data on the next cycle.
+     */
+    uint32_t latency;
+} epio_mem_config_t;
+
+/**
+ * @brief Attach a memory responder backed by an image in memory.
+ *
+ * The image is not copied, and must remain valid, and unmodified, until the
+ * responder is detached or the instance freed.  The data GPIOs are driven or
+ * released to match the current address and control GPIOs immediately.
+ *
+ * @param epio      The epio instance.
+ * @param config    The responder's configuration, which is copied.  The
+ *                  data GPIOs must not overlap the address and control
+ *                  GPIOs.
+ * @param image     The backing image.
+ * @param size      Size of the image in bytes.
+ * @return          Device model ID, or -1 if EPIO_MAX_DEVICES are already
+ *                  attached, or on allocation failure.
+ * @see epio_device_detach()
+ */
+EPIO_EXPORT int epio_mem_attach(epio_t *epio, const epio_mem_config_t *config, const uint8_t *image, size_t size);
+
+/**
+ * @brief Attach a memory responder backed by a file.
+ *
+ * The file is mapped into memory, so is not read up front, and is unmapped
+ * when the responder is detached.  It must not be modified until then.
+ *
+ * @param epio      The epio instance.
+ * @param config    The responder's configuration, as for epio_mem_attach().
+ * @param path      Path of the image file, which must not be empty.
+ * @return          Device model ID, or -1 if the file could not be mapped,
+ *                  or the responder could not be attached.
+ * @see epio_mem_attach(), epio_device_detach()
+ */
+EPIO_EXPORT int epio_mem_attach_file(epio_t *epio, const epio_mem_config_t *config, const char *path);
+
+/** @} */
+
+/**
+ * @defgroup system System API
+ * @brief Functions for simulating several connected chips.
+ *
+ * A system owns several epio instances, each emulating one chip, and a
+ * netlist connecting their GPIOs.  The chips are stepped in lockstep, one
+ * cycle at a time, so they share a clock.  After every cycle, each net's
+ * level is resolved - wired-AND, so low if any chip drives it low, high if
+ * any drives it high and none low, and pulled up if none drive it - and the
+ * net's GPIOs on every chip are externally driven to that level, so a level
+ * output by one chip on a cycle is seen by the others on the next.
+ *
+ * Resolution is done with masks, a chip at a time, and is skipped
+ * entirely on cycles where no chip's netted outputs changed.
+ *
+ * A chip's GPIO which is part of a net is driven by the system, so should
+ * not also be driven with epio_drive_gpios_ext() or a stimulus, which
+ * would be overridden on its next change.  An output reads as the level
+ * its chip drives, as with a single instance.
+ * @{
+ */
+
+/** @brief Opaque system of connected epio instances. */
+typedef struct epio_system_t epio_system_t;
+
+/** @brief Maximum number of chips in a system. */
+#define EPIO_SYSTEM_MAX_CHIPS       8
+
+/**
+ * @brief Create an empty system.
+ *
+ * @return  The new system, or NULL on allocation failure.
+ * @see epio_system_free()
+ */
+EPIO_EXPORT epio_system_t *epio_system_create(void);
+
+/**
+ * @brief Free a system, and every chip in it.
+ *
+ * @param sys   The system.
+ */
+EPIO_EXPORT void epio_system_free(epio_system_t *sys);
+
+/**
+ * @brief Add a chip to a system.
+ *
+ * The system takes ownership of the instance, which is freed by
+ * epio_system_free().  It remains usable through the returned pointer, or
+ * epio_system_chip(), to configure and inspect.
+ *
+ * @param sys   The system.
+ * @param epio  The chip's epio instance, which must not already be in a
+ *              system.
+ * @return      The chip's index, or -1 if the system already holds
+ *              EPIO_SYSTEM_MAX_CHIPS chips.
+ */
+EPIO_EXPORT int epio_system_add(epio_system_t *sys, epio_t *epio);
+
+/**
+ * @brief Get a chip in a system.
+ *
+ * @param sys   The system.
+ * @param chip  The chip's index, from epio_system_add().
+ * @return      The chip's epio instance.
+ */
+EPIO_EXPORT epio_t *epio_system_chip(epio_system_t *sys, uint8_t chip);
+
+/**
+ * @brief Connect a GPIO on one chip to a GPIO on another, or the same, chip.
+ *
+ * If either GPIO is already part of a net, the other joins it, and if both
+ * are, the two nets are merged.  The new net is resolved, and driven onto
+ * its GPIOs, immediately.
+ *
+ * @param sys       The system.
+ * @param chip_a    Index of the first chip.
+ * @param gpio_a    GPIO on the first chip.
+ * @param chip_b    Index of the second chip.
+ * @param gpio_b    GPIO on the second chip.
+ */
+EPIO_EXPORT void epio_system_connect(epio_system_t *sys, uint8_t chip_a, uint8_t gpio_a, uint8_t chip_b, uint8_t gpio_b);
+
+/**
+ * @brief Step every chip in a system, in lockstep.
+ *
+ * @param sys       The system.
+ * @param cycles    Number of cycles to step.
+ */
+EPIO_EXPORT void epio_system_step_cycles(epio_system_t *sys, uint32_t cycles);
+
+/** @} */
+
+/**
+ * @defgroup check Timing Check API
+ * @brief Functions for registering timing assertions, checked as the
+ * instance runs.
+ *
+ * Checks are registered up front, and each is evaluated by a small state
+ * machine after every cycle, inside epio_step_cycles(), so a long run is
+ * verified cycle by cycle without stepping and asserting from the harness.
+ * Each failure is recorded as a violation, with the ID of the check and the
+ * cycle it failed on, and the run continues.
+ *
+ * GPIO checks see the levels, as returned by epio_read_pin_states(), after
+ * each cycle's SMs and DMA have executed, and before any device model
+ * responds to them.  Each cycle is checked once - cycles which are replayed
+ * by epio_seek() are not checked again.  Checks and violations are removed
+ * by epio_reset() and epio_reset_cycle_count().
+ * @{
+ */
+
+/** @brief Maximum number of checks registered with an instance. */
+#define EPIO_MAX_CHECKS             32
+
+/** @brief Maximum number of violations recorded.  Later violations are
+ * counted, but not recorded. */
+#define EPIO_MAX_VIOLATIONS         256
+
+/** @brief Types of check. */
+typedef enum {
+    EPIO_CHECK_PERIOD,
+    EPIO_CHECK_RESPONSE,
+    EPIO_CHECK_RX_OVERFLOW,
+    EPIO_CHECK_TX_UNDERRUN,
+    EPIO_CHECK_MAX_STALL,
+} epio_check_type_t;
+
+/** @brief A failed check. */
+typedef struct {
+    /** @brief Cycle the check failed on. */
+    uint64_t cycle;
+
+    /** @brief ID of the check, as returned when it was registered. */
+    int id;
+
+    /** @brief Type of the check. */
+    epio_check_type_t type;
+} epio_violation_t;
+
+/**
+ * @brief Check a GPIO's period.
+ *
+ * Fails on any rising edge which is not period ± tolerance cycles after the
+ * previous rising edge, and on the cycle the next rising edge becomes
+ * overdue, after which the period is measured afresh from the next rising
+ * edge.
+ *
+ * @param epio      The epio instance.
+ * @param gpio      The GPIO.
+ * @param period    Expected cycles between rising edges.  Must be non-zero.
+ * @param tolerance Cycles either side of period allowed.  Must be less than
+ *                  period.
+ * @return          ID of the check, or -1 if EPIO_MAX_CHECKS are already
+ *                  registered, or on allocation failure.
+ */
+EPIO_EXPORT int epio_check_period(epio_t *epio, uint8_t gpio, uint32_t period, uint32_t tolerance);
+
+/**
+ * @brief Check GPIOs become valid within a time of a trigger GPIO changing.
+ *
+ * After the trigger GPIO changes to the trigger level, all of @p gpios must
+ * be driven, either as outputs or externally, within @p within cycles, or
+ * the check fails on the cycle they are due.  The check is abandoned if the
+ * trigger GPIO changes back first.  For example, after an active low chip
+ * select falls, the data GPIOs are driven within 12 cycles.
+ *
+ * @param epio          The epio instance.
+ * @param trigger_gpio  The trigger GPIO.
+ * @param trigger_level Level the trigger GPIO changes to, 0 or 1.
+ * @param gpios         GPIOs which must become driven (bit N = GPIO N).
+ *                      Must be non-zero.
+ * @param within        Cycles allowed, after the cycle the trigger GPIO
+ *                      changed.
+ * @return              ID of the check, or -1 if EPIO_MAX_CHECKS are
+ *                      already registered, or on allocation failure.
+ */
+EPIO_EXPORT int epio_check_response(epio_t *epio, uint8_t trigger_gpio, uint8_t trigger_level, uint64_t gpios, uint32_t within);
+
+/**
+ * @brief Check an SM's RX FIFO never overflows.
+ *
+ * Fails on every cycle the SM is stalled on a PUSH or autopush because its
+ * RX FIFO is full, or discards its ISR with a non-blocking PUSH to a full RX
+ * FIFO.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @return      ID of the check, or -1 if EPIO_MAX_CHECKS are already
+ *              registered, or on allocation failure.
+ */
+EPIO_EXPORT int epio_check_rx_overflow(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Check an SM's TX FIFO never underruns.
+ *
+ * Fails on every cycle the SM is stalled on a PULL or autopull because its
+ * TX FIFO is empty.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @return      ID of the check, or -1 if EPIO_MAX_CHECKS are already
+ *              registered, or on allocation failure.
+ */
+EPIO_EXPORT int epio_check_tx_underrun(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Check an SM never stalls for more than a number of cycles.
+ *
+ * Stalls include WAITs, blocking FIFO operations, and IRQ waits, but not
+ * delays.  Fails once per stall, on the first cycle it exceeds
+ * @p max_cycles.
+ *
+ * @param epio          The epio instance.
+ * @param block         PIO block.
+ * @param sm            SM.
+ * @param max_cycles    Longest stall allowed, in consecutive cycles.
+ * @return              ID of the check, or -1 if EPIO_MAX_CHECKS are
+ *                      already registered, or on allocation failure.
+ */
+EPIO_EXPORT int epio_check_max_stall(epio_t *epio, uint8_t block, uint8_t sm, uint32_t max_cycles);
+
+/**
+ * @brief Get the violations of the registered checks.
+ *
+ * @param epio          The epio instance.
+ * @param violations    Buffer for the violations, in the order they
+ *                      occurred.  May be NULL if @p max is 0.
+ * @param max           Size of the buffer.  At most EPIO_MAX_VIOLATIONS
+ *                      are recorded.
+ * @return              Total number of violations, which may be more than
+ *                      were copied to the buffer.
+ */
+EPIO_EXPORT uint64_t epio_check_violations(epio_t *epio, epio_violation_t *violations, uint32_t max);
+
+/**
+ * @brief Remove all checks and violations.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_check_clear(epio_t *epio);
+
+/** @} */
+
+/**
+ * @defgroup schedule Schedule API
+ * @brief Functions for scheduling host actions at future cycles.
+ *
+ * An action - driving or releasing GPIOs, pushing a word to a TX FIFO,
+ * setting or clearing an IRQ, or calling a callback - is scheduled against
+ * an absolute cycle, or a number of cycles from now.  epio_step_cycles()
+ * runs up to the cycle of each scheduled action, and performs it before
+ * that cycle executes, so a scripted scenario runs with a single call.
+ * Actions scheduled for the same cycle are performed in the order they were
+ * scheduled.
+ *
+ * Actions are only performed by epio_step_cycles().  An action whose cycle
+ * has already passed, for example after epio_seek() moved the instance
+ * back, is performed before the next cycle executes.  Actions performed are
+ * not undone or repeated by epio_seek().  Scheduled actions are removed by
+ * epio_reset() and epio_reset_cycle_count().
+ *
+ * Each run of cycles is bounded by the next scheduled action when it
+ * starts, so an action scheduled from inside the step loop, by a device
+ * model, for a cycle before that run ends is performed late, when it ends.
+ * @{
+ */
+
+/** @brief Types of scheduled action. */
+typedef enum {
+    /** @brief Drive gpios to level, leaving all other GPIOs unaffected. */
+    EPIO_ACTION_DRIVE,
+
+    /** @brief Release gpios, so they are pulled up. */
+    EPIO_ACTION_RELEASE,
+
+    /** @brief Push value to the TX FIFO of block and sm, which must not be
+     * full. */
+    EPIO_ACTION_PUSH_TX,
+
+    /** @brief Set IRQ irq of block. */
+    EPIO_ACTION_SET_IRQ,
+
+    /** @brief Clear IRQ irq of block. */
+    EPIO_ACTION_CLEAR_IRQ,
+
+    /** @brief Call callback. */
+    EPIO_ACTION_CALLBACK,
+} epio_action_type_t;
+
+/** @brief A scheduled action.  Only the fields used by its type are read. */
+typedef struct {
+    epio_action_type_t type;
+
+    /** @brief GPIOs to drive or release (bit N = GPIO N). */
+    uint64_t gpios;
+
+    /** @brief Levels to drive them to (bit N = GPIO N). */
+    uint64_t level;
+
+    /** @brief PIO block, and SM, of the FIFO or IRQ. */
+    uint8_t block;
+    uint8_t sm;
+
+    /** @brief IRQ number. */
+    uint8_t irq;
+
+    /** @brief Value pushed to the TX FIFO. */
+    uint32_t value;
+
+    /**
+     * @brief Called on the scheduled cycle.
+     *
+     * May drive GPIOs, push to FIFOs, and schedule further actions,
+     * including at the current cycle, but must not step the instance or
+     * call epio_schedule_clear().
+     *
+     * @param ctx   ctx from this action.
+     * @param epio  The epio instance.  Its cycle count is that of the cycle
+     *              about to execute.
+     */
+    void (*callback)(void *ctx, epio_t *epio);
+
+    /** @brief Context passed to callback. */
+    void *ctx;
+} epio_action_t;
+
+/**
+ * @brief Schedule an action at a cycle.
+ *
+ * @param epio      The epio instance.
+ * @param cycle     Cycle the action is performed before.
+ * @param action    The action, which is copied.
+ * @return          0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_schedule_at(epio_t *epio, uint64_t cycle, const epio_action_t *action);
+
+/**
+ * @brief Schedule an action a number of cycles from the current cycle.
+ *
+ * @param epio      The epio instance.
+ * @param cycles    Cycles from now.  0 performs the action before the next
+ *                  cycle executes.
+ * @param action    The action, which is copied.
+ * @return          0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_schedule_in(epio_t *epio, uint64_t cycles, const epio_action_t *action);
+
+/**
+ * @brief Get the number of actions scheduled but not yet performed.
+ *
+ * @param epio  The epio instance.
+ * @return      Number of pending actions.
+ */
+EPIO_EXPORT uint32_t epio_schedule_pending(epio_t *epio);
+
+/**
+ * @brief Remove all scheduled actions.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_schedule_clear(epio_t *epio);
+
+/** @} */
+
+/**
+ * @defgroup stream Stream API
+ * @brief Functions for streaming words to TX FIFOs and from RX FIFOs.
+ *
+ * A TX source, a buffer or a callback, is attached to an SM, and refills
+ * its TX FIFO whenever it has room.  An RX sink, a buffer or a callback,
+ * drains its RX FIFO.  Both are serviced by epio_step_cycles() after each
+ * cycle's SMs and DMA have executed, so a word an SM pushes is drained
+ * after that cycle, and the TX FIFO is refilled in time for the SM to pull
+ * again on the next cycle.  A source is also serviced when attached.  A
+ * long transfer therefore runs with a single step call, with the FIFOs
+ * never limiting it unless the source or sink falls behind.
+ *
+ * Each stream counts the words transferred, and the cycles on which its SM
+ * underran or overran - stalled on an empty TX FIFO, or stalled on a full
+ * RX FIFO or discarded its ISR with a non-blocking PUSH.
+ *
+ * Words transferred by streams are not recorded by history, so epio_seek()
+ * fails while any stream is attached, and cannot return to a cycle before
+ * the end of a step with one attached.  Streams are detached by epio_reset()
+ * and epio_reset_cycle_count().
+ * @{
+ */
+
+/**
+ * @brief Callback supplying words to a TX stream.
+ *
+ * Must not attach or detach streams.
+ *
+ * @param ctx   Context passed to epio_stream_tx_callback().
+ * @param epio  The epio instance.
+ * @param words Buffer for the words, in the order they are pushed.
+ * @param max   Room in the TX FIFO, and the size of the buffer.  Never 0.
+ * @return      Number of words supplied, at most @p max.  May be 0.
+ */
+typedef uint32_t (*epio_stream_fill_t)(void *ctx, epio_t *epio, uint32_t *words, uint32_t max);
+
+/**
+ * @brief Callback accepting words from an RX stream.
+ *
+ * Must not attach or detach streams.
+ *
+ * @param ctx   Context passed to epio_stream_rx_callback().
+ * @param epio  The epio instance.
+ * @param words The words in the RX FIFO, oldest first.
+ * @param count Number of words.  Never 0.
+ * @return      Number of words accepted, at most @p count, which are
+ *              popped from the RX FIFO.  The rest stay in it.
+ */
+typedef uint32_t (*epio_stream_drain_t)(void *ctx, epio_t *epio, const uint32_t *words, uint32_t count);
+
+/** @brief Statistics of a stream. */
+typedef struct {
+    /** @brief Words pushed to the TX FIFO, or popped from the RX FIFO. */
+    uint64_t words;
+
+    /** @brief Cycles on which the SM underran or overran. */
+    uint64_t stall_cycles;
+
+    /** @brief First and last cycles on which the SM underran or overran,
+     * or UINT64_MAX if it has not. */
+    uint64_t first_stall;
+    uint64_t last_stall;
+
+    /** @brief Whether a buffer source has been exhausted, or a buffer sink
+     * filled.  Always 0 for callbacks. */
+    uint8_t done;
+} epio_stream_stats_t;
+
+/**
+ * @brief Attach a buffer as an SM's TX source, replacing any existing one.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @param words Words to push, in order.  Not copied, so must remain valid
+ *              until the source is exhausted or detached.
+ * @param count Number of words.
+ * @return      0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_stream_tx_buffer(epio_t *epio, uint8_t block, uint8_t sm, const uint32_t *words, uint32_t count);
+
+/**
+ * @brief Attach a callback as an SM's TX source, replacing any existing one.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @param fill  Called whenever the TX FIFO has room.
+ * @param ctx   Context passed to @p fill.
+ * @return      0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_stream_tx_callback(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_fill_t fill, void *ctx);
+
+/**
+ * @brief Attach a buffer as an SM's RX sink, replacing any existing one.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @param words Buffer for the words popped, in order.  Must remain valid
+ *              until the sink is full or detached.
+ * @param max   Size of the buffer, in words.  Once it is full, words are
+ *              left in the RX FIFO.
+ * @return      0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_stream_rx_buffer(epio_t *epio, uint8_t block, uint8_t sm, uint32_t *words, uint32_t max);
+
+/**
+ * @brief Attach a callback as an SM's RX sink, replacing any existing one.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @param drain Called whenever the RX FIFO is not empty.
+ * @param ctx   Context passed to @p drain.
+ * @return      0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_stream_rx_callback(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_drain_t drain, void *ctx);
+
+/**
+ * @brief Get the statistics of an SM's streams.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ * @param tx    Filled with the TX source's statistics, or zeroed, with no
+ *              stalls, if none is attached.  May be NULL.
+ * @param rx    Filled with the RX sink's statistics, likewise.  May be
+ *              NULL.
+ */
+EPIO_EXPORT void epio_stream_stats(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_stats_t *tx, epio_stream_stats_t *rx);
+
+/**
+ * @brief Detach an SM's TX source and RX sink.
+ *
+ * Words already pushed to the TX FIFO, or left in the RX FIFO, stay there.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block.
+ * @param sm    SM.
+ */
+EPIO_EXPORT void epio_stream_detach(epio_t *epio, uint8_t block, uint8_t sm);
+
+/** @} */
+
+/**
+ * @defgroup fifo_stats FIFO Statistics API
+ * @brief Functions for measuring how full every SM's FIFOs run.
+ *
+ * While enabled, every SM's TX and RX FIFO levels are tracked as words are
+ * pushed and popped - by SMs, DMA, streams, scheduled actions or the host -
+ * giving the number of cycles each FIFO spent at each level.  The cycles
+ * each SM stalled on an empty TX FIFO or a full RX FIFO are counted, as are
+ * the words it lost with a non-blocking PUSH to a full RX FIFO.
+ *
+ * Statistics cost nothing while disabled.  Cycles replayed by epio_seek()
+ * are not counted again.  They are disabled by epio_reset() and
+ * epio_reset_cycle_count().
+ * @{
+ */
+
+/** @brief FIFO statistics of an SM, from epio_fifo_stats(). */
+typedef struct {
+    /** @brief Cycles the TX FIFO held each number of words, 0 to
+     * MAX_JOINED_FIFO_DEPTH. */
+    uint64_t tx_level_cycles[9];
+
+    /** @brief Cycles the RX FIFO held each number of words. */
+    uint64_t rx_level_cycles[9];
+
+    /** @brief Cycles the SM stalled on an empty TX FIFO, with PULL or
+     * autopull. */
+    uint64_t tx_stall_cycles;
+
+    /** @brief Cycles the SM stalled on a full RX FIFO, with PUSH or
+     * autopush. */
+    uint64_t rx_stall_cycles;
+
+    /** @brief Words the SM discarded with a non-blocking PUSH to a full RX
+     * FIFO. */
+    uint64_t rx_lost;
+} epio_fifo_stats_t;
+
+/**
+ * @brief Start collecting FIFO statistics, from the current cycle.
+ *
+ * If already enabled, the statistics are restarted from zero.
+ *
+ * @param epio  The epio instance.
+ * @return      0 on success, or -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_fifo_stats_enable(epio_t *epio);
+
+/**
+ * @brief Stop collecting FIFO statistics, and free them.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_fifo_stats_disable(epio_t *epio);
+
+/**
+ * @brief Get the FIFO statistics of every SM.
+ *
+ * The level histograms include the cycles up to the current cycle count.
+ *
+ * @param epio  The epio instance.
+ * @param stats Array of NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK statistics to
+ *              fill, in block then SM order.  Zeroed if statistics are not
+ *              enabled.
+ */
+EPIO_EXPORT void epio_fifo_stats(epio_t *epio, epio_fifo_stats_t *stats);
+
+/** @} */
+
+/**
+ * @defgroup trace Trace API
+ * @brief Functions for writing a VCD waveform trace as the instance runs.
+ *
+ * While tracing, the selected GPIO and SM signals are sampled every cycle,
+ * and any which have changed are written to a VCD file, through a large
+ * write buffer.  Tracing costs nothing while it is not enabled.
+ *
+ * Timestamps are in picoseconds, from the cycle count and the system clock -
+ * see epio_set_sys_clock_hz() - rounded up, so that a trace of GPIO levels
+ * can be played back as a stimulus with epio_stimulus_open_vcd().  GPIO N's
+ * level is the signal @c gpioN, and its direction @c gpioN_oe.  SM signals
+ * are in a scope per block and SM, such as @c pio0.sm1.pc.
+ *
+ * Each cycle is written once - cycles which are replayed by epio_seek() are
+ * not written again.  The trace is stopped by epio_reset() and
+ * epio_reset_cycle_count().
+ * @{
+ */
+
+/** @brief Trace an SM's program counter. */
+#define EPIO_TRACE_SM_PC            (1 << 0)
+/** @brief Trace an SM's X register. */
+#define EPIO_TRACE_SM_X             (1 << 1)
+/** @brief Trace an SM's Y register. */
+#define EPIO_TRACE_SM_Y             (1 << 2)
+/** @brief Trace the number of bits in an SM's ISR. */
+#define EPIO_TRACE_SM_ISR_COUNT     (1 << 3)
+/** @brief Trace the number of bits in an SM's OSR. */
+#define EPIO_TRACE_SM_OSR_COUNT     (1 << 4)
+/** @brief Trace the number of entries in an SM's TX FIFO. */
+#define EPIO_TRACE_SM_TX_LEVEL      (1 << 5)
+/** @brief Trace the number of entries in an SM's RX FIFO. */
+#define EPIO_TRACE_SM_RX_LEVEL      (1 << 6)
+/** @brief Trace whether an SM is stalled. */
+#define EPIO_TRACE_SM_STALLED       (1 << 7)
+/** @brief Trace all SM signals. */
+#define EPIO_TRACE_SM_ALL           0xFF
+
+/**
+ * @brief Selection of signals to trace.
+ */
+typedef struct {
+    /** GPIOs whose levels to trace (bit N = GPIO N). */
+    uint64_t gpio_levels;
+    /** GPIOs whose directions to trace (bit N = GPIO N). */
+    uint64_t gpio_dirs;
+    /** SMs to trace (bit block * NUM_SMS_PER_BLOCK + sm). */
+    uint16_t sms;
+    /** Signals to trace for each of those SMs - EPIO_TRACE_SM_* flags. */
+    uint16_t sm_signals;
+    /** PIO blocks whose IRQ flags to trace (bit N = block N). */
+    uint8_t irq_blocks;
+} epio_trace_config_t;
+
+/**
+ * @brief Start writing a VCD trace.
+ *
+ * Writes the VCD header and the initial value of every traced signal at the
+ * current cycle.  Any trace already being written is stopped first.
+ *
+ * @param epio   The epio instance.
+ * @param path   Path of the VCD file to write.
+ * @param config Signals to trace.
+ * @return       0 on success, -1 if the file could not be created.
+ * @see epio_trace_stop()
+ */
+EPIO_EXPORT int epio_trace_start(epio_t *epio, const char *path, const epio_trace_config_t *config);
+
+/**
+ * @brief Stop writing the VCD trace, and close the file.
+ *
+ * Does nothing if no trace is being written.
+ *
+ * @param epio  The epio instance.
+ * @return      0 on success, -1 if any part of the trace could not be
+ *              written.
+ */
+EPIO_EXPORT int epio_trace_stop(epio_t *epio);
+
+/** @} */
+
+/**
+ * @defgroup recorder Recorder API
+ * @brief Functions for recording recent activity in memory, for post-mortem
+ * debugging.
+ *
+ * While enabled, the recorder keeps the most recent events in a fixed-size
+ * ring buffer of compact binary records, overwriting the oldest.  Each event
+ * is a change to an SM's PC or a register, a FIFO push or pop, a change to a
+ * block's IRQ flags, or a change to the GPIO levels, and is tagged with the
+ * cycle it happened in.  Register, IRQ and GPIO changes are recorded once
+ * per cycle, so a value which changes and changes back within a cycle is not
+ * recorded.  FIFO pushes and pops, including those made by the API, are
+ * recorded as they happen.
+ *
+ * Recording costs nothing while it is not enabled.  Each cycle is recorded
+ * once - cycles which are replayed by epio_seek() are not recorded again.
+ * The recorder is disabled by epio_reset() and epio_reset_cycle_count().
+ * @{
+ */
+
+/** @brief An SM's program counter changed.  Value is the new PC. */
+#define EPIO_EVENT_PC               0
+/** @brief An SM's X register changed.  Value is the new X. */
+#define EPIO_EVENT_X                1
+/** @brief An SM's Y register changed.  Value is the new Y. */
+#define EPIO_EVENT_Y                2
+/** @brief An SM's ISR changed.  Value is the new ISR. */
+#define EPIO_EVENT_ISR              3
+/** @brief An SM's OSR changed.  Value is the new OSR. */
+#define EPIO_EVENT_OSR              4
+/** @brief A value was pushed to an SM's TX FIFO. */
+#define EPIO_EVENT_TX_PUSH          5
+/** @brief A value was popped from an SM's TX FIFO. */
+#define EPIO_EVENT_TX_POP           6
+/** @brief A value was pushed to an SM's RX FIFO. */
+#define EPIO_EVENT_RX_PUSH          7
+/** @brief A value was popped from an SM's RX FIFO. */
+#define EPIO_EVENT_RX_POP           8
+/** @brief A block's IRQ flags changed.  Value is the new flags.  SM is 0. */
+#define EPIO_EVENT_IRQ              9
+/** @brief The GPIO levels changed.  Value is the new levels, as returned by
+ * epio_read_pin_states().  Block and SM are 0. */
+#define EPIO_EVENT_GPIO             10
+
+/**
+ * @brief A recorded event.
+ */
+typedef struct {
+    /** Cycle the event happened in.  Events made by the API between cycles
+     * are in the next cycle to run. */
+    uint64_t cycle;
+    /** Value, depending on the type. */
+    uint64_t value;
+    /** Type of event - an EPIO_EVENT_* value. */
+    uint8_t type;
+    /** PIO block. */
+    uint8_t block;
+    /** State machine within the block. */
+    uint8_t sm;
+} epio_event_t;
+
+/**
+ * @brief Start recording events.
+ *
+ * The initial state is not recorded - only changes from it.  If the recorder
+ * is already enabled, its events are discarded and recording restarts.
+ *
+ * @param epio      The epio instance.
+ * @param events    Number of most recent events to keep, rounded up to a
+ *                  power of 2.  Each takes 16 bytes.
+ * @return          0 on success, -1 on allocation failure.
+ */
+EPIO_EXPORT int epio_recorder_enable(epio_t *epio, uint32_t events);
+
+/**
+ * @brief Stop recording events, and discard those recorded.
+ *
+ * Does nothing if the recorder is not enabled.
+ *
+ * @param epio  The epio instance.
+ */
+EPIO_EXPORT void epio_recorder_disable(epio_t *epio);
+
+/**
+ * @brief Return the number of events held by the recorder.
+ *
+ * @param epio  The epio instance.
+ * @return      Number of events which can be read, or 0 if the recorder is
+ *              not enabled.
+ */
+EPIO_EXPORT uint32_t epio_recorder_count(epio_t *epio);
+
+/**
+ * @brief Return the total number of events recorded since it was enabled,
+ * including those which have since been overwritten.
+ *
+ * @param epio  The epio instance.
+ * @return      Total number of events, or 0 if the recorder is not enabled.
+ */
+EPIO_EXPORT uint64_t epio_recorder_total(epio_t *epio);
+
+/**
+ * @brief Decode a recorded event.
+ *
+ * Events are in the order they happened.  Within a cycle, FIFO pushes and
+ * pops come before the other changes made in that cycle.
+ *
+ * @param epio  The epio instance.
+ * @param index Index of the event, from 0 (the oldest held) to
+ *              epio_recorder_count() - 1.
+ * @param event Filled in with the event.
+ */
+EPIO_EXPORT void epio_recorder_read(epio_t *epio, uint32_t index, epio_event_t *event);
+
+/** @} */
+
+/**
+ * @defgroup capture Capture API
+ * @brief Functions for capturing GPIO waveforms as edges.
+ *
+ * While capturing, the observable levels of the selected GPIOs - as returned
+ * by epio_read_pin_states() - are compared before each cycle, and after the
+ * last, and an edge is written to a caller supplied buffer only when they
+ * change.  Long runs with sparse activity therefore capture a few edges,
+ * rather than a value per cycle.
+ *
+ * Each edge is stamped with the cycle count at which the new levels were
+ * first observed, so the levels at cycle N are those of the last edge at or
+ * before N.  The first edge is the levels when the capture started, with no
+ * bits changed.
+ *
+ * Each cycle is captured once - cycles which are replayed by epio_seek() are
+ * not captured again.  The capture is stopped by epio_reset() and
+ * epio_reset_cycle_count().
+ * @{
+ */
+
+/** @brief When the buffer is full, stop capturing further edges. */
+#define EPIO_CAPTURE_STOP           0
+/** @brief When the buffer is full, overwrite the oldest edges. */
+#define EPIO_CAPTURE_WRAP           1
+/** @brief When the buffer is full, pass its edges to a callback, and then
+ * reuse it. */
+#define EPIO_CAPTURE_CALLBACK       2
+
+/**
+ * @brief A change in the captured GPIO levels.
+ */
+typedef struct {
+    /** Cycle count at which the new levels were first observed. */
+    uint64_t cycle;
+    /** Captured GPIOs which changed (bit N = GPIO N). */
+    uint64_t changed;
+    /** New levels of all of the captured GPIOs (bit N = GPIO N). */
+    uint64_t value;
+} epio_edge_t;
+
+/**
+ * @brief Callback to receive a full buffer of edges.
+ *
+ * @param arg   Argument passed to epio_capture_start().
+ * @param edges Captured edges, oldest first.  The buffer is reused once the
+ *              callback returns.
+ * @param count Number of edges.
+ */
+typedef void (*epio_capture_fn_t)(void *arg, const epio_edge_t *edges, uint32_t count);
+
+/**
+ * @brief Start capturing GPIO edges.
+ *
+ * Records the current levels as the first edge.  Any capture already in
+ * progress is stopped first.
+ *
+ * @param epio      The epio instance.
+ * @param mask      GPIOs to capture (bit N = GPIO N).
+ * @param buffer    Buffer to write edges to.  Must remain valid until the
+ *                  capture is stopped.
+ * @param size      Number of edges the buffer holds.
+ * @param overflow  What to do when the buffer is full - an EPIO_CAPTURE_*
+ *                  value.
+ * @param callback  Callback for EPIO_CAPTURE_CALLBACK, otherwise NULL.
+ * @param arg       Argument passed to the callback.
+ * @return          0 on success, -1 on allocation failure.
+ * @see epio_capture_stop()
+ */
+EPIO_EXPORT int epio_capture_start(epio_t *epio, uint64_t mask, epio_edge_t *buffer, uint32_t size, uint8_t overflow, epio_capture_fn_t callback, void *arg);
+
+/**
+ * @brief Stop capturing GPIO edges.
+ *
+ * For EPIO_CAPTURE_WRAP, the buffer is reordered so that the oldest edge
+ * held is first.  For EPIO_CAPTURE_CALLBACK, the edges which have not been
+ * passed to the callback are left in the buffer.
+ *
+ * @param epio  The epio instance.
+ * @param total If not NULL, set to the total number of edges captured,
+ *              including any which were dropped, overwritten or passed to
+ *              the callback.
+ * @return      Number of edges in the buffer, or 0 if no capture was in
+ *              progress.
+ */
+EPIO_EXPORT uint32_t epio_capture_stop(epio_t *epio, uint64_t *total);
+
+/** @} */
+
+/**
+ * @defgroup index Edge Index API
+ * @brief Functions for querying captured GPIO edges by time.
+ *
+ * An index is built once over edges captured with epio_capture_start(), and
+ * answers questions like "what was GPIO 8 at cycle N" or "when was the next
+ * rising edge of GPIO 3 after cycle N" in O(log n) time, where n is the
+ * number of edges of that GPIO, without re-running or scanning the capture.
+ *
+ * The first edge gives the levels at the start of the index, which is the
+ * earliest cycle which can be queried.  An index does not refer to the
+ * edges it was built from, so they may be freed or reused.
+ * @{
+ */
+
+/** @brief Opaque edge index type. */
+typedef struct epio_index_t epio_index_t;
+
+/** @brief Match rising edges. */
+#define EPIO_EDGE_RISING            (1 << 0)
+/** @brief Match falling edges. */
+#define EPIO_EDGE_FALLING           (1 << 1)
+/** @brief Match rising and falling edges. */
+#define EPIO_EDGE_ANY               (EPIO_EDGE_RISING | EPIO_EDGE_FALLING)
+
+/**
+ * @brief Build an index over captured edges.
+ *
+ * @param edges Edges, in cycle order, as captured by epio_capture_start().
+ * @param count Number of edges - at least 1.
+ * @return      The index, or NULL on allocation failure.
+ */
+EPIO_EXPORT epio_index_t *epio_index_build(const epio_edge_t *edges, uint32_t count);
+
+/**
+ * @brief Free an index.
+ *
+ * @param index The index.
+ */
+EPIO_EXPORT void epio_index_free(epio_index_t *index);
+
+/**
+ * @brief Return a GPIO's level at a cycle.
+ *
+ * @param index The index.
+ * @param pin   GPIO number.
+ * @param cycle Cycle count.
+ * @return      The level (0 or 1), or -1 if the cycle is before the start
+ *              of the index.
+ */
+EPIO_EXPORT int epio_index_level(const epio_index_t *index, uint8_t pin, uint64_t cycle);
+
+/**
+ * @brief Find a GPIO's first edge after a cycle.
+ *
+ * @param index The index.
+ * @param pin   GPIO number.
+ * @param cycle Cycle count.  Edges at this cycle are not matched.
+ * @param type  Edges to match - EPIO_EDGE_* flags.
+ * @param edge  Set to the cycle of the edge, if found.
+ * @return      0 if an edge was found, -1 if not.
+ */
+EPIO_EXPORT int epio_index_next_edge(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint8_t type, uint64_t *edge);
+
+/**
+ * @brief Find a GPIO's last edge at or before a cycle.
+ *
+ * @param index The index.
+ * @param pin   GPIO number.
+ * @param cycle Cycle count.  Edges at this cycle are matched.
+ * @param type  Edges to match - EPIO_EDGE_* flags.
+ * @param edge  Set to the cycle of the edge, if found.
+ * @return      0 if an edge was found, -1 if not.
+ */
+EPIO_EXPORT int epio_index_prev_edge(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint8_t type, uint64_t *edge);
+
+/**
+ * @brief Return the width of the pulse of a GPIO containing a cycle.
+ *
+ * The pulse is from the GPIO's last edge at or before the cycle to its next
+ * edge after it.
+ *
+ * @param index The index.
+ * @param pin   GPIO number.
+ * @param cycle Cycle count.
+ * @param width Set to the width of the pulse in cycles, if found.
+ * @return      0 on success, -1 if either edge is not in the index.
+ */
+EPIO_EXPORT int epio_index_pulse_width(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint64_t *width);
+
+/**
+ * @brief Return the period of a GPIO's signal at a cycle.
+ *
+ * The period is from the GPIO's last rising edge at or before the cycle to
+ * its next rising edge after it.
+ *
+ * @param index     The index.
+ * @param pin       GPIO number.
+ * @param cycle     Cycle count.
+ * @param period    Set to the period in cycles, if found.
+ * @return          0 on success, -1 if either edge is not in the index.
+ */
+EPIO_EXPORT int epio_index_period(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint64_t *period);
+
+/** @} */
+
+/**
+ * @defgroup decoder Decoder API
+ * @brief Functions for decoding UART, SPI, I2C and parallel bus traffic
+ * from captured GPIO edges.
+ *
+ * A decoder is created for a protocol, with its pin assignments and timing,
+ * and a callback which receives each decoded frame, stamped with cycle
+ * counts.  Edges from epio_capture_start() are fed to it with
+ * epio_decoder_feed(), in one or more batches.  Decoding is streaming, and
+ * does not allocate memory once the decoder has been created.
+ *
+ * To decode live, as the instance runs, start a capture of the decoder's
+ * pins with EPIO_CAPTURE_CALLBACK, passing epio_decoder_capture() as the
+ * callback and the decoder as its argument.  Edges are then decoded each
+ * time the capture buffer fills.  Feed the edges left in the buffer when
+ * the capture is stopped to the decoder with epio_decoder_feed().
+ *
+ * Where a clock or strobe edge is captured in the same cycle as a data
+ * change, the data is taken from before the change, as it must be set up
+ * before the clock.  The exception is I2C, where SDA is taken while SCL is
+ * high, so after the change.
+ * @{
+ */
+
+/** @brief Opaque decoder type. */
+typedef struct epio_decoder_t epio_decoder_t;
+
+/** @brief Pin is not used - for the optional SPI pins. */
+#define EPIO_DECODE_NO_PIN          0xFF
+
+/** @brief A data word - UART character, SPI word, I2C data byte or parallel
+ * bus value. */
+#define EPIO_FRAME_DATA             0
+/** @brief An I2C address byte.  The data is the byte, including the read
+ * bit. */
+#define EPIO_FRAME_ADDRESS          1
+/** @brief An I2C start or repeated start condition, or SPI chip select
+ * being asserted. */
+#define EPIO_FRAME_START            2
+/** @brief An I2C stop condition, or SPI chip select being deasserted. */
+#define EPIO_FRAME_STOP             3
+
+/** @brief UART parity bit was incorrect. */
+#define EPIO_FRAME_ERR_PARITY       (1 << 0)
+/** @brief UART stop bit was low, or an SPI word or I2C byte was cut short
+ * by chip select being deasserted or a start or stop condition. */
+#define EPIO_FRAME_ERR_FRAMING      (1 << 1)
+/** @brief I2C byte was not acknowledged. */
+#define EPIO_FRAME_NACK             (1 << 2)
+
+/** @brief No UART parity bit. */
+#define EPIO_UART_PARITY_NONE       0
+/** @brief Even UART parity. */
+#define EPIO_UART_PARITY_EVEN       1
+/** @brief Odd UART parity. */
+#define EPIO_UART_PARITY_ODD        2
+
+/**
+ * @brief A decoded frame.
+ */
+typedef struct {
+    /** Cycle count at which the frame started - the UART start bit, first
+     * SPI or I2C clock edge, or parallel bus strobe. */
+    uint64_t cycle;
+    /** Cycle count at which the frame was complete. */
+    uint64_t end;
+    /** Data - the UART character, SPI MOSI word, I2C byte or parallel bus
+     * value. */
+    uint32_t data;
+    /** SPI MISO word, otherwise 0. */
+    uint32_t data_in;
+    /** Type of frame - an EPIO_FRAME_* value. */
+    uint8_t type;
+    /** Errors and conditions - EPIO_FRAME_ERR_* and EPIO_FRAME_NACK
+     * flags. */
+    uint8_t flags;
+} epio_frame_t;
+
+/**
+ * @brief Callback to receive a decoded frame.
+ *
+ * @param arg   Argument passed when creating the decoder.
+ * @param frame The frame, valid only until the callback returns.
+ */
+typedef void (*epio_frame_fn_t)(void *arg, const epio_frame_t *frame);
+
+/**
+ * @brief UART decoder configuration.
+ */
+typedef struct {
+    /** GPIO carrying the UART signal, idle high. */
+    uint8_t pin;
+    /** Length of a bit in cycles. */
+    uint32_t bit_cycles;
+    /** Number of data bits (5 to 9), sent LSB first. */
+    uint8_t data_bits;
+    /** Parity - an EPIO_UART_PARITY_* value. */
+    uint8_t parity;
+    /** Number of stop bits (1 or 2). */
+    uint8_t stop_bits;
+} epio_uart_config_t;
+
+/**
+ * @brief SPI decoder configuration.
+ */
+typedef struct {
+    /** Clock GPIO. */
+    uint8_t sck;
+    /** Controller to peripheral data GPIO. */
+    uint8_t mosi;
+    /** Peripheral to controller data GPIO, or EPIO_DECODE_NO_PIN. */
+    uint8_t miso;
+    /** Active low chip select GPIO, or EPIO_DECODE_NO_PIN if always
+     * selected. */
+    uint8_t cs;
+    /** SPI mode (0 to 3) - bit 1 is CPOL and bit 0 CPHA. */
+    uint8_t mode;
+    /** Number of bits per word (1 to 32). */
+    uint8_t bits;
+    /** 1 if words are sent LSB first, 0 if MSB first. */
+    uint8_t lsb_first;
+} epio_spi_config_t;
+
+/**
+ * @brief I2C decoder configuration.
+ */
+typedef struct {
+    /** Clock GPIO. */
+    uint8_t scl;
+    /** Data GPIO. */
+    uint8_t sda;
+} epio_i2c_config_t;
+
+/**
+ * @brief Parallel bus decoder configuration.
  */
-EPIO_EXPORT void epio_get_sm_debug(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_debug_t *debug);
+typedef struct {
+    /** Lowest data GPIO. */
+    uint8_t data_base;
+    /** Number of data GPIOs (1 to 32), contiguous from data_base. */
+    uint8_t data_count;
+    /** Strobe GPIO, on whose edges the data is latched. */
+    uint8_t strobe;
+    /** Strobe edge which latches the data - EPIO_EDGE_RISING or
+     * EPIO_EDGE_FALLING. */
+    uint8_t strobe_edge;
+} epio_parallel_config_t;
 
 /**
- * @brief Set the GPIO base for a PIO block.
+ * @brief Create a UART decoder.
  *
- * The RP2350 supports GPIOBASE values of 0 and 16 per PIO block, shifting
- * the block's GPIO mapping accordingly.  This must match the GPIOBASE
- * configuration of the PIO block under test.
+ * Each character is decoded by sampling the middle of each bit after the
+ * falling edge of its start bit.
  *
- * @param epio      The epio instance.
- * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param gpio_base GPIO base offset (0 or 16).
+ * @param config    Configuration.
+ * @param callback  Callback to receive each frame.
+ * @param arg       Argument passed to the callback.
+ * @return          The decoder, or NULL on allocation failure.
  */
-EPIO_EXPORT void epio_set_gpiobase(epio_t *epio, uint8_t block, uint32_t gpio_base);
+EPIO_EXPORT epio_decoder_t *epio_decoder_uart(const epio_uart_config_t *config, epio_frame_fn_t callback, void *arg);
 
 /**
- * @brief Get the GPIO base for a PIO block.
- * 
- * @param epio The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @return The GPIO base offset for this block.
+ * @brief Create an SPI decoder.
+ *
+ * @param config    Configuration.
+ * @param callback  Callback to receive each frame.
+ * @param arg       Argument passed to the callback.
+ * @return          The decoder, or NULL on allocation failure.
  */
-EPIO_EXPORT uint32_t epio_get_gpiobase(epio_t *epio, uint8_t block);
+EPIO_EXPORT epio_decoder_t *epio_decoder_spi(const epio_spi_config_t *config, epio_frame_fn_t callback, void *arg);
 
 /**
- * @brief Set the SM configuration registers for a state machine.
+ * @brief Create an I2C decoder.
  *
- * Copies the register state from @p reg into the specified SM.  This
- * configures the SM's PINCTRL, EXECCTRL, SHIFTCTRL, and CLKDIV registers
- * to match a known hardware or intended configuration.
+ * The first byte after each start condition is an EPIO_FRAME_ADDRESS frame,
+ * and the rest are EPIO_FRAME_DATA frames.
  *
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
- * @param reg   Pointer to the register state to apply.
- * @see epio_get_sm_reg()
+ * @param config    Configuration.
+ * @param callback  Callback to receive each frame.
+ * @param arg       Argument passed to the callback.
+ * @return          The decoder, or NULL on allocation failure.
  */
-EPIO_EXPORT void epio_set_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg);
+EPIO_EXPORT epio_decoder_t *epio_decoder_i2c(const epio_i2c_config_t *config, epio_frame_fn_t callback, void *arg);
 
 /**
- * @brief Read the current SM configuration registers for a state machine.
- *
- * Copies the current register state of the specified SM into @p reg.
+ * @brief Create a parallel bus decoder.
  *
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
- * @param reg   Pointer to a caller-allocated structure to receive the state.
- * @see epio_set_sm_reg()
+ * @param config    Configuration.
+ * @param callback  Callback to receive each frame.
+ * @param arg       Argument passed to the callback.
+ * @return          The decoder, or NULL on allocation failure.
  */
-EPIO_EXPORT void epio_get_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg);
+EPIO_EXPORT epio_decoder_t *epio_decoder_parallel(const epio_parallel_config_t *config, epio_frame_fn_t callback, void *arg);
 
 /**
- * @brief Enable a state machine for execution.
+ * @brief Decode edges.
  *
- * Marks the specified SM as enabled.  Only enabled SMs are advanced by
- * epio_step_cycles().  The SM must be fully configured before enabling.
+ * Edges must include the decoder's pins, and be fed in cycle order.  The
+ * first edge fed gives the initial levels.
  *
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param decoder   The decoder.
+ * @param edges     Edges, as captured by epio_capture_start().
+ * @param count     Number of edges.
  */
-EPIO_EXPORT void epio_enable_sm(epio_t *epio, uint8_t block, uint8_t sm);
+EPIO_EXPORT void epio_decoder_feed(epio_decoder_t *decoder, const epio_edge_t *edges, uint32_t count);
 
 /**
- * @brief Check if a state machine is enabled.
+ * @brief Decode edges - an epio_capture_fn_t for live decoding.
  *
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-
- * 1).
- * @return      1 if the SM is enabled, 0 otherwise.
+ * @param decoder   The decoder.
+ * @param edges     Edges, as captured by epio_capture_start().
+ * @param count     Number of edges.
+ * @see epio_decoder_feed()
  */
-EPIO_EXPORT uint8_t epio_is_sm_enabled(epio_t *epio, uint8_t block, uint8_t sm);
+EPIO_EXPORT void epio_decoder_capture(void *decoder, const epio_edge_t *edges, uint32_t count);
 
 /**
- * @brief Disable a state machine.
- * 
- * Marks the specified SM as disabled.  Disabled SMs are not advanced by
- * epio_step_cycles() and do not execute instructions until re-enabled.
- * 
- * @param epio  The epio instance.
- * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-
- * 1).
+ * @brief Complete decoding up to a cycle.
+ *
+ * A UART character's final bits are only decoded when a later edge is fed,
+ * as until then the line may change.  This decodes them, if they are before
+ * the given cycle - typically the cycle count at the end of the capture.
+ *
+ * @param decoder   The decoder.
+ * @param cycle     Cycle count up to which the levels are known.
  */
-EPIO_EXPORT void epio_disable_sm(epio_t *epio, uint8_t block, uint8_t sm);
-
-/** @} */
+EPIO_EXPORT void epio_decoder_flush(epio_decoder_t *decoder, uint64_t cycle);
 
 /**
- * @defgroup execution Execution API
- * @brief Functions for loading instructions and stepping execution.
- * @{
+ * @brief Free a decoder.
+ *
+ * @param decoder   The decoder.
  */
+EPIO_EXPORT void epio_decoder_free(epio_decoder_t *decoder);
+
+/** @} */
 
 /**
- * @brief Write a PIO instruction into the instruction memory of a block.
+ * @defgroup sigrok Sigrok Export API
+ * @brief Functions for writing captured GPIO edges to sigrok session files.
  *
- * @param epio      The epio instance.
- * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param instr_num Instruction slot (0 to NUM_INSTRS_PER_BLOCK-1).
- * @param instr     Encoded 16-bit PIO instruction.
- * @see epio_get_instr()
+ * A sigrok session (.sr) file can be opened in PulseView or sigrok-cli.  It
+ * is a ZIP archive holding a sample of every captured GPIO at every cycle,
+ * with the samplerate set to the emulated system clock frequency, so that
+ * each sample is one cycle.
+ *
+ * The samples are generated from the edges as they are written, and
+ * compressed as runs of repeated samples, so neither a per-cycle sample
+ * array nor a file of that size is created for long runs with sparse
+ * activity.  Edges are written in one or more batches, or live, by starting
+ * a capture with EPIO_CAPTURE_CALLBACK, passing epio_sigrok_capture() as the
+ * callback and the writer as its argument.
+ *
+ * As a ZIP32 archive, the file is limited to 4 GB, and 65535 files of 4 MB
+ * of samples each.
+ * @{
  */
-EPIO_EXPORT void epio_set_instr(epio_t *epio, uint8_t block, uint8_t instr_num, uint16_t instr);
+
+/** @brief Opaque sigrok session writer type. */
+typedef struct epio_sigrok_t epio_sigrok_t;
 
 /**
- * @brief Read a PIO instruction from the instruction memory of a block.
+ * @brief Create a sigrok session file.
  *
- * @param epio      The epio instance.
- * @param block     PIO block index (0 to NUM_PIO_BLOCKS-1).
- * @param instr_num Instruction slot (0 to NUM_INSTRS_PER_BLOCK-1).
- * @return          The encoded 16-bit PIO instruction at that slot.
- * @see epio_set_instr()
+ * Each GPIO in the mask is a channel, named GPIO<n>, in GPIO order.
+ *
+ * @param path          Path of the .sr file to write.
+ * @param mask          GPIOs to write (bit N = GPIO N) - normally the mask
+ *                      passed to epio_capture_start().
+ * @param samplerate    Samples per second - normally the emulated system
+ *                      clock frequency, from epio_get_sys_clock_hz().
+ * @return              The writer, or NULL if the file could not be
+ *                      created.
+ * @see epio_sigrok_close()
  */
-EPIO_EXPORT uint16_t epio_get_instr(epio_t *epio, uint8_t block, uint8_t instr_num);
+EPIO_EXPORT epio_sigrok_t *epio_sigrok_open(const char *path, uint64_t mask, uint32_t samplerate);
 
 /**
- * @brief Advance all enabled state machines by a number of clock cycles.
+ * @brief Write edges to a sigrok session file.
  *
- * Each enabled SM is stepped exactly @p cycles clock cycles.  SMs stalled
- * on a FIFO condition or IRQ consume cycles but make no forward progress.
- * The global cycle count is incremented by @p cycles after each call.
+ * Edges must be written in cycle order.  The first edge written gives the
+ * initial levels, and its cycle is the first sample.
  *
- * @param epio   The epio instance.
- * @param cycles Number of cycles to advance.
- * @see epio_get_cycle_count()
+ * @param sigrok    The writer.
+ * @param edges     Edges, as captured by epio_capture_start().
+ * @param count     Number of edges.
  */
-EPIO_EXPORT void epio_step_cycles(epio_t *epio, uint32_t cycles);
+EPIO_EXPORT void epio_sigrok_write(epio_sigrok_t *sigrok, const epio_edge_t *edges, uint32_t count);
 
 /**
- * @brief Return the total number of cycles executed since last reset.
+ * @brief Write edges to a sigrok session file - an epio_capture_fn_t for
+ * live export.
  *
- * @param epio  The epio instance.
- * @return      Total cycle count.
- * @see epio_reset_cycle_count()
+ * @param sigrok    The writer.
+ * @param edges     Edges, as captured by epio_capture_start().
+ * @param count     Number of edges.
+ * @see epio_sigrok_write()
  */
-EPIO_EXPORT uint64_t epio_get_cycle_count(epio_t *epio);
+EPIO_EXPORT void epio_sigrok_capture(void *sigrok, const epio_edge_t *edges, uint32_t count);
 
 /**
- * @brief Reset the cycle counter to zero.
+ * @brief Complete and close a sigrok session file, and free the writer.
  *
- * @param epio  The epio instance.
- * @see epio_get_cycle_count()
+ * The levels after the last edge are written up to and including the end
+ * cycle.  If no edges were written, the file has no samples.
+ *
+ * @param sigrok    The writer.
+ * @param end       Cycle of the last sample - normally the cycle count at
+ *                  the end of the capture, from epio_get_cycle_count().
+ *                  Must be no earlier than the last edge.
+ * @return          0 on success, -1 if any part of the file could not be
+ *                  written.
  */
-EPIO_EXPORT void epio_reset_cycle_count(epio_t *epio);
+EPIO_EXPORT int epio_sigrok_close(epio_sigrok_t *sigrok, uint64_t end);
 
 /** @} */
 
@@ -299,7 +2115,7 @@ EPIO_EXPORT int32_t epio_wait_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, i
  * @param epio  The epio instance.
  * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
  * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
- * @return      Number of entries currently in the TX FIFO (0 to MAX_FIFO_DEPTH).
+ * @return      Number of entries currently in the TX FIFO (0 to its capacity).
  */
 EPIO_EXPORT uint8_t epio_tx_fifo_depth(epio_t *epio, uint8_t block, uint8_t sm);
 
@@ -309,7 +2125,7 @@ EPIO_EXPORT uint8_t epio_tx_fifo_depth(epio_t *epio, uint8_t block, uint8_t sm);
  * @param epio  The epio instance.
  * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
  * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
- * @return      Number of entries currently in the RX FIFO (0 to MAX_FIFO_DEPTH).
+ * @return      Number of entries currently in the RX FIFO (0 to its capacity).
  */
 EPIO_EXPORT uint8_t epio_rx_fifo_depth(epio_t *epio, uint8_t block, uint8_t sm);
 
@@ -349,7 +2165,7 @@ EPIO_EXPORT uint32_t epio_pop_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm);
  * Adds @p value to the TX FIFO.  The SM will consume this via PULL
  * instructions.  The TX FIFO is written by the host and read by the SM.
  *
- * Asserts if the TX FIFO is full (i.e. has MAX_FIFO_DEPTH entries).
+ * Asserts if the TX FIFO is full (i.e. has epio_tx_fifo_capacity() entries).
  *
  * @param epio  The epio instance.
  * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
@@ -364,7 +2180,7 @@ EPIO_EXPORT void epio_push_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint
  * Allows the host to inject a value into the RX FIFO, simulating a DMA
  * write or other external data source.
  *
- * Asserts if the RX FIFO is full (i.e. has MAX_FIFO_DEPTH entries).
+ * Asserts if the RX FIFO is full (i.e. has epio_rx_fifo_capacity() entries).
  *
  * @param epio  The epio instance.
  * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
@@ -373,6 +2189,75 @@ EPIO_EXPORT void epio_push_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint
  */
 EPIO_EXPORT void epio_push_rx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint32_t value);
 
+/**
+ * @brief Return the number of entries the TX FIFO can hold.
+ *
+ * MAX_FIFO_DEPTH, unless the SM's SHIFTCTRL joins its FIFOs - then
+ * MAX_JOINED_FIFO_DEPTH with FJOIN_TX set, or 0 with FJOIN_RX set, when the
+ * TX FIFO is always both full and empty.
+ *
+ * Changing any of the SHIFTCTRL FJOIN bits with epio_set_sm_reg() flushes
+ * both FIFOs, as on hardware.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @return      Capacity of the TX FIFO.
+ * @see epio_rx_fifo_capacity()
+ */
+EPIO_EXPORT uint8_t epio_tx_fifo_capacity(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Return the number of entries the RX FIFO can hold.
+ *
+ * MAX_FIFO_DEPTH, unless the SM's SHIFTCTRL joins its FIFOs - then
+ * MAX_JOINED_FIFO_DEPTH with FJOIN_RX set, or 0 with FJOIN_TX, FJOIN_RX_PUT
+ * or FJOIN_RX_GET set.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @return      Capacity of the RX FIFO.
+ * @see epio_tx_fifo_capacity()
+ */
+EPIO_EXPORT uint8_t epio_rx_fifo_capacity(epio_t *epio, uint8_t block, uint8_t sm);
+
+/**
+ * @brief Read one of a state machine's RXF PUTGET registers.
+ *
+ * With SHIFTCTRL FJOIN_RX_PUT or FJOIN_RX_GET set, the RX FIFO's storage
+ * becomes NUM_RX_PUTGET registers, written by the SM with
+ * `mov rxfifo[], isr` and read with `mov osr, rxfifo[]`.  This is the host's
+ * view of them, as the RXFx_PUTGETy registers.
+ *
+ * Asserts if neither FJOIN_RX_PUT nor FJOIN_RX_GET is set.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param index Register index (0 to NUM_RX_PUTGET-1).
+ * @return      The register's value.
+ * @see epio_set_rx_putget()
+ */
+EPIO_EXPORT uint32_t epio_get_rx_putget(epio_t *epio, uint8_t block, uint8_t sm, uint8_t index);
+
+/**
+ * @brief Write one of a state machine's RXF PUTGET registers.
+ *
+ * Typically used with FJOIN_RX_GET set, to provide values the SM reads
+ * with `mov osr, rxfifo[]`.
+ *
+ * Asserts if neither FJOIN_RX_PUT nor FJOIN_RX_GET is set.
+ *
+ * @param epio  The epio instance.
+ * @param block PIO block index (0 to NUM_PIO_BLOCKS-1).
+ * @param sm    State machine index within the block (0 to NUM_SMS_PER_BLOCK-1).
+ * @param index Register index (0 to NUM_RX_PUTGET-1).
+ * @param value The value to write.
+ * @see epio_get_rx_putget()
+ */
+EPIO_EXPORT void epio_set_rx_putget(epio_t *epio, uint8_t block, uint8_t sm, uint8_t index, uint32_t value);
+
 /** @} */
 
 /**
@@ -727,6 +2612,43 @@ EPIO_EXPORT void epio_sram_write_halfword(epio_t *epio, uint32_t addr, uint16_t
  */
 EPIO_EXPORT void epio_sram_write_word(epio_t *epio, uint32_t addr, uint32_t value);
 
+/**
+ * @brief Return the number of emulated SRAM pages currently allocated.
+ *
+ * The emulated SRAM is sparse.  It is held as SRAM_PAGE_SIZE byte pages,
+ * each of which is only allocated when first written.  Pages which have
+ * never been written read as zero, and take no host memory.
+ *
+ * @param epio  The epio instance.
+ * @return      Number of resident SRAM pages.
+ */
+EPIO_EXPORT uint32_t epio_sram_resident_pages(epio_t *epio);
+
+/**
+ * @brief Return a writable pointer to an emulated SRAM page.
+ *
+ * Gives direct access to the SRAM_PAGE_SIZE bytes of the page containing
+ * @p addr, for reading or writing SRAM in bulk without a call per access -
+ * for example as a numpy array from Python.  The page is allocated if it
+ * has never been written, and is made private to this instance if shared
+ * with a template.
+ *
+ * The page is marked as written, for epio_state_hash() and history
+ * checkpoints, when this is called, so writes through the pointer are only
+ * seen by them if made before either is next taken.
+ *
+ * The pointer is only valid until the next step, epio_seek(),
+ * epio_step_back() or epio_reset(), or template or image operation on the
+ * instance - any of these may free the page, replace it, or share it so
+ * that it is copied on its next write.  Call this again after any of them,
+ * rather than keeping the pointer.
+ *
+ * @param epio  The epio instance.
+ * @param addr  Any SRAM address in the page.
+ * @return      Pointer to the start of the page.
+ */
+EPIO_EXPORT uint8_t *epio_sram_page(epio_t *epio, uint32_t addr);
+
 /** @} */
 
 /**
@@ -975,6 +2897,79 @@ EPIO_EXPORT uint32_t epio_peek_rx_fifo(epio_t *epio, uint8_t block, uint8_t sm,
  */
 EPIO_EXPORT uint32_t epio_peek_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint8_t entry);
 
+/**
+ * @brief Snapshot of a state machine's runtime state.
+ *
+ * Filled by epio_peek_sms(), to read the state of every SM in a single
+ * call, rather than one field at a time with the other peek functions.
+ */
+typedef struct {
+    /** X register. */
+    uint32_t x;
+    /** Y register. */
+    uint32_t y;
+    /** Input Shift Register. */
+    uint32_t isr;
+    /** Output Shift Register. */
+    uint32_t osr;
+    /** TX FIFO entries (MAX_JOINED_FIFO_DEPTH), 0 being the next to be
+     * popped.  Only the first tx_fifo_count are valid. */
+    uint32_t tx_fifo[8];
+    /** RX FIFO entries (MAX_JOINED_FIFO_DEPTH), 0 being the next to be
+     * popped.  Only the first rx_fifo_count are valid. */
+    uint32_t rx_fifo[8];
+    /** Instruction to be executed by a pending exec. */
+    uint16_t exec_instr;
+    /** Program counter. */
+    uint8_t pc;
+    /** Number of bits in the ISR. */
+    uint8_t isr_count;
+    /** Number of bits shifted out of the OSR. */
+    uint8_t osr_count;
+    /** Number of entries in the TX FIFO. */
+    uint8_t tx_fifo_count;
+    /** Number of entries in the RX FIFO. */
+    uint8_t rx_fifo_count;
+    /** 1 if the SM is enabled. */
+    uint8_t enabled;
+    /** 1 if the SM is stalled. */
+    uint8_t stalled;
+    /** Delay cycles remaining. */
+    uint8_t delay;
+    /** 1 if an exec is pending. */
+    uint8_t exec_pending;
+} epio_sm_snapshot_t;
+
+/**
+ * @brief Get a snapshot of every state machine's runtime state.
+ *
+ * @param epio      The epio instance.
+ * @param snapshots Array of NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK snapshots to
+ *                  fill, in block then SM order.
+ */
+EPIO_EXPORT void epio_peek_sms(epio_t *epio, epio_sm_snapshot_t *snapshots);
+
+/**
+ * @brief Get a hash of the complete emulated state.
+ *
+ * Covers all SM, FIFO, IRQ, GPIO and DMA state, instruction memory and SRAM,
+ * but not the cycle count, so that a state revisited at a later cycle hashes
+ * the same.  An SRAM page which has been written with zeros hashes the same
+ * as one which has never been written.
+ *
+ * Use this for golden-run checks, deduplicating states and detecting loops,
+ * rather than peeking individual fields.  The cost is independent of how
+ * long the instance has run - SRAM page hashes are cached, and only pages
+ * written since the previous call are rehashed.
+ *
+ * The hash is not stable across epio versions or hosts with different data
+ * layouts.
+ *
+ * @param epio  The epio instance.
+ * @return      64-bit hash of the instance's state.
+ */
+EPIO_EXPORT uint64_t epio_state_hash(epio_t *epio);
+
 /** @} */
 
 /**
@@ -1009,6 +3004,165 @@ EPIO_EXPORT void epio_clear_block_irq(epio_t *epio, uint8_t block, uint8_t irq_n
 
 /** @} */
 
+/**
+ * @defgroup template Template API
+ * @brief Functions for cheaply creating many identically configured
+ * instances.
+ *
+ * A template captures the complete machine state of a configured instance,
+ * including instruction memory, SM registers and FIFOs, GPIO and DMA state,
+ * and SRAM contents.  Instances are created from it with a single copy of the
+ * machine state, rather than by replaying the configuration.
+ *
+ * SRAM pages are shared read-only between a template and the instances
+ * created from it.  An instance takes a private copy of a shared page the
+ * first time it writes to it.  A template must therefore not be freed until
+ * all instances created from it have been freed.
+ * @{
+ */
+
+/**
+ * @brief Create a template from an existing epio instance.
+ *
+ * Captures the current state of @p epio, which is not modified and may
+ * continue to be used, or freed, independently of the template.
+ *
+ * @param epio  The epio instance to capture.
+ * @return      Pointer to the new template, or NULL on allocation failure.
+ * @see epio_from_template(), epio_template_free()
+ */
+EPIO_EXPORT epio_template_t *epio_template_from_epio(epio_t *epio);
+
+/**
+ * @brief Create a new epio instance from a template.
+ *
+ * The instance starts in exactly the state captured by the template.
+ *
+ * @param tmpl  The template.
+ * @return      Pointer to the new epio instance, or NULL on allocation
+ *              failure.
+ * @see epio_from_template_in(), epio_free()
+ */
+EPIO_EXPORT epio_t *epio_from_template(const epio_template_t *tmpl);
+
+/**
+ * @brief Create a new epio instance from a template in caller-provided
+ * memory.
+ *
+ * As epio_from_template(), but the instance is placed in @p mem, as
+ * epio_init_in().
+ *
+ * @param tmpl  The template.
+ * @param mem   Memory in which to place the instance.
+ * @param size  Size of @p mem in bytes.  Must be at least epio_sizeof().
+ * @return      Pointer to the new epio instance, which is at @p mem.
+ * @see epio_from_template(), epio_init_in()
+ */
+EPIO_EXPORT epio_t *epio_from_template_in(const epio_template_t *tmpl, void *mem, size_t size);
+
+/**
+ * @brief Free a template.
+ *
+ * @param tmpl  The template to free.  All instances created from it must
+ *              have been freed first.
+ */
+EPIO_EXPORT void epio_template_free(epio_template_t *tmpl);
+
+/** @} */
+
+/**
+ * @defgroup image Image API
+ * @brief Functions for saving an instance's complete state to a file, and
+ * loading it again.
+ *
+ * An image holds the complete machine state - instruction memory, SM
+ * registers, runtime state and debug information, FIFOs, IRQs, GPIO and DMA
+ * state - plus every resident SRAM page.  It can be used to perform a long
+ * warm-up once, and start every subsequent test from its end state.
+ *
+ * Images are versioned, and are only loadable by a host with the same data
+ * layout, and the same epio image version, as the host which saved them.
+ * @{
+ */
+
+/**
+ * @brief Save the complete state of an epio instance to an image file.
+ *
+ * @param epio  The epio instance.  Not modified.
+ * @param path  Path of the image file to create or overwrite.
+ * @return      0 on success, -1 if the file could not be written.
+ * @see epio_load_image()
+ */
+EPIO_EXPORT int epio_save_image(epio_t *epio, const char *path);
+
+/**
+ * @brief Create a new epio instance from an image file.
+ *
+ * The file is mapped into memory, and its SRAM pages are used in place,
+ * copy-on-write, so loading is fast regardless of how much SRAM the image
+ * holds.  The file must not be modified until the instance has been freed.
+ *
+ * @param path  Path of an image file, from epio_save_image().
+ * @return      Pointer to the new epio instance, or NULL if the file could
+ *              not be read, or is not a valid image for this host.
+ * @see epio_save_image(), epio_free()
+ */
+EPIO_EXPORT epio_t *epio_load_image(const char *path);
+
+/** @} */
+
+/**
+ * @defgroup desc Description API
+ * @brief Functions for creating an instance from a program description file.
+ *
+ * A description is a text file which configures a new instance without a C
+ * harness or apio, for example for the epio-run tool.  Each line is a
+ * directive followed by its arguments, which are numbers in decimal, hex
+ * (0x) or octal (0).  Anything after a # is a comment.  Directives are
+ * applied in order, to an instance fresh from epio_init():
+ *
+ * - @c sysclk @e hz - set the system clock.
+ * - @c gpiobase @e block @e base - set a block's GPIOBASE, 0 or 16.
+ * - @c instr @e block @e slot @e instr... - write consecutive instructions,
+ *   starting at @e slot.
+ * - @c sm @e block @e sm @e clkdiv @e execctrl @e shiftctrl @e pinctrl -
+ *   set an SM's registers.  shiftctrl may not set both FIFO joins, or a
+ *   join with RX FIFO PUT/GET.
+ * - @c exec @e block @e sm @e instr - execute an instruction on an SM
+ *   immediately, for example a JMP to its start.  Reserved encodings, and
+ *   MOV to or from the RX FIFO registers without the matching join, are
+ *   errors.
+ * - @c tx / @c rx @e block @e sm @e value - push a value to a FIFO.
+ * - @c enable @e block @e sm - enable an SM.
+ * - @c output @e gpio @e block - give a block output control of a GPIO.
+ * - @c invert, @c force-low, @c force-high @e gpio - invert or force a
+ *   GPIO's input.
+ * - @c drive @e mask @e levels - drive GPIOs externally.
+ * - @c dma @e chan @e read_block @e read_sm @e read_cycles @e write_block
+ *   @e write_sm @e write_cycles @e bits - set up a DMA chain, as
+ *   epio_dma_setup_read_pio_chain().
+ * - @c sram @e addr @e byte... - write bytes to SRAM.
+ * - @c sram-file @e addr @e path - write a file's contents to SRAM.
+ * @{
+ */
+
+/**
+ * @brief Create a new epio instance from a program description file.
+ *
+ * @param path          Path of the description file.
+ * @param error_line    If not NULL, set to the number of the first line
+ *                      which could not be applied, or 0 if the file could
+ *                      not be read.  Lines are numbered from 1.
+ * @return              Pointer to the new epio instance, or NULL if the file
+ *                      could not be read, or a directive is unknown, has the
+ *                      wrong number of arguments, or an argument is out of
+ *                      range.
+ * @see epio_free()
+ */
+EPIO_EXPORT epio_t *epio_load_desc(const char *path, uint32_t *error_line);
+
+/** @} */
+
 /**
  * @defgroup apio apio Integration API
  * @brief Functions for creating an epio instance from apio state.
@@ -1029,6 +3183,51 @@ EPIO_EXPORT void epio_clear_block_irq(epio_t *epio, uint8_t block, uint8_t irq_n
  */
 EPIO_EXPORT epio_t *epio_from_apio(void);
 
+/**
+ * @brief Capture the current apio state into a context.
+ *
+ * Copies the PIO program, SM configuration, and GPIO state assembled by
+ * apio into @p ctx.  This is the only step which reads apio's globals, so
+ * when configuring from several threads, only the apio setup code and this
+ * call need to be serialised.  Instances can then be created from the
+ * context concurrently, with epio_from_apio_ctx().
+ *
+ * Only available when APIO_EMULATION is defined (i.e. on non-RP2350 hosts).
+ *
+ * @param ctx   Context to populate.
+ * @see epio_from_apio_ctx()
+ */
+EPIO_EXPORT void epio_apio_ctx_capture(epio_apio_ctx_t *ctx);
+
+/**
+ * @brief Create an epio instance configured from a captured apio state.
+ *
+ * As epio_from_apio(), but reads the configuration from @p ctx rather than
+ * apio's globals, so is safe to call concurrently with other epio calls and
+ * with apio building a new configuration.  The context is not modified, and
+ * may be used to create any number of instances.
+ *
+ * @param ctx   Captured apio state, from epio_apio_ctx_capture().
+ * @return      Pointer to the configured epio instance, or NULL on failure.
+ * @see epio_apio_ctx_capture(), epio_from_apio()
+ */
+EPIO_EXPORT epio_t *epio_from_apio_ctx(const epio_apio_ctx_t *ctx);
+
+/**
+ * @brief Create a template configured from the current apio state.
+ *
+ * Equivalent to calling epio_template_from_epio() on the result of
+ * epio_from_apio(), but without leaving an intermediate instance behind.
+ * Use this to configure from apio once, and then create many instances with
+ * epio_from_template(), rather than calling epio_from_apio() repeatedly.
+ *
+ * Only available when APIO_EMULATION is defined (i.e. on non-RP2350 hosts).
+ *
+ * @return Pointer to the new template, or NULL on failure.
+ * @see epio_from_template(), epio_template_free()
+ */
+EPIO_EXPORT epio_template_t *epio_template_from_apio(void);
+
 /** @} */
 
 /**
@@ -1064,9 +3263,15 @@ _Static_assert(NUM_GPIOS == APIO_MAX_GPIOS, "NUM_GPIOS must match APIO_MAX_GPIOS
 /** @brief Number of state machines per PIO block. */
 #define NUM_SMS_PER_BLOCK       4
 
-/** @brief Maximum TX/RX FIFO depth per state machine. */
+/** @brief TX/RX FIFO depth per state machine, when its FIFOs are not joined. */
 #define MAX_FIFO_DEPTH          4
 
+/** @brief Depth of a FIFO joined with the other, by SHIFTCTRL FJOIN_TX or FJOIN_RX. */
+#define MAX_JOINED_FIFO_DEPTH   8
+
+/** @brief Number of RXF PUTGET registers per state machine. */
+#define NUM_RX_PUTGET           4
+
 /** @brief Number of DMA channels. */
 #define NUM_DMA_CHANNELS        16
 
@@ -1076,4 +3281,10 @@ _Static_assert(NUM_GPIOS == APIO_MAX_GPIOS, "NUM_GPIOS must match APIO_MAX_GPIOS
 /** @brief Number of instruction slots per PIO block. */
 #define NUM_INSTRS_PER_BLOCK    32
 
+/** @brief Size of each lazily allocated page of emulated SRAM, in bytes. */
+#define SRAM_PAGE_SIZE          4096
+
+/** @brief Default emulated system clock frequency, in Hz. */
+#define EPIO_DEFAULT_SYS_CLOCK_HZ   150000000
+
 #endif // EPIO_H
\ No newline at end of file
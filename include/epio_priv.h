@@ -30,18 +30,43 @@
 #define EPIO_DBG(...)   do {} while (0)
 #endif // EPIO_DEBUG
 
-// FIFO state for a single SM
+#define SRAM_SIZE           520*1024
+#define MIN_SRAM_ADDR       0x20000000
+#define MAX_SRAM_ADDR       (MIN_SRAM_ADDR + SRAM_SIZE - 1)
+#define SRAM_NUM_PAGES      ((SRAM_SIZE) / SRAM_PAGE_SIZE)
+#define SRAM_SHARED_WORDS   ((SRAM_NUM_PAGES + 31) / 32)
+_Static_assert((SRAM_SIZE) % SRAM_PAGE_SIZE == 0, "SRAM_SIZE must be a multiple of SRAM_PAGE_SIZE");
+
+// FIFO state for a single SM.  Each FIFO is a ring, whose entries are
+// head to head + count - 1, masked by FIFO_MASK.
+//
+// Each ring has room for a joined FIFO, and its capacity is set from the
+// SHIFTCTRL FJOIN bits - 0 for a FIFO disabled by a join.  With FJOIN_RX_PUT
+// or FJOIN_RX_GET set, the first NUM_RX_PUTGET entries of rx_fifo are the
+// RXF PUTGET registers instead.
 typedef struct {
-    uint32_t tx_fifo[MAX_FIFO_DEPTH];
-    uint32_t rx_fifo[MAX_FIFO_DEPTH];
+    uint32_t tx_fifo[MAX_JOINED_FIFO_DEPTH];
+    uint32_t rx_fifo[MAX_JOINED_FIFO_DEPTH];
     uint8_t tx_fifo_count;
     uint8_t rx_fifo_count;
+    uint8_t tx_fifo_head;
+    uint8_t rx_fifo_head;
+    uint8_t tx_fifo_capacity;
+    uint8_t rx_fifo_capacity;
+
+    // Explicit padding, so the state has none - see epio_hash.c
+    uint8_t pad[2];
 } epio_fifo_state_t;
 
+#define FIFO_MASK           (MAX_JOINED_FIFO_DEPTH - 1)
+_Static_assert((MAX_JOINED_FIFO_DEPTH & FIFO_MASK) == 0, "MAX_JOINED_FIFO_DEPTH must be a power of two");
+_Static_assert(NUM_RX_PUTGET <= MAX_JOINED_FIFO_DEPTH, "RXF PUTGET registers must fit in the RX FIFO");
+
 // State of an individual PIO state machine
 typedef struct {
     // Debug information about this SM
     epio_sm_debug_t debug;
+    uint8_t pad_debug;
 
     // PIO SM registers
     epio_sm_reg_t reg;
@@ -81,9 +106,11 @@ typedef struct {
     // Whether we have a pending EXEC instruction from an OUT EXEC that should
     // be executed next
     uint8_t exec_pending;
+    uint8_t pad_exec;
 
     // If exec_pending is set, this instruction should be executed next
     uint16_t exec_instr;
+    uint8_t pad_fifo[2];
 
     // FIFO state of this state machine
     epio_fifo_state_t fifo;
@@ -103,6 +130,7 @@ typedef struct {
     uint8_t read_delay;
     uint8_t write_delay;
     uint8_t bit_mode;
+    uint8_t pad[2];
     uint32_t read_addr;
     uint32_t read_value;
 } epio_dma_state_t;
@@ -161,6 +189,37 @@ typedef struct {
     uint16_t instr[NUM_INSTRS_PER_BLOCK];
 } epio_block_state_t;
 
+// Reverse execution history - see epio_history.c
+typedef struct epio_history_t epio_history_t;
+
+// VCD trace writer - see epio_trace.c
+typedef struct epio_trace_t epio_trace_t;
+
+// In-memory event recorder - see epio_recorder.c
+typedef struct epio_recorder_t epio_recorder_t;
+
+// GPIO edge capture - see epio_capture.c
+typedef struct epio_capture_t epio_capture_t;
+
+// Attached device models - see epio_device.c
+typedef struct epio_devices_t epio_devices_t;
+
+// Registered timing checks - see epio_check.c
+typedef struct epio_checks_t epio_checks_t;
+
+// Scheduled host actions - see epio_schedule.c
+typedef struct epio_schedule_t epio_schedule_t;
+
+// Attached FIFO streams - see epio_stream.c
+typedef struct epio_streams_t epio_streams_t;
+
+// FIFO statistics - see epio_fifo_stats.c
+typedef struct epio_fifo_counters_t epio_fifo_counters_t;
+
+// The emulated machine state (GPIOs, PIO blocks, DMA and cycle count) is
+// kept at the start of this struct, before the SRAM page table.  It is plain
+// data, with no pointers, so can be zeroed or copied as a single block - see
+// EPIO_MACHINE_STATE_SIZE.
 struct epio_t {
     // State of the GPIOs
     epio_gpio_state_t gpio;
@@ -171,33 +230,170 @@ struct epio_t {
     // State of each DMA channel
     epio_dma_state_t dma[NUM_DMA_CHANNELS];
 
-    // Number of cycles that have elapsed since the last reset
+    // System clock frequency, used to convert between cycles and real time
+    uint32_t sys_clock_hz;
+    uint32_t pad;
+
+    // Number of cycles that have elapsed since the last reset.  Must remain
+    // the last field of the machine state, as it is excluded from the state
+    // hash - see EPIO_HASHED_STATE_SIZE.
     uint64_t cycle_count;
 
-    // SRAM
-    uint8_t *sram;
+    // SRAM, as a table of SRAM_PAGE_SIZE pages.  Pages are allocated on
+    // first write - a NULL entry has never been written, and reads as zero.
+    uint8_t *sram_page[SRAM_NUM_PAGES];
+
+    // Number of non-NULL entries in sram_page
+    uint32_t sram_resident_pages;
+
+    // Which entries in sram_page are shared with a template, so are read-only
+    // and not owned by this instance.  Page 0 = LSB of word 0.
+    uint32_t sram_shared[SRAM_SHARED_WORDS];
+
+    // Cached hash of each SRAM page, and the XOR of the cached hashes of all
+    // pages which are not dirty.  A page is dirty if it may have changed
+    // since its hash was cached.  Unwritten and all-zero pages hash to 0.
+    uint64_t sram_page_hash[SRAM_NUM_PAGES];
+    uint32_t sram_dirty[SRAM_SHARED_WORDS];
+    uint64_t sram_hash;
+
+    // Total number of SRAM writes, and which pages have been written since
+    // the last history checkpoint
+    uint64_t sram_writes;
+    uint32_t sram_ckpt_dirty[SRAM_SHARED_WORDS];
+
+    // Whether this instance was allocated by epio_init(), rather than placed
+    // in caller memory by epio_init_in(), so should be freed by epio_free()
+    uint8_t allocated;
+
+    // If loaded by epio_load_image(), the mapped image file.  Any SRAM pages
+    // in it are mapped into sram_page as shared.
+    void *image;
+    size_t image_size;
+
+    // Reverse execution history, if enabled by epio_history_enable()
+    epio_history_t *history;
+
+    // GPIO stimulus being played, if attached by epio_stimulus_attach()
+    epio_stimulus_t *stimulus;
+
+    // VCD trace being written, if started by epio_trace_start()
+    epio_trace_t *trace;
+
+    // Event recorder, if enabled by epio_recorder_enable()
+    epio_recorder_t *recorder;
+
+    // GPIO edge capture, if started by epio_capture_start()
+    epio_capture_t *capture;
+
+    // Device models, if any are attached by epio_device_attach()
+    epio_devices_t *devices;
+
+    // Timing checks, if any are registered by the epio_check_*() functions
+    epio_checks_t *checks;
+
+    // Scheduled host actions, if any are scheduled by epio_schedule_at()
+    epio_schedule_t *schedule;
+
+    // FIFO streams, if any are attached by the epio_stream_*() functions
+    epio_streams_t *streams;
+
+    // FIFO statistics, if enabled by epio_fifo_stats_enable()
+    epio_fifo_counters_t *fifo_counters;
+
+    // FIFO events of each SM since they were last consumed - see
+    // SM_EVENT_*.  Not part of the machine state.
+    uint8_t sm_events[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+};
+
+// Size of the plain machine state at the start of epio_t
+#define EPIO_MACHINE_STATE_SIZE offsetof(epio_t, sram_page)
+
+// Size of the part of the machine state included in the state hash -
+// everything except the cycle count
+#define EPIO_HASHED_STATE_SIZE  offsetof(epio_t, cycle_count)
+
+// A template is an instance which is never run, and whose SRAM pages are
+// shared with every instance created from it
+struct epio_template_t {
+    epio_t epio;
 };
 
 // Function prototypes
 
+// epio.c
+epio_t *epio_place_in(void *mem, size_t size);
+epio_t *epio_alloc(void);
+
+// epio_fifo.c
+void epio_fifo_configure(epio_t *epio, uint8_t block, uint8_t sm);
+
 // epio_exec.c
 uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t instr);
+void epio_run_cycles(epio_t *epio, uint32_t cycles);
+void epio_run_recorded(epio_t *epio, uint32_t cycles);
 
 // epio_sram.c
-uint8_t *epio_sram_init(epio_t *epio);
+void epio_sram_init(epio_t *epio);
+void epio_sram_zero(epio_t *epio);
 void epio_sram_free(epio_t *epio);
+void epio_sram_copy_pages(epio_t *dst, const epio_t *src);
+void epio_sram_share_pages(epio_t *dst, const epio_t *src);
+void epio_sram_map_shared_page(epio_t *epio, uint32_t page_num, const uint8_t *page);
+uint64_t epio_sram_hash(epio_t *epio);
+void epio_sram_restore_page(epio_t *epio, uint32_t page_num, const uint8_t *data);
+
+// epio_history.c
+void epio_history_step(epio_t *epio, uint32_t cycles);
+
+// epio_stimulus.c
+uint64_t epio_stimulus_next_cycle(epio_t *epio);
+void epio_stimulus_apply(epio_t *epio);
+
+// epio_trace.c
+void epio_trace_sample(epio_t *epio);
+
+// epio_recorder.c
+void epio_recorder_sample(epio_t *epio);
+void epio_recorder_fifo(epio_t *epio, uint8_t type, uint8_t block, uint8_t sm, uint32_t value);
+
+// epio_capture.c
+void epio_capture_sample(epio_t *epio);
+
+// epio_device.c
+void epio_devices_step(epio_t *epio);
+void epio_devices_free(epio_t *epio);
+
+// epio_check.c
+void epio_checks_step(epio_t *epio);
+
+// epio_schedule.c
+uint64_t epio_schedule_next_cycle(epio_t *epio);
+void epio_schedule_apply(epio_t *epio);
+
+// epio_stream.c
+void epio_streams_step(epio_t *epio);
+void epio_streams_free(epio_t *epio);
+
+// epio_fifo_stats.c
+void epio_fifo_stats_step(epio_t *epio);
+void epio_fifo_stats_level(epio_t *epio, uint8_t block, uint8_t sm, uint8_t tx, uint8_t level);
+
+// epio_hash.c
+uint64_t epio_hash_data(const void *data, size_t len, uint64_t seed);
+
+// epio_image.c
+void epio_image_release(epio_t *epio);
 
 // epio_gpio.c
 uint8_t epio_get_jmp_pin_state(epio_t *epio, uint8_t block, uint8_t sm);
+void epio_drive_gpios_masked(epio_t *epio, uint64_t mask, uint64_t gpios, uint64_t level);
+uint64_t epio_gpio_levels(epio_t *epio);
 
 // epio_dma.c
 void epio_init_dma(epio_t *epio);
 void epio_dma_step(epio_t *epio);
 
-#define SRAM_SIZE           520*1024
-#define MIN_SRAM_ADDR       0x20000000
-#define MAX_SRAM_ADDR       (MIN_SRAM_ADDR + SRAM_SIZE - 1)
-
 #define CHECK_IRQ() \
     assert((block) < NUM_PIO_BLOCKS && "Invalid IRQ block"); \
     assert((irq_num) < NUM_IRQS_PER_BLOCK && "Invalid IRQ index")
@@ -213,11 +409,16 @@ void epio_dma_step(epio_t *epio);
     assert((ADDR <= MAX_SRAM_ADDR) && "Address above maximum SRAM address")
 #define CHECK_SRAM_ALIGN(ADDR, ALIGN) \
     assert(((ADDR - MIN_SRAM_ADDR) % (ALIGN)) == 0 && "Address not aligned to required boundary")
+#define SRAM_PAGE_IS_SHARED(EPIO, PAGE) \
+    (((EPIO)->sram_shared[(PAGE) / 32] >> ((PAGE) % 32)) & 1)
 #define CHECK_GPIO(PIN) \
     assert((PIN) < NUM_GPIOS && "Invalid GPIO pin")
 #define CHECK_GPIO_MASK(GPIO) \
     assert(((GPIO & (0xFFFFFFFFFFFFFFFFULL << NUM_GPIOS)) == 0) && "Invalid GPIO bit(s) set")
 
+// All valid GPIOs, GPIO0 = LSB
+#define GPIO_ALL_MASK       ((1ULL << NUM_GPIOS) - 1)
+
 #define BLK(BLOCK)           epio->block[BLOCK]
 #define SM(BLOCK, _SM)       epio->block[BLOCK].sm[_SM]
 #define PC(BLOCK, _SM)       SM(BLOCK, _SM).pc
@@ -228,6 +429,25 @@ void epio_dma_step(epio_t *epio);
 #define GPIOBASE(BLOCK)      epio->block[BLOCK].gpio_base
 #define REG(BLOCK, _SM)      SM(BLOCK, _SM).reg
 #define FIFO(BLOCK, _SM)     SM(BLOCK, _SM).fifo
+#define SM_EVENTS(BLOCK, _SM) epio->sm_events[BLOCK][_SM]
+
+// FIFO levels, and entries, entry 0 being the next to be popped
+#define TX_FIFO_LEVEL(BLOCK, _SM)   FIFO(BLOCK, _SM).tx_fifo_count
+#define RX_FIFO_LEVEL(BLOCK, _SM)   FIFO(BLOCK, _SM).rx_fifo_count
+#define TX_FIFO_ENTRY(BLOCK, _SM, N) \
+    FIFO(BLOCK, _SM).tx_fifo[(FIFO(BLOCK, _SM).tx_fifo_head + (N)) & FIFO_MASK]
+#define RX_FIFO_ENTRY(BLOCK, _SM, N) \
+    FIFO(BLOCK, _SM).rx_fifo[(FIFO(BLOCK, _SM).rx_fifo_head + (N)) & FIFO_MASK]
+
+// FIFO capacities, depending on any join, and the RXF PUTGET registers
+#define TX_FIFO_CAPACITY(BLOCK, _SM) FIFO(BLOCK, _SM).tx_fifo_capacity
+#define RX_FIFO_CAPACITY(BLOCK, _SM) FIFO(BLOCK, _SM).rx_fifo_capacity
+#define RX_PUTGET(BLOCK, _SM, N)     FIFO(BLOCK, _SM).rx_fifo[N]
+
+// SM FIFO events, in sm_events
+#define SM_EVENT_TX_STALL    (1 << 0)   // Stalled on an empty TX FIFO
+#define SM_EVENT_RX_STALL    (1 << 1)   // Stalled on a full RX FIFO
+#define SM_EVENT_RX_LOST     (1 << 2)   // Non-blocking PUSH to a full RX FIFO
 
 // EXECCTRL register fields
 #define JMP_PIN_GET(BLOCK, _SM) \
@@ -257,6 +477,16 @@ void epio_dma_step(epio_t *epio);
     _THRESH_CONVERT(((REG(BLOCK, _SM).shiftctrl >> 20) & 0x1F))
 #define PULL_THRESH_GET(BLOCK, _SM) \
     _THRESH_CONVERT(((REG(BLOCK, _SM).shiftctrl >> 25) & 0x1F))
+#define SHIFTCTRL_FJOIN_RX      (1U << 31)
+#define SHIFTCTRL_FJOIN_TX      (1U << 30)
+#define SHIFTCTRL_FJOIN_RX_PUT  (1U << 15)
+#define SHIFTCTRL_FJOIN_RX_GET  (1U << 14)
+#define SHIFTCTRL_FJOIN_MASK \
+    (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX | SHIFTCTRL_FJOIN_RX_PUT | SHIFTCTRL_FJOIN_RX_GET)
+#define FJOIN_RX_PUT_GET(BLOCK, _SM) \
+    ((REG(BLOCK, _SM).shiftctrl >> 15) & 0x1)
+#define FJOIN_RX_GET_GET(BLOCK, _SM) \
+    ((REG(BLOCK, _SM).shiftctrl >> 14) & 0x1)
 
 // PINCTRL register fields
 #define IN_BASE_GET(BLOCK, _SM) \
@@ -369,3 +599,68 @@ void epio_dma_step(epio_t *epio);
 #define SET_DEST_X          0b001
 #define SET_DEST_Y          0b010
 #define SET_DEST_PIN_DIRS   0b100
+
+// FIFO accessors for the exec, DMA and stream paths.  Unlike the public
+// epio_push_*_fifo() and epio_pop_*_fifo() functions, these don't check
+// their arguments, or whether the FIFO is full or empty - the caller must
+// already have.
+//
+// Popped entries are cleared, and an emptied ring restarts at entry 0, so
+// equivalent states are more often identical, and so hash the same.
+//
+// FIFO statistics are told of each FIFO's new level before it changes.
+static inline uint32_t epio_fifo_pop_tx(epio_t *epio, uint8_t block, uint8_t sm) {
+    epio_fifo_state_t *fifo = &FIFO(block, sm);
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_level(epio, block, sm, 1, fifo->tx_fifo_count - 1);
+    }
+    uint32_t value = fifo->tx_fifo[fifo->tx_fifo_head];
+    fifo->tx_fifo[fifo->tx_fifo_head] = 0;
+    fifo->tx_fifo_head = (fifo->tx_fifo_head + 1) & FIFO_MASK;
+    if (--fifo->tx_fifo_count == 0) {
+        fifo->tx_fifo_head = 0;
+    }
+    if (epio->recorder != NULL) {
+        epio_recorder_fifo(epio, EPIO_EVENT_TX_POP, block, sm, value);
+    }
+    return value;
+}
+
+static inline uint32_t epio_fifo_pop_rx(epio_t *epio, uint8_t block, uint8_t sm) {
+    epio_fifo_state_t *fifo = &FIFO(block, sm);
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_level(epio, block, sm, 0, fifo->rx_fifo_count - 1);
+    }
+    uint32_t value = fifo->rx_fifo[fifo->rx_fifo_head];
+    fifo->rx_fifo[fifo->rx_fifo_head] = 0;
+    fifo->rx_fifo_head = (fifo->rx_fifo_head + 1) & FIFO_MASK;
+    if (--fifo->rx_fifo_count == 0) {
+        fifo->rx_fifo_head = 0;
+    }
+    if (epio->recorder != NULL) {
+        epio_recorder_fifo(epio, EPIO_EVENT_RX_POP, block, sm, value);
+    }
+    return value;
+}
+
+static inline void epio_fifo_push_tx(epio_t *epio, uint8_t block, uint8_t sm, uint32_t value) {
+    epio_fifo_state_t *fifo = &FIFO(block, sm);
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_level(epio, block, sm, 1, fifo->tx_fifo_count + 1);
+    }
+    fifo->tx_fifo[(fifo->tx_fifo_head + fifo->tx_fifo_count++) & FIFO_MASK] = value;
+    if (epio->recorder != NULL) {
+        epio_recorder_fifo(epio, EPIO_EVENT_TX_PUSH, block, sm, value);
+    }
+}
+
+static inline void epio_fifo_push_rx(epio_t *epio, uint8_t block, uint8_t sm, uint32_t value) {
+    epio_fifo_state_t *fifo = &FIFO(block, sm);
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_level(epio, block, sm, 0, fifo->rx_fifo_count + 1);
+    }
+    fifo->rx_fifo[(fifo->rx_fifo_head + fifo->rx_fifo_count++) & FIFO_MASK] = value;
+    if (epio->recorder != NULL) {
+        epio_recorder_fifo(epio, EPIO_EVENT_RX_PUSH, block, sm, value);
+    }
+}
@@ -0,0 +1,231 @@
+# Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+#
+# MIT License
+
+# epio - A PIO emulator
+#
+# Python bindings for libepio.so, built with `make shared`.
+#
+# State is read in bulk into numpy arrays, rather than one field per call.
+# SRAM pages and captured edges are numpy views of epio's own memory, so
+# reading them involves no copies.  SRAM is written with sram_set().  Calls into libepio release
+# the GIL, so instances stepped from different threads run in parallel.
+
+import ctypes
+import os
+
+import numpy as np
+
+NUM_GPIOS = 48
+NUM_PIO_BLOCKS = 3
+NUM_SMS_PER_BLOCK = 4
+MAX_FIFO_DEPTH = 4
+MAX_JOINED_FIFO_DEPTH = 8
+SRAM_PAGE_SIZE = 4096
+
+CAPTURE_STOP = 0
+CAPTURE_WRAP = 1
+
+# Matches epio_sm_snapshot_t
+SM_SNAPSHOT_DTYPE = np.dtype([
+    ('x', '<u4'),
+    ('y', '<u4'),
+    ('isr', '<u4'),
+    ('osr', '<u4'),
+    ('tx_fifo', '<u4', (MAX_JOINED_FIFO_DEPTH,)),
+    ('rx_fifo', '<u4', (MAX_JOINED_FIFO_DEPTH,)),
+    ('exec_instr', '<u2'),
+    ('pc', 'u1'),
+    ('isr_count', 'u1'),
+    ('osr_count', 'u1'),
+    ('tx_fifo_count', 'u1'),
+    ('rx_fifo_count', 'u1'),
+    ('enabled', 'u1'),
+    ('stalled', 'u1'),
+    ('delay', 'u1'),
+    ('exec_pending', 'u1'),
+], align=True)
+
+# Matches epio_edge_t
+EDGE_DTYPE = np.dtype([
+    ('cycle', '<u8'),
+    ('changed', '<u8'),
+    ('value', '<u8'),
+], align=True)
+
+
+class SmReg(ctypes.Structure):
+    """Matches epio_sm_reg_t."""
+    _fields_ = [
+        ('clkdiv', ctypes.c_uint32),
+        ('execctrl', ctypes.c_uint32),
+        ('shiftctrl', ctypes.c_uint32),
+        ('pinctrl', ctypes.c_uint32),
+    ]
+
+
+def _load():
+    path = os.environ.get('EPIO_LIB')
+    if path is None:
+        path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            '..', 'build', 'libepio.so')
+    lib = ctypes.CDLL(path)
+
+    p = ctypes.c_void_p
+    u8 = ctypes.c_uint8
+    u16 = ctypes.c_uint16
+    u32 = ctypes.c_uint32
+    u64 = ctypes.c_uint64
+    protos = {
+        'epio_init': (p, []),
+        'epio_free': (None, [p]),
+        'epio_reset': (None, [p]),
+        'epio_set_instr': (None, [p, u8, u8, u16]),
+        'epio_set_sm_reg': (None, [p, u8, u8, ctypes.POINTER(SmReg)]),
+        'epio_enable_sm': (None, [p, u8, u8]),
+        'epio_disable_sm': (None, [p, u8, u8]),
+        'epio_step_cycles': (None, [p, u32]),
+        'epio_get_cycle_count': (u64, [p]),
+        'epio_push_tx_fifo': (None, [p, u8, u8, u32]),
+        'epio_pop_rx_fifo': (u32, [p, u8, u8]),
+        'epio_set_gpio_output': (None, [p, u8]),
+        'epio_set_gpio_output_control': (None, [p, u8, u8]),
+        'epio_drive_gpios_ext': (None, [p, u64, u64]),
+        'epio_read_pin_states': (u64, [p]),
+        'epio_peek_sms': (None, [p, p]),
+        'epio_sram_page': (ctypes.POINTER(u8), [p, u32]),
+        'epio_sram_set': (None, [p, u32, p, ctypes.c_size_t]),
+        'epio_capture_start': (ctypes.c_int, [p, u64, p, u32, u8, p, p]),
+        'epio_capture_stop': (u32, [p, ctypes.POINTER(u64)]),
+    }
+    for name, (restype, argtypes) in protos.items():
+        fn = getattr(lib, name)
+        fn.restype = restype
+        fn.argtypes = argtypes
+    return lib
+
+
+_lib = _load()
+
+
+class Epio:
+    """An epio instance."""
+
+    # Largest number of cycles stepped by one call into libepio
+    _STEP_CHUNK = 0xFFFFFFFF
+
+    def __init__(self):
+        self._epio = _lib.epio_init()
+        if not self._epio:
+            raise MemoryError('epio_init failed')
+        self._sms = np.zeros((NUM_PIO_BLOCKS, NUM_SMS_PER_BLOCK),
+                             dtype=SM_SNAPSHOT_DTYPE)
+        self._capture = None
+
+    def close(self):
+        """Free the instance.  Any SRAM page views become invalid."""
+        if self._epio:
+            if self._capture is not None:
+                _lib.epio_capture_stop(self._epio, None)
+                self._capture = None
+            _lib.epio_free(self._epio)
+            self._epio = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def reset(self):
+        _lib.epio_reset(self._epio)
+
+    def set_instr(self, block, instr_num, instr):
+        _lib.epio_set_instr(self._epio, block, instr_num, instr)
+
+    def set_program(self, block, instrs, offset=0):
+        for num, instr in enumerate(instrs):
+            _lib.epio_set_instr(self._epio, block, offset + num, instr)
+
+    def set_sm_reg(self, block, sm, clkdiv=0x00010000, execctrl=0,
+                   shiftctrl=0, pinctrl=0):
+        reg = SmReg(clkdiv, execctrl, shiftctrl, pinctrl)
+        _lib.epio_set_sm_reg(self._epio, block, sm, ctypes.byref(reg))
+
+    def enable_sm(self, block, sm):
+        _lib.epio_enable_sm(self._epio, block, sm)
+
+    def disable_sm(self, block, sm):
+        _lib.epio_disable_sm(self._epio, block, sm)
+
+    def step(self, cycles=1):
+        """Step all enabled SMs.  The GIL is released while stepping."""
+        while cycles > 0:
+            chunk = min(cycles, self._STEP_CHUNK)
+            _lib.epio_step_cycles(self._epio, chunk)
+            cycles -= chunk
+
+    @property
+    def cycle_count(self):
+        return _lib.epio_get_cycle_count(self._epio)
+
+    def push_tx_fifo(self, block, sm, value):
+        _lib.epio_push_tx_fifo(self._epio, block, sm, value)
+
+    def pop_rx_fifo(self, block, sm):
+        return _lib.epio_pop_rx_fifo(self._epio, block, sm)
+
+    def set_gpio_output(self, pin, block):
+        """Make a GPIO an output, driven by a PIO block."""
+        _lib.epio_set_gpio_output_control(self._epio, pin, block)
+        _lib.epio_set_gpio_output(self._epio, pin)
+
+    def drive_gpios(self, gpios, level):
+        _lib.epio_drive_gpios_ext(self._epio, gpios, level)
+
+    def pin_states(self):
+        return _lib.epio_read_pin_states(self._epio)
+
+    def sms(self):
+        """Snapshot every SM, with one call into libepio.
+
+        Returns a (NUM_PIO_BLOCKS, NUM_SMS_PER_BLOCK) array of
+        SM_SNAPSHOT_DTYPE, which is refilled by the next call.
+        """
+        _lib.epio_peek_sms(self._epio, self._sms.ctypes.data)
+        return self._sms
+
+    def sram_page(self, addr):
+        """A read-only uint8 view of the SRAM page holding addr.
+
+        SRAM is held in sparse, copy-on-write pages, so each page is a
+        separate view.  Valid only until the next step, seek, reset, or
+        template or image operation, so take it again after any of these.
+        Write with sram_set(), so that writes are seen by the state hash and
+        history.
+        """
+        page = _lib.epio_sram_page(self._epio, addr)
+        view = np.ctypeslib.as_array(page, shape=(SRAM_PAGE_SIZE,))
+        view.flags.writeable = False
+        return view
+
+    def sram_set(self, addr, data):
+        data = np.frombuffer(bytes(data), dtype=np.uint8)
+        _lib.epio_sram_set(self._epio, addr, data.ctypes.data, data.size)
+
+    def capture_start(self, mask, size, overflow=CAPTURE_STOP):
+        """Start capturing edges on the GPIOs in mask into a numpy buffer."""
+        buffer = np.zeros(size, dtype=EDGE_DTYPE)
+        if _lib.epio_capture_start(self._epio, mask, buffer.ctypes.data,
+                                   size, overflow, None, None) != 0:
+            raise MemoryError('epio_capture_start failed')
+        self._capture = buffer
+
+    def capture_stop(self):
+        """Stop capturing, returning a view of the captured edges."""
+        count = _lib.epio_capture_stop(self._epio, None)
+        buffer, self._capture = self._capture, None
+        return buffer[:count]
@@ -0,0 +1,97 @@
+# Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+#
+# MIT License
+
+# epio - A PIO emulator
+#
+# Tests for the Python bindings.  Run with `make python-test`.
+
+import threading
+import unittest
+
+import numpy as np
+
+from epio import Epio, NUM_PIO_BLOCKS, NUM_SMS_PER_BLOCK, SRAM_PAGE_SIZE
+
+SRAM_BASE = 0x20000000
+
+# Block 0 SM 0 drives GPIO 0 high for 4 cycles, then low for 4 cycles
+SQUARE_WAVE = [
+    0xE301,     # set pins, 1 [3]
+    0xE300,     # set pins, 0 [3]
+]
+
+
+def square_wave(epio):
+    epio.set_program(0, SQUARE_WAVE)
+    epio.set_sm_reg(0, 0, execctrl=(1 << 12), pinctrl=(1 << 26))
+    epio.set_gpio_output(0, 0)
+    epio.enable_sm(0, 0)
+
+
+class TestEpio(unittest.TestCase):
+    def test_step(self):
+        with Epio() as epio:
+            square_wave(epio)
+            epio.step(2)
+            self.assertEqual(epio.cycle_count, 2)
+            self.assertEqual(epio.pin_states() & 1, 1)
+            epio.step(4)
+            self.assertEqual(epio.pin_states() & 1, 0)
+
+    def test_sms(self):
+        with Epio() as epio:
+            epio.push_tx_fifo(1, 2, 0x11)
+            epio.push_tx_fifo(1, 2, 0x22)
+            square_wave(epio)
+            epio.step(1)
+            sms = epio.sms()
+            self.assertEqual(sms.shape, (NUM_PIO_BLOCKS, NUM_SMS_PER_BLOCK))
+            self.assertEqual(sms[0, 0]['enabled'], 1)
+            self.assertEqual(sms[0, 0]['pc'], 1)
+            self.assertEqual(sms[0, 0]['delay'], 3)
+            self.assertEqual(sms[1, 2]['tx_fifo_count'], 2)
+            self.assertEqual(list(sms[1, 2]['tx_fifo'][:2]), [0x11, 0x22])
+            self.assertEqual(sms['enabled'].sum(), 1)
+
+    def test_sram_page(self):
+        with Epio() as epio:
+            page = epio.sram_page(SRAM_BASE + SRAM_PAGE_SIZE + 8)
+            self.assertEqual(page.shape, (SRAM_PAGE_SIZE,))
+            with self.assertRaises(ValueError):
+                page[0] = 1
+            epio.sram_set(SRAM_BASE + SRAM_PAGE_SIZE + 8, b'\x78\x56\x34\x12')
+            epio.sram_set(SRAM_BASE + SRAM_PAGE_SIZE, b'\xAA\xBB')
+            self.assertEqual(page[0], 0xAA)
+            self.assertEqual(page[1], 0xBB)
+            self.assertEqual(page[8], 0x78)
+            again = epio.sram_page(SRAM_BASE + SRAM_PAGE_SIZE)
+            self.assertEqual(again.ctypes.data, page.ctypes.data)
+
+    def test_capture(self):
+        with Epio() as epio:
+            square_wave(epio)
+            epio.capture_start(0x1, 64)
+            epio.step(40)
+            edges = epio.capture_stop()
+            self.assertEqual(edges[0]['changed'], 0)
+            rising = edges[(edges['changed'] & 1) & (edges['value'] & 1) == 1]
+            self.assertTrue(np.all(np.diff(rising['cycle'].astype(np.int64)) == 8))
+
+    def test_threads(self):
+        epios = [Epio() for _ in range(4)]
+        for epio in epios:
+            square_wave(epio)
+        threads = [threading.Thread(target=epio.step, args=(100000,))
+                   for epio in epios]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        for epio in epios:
+            self.assertEqual(epio.cycle_count, 100000)
+            epio.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
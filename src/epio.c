@@ -14,9 +14,7 @@
 //   - For clashes between SMs, highest numbered is preferred (easy to deal
 //     with just using incrementing scheduling order).  This is handled
 //     separately for direction and levels. 
-// - MOV instructions for RX FIFO access aren't supported
 // - Does not include/support 2 cycle GPIO input delay via flip-flops
-// - Only supports 4 word FIFOs
 // - Ingores clock dividers
 
 #include <stdlib.h>
@@ -75,6 +73,10 @@ static void epio_init_sm(
     // Initialize FIFOs
     FIFO(block, sm).tx_fifo_count = 0;
     FIFO(block, sm).rx_fifo_count = 0;
+    FIFO(block, sm).tx_fifo_head = 0;
+    FIFO(block, sm).rx_fifo_head = 0;
+    FIFO(block, sm).tx_fifo_capacity = MAX_FIFO_DEPTH;
+    FIFO(block, sm).rx_fifo_capacity = MAX_FIFO_DEPTH;
 }
 
 void epio_set_gpiobase(epio_t *epio, uint8_t block, uint32_t gpio_base) {
@@ -104,8 +106,63 @@ static void epio_init_block(epio_t *epio, uint8_t block) {
     }
 }
 
-epio_t *epio_init(void) {
-    // Allocate the epio struct, which will hold the state of the emulator
+// Puts the machine state into its power-on state.  Does not touch SRAM.
+static void epio_power_on(epio_t *epio) {
+    // Start from all zeros, then apply any non-zero defaults
+    memset(epio, 0, EPIO_MACHINE_STATE_SIZE);
+
+    // Set up GPIOs
+    epio_init_gpios(epio);
+
+    // Set up DMA
+    epio_init_dma(epio);
+
+    // Set up each PIO block
+    for (int ii = 0; ii < NUM_PIO_BLOCKS; ii++) {
+        epio_init_block(epio, ii);
+    }
+
+    // Initialize clock and cycle count
+    epio->sys_clock_hz = EPIO_DEFAULT_SYS_CLOCK_HZ;
+    epio->cycle_count = 0;
+}
+
+size_t epio_sizeof(void) {
+    return sizeof(epio_t);
+}
+
+// Places an instance in caller-provided memory, with no SRAM resident, but
+// does not initialise the machine state.
+epio_t *epio_place_in(void *mem, size_t size) {
+    assert(mem != NULL && "Memory for epio instance cannot be NULL");
+    assert(size >= sizeof(epio_t) && "Memory too small for epio instance");
+    assert(((uintptr_t)mem % _Alignof(epio_t)) == 0 && "Memory for epio instance is misaligned");
+
+    epio_t *epio = (epio_t *)mem;
+
+    // Set up SRAM.  This is sparse, so no pages are allocated until written.
+    epio_sram_init(epio);
+    epio->allocated = 0;
+    epio->image = NULL;
+    epio->image_size = 0;
+    epio->history = NULL;
+    epio->stimulus = NULL;
+    epio->trace = NULL;
+    epio->recorder = NULL;
+    epio->capture = NULL;
+    epio->devices = NULL;
+    epio->checks = NULL;
+    epio->schedule = NULL;
+    epio->streams = NULL;
+    epio->fifo_counters = NULL;
+    memset(epio->sm_events, 0, sizeof(epio->sm_events));
+
+    return epio;
+}
+
+// Allocates an instance, with no SRAM resident, but does not initialise the
+// machine state.
+epio_t *epio_alloc(void) {
     epio_t *epio = (epio_t *)calloc(1, sizeof(epio_t));
     if (epio == NULL) {
         // LCOV_EXCL_START
@@ -113,42 +170,82 @@ epio_t *epio_init(void) {
         // LCOV_EXCL_STOP
     }
 
-    // Set up SRAM (can fail so do it early)
-    epio_sram_init(epio);
-    if (epio->sram == NULL) {
+    epio_place_in(epio, sizeof(epio_t));
+    epio->allocated = 1;
+
+    return epio;
+}
+
+epio_t *epio_init_in(void *mem, size_t size) {
+    epio_t *epio = epio_place_in(mem, size);
+    epio_power_on(epio);
+    return epio;
+}
+
+epio_t *epio_init(void) {
+    // Allocate the epio struct, which will hold the state of the emulator
+    epio_t *epio = epio_alloc();
+    if (epio == NULL) {
         // LCOV_EXCL_START
-        free(epio);
         return NULL;
         // LCOV_EXCL_STOP
     }
 
-    // Set up GPIOs
-    epio_init_gpios(epio);
+    epio_power_on(epio);
 
-    // Set up DMA
-    epio_init_dma(epio);
+    return epio;
+}
 
-    // Set up each PIO block
-    for (int ii = 0; ii < NUM_PIO_BLOCKS; ii++) {
-        epio_init_block(epio, ii);
-    }
+void epio_reset(epio_t *epio) {
+    assert(epio != NULL && "Cannot reset a NULL epio instance");
 
-    // Initialize cycle count
-    epio->cycle_count = 0;
+    // History, stimulus, trace, recorder, capture, checks, scheduled actions,
+    // streams and FIFO statistics are of the state being reset, so are no
+    // longer valid
+    epio_history_disable(epio);
+    epio_stimulus_detach(epio);
+    epio_trace_stop(epio);
+    epio_recorder_disable(epio);
+    epio_capture_stop(epio, NULL);
+    epio_check_clear(epio);
+    epio_schedule_clear(epio);
+    epio_streams_free(epio);
+    epio_fifo_stats_disable(epio);
 
-    return epio;
+    // Keep any SRAM pages which have been allocated, so they can be reused
+    // without further allocations, but clear their contents.
+    epio_sram_zero(epio);
+
+    epio_power_on(epio);
 }
 
 void epio_free(epio_t *epio) {
     assert(epio != NULL && "Cannot free a NULL epio instance");
+    epio_history_disable(epio);
+    epio_stimulus_detach(epio);
+    epio_trace_stop(epio);
+    epio_recorder_disable(epio);
+    epio_capture_stop(epio, NULL);
+    epio_devices_free(epio);
+    epio_check_clear(epio);
+    epio_schedule_clear(epio);
+    epio_streams_free(epio);
+    epio_fifo_stats_disable(epio);
     epio_sram_free(epio);
-    free(epio);
+    epio_image_release(epio);
+    if (epio->allocated) {
+        free(epio);
+    }
 }
 
 void epio_set_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg) {
     CHECK_BLOCK_SM();
     assert(reg != NULL && "Register configuration cannot be NULL");
+    uint32_t fjoin_changed = (REG(block, sm).shiftctrl ^ reg->shiftctrl) & SHIFTCTRL_FJOIN_MASK;
     memcpy(&REG(block, sm), reg, sizeof(epio_sm_reg_t));
+    if (fjoin_changed) {
+        epio_fifo_configure(epio, block, sm);
+    }
 }
 
 void epio_get_sm_reg(epio_t *epio, uint8_t block, uint8_t sm, epio_sm_reg_t *reg) {
@@ -0,0 +1,150 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// GPIO edge capture
+//
+// While capturing, epio_run_cycles() calls epio_capture_sample() before each
+// cycle and after the last.  Each sample masks the observable GPIO levels,
+// and writes an edge to the caller's buffer only if they differ from the
+// last edge written, so a cycle with no changes costs a mask and a compare.
+
+#include <stdlib.h>
+#include <epio_priv.h>
+
+struct epio_capture_t {
+    uint64_t mask;
+    epio_edge_t *buffer;
+    uint32_t size;
+    uint8_t overflow;
+    epio_capture_fn_t callback;
+    void *arg;
+
+    // Number of edges in the buffer, and the index to write the next one to,
+    // which differ once a wrapping buffer is full
+    uint32_t count;
+    uint32_t next;
+
+    // Total number of edges captured
+    uint64_t total;
+
+    // Levels of the last edge
+    uint64_t value;
+
+    // The last cycle sampled.  Earlier cycles are being replayed, so are not
+    // captured again.
+    uint64_t cycle;
+};
+
+#define CAPTURE             epio->capture
+
+// Reverses edges first to last - 1 in place
+static void capture_reverse(epio_edge_t *first, epio_edge_t *last) {
+    while (first < --last) {
+        epio_edge_t tmp = *first;
+        *first++ = *last;
+        *last = tmp;
+    }
+}
+
+// Writes an edge
+static void capture_edge(epio_capture_t *cap, uint64_t cycle, uint64_t changed, uint64_t value) {
+    cap->total++;
+    if (cap->count == cap->size) {
+        if (cap->overflow == EPIO_CAPTURE_STOP) {
+            return;
+        } else if (cap->overflow == EPIO_CAPTURE_CALLBACK) {
+            cap->callback(cap->arg, cap->buffer, cap->count);
+            cap->count = 0;
+            cap->next = 0;
+        }
+    }
+
+    epio_edge_t *edge = &cap->buffer[cap->next];
+    edge->cycle = cycle;
+    edge->changed = changed;
+    edge->value = value;
+    cap->next = (cap->next + 1 == cap->size) ? 0 : (cap->next + 1);
+    if (cap->count < cap->size) {
+        cap->count++;
+    }
+}
+
+int epio_capture_start(epio_t *epio, uint64_t mask, epio_edge_t *buffer, uint32_t size, uint8_t overflow, epio_capture_fn_t callback, void *arg) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO_MASK(mask);
+    assert(buffer != NULL && "Capture buffer cannot be NULL");
+    assert(size > 0 && "Capture buffer must hold at least one edge");
+    assert(overflow <= EPIO_CAPTURE_CALLBACK && "Invalid overflow policy");
+    assert(((overflow == EPIO_CAPTURE_CALLBACK) == (callback != NULL)) && "Callback must be given if, and only if, the overflow policy is callback");
+
+    epio_capture_stop(epio, NULL);
+
+    epio_capture_t *cap = (epio_capture_t *)calloc(1, sizeof(epio_capture_t));
+    if (cap == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    cap->mask = mask;
+    cap->buffer = buffer;
+    cap->size = size;
+    cap->overflow = overflow;
+    cap->callback = callback;
+    cap->arg = arg;
+    cap->value = epio_gpio_levels(epio) & mask;
+    cap->cycle = epio->cycle_count;
+    capture_edge(cap, cap->cycle, 0, cap->value);
+
+    CAPTURE = cap;
+
+    return 0;
+}
+
+uint32_t epio_capture_stop(epio_t *epio, uint64_t *total) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_capture_t *cap = CAPTURE;
+    if (cap == NULL) {
+        if (total != NULL) {
+            *total = 0;
+        }
+        return 0;
+    }
+
+    // Rotate a wrapped buffer so the oldest edge, which is the next to be
+    // overwritten, is first
+    if ((cap->count == cap->size) && (cap->next != 0)) {
+        capture_reverse(cap->buffer, cap->buffer + cap->next);
+        capture_reverse(cap->buffer + cap->next, cap->buffer + cap->size);
+        capture_reverse(cap->buffer, cap->buffer + cap->size);
+    }
+
+    uint32_t count = cap->count;
+    if (total != NULL) {
+        *total = cap->total;
+    }
+    free(cap);
+    CAPTURE = NULL;
+
+    return count;
+}
+
+// Writes an edge if the captured GPIO levels have changed
+void epio_capture_sample(epio_t *epio) {
+    epio_capture_t *cap = CAPTURE;
+    uint64_t cycle = epio->cycle_count;
+    if (cycle < cap->cycle) {
+        // Replaying cycles which have already been captured
+        return;
+    }
+    cap->cycle = cycle;
+
+    uint64_t value = epio_gpio_levels(epio) & cap->mask;
+    uint64_t changed = value ^ cap->value;
+    if (changed != 0) {
+        cap->value = value;
+        capture_edge(cap, cycle, changed, value);
+    }
+}
@@ -0,0 +1,271 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Timing checks
+//
+// While any check is registered, epio_after_step() calls epio_checks_step()
+// after every cycle.  The GPIO levels are read and compared with the
+// previous cycle's once, and each check then advances its own small state
+// machine - the cycle of the last edge, or of the trigger, or the length of
+// the current stall - so no history is kept.
+//
+// FIFO checks use the SM events set by the instructions which stall on, or
+// drop data because of, a FIFO, which epio_after_step() clears after each
+// cycle.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+typedef struct {
+    epio_check_type_t type;
+
+    // GPIO checked, or the trigger GPIO, and its trigger level
+    uint8_t gpio;
+    uint8_t trigger_level;
+
+    // SM checked
+    uint8_t block;
+    uint8_t sm;
+
+    // GPIOs which must become driven
+    uint64_t gpios;
+
+    // Period and tolerance, response time, or longest stall, in cycles
+    uint32_t cycles;
+    uint32_t tolerance;
+
+    // Whether a period is being measured, or a response awaited, since the
+    // cycle in since
+    uint8_t armed;
+    uint64_t since;
+
+    // Length of the current stall
+    uint32_t stalled;
+} epio_check_t;
+
+struct epio_checks_t {
+    epio_check_t check[EPIO_MAX_CHECKS];
+    uint32_t count;
+
+    // GPIO levels after the previous cycle
+    uint64_t levels;
+
+    // The next cycle to check.  Earlier cycles are being replayed, so are
+    // not checked again.
+    uint64_t cycle;
+
+    epio_violation_t violation[EPIO_MAX_VIOLATIONS];
+    uint64_t num_violations;
+};
+
+#define CHECKS      epio->checks
+
+// Registers a check, returning it, or NULL if there is no room
+static epio_check_t *epio_check_add(epio_t *epio, epio_check_type_t type, int *id) {
+    if (CHECKS == NULL) {
+        CHECKS = (epio_checks_t *)calloc(1, sizeof(epio_checks_t));
+        if (CHECKS == NULL) {
+            // LCOV_EXCL_START
+            *id = -1;
+            return NULL;
+            // LCOV_EXCL_STOP
+        }
+        CHECKS->levels = epio_gpio_levels(epio);
+        CHECKS->cycle = epio->cycle_count;
+        memset(epio->sm_events, 0, sizeof(epio->sm_events));
+    }
+
+    if (CHECKS->count == EPIO_MAX_CHECKS) {
+        *id = -1;
+        return NULL;
+    }
+    *id = CHECKS->count;
+    epio_check_t *check = &CHECKS->check[CHECKS->count++];
+    check->type = type;
+    return check;
+}
+
+int epio_check_period(epio_t *epio, uint8_t gpio, uint32_t period, uint32_t tolerance) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO(gpio);
+    assert(period > 0 && "Period must be non-zero");
+    assert(tolerance < period && "Tolerance must be less than the period");
+
+    int id;
+    epio_check_t *check = epio_check_add(epio, EPIO_CHECK_PERIOD, &id);
+    if (check != NULL) {
+        check->gpio = gpio;
+        check->cycles = period;
+        check->tolerance = tolerance;
+    }
+    return id;
+}
+
+int epio_check_response(epio_t *epio, uint8_t trigger_gpio, uint8_t trigger_level, uint64_t gpios, uint32_t within) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO(trigger_gpio);
+    assert(trigger_level < 2 && "Trigger level must be 0 or 1");
+    CHECK_GPIO_MASK(gpios);
+    assert(gpios != 0 && "No GPIOs to check");
+
+    int id;
+    epio_check_t *check = epio_check_add(epio, EPIO_CHECK_RESPONSE, &id);
+    if (check != NULL) {
+        check->gpio = trigger_gpio;
+        check->trigger_level = trigger_level;
+        check->gpios = gpios;
+        check->cycles = within;
+    }
+    return id;
+}
+
+// Registers a check of an SM
+static int epio_check_sm(epio_t *epio, epio_check_type_t type, uint8_t block, uint8_t sm, uint32_t cycles) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+
+    int id;
+    epio_check_t *check = epio_check_add(epio, type, &id);
+    if (check != NULL) {
+        check->block = block;
+        check->sm = sm;
+        check->cycles = cycles;
+    }
+    return id;
+}
+
+int epio_check_rx_overflow(epio_t *epio, uint8_t block, uint8_t sm) {
+    return epio_check_sm(epio, EPIO_CHECK_RX_OVERFLOW, block, sm, 0);
+}
+
+int epio_check_tx_underrun(epio_t *epio, uint8_t block, uint8_t sm) {
+    return epio_check_sm(epio, EPIO_CHECK_TX_UNDERRUN, block, sm, 0);
+}
+
+int epio_check_max_stall(epio_t *epio, uint8_t block, uint8_t sm, uint32_t max_cycles) {
+    return epio_check_sm(epio, EPIO_CHECK_MAX_STALL, block, sm, max_cycles);
+}
+
+uint64_t epio_check_violations(epio_t *epio, epio_violation_t *violations, uint32_t max) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert((violations != NULL || max == 0) && "Violations buffer cannot be NULL");
+    if (CHECKS == NULL) {
+        return 0;
+    }
+
+    uint64_t count = CHECKS->num_violations;
+    if (count > EPIO_MAX_VIOLATIONS) {
+        count = EPIO_MAX_VIOLATIONS;
+    }
+    if (count > max) {
+        count = max;
+    }
+    memcpy(violations, CHECKS->violation, count * sizeof(epio_violation_t));
+    return CHECKS->num_violations;
+}
+
+void epio_check_clear(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    free(CHECKS);
+    CHECKS = NULL;
+}
+
+// Records a violation of check id
+static void epio_check_fail(epio_checks_t *checks, uint32_t id, uint64_t cycle) {
+    if (checks->num_violations < EPIO_MAX_VIOLATIONS) {
+        epio_violation_t *violation = &checks->violation[checks->num_violations];
+        violation->cycle = cycle;
+        violation->id = (int)id;
+        violation->type = checks->check[id].type;
+    }
+    checks->num_violations++;
+}
+
+void epio_checks_step(epio_t *epio) {
+    uint64_t cycle = epio->cycle_count;
+    if (cycle < CHECKS->cycle) {
+        return;
+    }
+    CHECKS->cycle = cycle + 1;
+
+    uint64_t levels = epio_gpio_levels(epio);
+    uint64_t changed = levels ^ CHECKS->levels;
+    CHECKS->levels = levels;
+
+    for (uint32_t id = 0; id < CHECKS->count; id++) {
+        epio_check_t *check = &CHECKS->check[id];
+        uint64_t gpio = 1ULL << check->gpio;
+        uint8_t block = check->block;
+        uint8_t sm = check->sm;
+
+        switch (check->type) {
+            case EPIO_CHECK_PERIOD:
+                if (changed & levels & gpio) {
+                    if (check->armed) {
+                        uint64_t period = cycle - check->since;
+                        if ((period < check->cycles - check->tolerance) ||
+                            (period > (uint64_t)check->cycles + check->tolerance)) {
+                            epio_check_fail(CHECKS, id, cycle);
+                        }
+                    }
+                    check->armed = 1;
+                    check->since = cycle;
+                } else if (check->armed && (cycle - check->since > (uint64_t)check->cycles + check->tolerance)) {
+                    epio_check_fail(CHECKS, id, cycle);
+                    check->armed = 0;
+                }
+                break;
+
+            case EPIO_CHECK_RESPONSE:
+                if (changed & gpio) {
+                    check->armed = ((levels >> check->gpio) & 1) == check->trigger_level;
+                    check->since = cycle;
+                }
+                if (check->armed) {
+                    uint64_t driven = epio->gpio.ext_driven | epio->gpio.gpio_direction;
+                    if ((driven & check->gpios) == check->gpios) {
+                        check->armed = 0;
+                    } else if (cycle - check->since >= check->cycles) {
+                        epio_check_fail(CHECKS, id, cycle);
+                        check->armed = 0;
+                    }
+                }
+                break;
+
+            case EPIO_CHECK_RX_OVERFLOW:
+                if (SM_EVENTS(block, sm) & (SM_EVENT_RX_STALL | SM_EVENT_RX_LOST)) {
+                    epio_check_fail(CHECKS, id, cycle);
+                }
+                break;
+
+            case EPIO_CHECK_TX_UNDERRUN:
+                if (SM_EVENTS(block, sm) & SM_EVENT_TX_STALL) {
+                    epio_check_fail(CHECKS, id, cycle);
+                }
+                break;
+
+            case EPIO_CHECK_MAX_STALL:
+                if (SM(block, sm).enabled && SM(block, sm).stalled) {
+                    if (check->stalled <= check->cycles) {
+                        check->stalled++;
+                        if (check->stalled > check->cycles) {
+                            epio_check_fail(CHECKS, id, cycle);
+                        }
+                    }
+                } else {
+                    check->stalled = 0;
+                }
+                break;
+
+            // LCOV_EXCL_START
+            default:
+                assert(0 && "Invalid check type");
+                break;
+            // LCOV_EXCL_STOP
+        }
+    }
+}
@@ -0,0 +1,323 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// UART, SPI, I2C and parallel bus decoders, over captured GPIO edges
+//
+// Each edge is handled by comparing the decoder's pins before and after it.
+// Levels are constant between edges, so the clocked protocols only need to
+// act on edges of their clock or strobe.  UART samples the middle of each
+// bit, so before handling an edge, any bit samples due before it are taken
+// from the levels before it.
+
+#include <stdlib.h>
+#include <epio_priv.h>
+
+typedef enum {
+    DECODE_UART,
+    DECODE_SPI,
+    DECODE_I2C,
+    DECODE_PARALLEL,
+} epio_decode_protocol_t;
+
+struct epio_decoder_t {
+    epio_decode_protocol_t protocol;
+    epio_frame_fn_t callback;
+    void *arg;
+
+    // Levels after the last edge fed, once any have been
+    uint8_t have_levels;
+    uint64_t levels;
+
+    union {
+        epio_uart_config_t uart;
+        epio_spi_config_t spi;
+        epio_i2c_config_t i2c;
+        epio_parallel_config_t parallel;
+    } config;
+
+    // The frame being decoded, and the number of bits of it so far.  For
+    // UART, a frame is in progress if started is set, and bits is the next
+    // bit to sample, with the start bit being bit 0.
+    epio_frame_t frame;
+    uint8_t started;
+    uint8_t bits;
+
+    // For I2C, whether the next byte is an address
+    uint8_t address_next;
+};
+
+#define LEVEL(LEVELS, PIN)  (((LEVELS) >> (PIN)) & 1)
+
+// Allocates a decoder
+static epio_decoder_t *decoder_alloc(epio_decode_protocol_t protocol, epio_frame_fn_t callback, void *arg) {
+    assert(callback != NULL && "Callback cannot be NULL");
+    epio_decoder_t *decoder = (epio_decoder_t *)calloc(1, sizeof(epio_decoder_t));
+    if (decoder == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    decoder->protocol = protocol;
+    decoder->callback = callback;
+    decoder->arg = arg;
+    return decoder;
+}
+
+// Passes a frame to the callback
+static void decoder_emit(epio_decoder_t *decoder, uint8_t type, uint64_t cycle, uint64_t end, uint32_t data, uint8_t flags) {
+    epio_frame_t frame = {
+        .cycle = cycle,
+        .end = end,
+        .data = data,
+        .type = type,
+        .flags = flags,
+    };
+    decoder->callback(decoder->arg, &frame);
+}
+
+epio_decoder_t *epio_decoder_uart(const epio_uart_config_t *config, epio_frame_fn_t callback, void *arg) {
+    assert(config != NULL && "Configuration cannot be NULL");
+    CHECK_GPIO(config->pin);
+    assert(config->bit_cycles > 0 && "Bit length must be non-zero");
+    assert((config->data_bits >= 5) && (config->data_bits <= 9) && "Data bits must be 5 to 9");
+    assert(config->parity <= EPIO_UART_PARITY_ODD && "Invalid parity");
+    assert((config->stop_bits >= 1) && (config->stop_bits <= 2) && "Stop bits must be 1 or 2");
+    epio_decoder_t *decoder = decoder_alloc(DECODE_UART, callback, arg);
+    if (decoder != NULL) {
+        decoder->config.uart = *config;
+    }
+    return decoder;
+}
+
+epio_decoder_t *epio_decoder_spi(const epio_spi_config_t *config, epio_frame_fn_t callback, void *arg) {
+    assert(config != NULL && "Configuration cannot be NULL");
+    CHECK_GPIO(config->sck);
+    CHECK_GPIO(config->mosi);
+    assert(((config->miso == EPIO_DECODE_NO_PIN) || (config->miso < NUM_GPIOS)) && "Invalid MISO pin");
+    assert(((config->cs == EPIO_DECODE_NO_PIN) || (config->cs < NUM_GPIOS)) && "Invalid CS pin");
+    assert(config->mode <= 3 && "SPI mode must be 0 to 3");
+    assert((config->bits >= 1) && (config->bits <= 32) && "Bits per word must be 1 to 32");
+    assert(config->lsb_first <= 1 && "lsb_first must be 0 or 1");
+    epio_decoder_t *decoder = decoder_alloc(DECODE_SPI, callback, arg);
+    if (decoder != NULL) {
+        decoder->config.spi = *config;
+    }
+    return decoder;
+}
+
+epio_decoder_t *epio_decoder_i2c(const epio_i2c_config_t *config, epio_frame_fn_t callback, void *arg) {
+    assert(config != NULL && "Configuration cannot be NULL");
+    CHECK_GPIO(config->scl);
+    CHECK_GPIO(config->sda);
+    epio_decoder_t *decoder = decoder_alloc(DECODE_I2C, callback, arg);
+    if (decoder != NULL) {
+        decoder->config.i2c = *config;
+    }
+    return decoder;
+}
+
+epio_decoder_t *epio_decoder_parallel(const epio_parallel_config_t *config, epio_frame_fn_t callback, void *arg) {
+    assert(config != NULL && "Configuration cannot be NULL");
+    assert((config->data_count >= 1) && (config->data_count <= 32) && "Data count must be 1 to 32");
+    assert((config->data_base + config->data_count <= NUM_GPIOS) && "Invalid data pins");
+    CHECK_GPIO(config->strobe);
+    assert(((config->strobe_edge == EPIO_EDGE_RISING) || (config->strobe_edge == EPIO_EDGE_FALLING)) && "Strobe edge must be rising or falling");
+    epio_decoder_t *decoder = decoder_alloc(DECODE_PARALLEL, callback, arg);
+    if (decoder != NULL) {
+        decoder->config.parallel = *config;
+    }
+    return decoder;
+}
+
+void epio_decoder_free(epio_decoder_t *decoder) {
+    assert(decoder != NULL && "Decoder cannot be NULL");
+    free(decoder);
+}
+
+// Takes any UART bit samples due before the cycle, from the current levels
+static void uart_advance(epio_decoder_t *decoder, uint64_t cycle) {
+    const epio_uart_config_t *config = &decoder->config.uart;
+    epio_frame_t *frame = &decoder->frame;
+    uint8_t parity_bits = (config->parity != EPIO_UART_PARITY_NONE) ? 1 : 0;
+    uint8_t last_bit = config->data_bits + parity_bits + config->stop_bits;
+
+    while (decoder->started) {
+        uint64_t sample = frame->cycle + (uint64_t)config->bit_cycles * decoder->bits + config->bit_cycles / 2;
+        if (sample >= cycle) {
+            break;
+        }
+        uint8_t level = LEVEL(decoder->levels, config->pin);
+        uint8_t bit = decoder->bits++;
+
+        if (bit == 0) {
+            // Start bit - if it is no longer low, it was a glitch
+            if (level) {
+                decoder->started = 0;
+            }
+        } else if (bit <= config->data_bits) {
+            frame->data |= (uint32_t)level << (bit - 1);
+        } else if (bit <= config->data_bits + parity_bits) {
+            uint8_t ones = (uint8_t)(__builtin_popcount(frame->data) + level);
+            if ((ones & 1) != (config->parity == EPIO_UART_PARITY_ODD)) {
+                frame->flags |= EPIO_FRAME_ERR_PARITY;
+            }
+        } else {
+            if (!level) {
+                frame->flags |= EPIO_FRAME_ERR_FRAMING;
+            }
+            if (bit == last_bit) {
+                decoder_emit(decoder, EPIO_FRAME_DATA, frame->cycle, sample, frame->data, frame->flags);
+                decoder->started = 0;
+            }
+        }
+    }
+}
+
+static void uart_edge(epio_decoder_t *decoder, uint64_t cycle, uint64_t old, uint64_t new) {
+    uint8_t pin = decoder->config.uart.pin;
+    uart_advance(decoder, cycle);
+    if (!decoder->started && LEVEL(old, pin) && !LEVEL(new, pin)) {
+        // Falling edge of a start bit
+        decoder->started = 1;
+        decoder->bits = 0;
+        decoder->frame.cycle = cycle;
+        decoder->frame.data = 0;
+        decoder->frame.flags = 0;
+    }
+}
+
+static void spi_edge(epio_decoder_t *decoder, uint64_t cycle, uint64_t old, uint64_t new) {
+    const epio_spi_config_t *config = &decoder->config.spi;
+    epio_frame_t *frame = &decoder->frame;
+    uint8_t selected = (config->cs == EPIO_DECODE_NO_PIN) || !LEVEL(old, config->cs);
+
+    // Data is sampled on the leading clock edge for CPHA 0, and the trailing
+    // edge for CPHA 1.  The leading edge is rising for CPOL 0.
+    uint8_t sample_level = !(((config->mode >> 1) ^ config->mode) & 1);
+    if (selected && (LEVEL(old, config->sck) != LEVEL(new, config->sck)) && (LEVEL(new, config->sck) == sample_level)) {
+        uint32_t mosi = LEVEL(old, config->mosi);
+        uint32_t miso = (config->miso == EPIO_DECODE_NO_PIN) ? 0 : LEVEL(old, config->miso);
+        if (decoder->bits == 0) {
+            frame->cycle = cycle;
+            frame->data = 0;
+            frame->data_in = 0;
+        }
+        if (config->lsb_first) {
+            frame->data |= mosi << decoder->bits;
+            frame->data_in |= miso << decoder->bits;
+        } else {
+            frame->data = (frame->data << 1) | mosi;
+            frame->data_in = (frame->data_in << 1) | miso;
+        }
+        if (++decoder->bits == config->bits) {
+            frame->end = cycle;
+            frame->type = EPIO_FRAME_DATA;
+            frame->flags = 0;
+            decoder->callback(decoder->arg, frame);
+            decoder->bits = 0;
+        }
+    }
+
+    if ((config->cs != EPIO_DECODE_NO_PIN) && (LEVEL(old, config->cs) != LEVEL(new, config->cs))) {
+        if (LEVEL(new, config->cs)) {
+            if (decoder->bits > 0) {
+                frame->end = cycle;
+                frame->type = EPIO_FRAME_DATA;
+                frame->flags = EPIO_FRAME_ERR_FRAMING;
+                decoder->callback(decoder->arg, frame);
+            }
+            decoder_emit(decoder, EPIO_FRAME_STOP, cycle, cycle, 0, 0);
+        } else {
+            decoder_emit(decoder, EPIO_FRAME_START, cycle, cycle, 0, 0);
+        }
+        decoder->bits = 0;
+    }
+}
+
+static void i2c_edge(epio_decoder_t *decoder, uint64_t cycle, uint64_t old, uint64_t new) {
+    const epio_i2c_config_t *config = &decoder->config.i2c;
+    epio_frame_t *frame = &decoder->frame;
+    uint8_t scl_old = LEVEL(old, config->scl);
+    uint8_t scl_new = LEVEL(new, config->scl);
+    uint8_t sda_new = LEVEL(new, config->sda);
+
+    if (scl_old && scl_new && (LEVEL(old, config->sda) != sda_new)) {
+        // SDA changing while SCL is high is a start or stop condition, which
+        // cuts short any byte in progress.  The last clock was part of the
+        // condition, not the byte.
+        if (decoder->bits > 1) {
+            decoder_emit(decoder, decoder->address_next ? EPIO_FRAME_ADDRESS : EPIO_FRAME_DATA,
+                frame->cycle, cycle, frame->data >> 1, EPIO_FRAME_ERR_FRAMING);
+        }
+        decoder->started = !sda_new;
+        decoder->address_next = 1;
+        decoder->bits = 0;
+        decoder_emit(decoder, sda_new ? EPIO_FRAME_STOP : EPIO_FRAME_START, cycle, cycle, 0, 0);
+    } else if (decoder->started && !scl_old && scl_new) {
+        // 8 data bits, MSB first, then the acknowledge bit
+        if (decoder->bits == 0) {
+            frame->cycle = cycle;
+            frame->data = 0;
+        }
+        if (decoder->bits++ < 8) {
+            frame->data = (frame->data << 1) | sda_new;
+        } else {
+            decoder_emit(decoder, decoder->address_next ? EPIO_FRAME_ADDRESS : EPIO_FRAME_DATA,
+                frame->cycle, cycle, frame->data, sda_new ? EPIO_FRAME_NACK : 0);
+            decoder->address_next = 0;
+            decoder->bits = 0;
+        }
+    }
+}
+
+static void parallel_edge(epio_decoder_t *decoder, uint64_t cycle, uint64_t old, uint64_t new) {
+    const epio_parallel_config_t *config = &decoder->config.parallel;
+    uint8_t strobe_level = (config->strobe_edge == EPIO_EDGE_RISING);
+    if ((LEVEL(old, config->strobe) != strobe_level) && (LEVEL(new, config->strobe) == strobe_level)) {
+        uint32_t data = (uint32_t)((old >> config->data_base) & ((1ULL << config->data_count) - 1));
+        decoder_emit(decoder, EPIO_FRAME_DATA, cycle, cycle, data, 0);
+    }
+}
+
+void epio_decoder_feed(epio_decoder_t *decoder, const epio_edge_t *edges, uint32_t count) {
+    assert(decoder != NULL && "Decoder cannot be NULL");
+    assert(((edges != NULL) || (count == 0)) && "Edges cannot be NULL");
+
+    for (uint32_t ii = 0; ii < count; ii++) {
+        const epio_edge_t *edge = &edges[ii];
+        if (!decoder->have_levels) {
+            decoder->levels = edge->value ^ edge->changed;
+            decoder->have_levels = 1;
+        }
+        uint64_t old = decoder->levels;
+        switch (decoder->protocol) {
+            case DECODE_UART:
+                uart_edge(decoder, edge->cycle, old, edge->value);
+                break;
+            case DECODE_SPI:
+                spi_edge(decoder, edge->cycle, old, edge->value);
+                break;
+            case DECODE_I2C:
+                i2c_edge(decoder, edge->cycle, old, edge->value);
+                break;
+            default:
+                parallel_edge(decoder, edge->cycle, old, edge->value);
+                break;
+        }
+        decoder->levels = edge->value;
+    }
+}
+
+void epio_decoder_capture(void *decoder, const epio_edge_t *edges, uint32_t count) {
+    epio_decoder_feed((epio_decoder_t *)decoder, edges, count);
+}
+
+void epio_decoder_flush(epio_decoder_t *decoder, uint64_t cycle) {
+    assert(decoder != NULL && "Decoder cannot be NULL");
+    if (decoder->protocol == DECODE_UART) {
+        uart_advance(decoder, cycle);
+    }
+}
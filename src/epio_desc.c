@@ -0,0 +1,420 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Program description files
+//
+// A description is a text file of directives, one per line, each applied in
+// turn to a new instance - see the Description API in epio.h for the
+// directives.  Unlike the API functions, which assert on invalid arguments,
+// any out of range value is reported as an error on its line, as
+// descriptions are user input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+#define DESC_MAX_LINE   4096
+#define DESC_MAX_ARGS   256
+
+// A directive, and the number of numeric arguments it takes.  A max_args of
+// 0 means any number, up to DESC_MAX_ARGS.
+typedef struct {
+    const char *name;
+    uint8_t min_args;
+    uint8_t max_args;
+} epio_desc_directive_t;
+
+typedef enum {
+    DESC_SYSCLK,
+    DESC_GPIOBASE,
+    DESC_INSTR,
+    DESC_SM,
+    DESC_EXEC,
+    DESC_TX,
+    DESC_RX,
+    DESC_ENABLE,
+    DESC_OUTPUT,
+    DESC_INVERT,
+    DESC_FORCE_LOW,
+    DESC_FORCE_HIGH,
+    DESC_DRIVE,
+    DESC_DMA,
+    DESC_SRAM,
+    DESC_SRAM_FILE,
+    DESC_NUM_DIRECTIVES,
+} epio_desc_id_t;
+
+static const epio_desc_directive_t desc_directives[DESC_NUM_DIRECTIVES] = {
+    [DESC_SYSCLK] = { "sysclk", 1, 1 },
+    [DESC_GPIOBASE] = { "gpiobase", 2, 2 },
+    [DESC_INSTR] = { "instr", 3, 0 },
+    [DESC_SM] = { "sm", 6, 6 },
+    [DESC_EXEC] = { "exec", 3, 3 },
+    [DESC_TX] = { "tx", 3, 3 },
+    [DESC_RX] = { "rx", 3, 3 },
+    [DESC_ENABLE] = { "enable", 2, 2 },
+    [DESC_OUTPUT] = { "output", 2, 2 },
+    [DESC_INVERT] = { "invert", 1, 1 },
+    [DESC_FORCE_LOW] = { "force-low", 1, 1 },
+    [DESC_FORCE_HIGH] = { "force-high", 1, 1 },
+    [DESC_DRIVE] = { "drive", 2, 2 },
+    [DESC_DMA] = { "dma", 8, 8 },
+    [DESC_SRAM] = { "sram", 2, 0 },
+    [DESC_SRAM_FILE] = { "sram-file", 1, 1 },
+};
+
+// Parses an unsigned number, in any base strtoull() accepts
+static int epio_desc_number(const char *token, uint64_t *value) {
+    char *end;
+    if (token[0] == '-') {
+        return -1;
+    }
+    *value = strtoull(token, &end, 0);
+    return ((end == token) || (*end != '\0')) ? -1 : 0;
+}
+
+// Checks an SRAM range lies within SRAM, without overflowing for any addr or
+// len
+static int epio_desc_sram_range(uint64_t addr, uint64_t len) {
+    return ((addr >= MIN_SRAM_ADDR) && (addr <= MAX_SRAM_ADDR) && (len > 0) && (len - 1 <= MAX_SRAM_ADDR - addr)) ? 0 : -1;
+}
+
+// Checks a shiftctrl value joins the FIFOs in a valid combination - at most
+// one of FJOIN_RX and FJOIN_TX, and neither with FJOIN_RX_PUT or FJOIN_RX_GET
+static int epio_desc_fjoin(uint64_t shiftctrl) {
+    uint8_t join = (shiftctrl & (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX)) != 0;
+    uint8_t both = (shiftctrl & (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX)) == (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX);
+    uint8_t putget = (shiftctrl & (SHIFTCTRL_FJOIN_RX_PUT | SHIFTCTRL_FJOIN_RX_GET)) != 0;
+    return (both || (join && putget)) ? -1 : 0;
+}
+
+// Checks an instruction to execute on an SM isn't a reserved encoding, and
+// only accesses the RX FIFO registers in the mode the SM's RX FIFO is in
+static int epio_desc_exec_instr(epio_t *epio, uint8_t block, uint8_t sm, uint16_t instr) {
+    switch ((instr >> 13) & 0x7) {
+        case OC_IN:
+            return (((instr >> 5) & 0b110) == 0b100) ? -1 : 0;
+
+        case OC_PUSH_PULL_MOV:
+            if (((instr >> 4) & 0b1) == 0) {
+                return ((instr & 0b11111) != 0) ? -1 : 0;
+            }
+            if (((instr & 0b1100100) != 0) || (!((instr >> 3) & 0b1) && ((instr & 0b11) != 0))) {
+                return -1;
+            }
+            // MOV OSR, RXFIFO[] needs FJOIN_RX_GET, MOV RXFIFO[], ISR needs
+            // FJOIN_RX_PUT
+            uint8_t mode = ((instr >> 7) & 0b1) ? FJOIN_RX_GET_GET(block, sm) : FJOIN_RX_PUT_GET(block, sm);
+            return mode ? 0 : -1;
+
+        case OC_MOV:
+            return (((instr & 0b111) == 0b100) || (((instr >> 3) & 0b11) == 0b11)) ? -1 : 0;
+
+        case OC_SET:
+            ;
+            uint8_t dest = (instr >> 5) & 0b111;
+            return ((dest == 0b011) || (dest > SET_DEST_PIN_DIRS)) ? -1 : 0;
+
+        default:
+            return 0;
+    }
+}
+
+// Loads the rest of a file into SRAM at addr
+static int epio_desc_sram_file(epio_t *epio, uint64_t addr, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    uint8_t buf[SRAM_PAGE_SIZE];
+    int rc = 0;
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+        if (epio_desc_sram_range(addr, len) < 0) {
+            rc = -1;
+            break;
+        }
+        epio_sram_set(epio, addr, buf, len);
+        addr += len;
+    }
+    if (ferror(file)) {
+        // LCOV_EXCL_START
+        rc = -1;
+        // LCOV_EXCL_STOP
+    }
+    fclose(file);
+    return rc;
+}
+
+// Applies one directive to epio.  Returns 0 on success, -1 if any argument
+// is invalid.
+static int epio_desc_apply(
+    epio_t *epio,
+    epio_desc_id_t id,
+    const uint64_t *args,
+    uint32_t num_args,
+    const char *path
+) {
+    // Most directives start with a block and SM, or a GPIO
+    uint8_t block_sm = (args[0] < NUM_PIO_BLOCKS) && (args[1] < NUM_SMS_PER_BLOCK);
+    uint8_t gpio = args[0] < NUM_GPIOS;
+
+    switch (id) {
+        case DESC_SYSCLK:
+            if ((args[0] == 0) || (args[0] > UINT32_MAX)) {
+                return -1;
+            }
+            epio_set_sys_clock_hz(epio, (uint32_t)args[0]);
+            break;
+
+        case DESC_GPIOBASE:
+            if ((args[0] >= NUM_PIO_BLOCKS) || ((args[1] != 0) && (args[1] != 16))) {
+                return -1;
+            }
+            epio_set_gpiobase(epio, args[0], args[1]);
+            break;
+
+        case DESC_INSTR:
+            if ((args[0] >= NUM_PIO_BLOCKS) || (args[1] >= NUM_INSTRS_PER_BLOCK) || (num_args - 2 > NUM_INSTRS_PER_BLOCK - args[1])) {
+                return -1;
+            }
+            for (uint32_t ii = 2; ii < num_args; ii++) {
+                if (args[ii] > UINT16_MAX) {
+                    return -1;
+                }
+                epio_set_instr(epio, args[0], args[1] + ii - 2, args[ii]);
+            }
+            break;
+
+        case DESC_SM:
+            if (!block_sm) {
+                return -1;
+            }
+            for (uint32_t ii = 2; ii < num_args; ii++) {
+                if (args[ii] > UINT32_MAX) {
+                    return -1;
+                }
+            }
+            if (epio_desc_fjoin(args[4]) < 0) {
+                return -1;
+            }
+            epio_sm_reg_t reg = {
+                .clkdiv = args[2],
+                .execctrl = args[3],
+                .shiftctrl = args[4],
+                .pinctrl = args[5],
+            };
+            epio_set_sm_reg(epio, args[0], args[1], &reg);
+            break;
+
+        case DESC_EXEC:
+            if (!block_sm || (args[2] > UINT16_MAX) || (epio_desc_exec_instr(epio, args[0], args[1], args[2]) < 0)) {
+                return -1;
+            }
+            epio_exec_instr_sm(epio, args[0], args[1], args[2]);
+            break;
+
+        case DESC_TX:
+        case DESC_RX:
+            if (!block_sm || (args[2] > UINT32_MAX)) {
+                return -1;
+            }
+            if (id == DESC_TX) {
+                if (epio_tx_fifo_depth(epio, args[0], args[1]) >= epio_tx_fifo_capacity(epio, args[0], args[1])) {
+                    return -1;
+                }
+                epio_push_tx_fifo(epio, args[0], args[1], args[2]);
+            } else {
+                if (epio_rx_fifo_depth(epio, args[0], args[1]) >= epio_rx_fifo_capacity(epio, args[0], args[1])) {
+                    return -1;
+                }
+                epio_push_rx_fifo(epio, args[0], args[1], args[2]);
+            }
+            break;
+
+        case DESC_ENABLE:
+            if (!block_sm) {
+                return -1;
+            }
+            epio_enable_sm(epio, args[0], args[1]);
+            break;
+
+        case DESC_OUTPUT:
+            if (!gpio || (args[1] >= NUM_PIO_BLOCKS)) {
+                return -1;
+            }
+            epio_set_gpio_output_control(epio, args[0], args[1]);
+            break;
+
+        case DESC_INVERT:
+        case DESC_FORCE_LOW:
+        case DESC_FORCE_HIGH:
+            if (!gpio) {
+                return -1;
+            }
+            if (id == DESC_INVERT) {
+                epio_set_gpio_input_inverted(epio, args[0], 1);
+            } else if (id == DESC_FORCE_LOW) {
+                epio_set_gpio_force_input_low(epio, args[0], 1);
+            } else {
+                epio_set_gpio_force_input_high(epio, args[0], 1);
+            }
+            break;
+
+        case DESC_DRIVE:
+            if (((args[0] | args[1]) & ~((1ULL << NUM_GPIOS) - 1)) != 0) {
+                return -1;
+            }
+            epio_drive_gpios_ext(epio, args[0], args[1]);
+            break;
+
+        case DESC_DMA:
+            if ((args[0] >= NUM_DMA_CHANNELS) ||
+                (args[1] >= NUM_PIO_BLOCKS) || (args[2] >= NUM_SMS_PER_BLOCK) ||
+                (args[3] < 1) || (args[3] > 255) ||
+                (args[4] >= NUM_PIO_BLOCKS) || (args[5] >= NUM_SMS_PER_BLOCK) ||
+                (args[6] < 1) || (args[6] > 255) ||
+                ((args[7] != 8) && (args[7] != 16) && (args[7] != 32))) {
+                return -1;
+            }
+            epio_dma_setup_read_pio_chain(epio, args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7]);
+            break;
+
+        case DESC_SRAM:
+            if (epio_desc_sram_range(args[0], num_args - 1) < 0) {
+                return -1;
+            }
+            for (uint32_t ii = 1; ii < num_args; ii++) {
+                if (args[ii] > UINT8_MAX) {
+                    return -1;
+                }
+                epio_sram_write_byte(epio, args[0] + ii - 1, args[ii]);
+            }
+            break;
+
+        case DESC_SRAM_FILE:
+            if (epio_desc_sram_range(args[0], 1) < 0) {
+                return -1;
+            }
+            return epio_desc_sram_file(epio, args[0], path);
+
+        // LCOV_EXCL_START
+        default:
+            assert(0 && "Invalid description directive");
+            break;
+        // LCOV_EXCL_STOP
+    }
+
+    return 0;
+}
+
+// Parses and applies one line.  Modifies line.  Returns 0 on success, -1 on
+// error.
+static int epio_desc_line(epio_t *epio, char *line) {
+    char *comment = strchr(line, '#');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+
+    char *save;
+    char *name = strtok_r(line, " \t\r\n", &save);
+    if (name == NULL) {
+        return 0;
+    }
+
+    epio_desc_id_t id;
+    for (id = 0; id < DESC_NUM_DIRECTIVES; id++) {
+        if (strcmp(name, desc_directives[id].name) == 0) {
+            break;
+        }
+    }
+    if (id == DESC_NUM_DIRECTIVES) {
+        return -1;
+    }
+    const epio_desc_directive_t *directive = &desc_directives[id];
+    uint32_t max_args = directive->max_args ? directive->max_args : DESC_MAX_ARGS;
+
+    // sram-file's path is its last argument, and is not a number
+    uint32_t num_numbers = (id == DESC_SRAM_FILE) ? 1 : max_args;
+    uint64_t args[DESC_MAX_ARGS] = { 0 };
+    uint32_t num_args = 0;
+    const char *path = NULL;
+    char *token;
+    while ((token = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        if (num_args == num_numbers) {
+            if ((id != DESC_SRAM_FILE) || (path != NULL)) {
+                return -1;
+            }
+            path = token;
+            continue;
+        }
+        if (epio_desc_number(token, &args[num_args]) < 0) {
+            return -1;
+        }
+        num_args++;
+    }
+    if ((num_args < directive->min_args) || ((id == DESC_SRAM_FILE) && (path == NULL))) {
+        return -1;
+    }
+
+    return epio_desc_apply(epio, id, args, num_args, path);
+}
+
+epio_t *epio_load_desc(const char *path, uint32_t *error_line) {
+    assert(path != NULL && "Path cannot be NULL");
+
+    uint32_t line_num = 0;
+    if (error_line != NULL) {
+        *error_line = 0;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    epio_t *epio = epio_init();
+    if (epio == NULL) {
+        // LCOV_EXCL_START
+        fclose(file);
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+
+    char line[DESC_MAX_LINE];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_num++;
+        size_t len = strlen(line);
+        if ((len == sizeof(line) - 1) && (line[len - 1] != '\n')) {
+            // The line fills the buffer, so is too long unless it ends here
+            int next = fgetc(file);
+            if ((next != EOF) && (next != '\n')) {
+                goto error;
+            }
+        }
+        if (epio_desc_line(epio, line) < 0) {
+            goto error;
+        }
+    }
+    if (ferror(file)) {
+        // LCOV_EXCL_START
+        line_num = 0;
+        goto error;
+        // LCOV_EXCL_STOP
+    }
+
+    fclose(file);
+    return epio;
+
+error:
+    if (error_line != NULL) {
+        *error_line = line_num;
+    }
+    epio_free(epio);
+    fclose(file);
+    return NULL;
+}
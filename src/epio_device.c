@@ -0,0 +1,148 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Device models
+//
+// While any model is attached, epio_after_step() calls epio_devices_step()
+// after every cycle.  This compares the GPIO levels with those of the
+// previous cycle once, and passes each model only the changes on its own
+// GPIOs, so a cycle with no changes costs a compare per model.
+//
+// The levels compared are those before any model drives, so that one
+// model's drives are seen by every model, including itself, on the next
+// cycle.
+//
+// Models may attach and detach models from their callbacks, so the devices
+// are only freed when the last is detached outside of a callback.
+
+#include <stdlib.h>
+#include <epio_priv.h>
+
+typedef struct {
+    uint8_t attached;
+    uint64_t mask;
+    epio_device_ops_t ops;
+    void *ctx;
+} epio_device_t;
+
+struct epio_devices_t {
+    epio_device_t device[EPIO_MAX_DEVICES];
+
+    // Number of models attached
+    uint32_t count;
+
+    // GPIO levels on the previous cycle
+    uint64_t levels;
+
+    // Whether the models are being called
+    uint8_t stepping;
+};
+
+#define DEVICES     epio->devices
+
+static void epio_devices_release(epio_t *epio) {
+    free(DEVICES);
+    DEVICES = NULL;
+}
+
+int epio_device_attach(epio_t *epio, uint64_t mask, const epio_device_ops_t *ops, void *ctx) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO_MASK(mask);
+    assert(ops != NULL && "Device ops cannot be NULL");
+
+    if (DEVICES == NULL) {
+        DEVICES = (epio_devices_t *)calloc(1, sizeof(epio_devices_t));
+        if (DEVICES == NULL) {
+            // LCOV_EXCL_START
+            return -1;
+            // LCOV_EXCL_STOP
+        }
+        DEVICES->levels = epio_gpio_levels(epio);
+    }
+
+    for (int id = 0; id < EPIO_MAX_DEVICES; id++) {
+        epio_device_t *device = &DEVICES->device[id];
+        if (!device->attached) {
+            device->attached = 1;
+            device->mask = mask;
+            device->ops = *ops;
+            device->ctx = ctx;
+            DEVICES->count++;
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+void epio_device_detach(epio_t *epio, int id) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert((id >= 0) && (id < EPIO_MAX_DEVICES) && "Invalid device ID");
+    assert((DEVICES != NULL) && DEVICES->device[id].attached && "Device not attached");
+
+    epio_device_t *device = &DEVICES->device[id];
+    device->attached = 0;
+    DEVICES->count--;
+    if (device->ops.free != NULL) {
+        device->ops.free(device->ctx);
+    }
+
+    if ((DEVICES->count == 0) && !DEVICES->stepping) {
+        epio_devices_release(epio);
+    }
+}
+
+void epio_device_drive(epio_t *epio, uint64_t gpios, uint64_t level) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO_MASK(gpios);
+    CHECK_GPIO_MASK(level);
+    epio_drive_gpios_masked(epio, gpios, gpios, level);
+}
+
+void epio_device_release(epio_t *epio, uint64_t gpios) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_GPIO_MASK(gpios);
+    epio_drive_gpios_masked(epio, gpios, 0, 0);
+}
+
+void epio_devices_step(epio_t *epio) {
+    uint64_t levels = epio_gpio_levels(epio);
+    uint64_t changed = levels ^ DEVICES->levels;
+    DEVICES->levels = levels;
+
+    DEVICES->stepping = 1;
+    for (int id = 0; id < EPIO_MAX_DEVICES; id++) {
+        epio_device_t *device = &DEVICES->device[id];
+        if (!device->attached) {
+            continue;
+        }
+        if (device->ops.step != NULL) {
+            device->ops.step(device->ctx, epio);
+        }
+        if ((device->ops.pins_changed != NULL) && device->attached && (changed & device->mask)) {
+            device->ops.pins_changed(device->ctx, epio, levels, changed & device->mask);
+        }
+    }
+    DEVICES->stepping = 0;
+
+    if (DEVICES->count == 0) {
+        epio_devices_release(epio);
+    }
+}
+
+void epio_devices_free(epio_t *epio) {
+    if (DEVICES == NULL) {
+        return;
+    }
+    for (int id = 0; id < EPIO_MAX_DEVICES; id++) {
+        if (DEVICES->device[id].attached) {
+            epio_device_detach(epio, id);
+            if (DEVICES == NULL) {
+                break;
+            }
+        }
+    }
+}
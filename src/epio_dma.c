@@ -83,14 +83,14 @@ void epio_dma_step(epio_t *epio) {
             }
             if (write) {
                 EPIO_DBG("  DMA channel %d write", ii);
-                uint8_t tx_fifo_depth = epio_tx_fifo_depth(epio, dma->write_block, dma->write_sm);
-                if (tx_fifo_depth >= MAX_FIFO_DEPTH) {
+                uint8_t tx_fifo_depth = TX_FIFO_LEVEL(dma->write_block, dma->write_sm);
+                if (tx_fifo_depth >= TX_FIFO_CAPACITY(dma->write_block, dma->write_sm)) {
                     EPIO_DBG("  DMA channel %d write stalled: TX FIFO full", ii);
                     printf("  DMA channel %d write stalled: TX FIFO full\n", ii);
                     dma->write_delay = 1; // Check again next cycle
                 } else {
                     EPIO_DBG("  DMA channel %d writing value 0x%08X", ii, dma->read_value);
-                    epio_push_tx_fifo(epio, dma->write_block, dma->write_sm, dma->read_value);
+                    epio_fifo_push_tx(epio, dma->write_block, dma->write_sm, dma->read_value);
                     dma->read_value = 0;
                 }
             }
@@ -132,9 +132,9 @@ void epio_dma_step(epio_t *epio) {
             // Finally, if we don't have a read pending, see if there's data
             // in the read SM RX FIFO that should trigger a new read.
             if (dma->read_delay == 0) {
-                uint8_t rx_fifo_depth = epio_rx_fifo_depth(epio, dma->read_block, dma->read_sm);
+                uint8_t rx_fifo_depth = RX_FIFO_LEVEL(dma->read_block, dma->read_sm);
                 if (rx_fifo_depth > 0) {
-                    uint32_t read_addr = epio_pop_rx_fifo(epio, dma->read_block, dma->read_sm);
+                    uint32_t read_addr = epio_fifo_pop_rx(epio, dma->read_block, dma->read_sm);
                     EPIO_DBG("  DMA channel %d new read triggered: address 0x%08X", ii, read_addr);
                     dma->read_addr = read_addr;
                     dma->read_delay = dma->read_cycles;  // Start the delay counter
@@ -6,6 +6,7 @@
 //
 // Routines to execute PIO instructions, step SMs, and manage cycle counts
 
+#include <string.h>
 #include <epio.h>
 #include <epio_priv.h>
 #include <apio_dis.h>
@@ -30,28 +31,106 @@ uint16_t epio_get_instr(epio_t *epio, uint8_t block, uint8_t instr_num) {
 // Step all enabled SMs once.
 void epio_step_cycles(epio_t *epio, uint32_t cycles) {
     assert(cycles > 0 && "Must step at least one cycle");
-    for (uint32_t ii = 0; ii < cycles; ii++) {
-        EPIO_DBG("Step...");
-
-        // !!!
-        //
-        // It is important that SMs be stepped in ascending order, as in this
-        // way any GPIO output setting clashes between SMs will be resolved in
-        // the correct way - that is highest numbered SM takes precedence, as
-        // per the datasheet.
-        //
-        // !!!
-        for (int block = 0; block < NUM_PIO_BLOCKS; block++) {
-            for (int sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
-                if (SM(block, sm).enabled) {
-                    epio_sm_step(epio, block, sm);
-                }
+    if ((epio->stimulus == NULL) && (epio->schedule == NULL)) {
+        epio_run_recorded(epio, cycles);
+        return;
+    }
+
+    // Playing stimulus, or performing scheduled actions, so run up to the
+    // cycle of each edge or action, and apply it before that cycle is
+    // executed.  Actions due now are performed first.
+    if (epio->schedule != NULL) {
+        epio_schedule_apply(epio);
+    }
+    while (cycles > 0) {
+        uint32_t run = cycles;
+        uint64_t next = UINT64_MAX;
+        if (epio->stimulus != NULL) {
+            next = epio_stimulus_next_cycle(epio);
+        }
+        if ((epio->schedule != NULL) && (epio_schedule_next_cycle(epio) < next)) {
+            next = epio_schedule_next_cycle(epio);
+        }
+        if (next - epio->cycle_count < run) {
+            run = (uint32_t)(next - epio->cycle_count);
+        }
+        epio_run_recorded(epio, run);
+        cycles -= run;
+        if (epio->stimulus != NULL) {
+            epio_stimulus_apply(epio);
+        }
+        if (epio->schedule != NULL) {
+            epio_schedule_apply(epio);
+        }
+    }
+}
+
+// Runs the emulation for the given number of cycles, recording history if
+// enabled
+void epio_run_recorded(epio_t *epio, uint32_t cycles) {
+    if (epio->history != NULL) {
+        // Recording history, which takes checkpoints between runs of cycles
+        epio_history_step(epio, cycles);
+    } else {
+        epio_run_cycles(epio, cycles);
+    }
+}
+
+// Runs the emulation for a single cycle
+static inline void epio_cycle(epio_t *epio) {
+    EPIO_DBG("Step...");
+
+    // !!!
+    //
+    // It is important that SMs be stepped in ascending order, as in this
+    // way any GPIO output setting clashes between SMs will be resolved in
+    // the correct way - that is highest numbered SM takes precedence, as
+    // per the datasheet.
+    //
+    // !!!
+    for (int block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (int sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            if (SM(block, sm).enabled) {
+                epio_sm_step(epio, block, sm);
             }
         }
-        epio_finish_step(epio);
-        epio_after_step(epio);
-        epio->cycle_count++;
     }
+    epio_finish_step(epio);
+    epio_after_step(epio);
+    epio->cycle_count++;
+}
+
+// Samples the state for the trace and capture, which observe it before each
+// cycle, so including any inputs made since the previous run, and after the
+// last
+static inline void epio_observe(epio_t *epio) {
+    if (epio->trace != NULL) {
+        epio_trace_sample(epio);
+    }
+    if (epio->capture != NULL) {
+        epio_capture_sample(epio);
+    }
+}
+
+// Runs the emulation for the given number of cycles, without recording any
+// history
+void epio_run_cycles(epio_t *epio, uint32_t cycles) {
+    if ((epio->trace == NULL) && (epio->recorder == NULL) && (epio->capture == NULL)) {
+        for (uint32_t ii = 0; ii < cycles; ii++) {
+            epio_cycle(epio);
+        }
+        return;
+    }
+
+    // The recorder samples the changes made by each cycle after it
+    for (uint32_t ii = 0; ii < cycles; ii++) {
+        epio_observe(epio);
+        epio_cycle(epio);
+        if (epio->recorder != NULL) {
+            epio_recorder_sample(epio);
+        }
+    }
+    epio_observe(epio);
 }
 
 uint64_t epio_get_cycle_count(epio_t *epio) {
@@ -59,9 +138,32 @@ uint64_t epio_get_cycle_count(epio_t *epio) {
 }
 
 void epio_reset_cycle_count(epio_t *epio) {
+    // History, stimulus, trace, recorder, capture, checks, scheduled actions,
+    // stream statistics and FIFO statistics are indexed by cycle count, so
+    // are no longer valid
+    epio_history_disable(epio);
+    epio_stimulus_detach(epio);
+    epio_trace_stop(epio);
+    epio_recorder_disable(epio);
+    epio_capture_stop(epio, NULL);
+    epio_check_clear(epio);
+    epio_schedule_clear(epio);
+    epio_streams_free(epio);
+    epio_fifo_stats_disable(epio);
     epio->cycle_count = 0;
 }
 
+void epio_set_sys_clock_hz(epio_t *epio, uint32_t hz) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(hz > 0 && "System clock frequency must be non-zero");
+    epio->sys_clock_hz = hz;
+}
+
+uint32_t epio_get_sys_clock_hz(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    return epio->sys_clock_hz;
+}
+
 // Does any final work after all SMs have executed, like combining GPIO output
 // from multiple SMs, deactivating IRQs if they were waited on, etc.
 static void epio_finish_step(epio_t *epio) {
@@ -77,9 +179,27 @@ static void epio_finish_step(epio_t *epio) {
 }
 
 // Handles any non-PIO work that needs to be done after each step, like
-// DMA chains
+// DMA chains, FIFO streams, timing checks and device models
 static void epio_after_step(epio_t *epio) {
     epio_dma_step(epio);
+    if (epio->streams != NULL) {
+        epio_streams_step(epio);
+    }
+    if (epio->checks != NULL) {
+        epio_checks_step(epio);
+    }
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_step(epio);
+    }
+    if (epio->devices != NULL) {
+        epio_devices_step(epio);
+    }
+
+    // SM events are only consumed by streams, checks and FIFO statistics, so
+    // only need clearing for the next cycle while there are any
+    if ((epio->streams != NULL) || (epio->checks != NULL) || (epio->fifo_counters != NULL)) {
+        memset(epio->sm_events, 0, sizeof(epio->sm_events));
+    }
 }
 
 static void epio_sm_step(epio_t *epio, uint8_t block, uint8_t sm) {
@@ -371,14 +491,15 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
             uint8_t autopush = AUTOPUSH_GET(block, sm);
             uint8_t push_threshold = PUSH_THRESH_GET(block, sm);
             if (autopush && SM(block, sm).isr_count >= push_threshold) {
-                if (epio_rx_fifo_depth(epio, block, sm) < MAX_FIFO_DEPTH) {
-                    epio_push_rx_fifo(epio, block, sm, SM(block, sm).isr);
+                if (RX_FIFO_LEVEL(block, sm) < RX_FIFO_CAPACITY(block, sm)) {
+                    epio_fifo_push_rx(epio, block, sm, SM(block, sm).isr);
                     SM(block, sm).isr = 0;
                     SM(block, sm).isr_count = 0;
                     SM(block, sm).stalled = 0;
                 } else {
                     // FIFO full - stall
                     SM(block, sm).stalled = 1;
+                    SM_EVENTS(block, sm) |= SM_EVENT_RX_STALL;
                     dont_update_pc = 1;
                     process_new_delay = 0;
                 }
@@ -392,14 +513,15 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
             uint8_t pull_threshold = PULL_THRESH_GET(block, sm);
                     
             if (autopull && SM(block, sm).osr_count >= pull_threshold) {
-                if (epio_tx_fifo_depth(epio, block, sm) > 0) {
+                if (TX_FIFO_LEVEL(block, sm) > 0) {
                     // Pull fresh data and unstall
-                    SM(block, sm).osr = epio_pop_tx_fifo(epio, block, sm);
+                    SM(block, sm).osr = epio_fifo_pop_tx(epio, block, sm);
                     SM(block, sm).osr_count = 0;
                     SM(block, sm).stalled = 0;
                 } else {
                     // Stall - don't execute OUT
                     SM(block, sm).stalled = 1;
+                    SM_EVENTS(block, sm) |= SM_EVENT_TX_STALL;
                     dont_update_pc = 1;
                     process_new_delay = 0;
                     break;  // Exit case early
@@ -491,12 +613,32 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
 
         case OC_PUSH_PULL_MOV:
             ;
-            uint8_t bit_3 = (instr >> 3) & 0b1;
-            assert(bit_3 == 0 && "MOV to/from RX FIFO not yet implemented");
-
             uint8_t is_pull = (instr >> 7) & 0b1;
-            
-            if (is_pull) {
+
+            if ((instr >> 4) & 0b1) {
+                // MOV to/from RXFIFO[], indexed by the immediate if IdxI is
+                // set, otherwise by Y
+                assert((instr & 0b1100100) == 0 && "Reserved MOV to/from RX FIFO encoding");
+                uint8_t idx_i = (instr >> 3) & 0b1;
+                uint8_t rx_index = instr & 0b11;
+                if (!idx_i) {
+                    assert(rx_index == 0 && "Reserved MOV to/from RX FIFO index");
+                    rx_index = SM(block, sm).y & 0b11;
+                }
+
+                if (is_pull) {
+                    // MOV OSR, RXFIFO[] - resets the output shift count, as
+                    // MOV to OSR does
+                    assert(FJOIN_RX_GET_GET(block, sm) && "MOV from RX FIFO requires FJOIN_RX_GET");
+                    SM(block, sm).osr = RX_PUTGET(block, sm, rx_index);
+                    SM(block, sm).osr_count = 0;
+                } else {
+                    // MOV RXFIFO[], ISR - leaves the ISR unchanged
+                    assert(FJOIN_RX_PUT_GET(block, sm) && "MOV to RX FIFO requires FJOIN_RX_PUT");
+                    RX_PUTGET(block, sm, rx_index) = SM(block, sm).isr;
+                }
+            } else if (is_pull) {
+                assert((instr & 0b11111) == 0 && "Reserved PULL encoding");
                 // PULL
                 uint8_t if_empty = (instr >> 6) & 0b1;
                 uint8_t block_bit = (instr >> 5) & 0b1;
@@ -517,8 +659,8 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                 }
                 
                 if (should_pull) {
-                    if (epio_tx_fifo_depth(epio, block, sm) > 0) {
-                        SM(block, sm).osr = epio_pop_tx_fifo(epio, block, sm);
+                    if (TX_FIFO_LEVEL(block, sm) > 0) {
+                        SM(block, sm).osr = epio_fifo_pop_tx(epio, block, sm);
                         SM(block, sm).osr_count = 0;
                         SM(block, sm).stalled = 0;
                     } else {
@@ -526,6 +668,7 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                         if (block_bit) {
                             // Stall
                             SM(block, sm).stalled = 1;
+                            SM_EVENTS(block, sm) |= SM_EVENT_TX_STALL;
                             dont_update_pc = 1;
                             process_new_delay = 0;
                         } else {
@@ -537,6 +680,7 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                     }
                 }
             } else {
+                assert((instr & 0b11111) == 0 && "Reserved PUSH encoding");
                 // PUSH
                 uint8_t if_full = (instr >> 6) & 0b1;
                 uint8_t block_bit = (instr >> 5) & 0b1;
@@ -551,8 +695,8 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                 }
                 
                 if (should_push) {
-                    if (epio_rx_fifo_depth(epio, block, sm) < MAX_FIFO_DEPTH) {
-                        epio_push_rx_fifo(epio, block, sm, SM(block, sm).isr);
+                    if (RX_FIFO_LEVEL(block, sm) < RX_FIFO_CAPACITY(block, sm)) {
+                        epio_fifo_push_rx(epio, block, sm, SM(block, sm).isr);
                         SM(block, sm).isr = 0;
                         SM(block, sm).isr_count = 0;
                         SM(block, sm).stalled = 0;
@@ -561,12 +705,15 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                         if (block_bit) {
                             // Stall
                             SM(block, sm).stalled = 1;
+                            SM_EVENTS(block, sm) |= SM_EVENT_RX_STALL;
                             dont_update_pc = 1;
                             process_new_delay = 0;
                         } else {
-                            // Non-blocking: clear ISR, lose data, set error flag (not implemented)
+                            // Non-blocking: clear ISR, losing its data, which
+                            // checks and FIFO statistics count from the event
                             SM(block, sm).isr = 0;
                             SM(block, sm).isr_count = 0;
+                            SM_EVENTS(block, sm) |= SM_EVENT_RX_LOST;
                         }
                     }
                 }
@@ -616,11 +763,11 @@ uint8_t epio_exec_instr_sm(epio_t *epio, uint8_t block, uint8_t sm, uint16_t ins
                     
                     switch (status_sel) {
                         case 0b00: // TXLEVEL
-                            mov_value = (epio_tx_fifo_depth(epio, block, sm) < status_n) ? 0xFFFFFFFF : 0;
+                            mov_value = (TX_FIFO_LEVEL(block, sm) < status_n) ? 0xFFFFFFFF : 0;
                             break;
                             
                         case 0b01: // RXLEVEL
-                            mov_value = (epio_rx_fifo_depth(epio, block, sm) < status_n) ? 0xFFFFFFFF : 0;
+                            mov_value = (RX_FIFO_LEVEL(block, sm) < status_n) ? 0xFFFFFFFF : 0;
                             break;
                             
                         case 0b10: // IRQ
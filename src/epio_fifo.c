@@ -6,6 +6,7 @@
 //
 // FIFO handling
 
+#include <string.h>
 #include <epio_priv.h>
 
 // Wait for a certain number of steps for something to be pushed to the TX
@@ -18,7 +19,7 @@ int32_t epio_wait_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, int32_t count
     CHECK_BLOCK_SM();
     int32_t steps = 0;
     while ((count == -1) || (steps < count)) {
-        if (SM(block, sm).fifo.tx_fifo_count > 0) {
+        if (TX_FIFO_LEVEL(block, sm) > 0) {
             return steps;
         }
         steps++;
@@ -30,52 +31,91 @@ int32_t epio_wait_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, int32_t count
 // Returns the current depth of the TX FIFO for the specified SM
 uint8_t epio_tx_fifo_depth(epio_t *epio, uint8_t block, uint8_t sm) {
     CHECK_BLOCK_SM();
-    return SM(block, sm).fifo.tx_fifo_count;
+    return TX_FIFO_LEVEL(block, sm);
 }
 
 // Returns the current depth of the RX FIFO for the specified SM
 uint8_t epio_rx_fifo_depth(epio_t *epio, uint8_t block, uint8_t sm) {
     CHECK_BLOCK_SM();
-    return SM(block, sm).fifo.rx_fifo_count;
+    return RX_FIFO_LEVEL(block, sm);
 }
 
-uint32_t epio_pop_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm)
-{
+uint32_t epio_pop_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm) {
     CHECK_BLOCK_SM();
-    assert(FIFO(block, sm).tx_fifo_count > 0);
-    uint32_t value = FIFO(block, sm).tx_fifo[0];
+    assert(TX_FIFO_LEVEL(block, sm) > 0);
+    uint32_t value = epio_fifo_pop_tx(epio, block, sm);
     EPIO_DBG("  Popping from PIO%d SM%d TX FIFO: 0x%08X", block, sm, value);
-    FIFO(block, sm).tx_fifo_count--;
-    for (int i = 0; i < FIFO(block, sm).tx_fifo_count; i++) {
-        FIFO(block, sm).tx_fifo[i] = FIFO(block, sm).tx_fifo[i + 1];
-    }
     return value;
 }
 
 uint32_t epio_pop_rx_fifo(epio_t *epio, uint8_t block, uint8_t sm) {
     CHECK_BLOCK_SM();
-    assert(FIFO(block, sm).rx_fifo_count > 0);
-    uint32_t value = FIFO(block, sm).rx_fifo[0];
+    assert(RX_FIFO_LEVEL(block, sm) > 0);
+    uint32_t value = epio_fifo_pop_rx(epio, block, sm);
     EPIO_DBG("  Popping from PIO%d SM%d RX FIFO: 0x%08X", block, sm, value);
-    FIFO(block, sm).rx_fifo_count--;
-    for (int i = 0; i < FIFO(block, sm).rx_fifo_count; i++) {
-        FIFO(block, sm).rx_fifo[i] = FIFO(block, sm).rx_fifo[i + 1];
-    }
     return value;
 }
 
 void epio_push_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint32_t value) {
     CHECK_BLOCK_SM();
-    assert(FIFO(block, sm).tx_fifo_count < MAX_FIFO_DEPTH);
+    assert(TX_FIFO_LEVEL(block, sm) < TX_FIFO_CAPACITY(block, sm));
     EPIO_DBG("  Pushing to PIO%d SM%d TX FIFO: 0x%08X", block, sm, value);
-    FIFO(block, sm).tx_fifo[FIFO(block, sm).tx_fifo_count++] = value;
-    return;
+    epio_fifo_push_tx(epio, block, sm, value);
 }
 
 void epio_push_rx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint32_t value) {
     CHECK_BLOCK_SM();
-    assert(FIFO(block, sm).rx_fifo_count < MAX_FIFO_DEPTH);
+    assert(RX_FIFO_LEVEL(block, sm) < RX_FIFO_CAPACITY(block, sm));
     EPIO_DBG("  Pushing to PIO%d SM%d RX FIFO: 0x%08X", block, sm, value);
-    FIFO(block, sm).rx_fifo[FIFO(block, sm).rx_fifo_count++] = value;
-    return;
-}
\ No newline at end of file
+    epio_fifo_push_rx(epio, block, sm, value);
+}
+
+uint8_t epio_tx_fifo_capacity(epio_t *epio, uint8_t block, uint8_t sm) {
+    CHECK_BLOCK_SM();
+    return TX_FIFO_CAPACITY(block, sm);
+}
+
+uint8_t epio_rx_fifo_capacity(epio_t *epio, uint8_t block, uint8_t sm) {
+    CHECK_BLOCK_SM();
+    return RX_FIFO_CAPACITY(block, sm);
+}
+
+uint32_t epio_get_rx_putget(epio_t *epio, uint8_t block, uint8_t sm, uint8_t index) {
+    CHECK_BLOCK_SM();
+    assert(index < NUM_RX_PUTGET && "Invalid RXF PUTGET register index");
+    assert((FJOIN_RX_PUT_GET(block, sm) || FJOIN_RX_GET_GET(block, sm)) && "RX FIFO is not in PUT/GET mode");
+    return RX_PUTGET(block, sm, index);
+}
+
+void epio_set_rx_putget(epio_t *epio, uint8_t block, uint8_t sm, uint8_t index, uint32_t value) {
+    CHECK_BLOCK_SM();
+    assert(index < NUM_RX_PUTGET && "Invalid RXF PUTGET register index");
+    assert((FJOIN_RX_PUT_GET(block, sm) || FJOIN_RX_GET_GET(block, sm)) && "RX FIFO is not in PUT/GET mode");
+    RX_PUTGET(block, sm, index) = value;
+}
+
+// Flushes an SM's FIFOs, and sets their capacities from its SHIFTCTRL FJOIN
+// bits.  Called when those bits change.
+void epio_fifo_configure(epio_t *epio, uint8_t block, uint8_t sm) {
+    uint32_t shiftctrl = REG(block, sm).shiftctrl;
+    uint32_t join = shiftctrl & (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX);
+    uint32_t putget = shiftctrl & (SHIFTCTRL_FJOIN_RX_PUT | SHIFTCTRL_FJOIN_RX_GET);
+    assert(join != (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX) && "FJOIN_RX and FJOIN_TX cannot both be set");
+    assert(!(join && putget) && "FJOIN_RX_PUT/GET cannot be set with FJOIN_RX or FJOIN_TX");
+
+    if (epio->fifo_counters != NULL) {
+        epio_fifo_stats_level(epio, block, sm, 1, 0);
+        epio_fifo_stats_level(epio, block, sm, 0, 0);
+    }
+    memset(&FIFO(block, sm), 0, sizeof(epio_fifo_state_t));
+    if (join == SHIFTCTRL_FJOIN_RX) {
+        FIFO(block, sm).rx_fifo_capacity = MAX_JOINED_FIFO_DEPTH;
+    } else if (join == SHIFTCTRL_FJOIN_TX) {
+        FIFO(block, sm).tx_fifo_capacity = MAX_JOINED_FIFO_DEPTH;
+    } else {
+        FIFO(block, sm).tx_fifo_capacity = MAX_FIFO_DEPTH;
+        FIFO(block, sm).rx_fifo_capacity = putget ? 0 : MAX_FIFO_DEPTH;
+    }
+    EPIO_DBG("  PIO%d SM%d FIFO capacities TX %d RX %d", block, sm,
+        FIFO(block, sm).tx_fifo_capacity, FIFO(block, sm).rx_fifo_capacity);
+}
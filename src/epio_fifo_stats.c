@@ -0,0 +1,143 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// FIFO statistics
+//
+// Level histograms are updated only when a FIFO's level changes - the FIFO
+// accessors call epio_fifo_stats_level() beforehand, which adds the cycles
+// since the previous change to the outgoing level.  Stalls and lost words
+// are counted from the SM events by epio_fifo_stats_step(), which
+// epio_after_step() calls after every cycle while statistics are enabled.
+//
+// After epio_seek() rewinds, cycles up to the furthest reached are not
+// counted again.  Each FIFO's level as of its last counted change is kept,
+// so it still accounts for the cycles from that change to the furthest.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+_Static_assert(sizeof(((epio_fifo_stats_t *)0)->tx_level_cycles) == (MAX_JOINED_FIFO_DEPTH + 1) * sizeof(uint64_t), "FIFO statistics TX levels must match MAX_JOINED_FIFO_DEPTH");
+_Static_assert(sizeof(((epio_fifo_stats_t *)0)->rx_level_cycles) == (MAX_JOINED_FIFO_DEPTH + 1) * sizeof(uint64_t), "FIFO statistics RX levels must match MAX_JOINED_FIFO_DEPTH");
+
+struct epio_fifo_counters_t {
+    epio_fifo_stats_t stats[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+
+    // Cycle each FIFO's level was last accounted up to, and its level since
+    uint64_t tx_since[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+    uint64_t rx_since[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+    uint8_t tx_level[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+    uint8_t rx_level[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+
+    // The next cycle whose SM events to count.  Earlier cycles are being
+    // replayed, so are not counted again.
+    uint64_t cycle;
+};
+
+#define COUNTERS    epio->fifo_counters
+
+int epio_fifo_stats_enable(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (COUNTERS == NULL) {
+        COUNTERS = (epio_fifo_counters_t *)malloc(sizeof(epio_fifo_counters_t));
+        if (COUNTERS == NULL) {
+            // LCOV_EXCL_START
+            return -1;
+            // LCOV_EXCL_STOP
+        }
+    }
+
+    memset(COUNTERS->stats, 0, sizeof(COUNTERS->stats));
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            COUNTERS->tx_since[block][sm] = epio->cycle_count;
+            COUNTERS->rx_since[block][sm] = epio->cycle_count;
+            COUNTERS->tx_level[block][sm] = TX_FIFO_LEVEL(block, sm);
+            COUNTERS->rx_level[block][sm] = RX_FIFO_LEVEL(block, sm);
+        }
+    }
+    COUNTERS->cycle = epio->cycle_count;
+    memset(epio->sm_events, 0, sizeof(epio->sm_events));
+    return 0;
+}
+
+void epio_fifo_stats_disable(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    free(COUNTERS);
+    COUNTERS = NULL;
+}
+
+void epio_fifo_stats(epio_t *epio, epio_fifo_stats_t *stats) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(stats != NULL && "Stats cannot be NULL");
+    if (COUNTERS == NULL) {
+        memset(stats, 0, sizeof(epio_fifo_stats_t) * NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK);
+        return;
+    }
+
+    // Include the cycles since each FIFO's last change, up to the furthest
+    // cycle reached
+    uint64_t cycle = epio->cycle_count;
+    if (COUNTERS->cycle > cycle) {
+        cycle = COUNTERS->cycle;
+    }
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            *stats = COUNTERS->stats[block][sm];
+            stats->tx_level_cycles[COUNTERS->tx_level[block][sm]] += cycle - COUNTERS->tx_since[block][sm];
+            stats->rx_level_cycles[COUNTERS->rx_level[block][sm]] += cycle - COUNTERS->rx_since[block][sm];
+            stats++;
+        }
+    }
+}
+
+void epio_fifo_stats_level(epio_t *epio, uint8_t block, uint8_t sm, uint8_t tx, uint8_t level) {
+    uint64_t *since;
+    uint8_t *last;
+    uint64_t *level_cycles;
+    if (tx) {
+        since = &COUNTERS->tx_since[block][sm];
+        last = &COUNTERS->tx_level[block][sm];
+        level_cycles = COUNTERS->stats[block][sm].tx_level_cycles;
+    } else {
+        since = &COUNTERS->rx_since[block][sm];
+        last = &COUNTERS->rx_level[block][sm];
+        level_cycles = COUNTERS->stats[block][sm].rx_level_cycles;
+    }
+
+    // Changes in replayed cycles were already accounted for
+    if (epio->cycle_count >= *since) {
+        level_cycles[*last] += epio->cycle_count - *since;
+        *since = epio->cycle_count;
+        *last = level;
+    }
+}
+
+void epio_fifo_stats_step(epio_t *epio) {
+    if (epio->cycle_count < COUNTERS->cycle) {
+        return;
+    }
+    COUNTERS->cycle = epio->cycle_count + 1;
+
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            uint8_t events = SM_EVENTS(block, sm);
+            if (events == 0) {
+                continue;
+            }
+            epio_fifo_stats_t *stats = &COUNTERS->stats[block][sm];
+            if (events & SM_EVENT_TX_STALL) {
+                stats->tx_stall_cycles++;
+            }
+            if (events & SM_EVENT_RX_STALL) {
+                stats->rx_stall_cycles++;
+            }
+            if (events & SM_EVENT_RX_LOST) {
+                stats->rx_lost++;
+            }
+        }
+    }
+}
@@ -18,15 +18,13 @@ static void epio_set_gpio_input_level_internal(epio_t *epio, uint8_t pin, uint8_
 }
 
 void epio_init_gpios(epio_t *epio) {
-    // Zero out GPIO state
+    // Zero out GPIO state, which leaves all GPIOs as non-inverted inputs
     memset(&epio->gpio, 0, sizeof(epio->gpio));
 
-    // Set all GPIOs to input with level high by default
-    for (int ii = 0; ii < NUM_GPIOS; ii++) {
-        epio_set_gpio_input(epio, ii);
-        epio_set_gpio_input_level(epio, ii, 1);
-        epio_set_gpio_input_inverted(epio, ii, 0);
-    }
+    // Inputs are pulled high by default, and undriven outputs are assumed
+    // to be pulled up too
+    epio->gpio.gpio_input_state = GPIO_ALL_MASK;
+    epio->gpio.gpio_output_state = GPIO_ALL_MASK;
 }
 
 void epio_set_gpio_force_input_low(epio_t *epio, uint8_t pin, uint8_t force_low) {
@@ -175,45 +173,39 @@ void epio_drive_gpios_ext(epio_t *epio, uint64_t gpios, uint64_t level) {
     CHECK_GPIO_MASK(level);
     // This is external driving of GPIOs, so only affects the input state
     EPIO_DBG("Driving GPIOs: 0x%016llX with levels 0x%016llX", gpios, level);
-    for (int ii = 0; ii < NUM_GPIOS; ii++) {
-        if (gpios & (1ULL << ii)) {
-            epio_set_gpio_input_level(epio, ii, (level >> ii) & 0x1);
-        } else {
-            // Undriven lines are pulled up
-            epio_set_gpio_input_level(epio, ii, 1);
-        }
-    }
-    epio->gpio.ext_driven = gpios;
+    epio_drive_gpios_masked(epio, GPIO_ALL_MASK, gpios, level);
+}
+
+// Externally drives or releases the GPIOs in mask, leaving all others
+// unchanged.
+// - gpios - which of the GPIOs in mask to drive.  The rest are released.
+// - level - levels to drive those GPIOs to
+void epio_drive_gpios_masked(epio_t *epio, uint64_t mask, uint64_t gpios, uint64_t level) {
+    // Undriven lines are pulled up, and forced levels take precedence
+    uint64_t input = (level & gpios) | ~gpios;
+    input = (input & ~epio->gpio.force_input_low) | epio->gpio.force_input_high;
+
+    epio->gpio.gpio_input_state = (epio->gpio.gpio_input_state & ~mask) | (input & mask);
+    epio->gpio.ext_driven = (epio->gpio.ext_driven & ~mask) | (gpios & mask);
 }
 
 // Read the actual observable pin states
 // For each pin: if output, return output state; if input, return input state
 uint64_t epio_read_pin_states(epio_t *epio) {
-    uint64_t result = 0;
-    for (int ii = 0; ii < NUM_GPIOS; ii++) {
-        uint8_t pin_level;
-        
-        if (epio->gpio.gpio_direction & (1ULL << ii)) {
-            // Output pin - read output state (what PIO is driving)
-            pin_level = (epio->gpio.gpio_output_state >> ii) & 0x1;
-        } else {
-            // Input pin - read input state (what's externally driven)
-            pin_level = (epio->gpio.gpio_input_state >> ii) & 0x1;
-        }
-        
-        // Apply inversion if configured
-        if (epio->gpio.input_inverted & (1ULL << ii)) {
-            pin_level = !pin_level;
-        }
-        
-        if (pin_level) {
-            result |= (1ULL << ii);
-        }
-    }
+    uint64_t result = epio_gpio_levels(epio);
     CHECK_GPIO_MASK(result);
     return result;
 }
 
+// Returns the observable pin states, computed for all pins at once
+uint64_t epio_gpio_levels(epio_t *epio) {
+    // Output pins read what PIO is driving, input pins what is externally
+    // driven, and inversion is applied to both
+    uint64_t levels = (epio->gpio.gpio_direction & epio->gpio.gpio_output_state)
+        | (~epio->gpio.gpio_direction & epio->gpio.gpio_input_state);
+    return (levels ^ epio->gpio.input_inverted) & GPIO_ALL_MASK;
+}
+
 // Read which GPIOs are currently being externally driven
 uint64_t epio_read_driven_pins(epio_t *epio) {
     // A pin is driven if either externally driven OR configured as output
@@ -0,0 +1,113 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// State hashing
+//
+// The state hash covers the plain machine state (except the cycle count) and
+// all of SRAM.  The machine state is a fixed size, so is hashed in full each
+// time, from a copy with each FIFO ring rotated so its head is entry 0 - the
+// same FIFO contents hash the same wherever the ring's head has got to.  SRAM
+// is hashed a page at a time, with each page's hash cached until it is next
+// written - see epio_sram_hash().
+//
+// The machine state is hashed as raw bytes, so must contain no implicit
+// padding, whose contents are undefined after a struct is assigned.  Each
+// struct in it instead has explicit padding fields, which are zeroed with
+// the rest of the state, and the asserts below check nothing was missed.
+
+#include <string.h>
+#include <epio_priv.h>
+
+#define HASH_MUL    0x9E3779B97F4A7C15ULL
+
+// Asserts field B immediately follows field A in struct T
+#define ASSERT_ADJACENT(T, A, B) \
+    _Static_assert(offsetof(T, B) == offsetof(T, A) + sizeof(((T *)0)->A), #T "." #B " must immediately follow " #A)
+
+// Asserts field A is the last in struct T, with nothing after it
+#define ASSERT_LAST(T, A) \
+    _Static_assert(sizeof(T) == offsetof(T, A) + sizeof(((T *)0)->A), #T "." #A " must end the struct")
+
+ASSERT_ADJACENT(epio_fifo_state_t, tx_fifo, rx_fifo);
+ASSERT_ADJACENT(epio_fifo_state_t, rx_fifo, tx_fifo_count);
+ASSERT_LAST(epio_fifo_state_t, pad);
+ASSERT_ADJACENT(epio_sm_state_t, debug, pad_debug);
+ASSERT_ADJACENT(epio_sm_state_t, pad_debug, reg);
+ASSERT_ADJACENT(epio_sm_state_t, reg, x);
+ASSERT_ADJACENT(epio_sm_state_t, osr, isr_count);
+ASSERT_ADJACENT(epio_sm_state_t, pad_exec, exec_instr);
+ASSERT_ADJACENT(epio_sm_state_t, exec_instr, pad_fifo);
+ASSERT_ADJACENT(epio_sm_state_t, pad_fifo, fifo);
+ASSERT_LAST(epio_sm_state_t, fifo);
+ASSERT_ADJACENT(epio_irq_state_t, irq_to_clear, irq_to_set);
+ASSERT_LAST(epio_irq_state_t, irq_to_set);
+ASSERT_ADJACENT(epio_block_state_t, sm, irq);
+ASSERT_ADJACENT(epio_block_state_t, irq, gpio_base);
+ASSERT_ADJACENT(epio_block_state_t, gpio_base, instr);
+ASSERT_LAST(epio_block_state_t, instr);
+ASSERT_ADJACENT(epio_dma_state_t, pad, read_addr);
+ASSERT_LAST(epio_dma_state_t, read_value);
+ASSERT_LAST(epio_gpio_state_t, output_control);
+ASSERT_ADJACENT(epio_t, gpio, block);
+ASSERT_ADJACENT(epio_t, block, dma);
+ASSERT_ADJACENT(epio_t, dma, sys_clock_hz);
+ASSERT_ADJACENT(epio_t, sys_clock_hz, pad);
+ASSERT_ADJACENT(epio_t, pad, cycle_count);
+
+// Finalisation mix, from MurmurHash3's fmix64
+static inline uint64_t epio_hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Hashes len bytes of data, which must be a multiple of 8 bytes.  Different
+// seeds give unrelated hashes for the same data.
+uint64_t epio_hash_data(const void *data, size_t len, uint64_t seed) {
+    assert((len % sizeof(uint64_t)) == 0 && "Hashed length must be a multiple of 8");
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t h = epio_hash_mix(seed * HASH_MUL + len);
+
+    for (size_t ii = 0; ii < len; ii += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + ii, sizeof(word));
+        h = (h ^ epio_hash_mix(word)) * HASH_MUL;
+    }
+
+    return epio_hash_mix(h);
+}
+
+// Writes fifo to out, with each ring rotated so its head is entry 0
+static void epio_hash_fifo(const epio_fifo_state_t *fifo, epio_fifo_state_t *out) {
+    memcpy(out, fifo, sizeof(*out));
+    for (uint8_t ii = 0; ii < MAX_JOINED_FIFO_DEPTH; ii++) {
+        out->tx_fifo[ii] = fifo->tx_fifo[(fifo->tx_fifo_head + ii) & FIFO_MASK];
+        out->rx_fifo[ii] = fifo->rx_fifo[(fifo->rx_fifo_head + ii) & FIFO_MASK];
+    }
+    out->tx_fifo_head = 0;
+    out->rx_fifo_head = 0;
+}
+
+uint64_t epio_state_hash(epio_t *epio) {
+    assert(epio != NULL && "Cannot hash a NULL epio instance");
+
+    uint64_t state[(EPIO_HASHED_STATE_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    memcpy(state, epio, EPIO_HASHED_STATE_SIZE);
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            epio_fifo_state_t fifo;
+            epio_hash_fifo(&FIFO(block, sm), &fifo);
+            size_t offset = (size_t)((const uint8_t *)&FIFO(block, sm) - (const uint8_t *)epio);
+            memcpy((uint8_t *)state + offset, &fifo, sizeof(fifo));
+        }
+    }
+
+    uint64_t hash = epio_hash_data(state, EPIO_HASHED_STATE_SIZE, 0);
+    return hash ^ epio_sram_hash(epio);
+}
@@ -0,0 +1,321 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Reverse execution, via periodic checkpoints and deterministic replay
+//
+// While history is enabled, a checkpoint is taken every interval cycles.  A
+// checkpoint holds a copy of the plain machine state, plus a copy of each
+// SRAM page written since the previous checkpoint - so SRAM is stored as
+// deltas, and the first checkpoint holds every resident page.
+//
+// Emulation is deterministic, so the only things which cannot be recreated
+// by stepping forward from a checkpoint are external inputs - GPIO drives,
+// FIFO pushes and pops, IRQ and SRAM writes, configuration changes, etc.
+// Rather than logging each API call, any change made to the state between
+// runs of cycles is detected when the next run (or seek) starts, and is
+// recorded by taking a checkpoint at that cycle.  Therefore no inputs can
+// occur between two checkpoints, and seeking is restoring the nearest
+// checkpoint at or before the target, and stepping forward at most interval
+// cycles.
+//
+// FIFO streams and device models are also external inputs, but act within
+// runs of cycles, so aren't detected.  Instead, a checkpoint is taken after
+// any run with either attached, and seeking is refused while they are
+// attached, or to any cycle before that checkpoint.
+//
+// Seeking only moves around the recorded history, so it is possible to seek
+// backwards and then forwards again.  However, stepping after seeking
+// backwards starts a new timeline, and any history after the current cycle is
+// discarded.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+// A copy of one SRAM page in a checkpoint
+typedef struct {
+    uint32_t page_num;
+
+    // NULL if the page was unwritten
+    uint8_t *data;
+} epio_history_page_t;
+
+typedef struct {
+    // The plain machine state, including the cycle count
+    uint8_t state[EPIO_MACHINE_STATE_SIZE];
+
+    // SRAM pages which changed since the previous checkpoint
+    epio_history_page_t *pages;
+    uint32_t num_pages;
+} epio_checkpoint_t;
+
+struct epio_history_t {
+    // Number of cycles between periodic checkpoints
+    uint32_t interval;
+
+    // Checkpoints, in cycle order
+    epio_checkpoint_t *ckpt;
+    uint32_t num_ckpts;
+    uint32_t max_ckpts;
+
+    // The checkpoint which sram_ckpt_dirty is relative to
+    uint32_t base;
+
+    // State at the end of the last run of cycles, or seek, used to detect
+    // external inputs
+    uint8_t last_state[EPIO_MACHINE_STATE_SIZE];
+    uint64_t last_sram_writes;
+
+    // The earliest cycle which can be sought to.  Earlier cycles were run
+    // with inputs which weren't recorded, so cannot be replayed.
+    uint64_t replay_from;
+};
+
+#define HISTORY             epio->history
+#define CKPT_CYCLE(CKPT)    (*(uint64_t *)((CKPT)->state + offsetof(epio_t, cycle_count)))
+#define LAST_CKPT()         (&HISTORY->ckpt[HISTORY->num_ckpts - 1])
+
+static void epio_history_free_ckpt(epio_checkpoint_t *ckpt) {
+    for (uint32_t ii = 0; ii < ckpt->num_pages; ii++) {
+        free(ckpt->pages[ii].data);
+    }
+    free(ckpt->pages);
+    ckpt->pages = NULL;
+    ckpt->num_pages = 0;
+}
+
+// Discards all checkpoints after cycle
+static void epio_history_truncate(epio_t *epio, uint64_t cycle) {
+    while ((HISTORY->num_ckpts > 0) && (CKPT_CYCLE(LAST_CKPT()) > cycle)) {
+        epio_history_free_ckpt(LAST_CKPT());
+        HISTORY->num_ckpts--;
+    }
+}
+
+// Stores a copy of the current contents of a page in ckpt, replacing any
+// copy already there
+static void epio_history_save_page(epio_t *epio, epio_checkpoint_t *ckpt, uint32_t page_num) {
+    uint8_t *data = NULL;
+    if (epio->sram_page[page_num] != NULL) {
+        data = malloc(SRAM_PAGE_SIZE);
+        assert(data != NULL && "Failed to allocate history page");
+        memcpy(data, epio->sram_page[page_num], SRAM_PAGE_SIZE);
+    }
+
+    for (uint32_t ii = 0; ii < ckpt->num_pages; ii++) {
+        if (ckpt->pages[ii].page_num == page_num) {
+            free(ckpt->pages[ii].data);
+            ckpt->pages[ii].data = data;
+            return;
+        }
+    }
+
+    ckpt->pages = realloc(ckpt->pages, (ckpt->num_pages + 1) * sizeof(epio_history_page_t));
+    assert(ckpt->pages != NULL && "Failed to allocate history pages");
+    ckpt->pages[ckpt->num_pages].page_num = page_num;
+    ckpt->pages[ckpt->num_pages].data = data;
+    ckpt->num_pages++;
+}
+
+// Takes a checkpoint at the current cycle, discarding any later history.  If
+// there is already a checkpoint at this cycle, it is updated.
+static void epio_history_checkpoint(epio_t *epio) {
+    epio_history_truncate(epio, epio->cycle_count);
+
+    if ((HISTORY->num_ckpts == 0) || (CKPT_CYCLE(LAST_CKPT()) != epio->cycle_count)) {
+        if (HISTORY->num_ckpts == HISTORY->max_ckpts) {
+            HISTORY->max_ckpts = HISTORY->max_ckpts ? HISTORY->max_ckpts * 2 : 16;
+            HISTORY->ckpt = realloc(HISTORY->ckpt, HISTORY->max_ckpts * sizeof(epio_checkpoint_t));
+            assert(HISTORY->ckpt != NULL && "Failed to allocate history checkpoints");
+        }
+        epio_checkpoint_t *ckpt = &HISTORY->ckpt[HISTORY->num_ckpts++];
+        ckpt->pages = NULL;
+        ckpt->num_pages = 0;
+    }
+
+    epio_checkpoint_t *ckpt = LAST_CKPT();
+    memcpy(ckpt->state, epio, EPIO_MACHINE_STATE_SIZE);
+    for (uint32_t page_num = 0; page_num < SRAM_NUM_PAGES; page_num++) {
+        if ((epio->sram_ckpt_dirty[page_num / 32] >> (page_num % 32)) & 1) {
+            epio_history_save_page(epio, ckpt, page_num);
+        }
+    }
+    memset(epio->sram_ckpt_dirty, 0, sizeof(epio->sram_ckpt_dirty));
+    HISTORY->base = HISTORY->num_ckpts - 1;
+}
+
+// Records the current state, as the state to compare against to detect
+// external inputs
+static void epio_history_mark(epio_t *epio) {
+    memcpy(HISTORY->last_state, epio, EPIO_MACHINE_STATE_SIZE);
+    HISTORY->last_sram_writes = epio->sram_writes;
+}
+
+// Takes a checkpoint if there have been any external inputs since the last
+// run of cycles or seek
+static void epio_history_sync(epio_t *epio) {
+    if ((epio->sram_writes != HISTORY->last_sram_writes)
+        || (memcmp(epio, HISTORY->last_state, EPIO_MACHINE_STATE_SIZE) != 0)) {
+        epio_history_checkpoint(epio);
+    }
+}
+
+int epio_history_enable(epio_t *epio, uint32_t interval) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(interval > 0 && "History interval must be at least one cycle");
+
+    epio_history_disable(epio);
+    HISTORY = (epio_history_t *)calloc(1, sizeof(epio_history_t));
+    if (HISTORY == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    HISTORY->interval = interval;
+
+    // The first checkpoint holds every resident page
+    memset(epio->sram_ckpt_dirty, 0, sizeof(epio->sram_ckpt_dirty));
+    for (uint32_t page_num = 0; page_num < SRAM_NUM_PAGES; page_num++) {
+        if (epio->sram_page[page_num] != NULL) {
+            epio->sram_ckpt_dirty[page_num / 32] |= (1U << (page_num % 32));
+        }
+    }
+    epio_history_checkpoint(epio);
+    epio_history_mark(epio);
+
+    return 0;
+}
+
+void epio_history_disable(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (HISTORY == NULL) {
+        return;
+    }
+    for (uint32_t ii = 0; ii < HISTORY->num_ckpts; ii++) {
+        epio_history_free_ckpt(&HISTORY->ckpt[ii]);
+    }
+    free(HISTORY->ckpt);
+    free(HISTORY);
+    HISTORY = NULL;
+}
+
+void epio_history_step(epio_t *epio, uint32_t cycles) {
+    epio_history_sync(epio);
+
+    // Stepping from anywhere but the end of the history starts a new timeline
+    epio_history_truncate(epio, epio->cycle_count);
+
+    uint64_t next = CKPT_CYCLE(LAST_CKPT()) + HISTORY->interval;
+    while (cycles > 0) {
+        if (epio->cycle_count >= next) {
+            // May happen after seeking beyond the end of the history
+            epio_history_checkpoint(epio);
+            next = epio->cycle_count + HISTORY->interval;
+        }
+        uint32_t run = cycles;
+        if (next - epio->cycle_count < run) {
+            run = (uint32_t)(next - epio->cycle_count);
+        }
+        epio_run_cycles(epio, run);
+        cycles -= run;
+        if (epio->cycle_count == next) {
+            epio_history_checkpoint(epio);
+            next += HISTORY->interval;
+        }
+    }
+
+    // Words transferred by streams and GPIOs driven by device models weren't
+    // recorded, so this run cannot be replayed
+    if ((epio->streams != NULL) || (epio->devices != NULL)) {
+        epio_history_checkpoint(epio);
+        HISTORY->replay_from = epio->cycle_count;
+    }
+
+    epio_history_mark(epio);
+}
+
+int epio_seek(epio_t *epio, uint64_t cycle) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if ((HISTORY == NULL) || (cycle < CKPT_CYCLE(&HISTORY->ckpt[0]))) {
+        return -1;
+    }
+
+    // Streams and device models would run again on replayed cycles
+    if ((epio->streams != NULL) || (epio->devices != NULL) || (cycle < HISTORY->replay_from)) {
+        return -1;
+    }
+
+    // Record any inputs made at the current cycle, so they can be returned to
+    epio_history_sync(epio);
+
+    // Find the last checkpoint at or before the target cycle
+    uint32_t lo = 0;
+    uint32_t hi = HISTORY->num_ckpts - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (CKPT_CYCLE(&HISTORY->ckpt[mid]) <= cycle) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    uint32_t target = lo;
+
+    // SRAM pages which may differ from the target checkpoint are those
+    // written since the current base checkpoint, and those in any checkpoint
+    // after the earlier of the base and target
+    uint32_t restore[SRAM_SHARED_WORDS];
+    memcpy(restore, epio->sram_ckpt_dirty, sizeof(restore));
+    uint32_t first = (HISTORY->base < target) ? HISTORY->base : target;
+    for (uint32_t ii = first + 1; ii < HISTORY->num_ckpts; ii++) {
+        for (uint32_t jj = 0; jj < HISTORY->ckpt[ii].num_pages; jj++) {
+            uint32_t page_num = HISTORY->ckpt[ii].pages[jj].page_num;
+            restore[page_num / 32] |= (1U << (page_num % 32));
+        }
+    }
+
+    // Restore each to its contents in the most recent checkpoint at or before
+    // the target which holds it, or to unwritten if there is none
+    for (uint32_t page_num = 0; page_num < SRAM_NUM_PAGES; page_num++) {
+        if (!((restore[page_num / 32] >> (page_num % 32)) & 1)) {
+            continue;
+        }
+        const uint8_t *data = NULL;
+        int found = 0;
+        for (int64_t ii = target; (ii >= 0) && !found; ii--) {
+            epio_checkpoint_t *ckpt = &HISTORY->ckpt[ii];
+            for (uint32_t jj = 0; jj < ckpt->num_pages; jj++) {
+                if (ckpt->pages[jj].page_num == page_num) {
+                    data = ckpt->pages[jj].data;
+                    found = 1;
+                    break;
+                }
+            }
+        }
+        epio_sram_restore_page(epio, page_num, data);
+    }
+    memset(epio->sram_ckpt_dirty, 0, sizeof(epio->sram_ckpt_dirty));
+    HISTORY->base = target;
+
+    // Restore the machine state, and replay forward to the target cycle
+    memcpy(epio, HISTORY->ckpt[target].state, EPIO_MACHINE_STATE_SIZE);
+    while (epio->cycle_count < cycle) {
+        uint64_t run = cycle - epio->cycle_count;
+        epio_run_cycles(epio, (run > UINT32_MAX) ? UINT32_MAX : (uint32_t)run);
+    }
+
+    epio_history_mark(epio);
+
+    return 0;
+}
+
+int epio_step_back(epio_t *epio, uint64_t cycles) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (cycles > epio->cycle_count) {
+        return -1;
+    }
+    return epio_seek(epio, epio->cycle_count - cycles);
+}
@@ -0,0 +1,247 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Binary state images
+//
+// An image file holds a header, followed by the plain machine state (see
+// EPIO_MACHINE_STATE_SIZE), followed by each resident SRAM page in address
+// order.  The machine state contains no pointers, so the image is position
+// independent.  It is, however, in the host's native layout, so the header
+// records enough about that layout to refuse an image from an incompatible
+// host or epio version.
+//
+// The machine state is checked after loading, so that a corrupt image can't
+// hold a value which indexes beyond one of the state's arrays.
+//
+// SRAM pages start on an SRAM_PAGE_SIZE boundary within the file, so that
+// when the file is mmapped on load, they can be used in place, as shared
+// pages - each is copied to a private page the first time it is written.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <epio_priv.h>
+
+#define EPIO_IMAGE_MAGIC    "EPIOIMG"
+#define EPIO_IMAGE_VERSION  2
+#define EPIO_IMAGE_ENDIAN   0x01020304
+
+typedef struct {
+    // EPIO_IMAGE_MAGIC, NUL terminated
+    char magic[8];
+
+    // EPIO_IMAGE_VERSION
+    uint32_t version;
+
+    // EPIO_IMAGE_ENDIAN, as written by the saving host
+    uint32_t endian;
+
+    // EPIO_MACHINE_STATE_SIZE on the saving host
+    uint32_t state_size;
+
+    // SRAM_PAGE_SIZE and SRAM_NUM_PAGES on the saving host
+    uint32_t page_size;
+    uint32_t num_pages;
+
+    // Number of SRAM pages in the image, and which they are.  Page 0 = LSB
+    // of word 0.
+    uint32_t resident_pages;
+    uint32_t page_map[SRAM_SHARED_WORDS];
+
+    // Offsets of the machine state and the first SRAM page from the start of
+    // the file
+    uint32_t state_offset;
+    uint32_t pages_offset;
+} epio_image_header_t;
+
+#define ROUND_UP(VAL, ALIGN)    ((((VAL) + (ALIGN) - 1) / (ALIGN)) * (ALIGN))
+
+// Fills in header for epio
+static void epio_image_header(epio_t *epio, epio_image_header_t *header) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, EPIO_IMAGE_MAGIC, sizeof(EPIO_IMAGE_MAGIC));
+    header->version = EPIO_IMAGE_VERSION;
+    header->endian = EPIO_IMAGE_ENDIAN;
+    header->state_size = EPIO_MACHINE_STATE_SIZE;
+    header->page_size = SRAM_PAGE_SIZE;
+    header->num_pages = SRAM_NUM_PAGES;
+    for (uint32_t ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if (epio->sram_page[ii] != NULL) {
+            header->page_map[ii / 32] |= (1U << (ii % 32));
+            header->resident_pages++;
+        }
+    }
+    header->state_offset = sizeof(*header);
+    header->pages_offset = ROUND_UP(header->state_offset + header->state_size, SRAM_PAGE_SIZE);
+}
+
+int epio_save_image(epio_t *epio, const char *path) {
+    assert(epio != NULL && "Cannot save a NULL epio instance");
+    assert(path != NULL && "Image path cannot be NULL");
+
+    epio_image_header_t header;
+    epio_image_header(epio, &header);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    static const uint8_t padding[SRAM_PAGE_SIZE] = {0};
+    size_t pad_len = header.pages_offset - (header.state_offset + header.state_size);
+    int ok = (fwrite(&header, sizeof(header), 1, file) == 1)
+        && (fwrite(epio, header.state_size, 1, file) == 1)
+        && ((pad_len == 0) || (fwrite(padding, pad_len, 1, file) == 1));
+    for (uint32_t ii = 0; ok && (ii < SRAM_NUM_PAGES); ii++) {
+        if (epio->sram_page[ii] != NULL) {
+            ok = (fwrite(epio->sram_page[ii], SRAM_PAGE_SIZE, 1, file) == 1);
+        }
+    }
+    if (fclose(file) != 0) {
+        // LCOV_EXCL_START
+        ok = 0;
+        // LCOV_EXCL_STOP
+    }
+
+    return ok ? 0 : -1;
+}
+
+// Checks that header describes an image this host can load, of size bytes.
+static int epio_image_valid(const epio_image_header_t *header, size_t size) {
+    if ((size < sizeof(*header))
+        || (memcmp(header->magic, EPIO_IMAGE_MAGIC, sizeof(EPIO_IMAGE_MAGIC)) != 0)
+        || (header->version != EPIO_IMAGE_VERSION)
+        || (header->endian != EPIO_IMAGE_ENDIAN)
+        || (header->state_size != EPIO_MACHINE_STATE_SIZE)
+        || (header->page_size != SRAM_PAGE_SIZE)
+        || (header->num_pages != SRAM_NUM_PAGES)
+        || (header->state_offset != sizeof(*header))
+        || (header->pages_offset % SRAM_PAGE_SIZE != 0)
+        || (header->pages_offset < header->state_offset + header->state_size)) {
+        return 0;
+    }
+
+    // Count every bit in the map, so any beyond SRAM_NUM_PAGES are rejected
+    uint32_t resident_pages = 0;
+    for (uint32_t ii = 0; ii < SRAM_SHARED_WORDS * 32; ii++) {
+        resident_pages += (header->page_map[ii / 32] >> (ii % 32)) & 1;
+    }
+    if ((resident_pages != header->resident_pages)
+        || (size != header->pages_offset + (size_t)resident_pages * SRAM_PAGE_SIZE)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+// Checks the machine state loaded from an image holds only values epio could
+// have set, for every field used as an array index or bound
+static int epio_image_state_valid(const epio_t *epio) {
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        if ((epio->block[block].gpio_base != 0) && (epio->block[block].gpio_base != 16)) {
+            return 0;
+        }
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            const epio_sm_state_t *state = &epio->block[block].sm[sm];
+            const epio_fifo_state_t *fifo = &state->fifo;
+            uint32_t join = state->reg.shiftctrl & (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX);
+            uint32_t putget = state->reg.shiftctrl & (SHIFTCTRL_FJOIN_RX_PUT | SHIFTCTRL_FJOIN_RX_GET);
+            if ((state->pc >= NUM_INSTRS_PER_BLOCK)
+                || (state->isr_count > 32) || (state->osr_count > 32)
+                || (join == (SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_TX)) || (join && putget)
+                || (fifo->tx_fifo_capacity > MAX_JOINED_FIFO_DEPTH)
+                || (fifo->rx_fifo_capacity > MAX_JOINED_FIFO_DEPTH)
+                || (fifo->tx_fifo_count > fifo->tx_fifo_capacity)
+                || (fifo->rx_fifo_count > fifo->rx_fifo_capacity)
+                || (fifo->tx_fifo_head > FIFO_MASK) || (fifo->rx_fifo_head > FIFO_MASK)) {
+                return 0;
+            }
+        }
+    }
+
+    for (uint8_t ii = 0; ii < NUM_DMA_CHANNELS; ii++) {
+        const epio_dma_state_t *dma = &epio->dma[ii];
+        if (dma->setup
+            && ((dma->read_block >= NUM_PIO_BLOCKS) || (dma->read_sm >= NUM_SMS_PER_BLOCK)
+                || (dma->write_block >= NUM_PIO_BLOCKS) || (dma->write_sm >= NUM_SMS_PER_BLOCK)
+                || ((dma->bit_mode != 8) && (dma->bit_mode != 16) && (dma->bit_mode != 32)))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+epio_t *epio_load_image(const char *path) {
+    assert(path != NULL && "Image path cannot be NULL");
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(epio_image_header_t))) {
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping is read-only - SRAM pages in it are shared, so are copied
+    // before being written.
+    size_t size = (size_t)st.st_size;
+    uint8_t *image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+
+    const epio_image_header_t *header = (const epio_image_header_t *)image;
+    if (!epio_image_valid(header, size)) {
+        munmap(image, size);
+        return NULL;
+    }
+
+    epio_t *epio = epio_alloc();
+    if (epio == NULL) {
+        // LCOV_EXCL_START
+        munmap(image, size);
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    epio->image = image;
+    epio->image_size = size;
+
+    memcpy(epio, image + header->state_offset, EPIO_MACHINE_STATE_SIZE);
+    if (!epio_image_state_valid(epio)) {
+        epio_free(epio);
+        return NULL;
+    }
+
+    const uint8_t *page = image + header->pages_offset;
+    for (uint32_t ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if ((header->page_map[ii / 32] >> (ii % 32)) & 1) {
+            epio_sram_map_shared_page(epio, ii, page);
+            page += SRAM_PAGE_SIZE;
+        }
+    }
+
+    return epio;
+}
+
+// Unmaps any image this instance was loaded from.  Any SRAM pages shared
+// with it must already have been dropped.
+void epio_image_release(epio_t *epio) {
+    if (epio->image != NULL) {
+        munmap(epio->image, epio->image_size);
+        epio->image = NULL;
+        epio->image_size = 0;
+    }
+}
@@ -0,0 +1,160 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Time-indexed queries over captured GPIO edges
+//
+// The index holds a sorted array of edge cycles for each GPIO, stored end to
+// end in a single allocation, with the offset of each GPIO's array.  Each
+// query is a binary search of one GPIO's array.  A GPIO's edges alternate
+// direction, so whether edge i is rising follows from its level at the
+// start of the index and i, and the nearest edge of a given direction is at
+// most one further on from the nearest edge.
+
+#include <stdlib.h>
+#include <epio_priv.h>
+
+struct epio_index_t {
+    // First cycle covered, and the levels at it
+    uint64_t start;
+    uint64_t initial;
+
+    // GPIO N's edges are cycle[offset[N]] to cycle[offset[N + 1] - 1]
+    uint32_t offset[NUM_GPIOS + 1];
+    uint64_t cycle[];
+};
+
+#define CHECK_INDEX_PIN() \
+    assert(index != NULL && "Index cannot be NULL"); \
+    CHECK_GPIO(pin)
+
+epio_index_t *epio_index_build(const epio_edge_t *edges, uint32_t count) {
+    assert(edges != NULL && "Edges cannot be NULL");
+    assert(count > 0 && "Must have at least one edge");
+
+    uint32_t pin_edges[NUM_GPIOS] = { 0 };
+    for (uint32_t ii = 1; ii < count; ii++) {
+        assert(edges[ii].cycle >= edges[ii - 1].cycle && "Edges must be in cycle order");
+        for (uint64_t changed = edges[ii].changed; changed != 0; changed &= changed - 1) {
+            pin_edges[__builtin_ctzll(changed)]++;
+        }
+    }
+
+    uint32_t total = 0;
+    for (int pin = 0; pin < NUM_GPIOS; pin++) {
+        total += pin_edges[pin];
+    }
+    epio_index_t *index = (epio_index_t *)malloc(sizeof(epio_index_t) + total * sizeof(uint64_t));
+    if (index == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    index->start = edges[0].cycle;
+    index->initial = edges[0].value;
+
+    // Lay out each GPIO's array, using pin_edges as each one's write position
+    index->offset[0] = 0;
+    for (int pin = 0; pin < NUM_GPIOS; pin++) {
+        index->offset[pin + 1] = index->offset[pin] + pin_edges[pin];
+        pin_edges[pin] = index->offset[pin];
+    }
+    for (uint32_t ii = 1; ii < count; ii++) {
+        for (uint64_t changed = edges[ii].changed; changed != 0; changed &= changed - 1) {
+            index->cycle[pin_edges[__builtin_ctzll(changed)]++] = edges[ii].cycle;
+        }
+    }
+
+    return index;
+}
+
+void epio_index_free(epio_index_t *index) {
+    assert(index != NULL && "Index cannot be NULL");
+    free(index);
+}
+
+// Returns the number of a GPIO's edges at or before the cycle, which is the
+// index of its first edge after it
+static uint32_t index_upper_bound(const epio_index_t *index, uint8_t pin, uint64_t cycle) {
+    const uint64_t *edges = &index->cycle[index->offset[pin]];
+    uint32_t lo = 0;
+    uint32_t hi = index->offset[pin + 1] - index->offset[pin];
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (edges[mid] <= cycle) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Returns whether a GPIO's edge number num is of the given type
+static int index_edge_matches(const epio_index_t *index, uint8_t pin, uint32_t num, uint8_t type) {
+    // Edge num leaves the GPIO at the opposite of its initial level if num is
+    // even
+    uint8_t rising = ((index->initial >> pin) & 1) == (num & 1);
+    return (type & (rising ? EPIO_EDGE_RISING : EPIO_EDGE_FALLING)) != 0;
+}
+
+int epio_index_level(const epio_index_t *index, uint8_t pin, uint64_t cycle) {
+    CHECK_INDEX_PIN();
+    if (cycle < index->start) {
+        return -1;
+    }
+    return (int)(((index->initial >> pin) ^ index_upper_bound(index, pin, cycle)) & 1);
+}
+
+int epio_index_next_edge(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint8_t type, uint64_t *edge) {
+    CHECK_INDEX_PIN();
+    assert((type != 0) && ((type & ~EPIO_EDGE_ANY) == 0) && "Invalid edge type");
+    assert(edge != NULL && "Edge cannot be NULL");
+
+    uint32_t count = index->offset[pin + 1] - index->offset[pin];
+    for (uint32_t num = index_upper_bound(index, pin, cycle); num < count; num++) {
+        if (index_edge_matches(index, pin, num, type)) {
+            *edge = index->cycle[index->offset[pin] + num];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int epio_index_prev_edge(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint8_t type, uint64_t *edge) {
+    CHECK_INDEX_PIN();
+    assert((type != 0) && ((type & ~EPIO_EDGE_ANY) == 0) && "Invalid edge type");
+    assert(edge != NULL && "Edge cannot be NULL");
+
+    for (uint32_t num = index_upper_bound(index, pin, cycle); num > 0; num--) {
+        if (index_edge_matches(index, pin, num - 1, type)) {
+            *edge = index->cycle[index->offset[pin] + num - 1];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Returns the cycles between the last edge of the type at or before the
+// cycle and the next after it
+static int index_span(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint8_t type, uint64_t *span) {
+    uint64_t prev, next;
+    if ((epio_index_prev_edge(index, pin, cycle, type, &prev) != 0)
+        || (epio_index_next_edge(index, pin, cycle, type, &next) != 0)) {
+        return -1;
+    }
+    *span = next - prev;
+    return 0;
+}
+
+int epio_index_pulse_width(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint64_t *width) {
+    assert(width != NULL && "Width cannot be NULL");
+    return index_span(index, pin, cycle, EPIO_EDGE_ANY, width);
+}
+
+int epio_index_period(const epio_index_t *index, uint8_t pin, uint64_t cycle, uint64_t *period) {
+    assert(period != NULL && "Period cannot be NULL");
+    return index_span(index, pin, cycle, EPIO_EDGE_RISING, period);
+}
@@ -0,0 +1,245 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Parallel memory responder
+//
+// A device model which serves words from an image onto data GPIOs, looked
+// up from address GPIOs.  Address and data GPIOs may be scattered, so the
+// GPIO levels are translated a byte of GPIOs at a time, through tables built
+// on attach - the address from the levels, and the data GPIO levels from the
+// word - rather than a bit at a time.
+//
+// Only responders with a latency have a step callback, so a responder with
+// none costs nothing on cycles where its GPIOs do not change.
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <epio_priv.h>
+
+#define NUM_GPIO_BYTES  ((NUM_GPIOS + 7) / 8)
+#define NUM_DATA_BYTES  ((EPIO_MEM_MAX_DATA_PINS + 7) / 8)
+
+typedef struct {
+    epio_mem_config_t config;
+
+    // Backing image, and the file mapping it is in, if any
+    const uint8_t *image;
+    size_t size;
+    void *mapping;
+
+    // Bytes per word
+    uint8_t word_bytes;
+
+    uint64_t data_gpios;
+    uint64_t cs_gpio;
+    uint64_t oe_gpio;
+
+    // The bytes of GPIOs holding any address bits, and the address bits
+    // given by each value of each byte of GPIOs
+    uint8_t addr_byte[NUM_GPIO_BYTES];
+    uint8_t num_addr_bytes;
+    uint32_t addr_table[NUM_GPIO_BYTES][256];
+
+    // The data GPIO levels given by each value of each byte of a word
+    uint64_t data_table[NUM_DATA_BYTES][256];
+
+    // Cycles until the data GPIOs are updated, if non-zero, and the levels
+    // they are updated from
+    uint32_t countdown;
+    uint64_t levels;
+} epio_mem_t;
+
+// Drives the data GPIOs with the word addressed by levels if selected, and
+// otherwise releases them
+static void epio_mem_update(epio_mem_t *mem, epio_t *epio, uint64_t levels) {
+    if ((levels & (mem->cs_gpio | mem->oe_gpio)) != 0) {
+        epio_device_release(epio, mem->data_gpios);
+        return;
+    }
+
+    uint32_t addr = 0;
+    for (uint8_t ii = 0; ii < mem->num_addr_bytes; ii++) {
+        uint8_t byte = mem->addr_byte[ii];
+        addr |= mem->addr_table[byte][(levels >> (byte * 8)) & 0xFF];
+    }
+
+    uint64_t data = 0;
+    size_t offset = (size_t)addr * mem->word_bytes;
+    if ((offset < mem->size) && (mem->size - offset >= mem->word_bytes)) {
+        const uint8_t *word = mem->image + offset;
+        for (uint8_t ii = 0; ii < mem->word_bytes; ii++) {
+            data |= mem->data_table[ii][word[ii]];
+        }
+    } else {
+        data = mem->data_gpios;
+    }
+    epio_device_drive(epio, mem->data_gpios, data);
+}
+
+static void epio_mem_step(void *ctx, epio_t *epio) {
+    epio_mem_t *mem = ctx;
+    if ((mem->countdown != 0) && (--mem->countdown == 0)) {
+        epio_mem_update(mem, epio, mem->levels);
+    }
+}
+
+static void epio_mem_pins_changed(void *ctx, epio_t *epio, uint64_t levels, uint64_t changed) {
+    (void)changed;
+    epio_mem_t *mem = ctx;
+    if (mem->config.latency == 0) {
+        epio_mem_update(mem, epio, levels);
+    } else {
+        mem->countdown = mem->config.latency;
+        mem->levels = levels;
+    }
+}
+
+static void epio_mem_free(void *ctx) {
+    epio_mem_t *mem = ctx;
+    if (mem->mapping != NULL) {
+        munmap(mem->mapping, mem->size);
+    }
+    free(mem);
+}
+
+static const epio_device_ops_t epio_mem_ops = {
+    .pins_changed = epio_mem_pins_changed,
+    .free = epio_mem_free,
+};
+
+static const epio_device_ops_t epio_mem_latency_ops = {
+    .step = epio_mem_step,
+    .pins_changed = epio_mem_pins_changed,
+    .free = epio_mem_free,
+};
+
+// Attaches a responder.  If mapping is non-NULL, it is unmapped when the
+// responder is freed, or if it cannot be attached.
+static int epio_mem_attach_mapped(
+    epio_t *epio,
+    const epio_mem_config_t *config,
+    const uint8_t *image,
+    size_t size,
+    void *mapping
+) {
+    epio_mem_t *mem = (epio_mem_t *)calloc(1, sizeof(epio_mem_t));
+    if (mem == NULL) {
+        // LCOV_EXCL_START
+        if (mapping != NULL) {
+            munmap(mapping, size);
+        }
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    mem->config = *config;
+    mem->image = image;
+    mem->size = size;
+    mem->mapping = mapping;
+    mem->word_bytes = (config->num_data_pins + 7) / 8;
+
+    uint64_t watched = 0;
+    for (uint8_t ii = 0; ii < config->num_addr_pins; ii++) {
+        uint8_t pin = config->addr_pins[ii];
+        uint8_t byte = pin / 8;
+        if ((watched & (0xFFULL << (byte * 8))) == 0) {
+            mem->addr_byte[mem->num_addr_bytes++] = byte;
+        }
+        watched |= 1ULL << pin;
+        for (uint32_t value = 0; value < 256; value++) {
+            if ((value >> (pin % 8)) & 1) {
+                mem->addr_table[byte][value] |= 1U << ii;
+            }
+        }
+    }
+    if (config->cs_pin != EPIO_MEM_NO_PIN) {
+        mem->cs_gpio = 1ULL << config->cs_pin;
+    }
+    if (config->oe_pin != EPIO_MEM_NO_PIN) {
+        mem->oe_gpio = 1ULL << config->oe_pin;
+    }
+    watched |= mem->cs_gpio | mem->oe_gpio;
+
+    for (uint8_t ii = 0; ii < config->num_data_pins; ii++) {
+        uint64_t gpio = 1ULL << config->data_pins[ii];
+        mem->data_gpios |= gpio;
+        for (uint32_t value = 0; value < 256; value++) {
+            if ((value >> (ii % 8)) & 1) {
+                mem->data_table[ii / 8][value] |= gpio;
+            }
+        }
+    }
+
+    const epio_device_ops_t *ops = config->latency ? &epio_mem_latency_ops : &epio_mem_ops;
+    int id = epio_device_attach(epio, watched, ops, mem);
+    if (id < 0) {
+        epio_mem_free(mem);
+        return -1;
+    }
+    epio_mem_update(mem, epio, epio_gpio_levels(epio));
+    return id;
+}
+
+// Checks a configuration's GPIOs are valid
+static void epio_mem_check_config(const epio_mem_config_t *config) {
+    assert(config != NULL && "Memory responder config cannot be NULL");
+    assert((config->num_addr_pins >= 1) && (config->num_addr_pins <= EPIO_MEM_MAX_ADDR_PINS) && "Invalid number of address GPIOs");
+    assert((config->num_data_pins >= 1) && (config->num_data_pins <= EPIO_MEM_MAX_DATA_PINS) && "Invalid number of data GPIOs");
+    assert(((config->cs_pin < NUM_GPIOS) || (config->cs_pin == EPIO_MEM_NO_PIN)) && "Invalid chip select GPIO");
+    assert(((config->oe_pin < NUM_GPIOS) || (config->oe_pin == EPIO_MEM_NO_PIN)) && "Invalid output enable GPIO");
+    uint64_t watched = 0;
+    for (uint8_t ii = 0; ii < config->num_addr_pins; ii++) {
+        assert(config->addr_pins[ii] < NUM_GPIOS && "Invalid address GPIO");
+        watched |= 1ULL << config->addr_pins[ii];
+    }
+    if (config->cs_pin != EPIO_MEM_NO_PIN) {
+        watched |= 1ULL << config->cs_pin;
+    }
+    if (config->oe_pin != EPIO_MEM_NO_PIN) {
+        watched |= 1ULL << config->oe_pin;
+    }
+    for (uint8_t ii = 0; ii < config->num_data_pins; ii++) {
+        assert(config->data_pins[ii] < NUM_GPIOS && "Invalid data GPIO");
+        assert(((watched >> config->data_pins[ii]) & 1) == 0 && "Data GPIOs cannot overlap address or control GPIOs");
+    }
+}
+
+int epio_mem_attach(epio_t *epio, const epio_mem_config_t *config, const uint8_t *image, size_t size) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_mem_check_config(config);
+    assert((image != NULL || size == 0) && "Image cannot be NULL");
+
+    return epio_mem_attach_mapped(epio, config, image, size, NULL);
+}
+
+int epio_mem_attach_file(epio_t *epio, const epio_mem_config_t *config, const char *path) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_mem_check_config(config);
+    assert(path != NULL && "Image path cannot be NULL");
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+
+    return epio_mem_attach_mapped(epio, config, mapping, size, mapping);
+}
@@ -6,6 +6,7 @@
 //
 // Peek functions for reading internal state machine and block state
 
+#include <string.h>
 #include <epio_priv.h>
 
 uint8_t epio_peek_sm_pc(epio_t *epio, uint8_t block, uint8_t sm) {
@@ -86,11 +87,42 @@ uint8_t epio_peek_block_irq_num(epio_t *epio, uint8_t block, uint8_t irq_num) {
 uint32_t epio_peek_rx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint8_t entry) {
     CHECK_BLOCK_SM();
     assert(entry < epio_rx_fifo_depth(epio, block, sm) && "Invalid RX FIFO entry index");
-    return FIFO(block, sm).rx_fifo[entry];
+    return RX_FIFO_ENTRY(block, sm, entry);
 }
 
 uint32_t epio_peek_tx_fifo(epio_t *epio, uint8_t block, uint8_t sm, uint8_t entry) {
     CHECK_BLOCK_SM();
     assert(entry < epio_tx_fifo_depth(epio, block, sm) && "Invalid TX FIFO entry index");
-    return FIFO(block, sm).tx_fifo[entry];
-}
\ No newline at end of file
+    return TX_FIFO_ENTRY(block, sm, entry);
+}
+
+_Static_assert(sizeof(((epio_sm_snapshot_t *)0)->tx_fifo) == MAX_JOINED_FIFO_DEPTH * sizeof(uint32_t), "Snapshot TX FIFO size must match MAX_JOINED_FIFO_DEPTH");
+_Static_assert(sizeof(((epio_sm_snapshot_t *)0)->rx_fifo) == MAX_JOINED_FIFO_DEPTH * sizeof(uint32_t), "Snapshot RX FIFO size must match MAX_JOINED_FIFO_DEPTH");
+
+void epio_peek_sms(epio_t *epio, epio_sm_snapshot_t *snapshots) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(snapshots != NULL && "Snapshots cannot be NULL");
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            epio_sm_snapshot_t *snapshot = snapshots++;
+            snapshot->x = SM(block, sm).x;
+            snapshot->y = SM(block, sm).y;
+            snapshot->isr = SM(block, sm).isr;
+            snapshot->osr = SM(block, sm).osr;
+            for (uint8_t ii = 0; ii < MAX_JOINED_FIFO_DEPTH; ii++) {
+                snapshot->tx_fifo[ii] = TX_FIFO_ENTRY(block, sm, ii);
+                snapshot->rx_fifo[ii] = RX_FIFO_ENTRY(block, sm, ii);
+            }
+            snapshot->exec_instr = SM(block, sm).exec_instr;
+            snapshot->pc = PC(block, sm);
+            snapshot->isr_count = SM(block, sm).isr_count;
+            snapshot->osr_count = SM(block, sm).osr_count;
+            snapshot->tx_fifo_count = FIFO(block, sm).tx_fifo_count;
+            snapshot->rx_fifo_count = FIFO(block, sm).rx_fifo_count;
+            snapshot->enabled = SM(block, sm).enabled;
+            snapshot->stalled = SM(block, sm).stalled;
+            snapshot->delay = SM(block, sm).delay;
+            snapshot->exec_pending = SM(block, sm).exec_pending;
+        }
+    }
+}
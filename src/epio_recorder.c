@@ -0,0 +1,221 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// In-memory event recorder
+//
+// Events are held as 16 byte records in a power of 2 sized ring buffer,
+// indexed by a free-running count of events recorded, so an append is never
+// more than a masked store.
+//
+// While the recorder is enabled, epio_run_cycles() calls
+// epio_recorder_sample() after each cycle.  This compares each SM's PC and
+// registers, each block's IRQ flags and the GPIO levels to their values
+// after the previous cycle.  Every value is unconditionally written to a
+// record - the next one in the ring if it changed, otherwise a scratch
+// record - and the count of events is only advanced if it changed, so
+// sampling has no data dependent branches, and never overwrites the oldest
+// event once the ring has wrapped.
+//
+// FIFO pushes and pops are not visible from the state at the end of a cycle,
+// as a value may be pushed and popped within one, so are recorded by the
+// FIFO functions as they happen, via epio_recorder_fifo().
+
+#include <stdlib.h>
+#include <epio_priv.h>
+
+#define MAX_EVENTS          (1U << 31)
+
+// A recorded event
+typedef struct {
+    uint64_t cycle;
+    uint32_t value;
+
+    // Bits 32-47 of the value, for GPIO events
+    uint16_t value_hi;
+
+    uint8_t type;
+
+    // Block in the upper nibble, SM in the lower
+    uint8_t block_sm;
+} epio_record_t;
+_Static_assert(sizeof(epio_record_t) == 16, "epio_record_t must be 16 bytes");
+
+// Values after the previous cycle
+typedef struct {
+    uint32_t pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+    uint32_t osr;
+} epio_recorder_sm_t;
+
+struct epio_recorder_t {
+    // Number of events recorded, and mask to index the ring with it
+    uint64_t head;
+    uint32_t mask;
+
+    // The cycle after the last one sampled.  Earlier cycles are being
+    // replayed, so are not recorded again.
+    uint64_t next_cycle;
+
+    epio_recorder_sm_t sm[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+    uint32_t irq[NUM_PIO_BLOCKS];
+    uint64_t gpio;
+
+    // Written instead of the ring by samples which haven't changed
+    epio_record_t scratch;
+
+    epio_record_t ring[];
+};
+
+#define RECORDER            epio->recorder
+
+// Returns the record to write a sample to - the next one in the ring if it
+// changed, otherwise the scratch record
+static inline epio_record_t *rec_slot(epio_recorder_t *rec, uint8_t changed) {
+    return changed ? &rec->ring[rec->head & rec->mask] : &rec->scratch;
+}
+
+// Writes an event to the next record, only keeping it if the value changed
+// from last, which is then updated
+static inline void rec_delta(epio_recorder_t *rec, uint64_t cycle, uint8_t type, uint8_t block_sm, uint32_t value, uint32_t *last) {
+    epio_record_t *record = rec_slot(rec, value != *last);
+    record->cycle = cycle;
+    record->value = value;
+    record->value_hi = 0;
+    record->type = type;
+    record->block_sm = block_sm;
+    rec->head += (value != *last);
+    *last = value;
+}
+
+// Sets the values changes are compared to from the current state
+static void rec_capture(epio_t *epio) {
+    epio_recorder_t *rec = RECORDER;
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            rec->sm[block][sm].pc = PC(block, sm);
+            rec->sm[block][sm].x = SM(block, sm).x;
+            rec->sm[block][sm].y = SM(block, sm).y;
+            rec->sm[block][sm].isr = SM(block, sm).isr;
+            rec->sm[block][sm].osr = SM(block, sm).osr;
+        }
+        rec->irq[block] = IRQ(block).irq;
+    }
+    rec->gpio = epio_gpio_levels(epio);
+}
+
+int epio_recorder_enable(epio_t *epio, uint32_t events) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(events > 0 && "Must record at least one event");
+    assert(events <= MAX_EVENTS && "Too many events");
+
+    epio_recorder_disable(epio);
+
+    uint32_t size = 1;
+    while (size < events) {
+        size <<= 1;
+    }
+    epio_recorder_t *rec = (epio_recorder_t *)calloc(1, sizeof(epio_recorder_t) + size * sizeof(epio_record_t));
+    if (rec == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    rec->mask = size - 1;
+    rec->next_cycle = epio->cycle_count;
+
+    RECORDER = rec;
+    rec_capture(epio);
+
+    return 0;
+}
+
+void epio_recorder_disable(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    free(RECORDER);
+    RECORDER = NULL;
+}
+
+uint32_t epio_recorder_count(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_recorder_t *rec = RECORDER;
+    if (rec == NULL) {
+        return 0;
+    }
+    return (rec->head > rec->mask) ? (rec->mask + 1) : (uint32_t)rec->head;
+}
+
+uint64_t epio_recorder_total(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_recorder_t *rec = RECORDER;
+    return (rec == NULL) ? 0 : rec->head;
+}
+
+void epio_recorder_read(epio_t *epio, uint32_t index, epio_event_t *event) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(event != NULL && "Event cannot be NULL");
+    assert(index < epio_recorder_count(epio) && "Invalid event index");
+    epio_recorder_t *rec = RECORDER;
+
+    uint64_t oldest = rec->head - epio_recorder_count(epio);
+    const epio_record_t *record = &rec->ring[(oldest + index) & rec->mask];
+    event->cycle = record->cycle;
+    event->value = ((uint64_t)record->value_hi << 32) | record->value;
+    event->type = record->type;
+    event->block = record->block_sm >> 4;
+    event->sm = record->block_sm & 0xF;
+}
+
+// Records a FIFO push or pop
+void epio_recorder_fifo(epio_t *epio, uint8_t type, uint8_t block, uint8_t sm, uint32_t value) {
+    epio_recorder_t *rec = RECORDER;
+    if (epio->cycle_count < rec->next_cycle) {
+        // Replaying a cycle which has already been recorded
+        return;
+    }
+
+    epio_record_t *record = &rec->ring[rec->head++ & rec->mask];
+    record->cycle = epio->cycle_count;
+    record->value = value;
+    record->value_hi = 0;
+    record->type = type;
+    record->block_sm = (uint8_t)((block << 4) | sm);
+}
+
+// Records the changes made by the cycle which has just run
+void epio_recorder_sample(epio_t *epio) {
+    epio_recorder_t *rec = RECORDER;
+    uint64_t cycle = epio->cycle_count - 1;
+    if (cycle < rec->next_cycle) {
+        // Replaying cycles which have already been recorded
+        return;
+    }
+    rec->next_cycle = cycle + 1;
+
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            epio_recorder_sm_t *last = &rec->sm[block][sm];
+            uint8_t block_sm = (uint8_t)((block << 4) | sm);
+            rec_delta(rec, cycle, EPIO_EVENT_PC, block_sm, PC(block, sm), &last->pc);
+            rec_delta(rec, cycle, EPIO_EVENT_X, block_sm, SM(block, sm).x, &last->x);
+            rec_delta(rec, cycle, EPIO_EVENT_Y, block_sm, SM(block, sm).y, &last->y);
+            rec_delta(rec, cycle, EPIO_EVENT_ISR, block_sm, SM(block, sm).isr, &last->isr);
+            rec_delta(rec, cycle, EPIO_EVENT_OSR, block_sm, SM(block, sm).osr, &last->osr);
+        }
+        rec_delta(rec, cycle, EPIO_EVENT_IRQ, (uint8_t)(block << 4), IRQ(block).irq, &rec->irq[block]);
+    }
+
+    uint64_t levels = epio_gpio_levels(epio);
+    epio_record_t *record = rec_slot(rec, levels != rec->gpio);
+    record->cycle = cycle;
+    record->value = (uint32_t)levels;
+    record->value_hi = (uint16_t)(levels >> 32);
+    record->type = EPIO_EVENT_GPIO;
+    record->block_sm = 0;
+    rec->head += (levels != rec->gpio);
+    rec->gpio = levels;
+}
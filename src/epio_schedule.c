@@ -0,0 +1,352 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Host actions scheduled at future cycles
+//
+// Actions are held in a hierarchical timer wheel of WHEEL_LEVELS levels,
+// each of WHEEL_SLOTS slots.  An action is filed in the lowest level whose
+// slot width covers the highest bits in which its cycle differs from the
+// wheel's current cycle, so level 0 slots each hold a single cycle, level 1
+// slots 64 cycles, and so on.  Actions too far ahead for the top level wait
+// in an overflow list.  When the current cycle reaches the start of a
+// higher level slot, its actions are cascaded down to lower levels.
+//
+// Each level keeps a bitmap of its occupied slots, so the next cycle at
+// which there is anything to do - perform an action, or cascade a slot - is
+// found with a few bit scans.  epio_step_cycles() runs uninterrupted up to
+// that cycle, so the cost of the schedule is per action, not per cycle.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+#define WHEEL_BITS      6
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_LEVELS    4
+#define WHEEL_SPAN      (1ULL << (WHEEL_BITS * WHEEL_LEVELS))
+#define NO_ENTRY        UINT32_MAX
+
+typedef struct {
+    epio_action_t action;
+    uint64_t cycle;
+
+    // Order the action was scheduled in
+    uint64_t seq;
+
+    // Next entry in the same slot, or the free list
+    uint32_t next;
+} epio_schedule_entry_t;
+
+struct epio_schedule_t {
+    // Entries, and the free list through them
+    epio_schedule_entry_t *entry;
+    uint32_t max_entries;
+    uint32_t free;
+    uint32_t pending;
+    uint64_t seq;
+
+    // Slot lists, occupied slot bitmaps, and overflow list
+    uint32_t slot[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint64_t occupied[WHEEL_LEVELS];
+    uint32_t overflow;
+
+    // Cycle the wheel is filed relative to, and the next cycle at which
+    // there is anything to do
+    uint64_t now;
+    uint64_t next;
+
+    // Set while performing actions
+    uint8_t performing;
+};
+
+#define SCHEDULE    epio->schedule
+
+// Returns the start of the next slot at level, at or after the current
+// cycle, which has an action in it, or UINT64_MAX if there is none
+static uint64_t epio_schedule_level_next(epio_schedule_t *sched, uint32_t level) {
+    uint32_t shift = WHEEL_BITS * level;
+    uint32_t digit = (uint32_t)(sched->now >> shift) & (WHEEL_SLOTS - 1);
+    uint64_t occupied = sched->occupied[level] & (~0ULL << digit);
+    if (occupied == 0) {
+        return UINT64_MAX;
+    }
+    uint64_t base = sched->now & ~((1ULL << (shift + WHEEL_BITS)) - 1);
+    return base | ((uint64_t)__builtin_ctzll(occupied) << shift);
+}
+
+// Updates the next cycle at which there is anything to do
+static void epio_schedule_update_next(epio_schedule_t *sched) {
+    // Lower levels' slots all start before higher levels'
+    for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+        uint64_t next = epio_schedule_level_next(sched, level);
+        if (next != UINT64_MAX) {
+            sched->next = next;
+            return;
+        }
+    }
+    if (sched->overflow != NO_ENTRY) {
+        sched->next = (sched->now | (WHEEL_SPAN - 1)) + 1;
+    } else {
+        sched->next = UINT64_MAX;
+    }
+}
+
+// Files an entry in the wheel, relative to the current cycle
+static void epio_schedule_file(epio_schedule_t *sched, uint32_t index) {
+    epio_schedule_entry_t *entry = &sched->entry[index];
+    if (entry->cycle < sched->now) {
+        entry->cycle = sched->now;
+    }
+
+    uint64_t diff = entry->cycle ^ sched->now;
+    if (diff >= WHEEL_SPAN) {
+        entry->next = sched->overflow;
+        sched->overflow = index;
+        return;
+    }
+    uint32_t level = (diff == 0) ? 0 : (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+    uint32_t digit = (uint32_t)(entry->cycle >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    entry->next = sched->slot[level][digit];
+    sched->slot[level][digit] = index;
+    sched->occupied[level] |= 1ULL << digit;
+}
+
+// Refiles every entry in a list
+static void epio_schedule_refile(epio_schedule_t *sched, uint32_t index) {
+    while (index != NO_ENTRY) {
+        uint32_t next = sched->entry[index].next;
+        epio_schedule_file(sched, index);
+        index = next;
+    }
+}
+
+// Removes and returns a slot's list
+static uint32_t epio_schedule_take(epio_schedule_t *sched, uint32_t level, uint32_t digit) {
+    uint32_t index = sched->slot[level][digit];
+    sched->slot[level][digit] = NO_ENTRY;
+    sched->occupied[level] &= ~(1ULL << digit);
+    return index;
+}
+
+// Moves the wheel to the current cycle.  Within a run up to the next cycle
+// with anything to do, only slots starting at the current cycle need
+// cascading.  Otherwise the cycle count was moved, by epio_seek() or by
+// running outside epio_step_cycles(), so every entry is refiled.
+static void epio_schedule_advance(epio_t *epio) {
+    epio_schedule_t *sched = SCHEDULE;
+    uint64_t now = epio->cycle_count;
+
+    if ((now < sched->now) || (now > sched->next)) {
+        uint32_t all = sched->overflow;
+        sched->overflow = NO_ENTRY;
+        for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+            for (uint32_t digit = 0; digit < WHEEL_SLOTS; digit++) {
+                uint32_t index = epio_schedule_take(sched, level, digit);
+                while (index != NO_ENTRY) {
+                    uint32_t next = sched->entry[index].next;
+                    sched->entry[index].next = all;
+                    all = index;
+                    index = next;
+                }
+            }
+        }
+        sched->now = now;
+        epio_schedule_refile(sched, all);
+        epio_schedule_update_next(sched);
+        return;
+    }
+
+    sched->now = now;
+    if ((now & (WHEEL_SPAN - 1)) == 0) {
+        uint32_t overflow = sched->overflow;
+        sched->overflow = NO_ENTRY;
+        epio_schedule_refile(sched, overflow);
+    }
+    for (uint32_t level = WHEEL_LEVELS - 1; level > 0; level--) {
+        uint32_t shift = WHEEL_BITS * level;
+        if ((now & ((1ULL << shift) - 1)) == 0) {
+            uint32_t digit = (uint32_t)(now >> shift) & (WHEEL_SLOTS - 1);
+            epio_schedule_refile(sched, epio_schedule_take(sched, level, digit));
+        }
+    }
+    epio_schedule_update_next(sched);
+}
+
+// Performs an action
+static void epio_schedule_perform(epio_t *epio, const epio_action_t *action) {
+    switch (action->type) {
+        case EPIO_ACTION_DRIVE:
+            epio_drive_gpios_masked(epio, action->gpios, action->gpios, action->level);
+            break;
+
+        case EPIO_ACTION_RELEASE:
+            epio_drive_gpios_masked(epio, action->gpios, 0, 0);
+            break;
+
+        case EPIO_ACTION_PUSH_TX:
+            epio_push_tx_fifo(epio, action->block, action->sm, action->value);
+            break;
+
+        case EPIO_ACTION_SET_IRQ:
+            epio_set_block_irq(epio, action->block, action->irq);
+            break;
+
+        case EPIO_ACTION_CLEAR_IRQ:
+            epio_clear_block_irq(epio, action->block, action->irq);
+            break;
+
+        case EPIO_ACTION_CALLBACK:
+            action->callback(action->ctx, epio);
+            break;
+
+        // LCOV_EXCL_START
+        default:
+            assert(0 && "Invalid action type");
+            break;
+        // LCOV_EXCL_STOP
+    }
+}
+
+uint64_t epio_schedule_next_cycle(epio_t *epio) {
+    return SCHEDULE->next;
+}
+
+// Performs all actions at or before the current cycle, in the order they
+// were scheduled, including any they schedule at the current cycle
+void epio_schedule_apply(epio_t *epio) {
+    epio_schedule_t *sched = SCHEDULE;
+    epio_schedule_advance(epio);
+
+    sched->performing = 1;
+    uint32_t digit = (uint32_t)sched->now & (WHEEL_SLOTS - 1);
+    while (sched->slot[0][digit] != NO_ENTRY) {
+        // Unlink the earliest scheduled
+        uint32_t *link = &sched->slot[0][digit];
+        uint32_t *first = link;
+        while (*link != NO_ENTRY) {
+            if (sched->entry[*link].seq < sched->entry[*first].seq) {
+                first = link;
+            }
+            link = &sched->entry[*link].next;
+        }
+        uint32_t index = *first;
+        *first = sched->entry[index].next;
+
+        // Free it before performing it, as the action may schedule another,
+        // which may move the entries
+        epio_action_t action = sched->entry[index].action;
+        sched->entry[index].next = sched->free;
+        sched->free = index;
+        sched->pending--;
+        epio_schedule_perform(epio, &action);
+    }
+    sched->occupied[0] &= ~(1ULL << digit);
+    sched->performing = 0;
+
+    epio_schedule_update_next(sched);
+}
+
+int epio_schedule_at(epio_t *epio, uint64_t cycle, const epio_action_t *action) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(action != NULL && "Action cannot be NULL");
+    assert(action->type <= EPIO_ACTION_CALLBACK && "Invalid action type");
+    switch (action->type) {
+        case EPIO_ACTION_DRIVE:
+            CHECK_GPIO_MASK(action->gpios);
+            CHECK_GPIO_MASK(action->level);
+            break;
+
+        case EPIO_ACTION_RELEASE:
+            CHECK_GPIO_MASK(action->gpios);
+            break;
+
+        case EPIO_ACTION_PUSH_TX: {
+            uint8_t block = action->block;
+            uint8_t sm = action->sm;
+            CHECK_BLOCK_SM();
+            break;
+        }
+
+        case EPIO_ACTION_SET_IRQ:
+        case EPIO_ACTION_CLEAR_IRQ:
+            assert(action->block < NUM_PIO_BLOCKS && "Invalid PIO block");
+            assert(action->irq < NUM_IRQS_PER_BLOCK && "Invalid IRQ number");
+            break;
+
+        case EPIO_ACTION_CALLBACK:
+            assert(action->callback != NULL && "Callback cannot be NULL");
+            break;
+    }
+
+    if (SCHEDULE == NULL) {
+        SCHEDULE = (epio_schedule_t *)calloc(1, sizeof(epio_schedule_t));
+        if (SCHEDULE == NULL) {
+            // LCOV_EXCL_START
+            return -1;
+            // LCOV_EXCL_STOP
+        }
+        memset(SCHEDULE->slot, 0xFF, sizeof(SCHEDULE->slot));
+        SCHEDULE->free = NO_ENTRY;
+        SCHEDULE->overflow = NO_ENTRY;
+        SCHEDULE->now = epio->cycle_count;
+        SCHEDULE->next = UINT64_MAX;
+    }
+    epio_schedule_t *sched = SCHEDULE;
+
+    if (sched->free == NO_ENTRY) {
+        uint32_t max = sched->max_entries ? sched->max_entries * 2 : 64;
+        epio_schedule_entry_t *entry = (epio_schedule_entry_t *)realloc(sched->entry, max * sizeof(epio_schedule_entry_t));
+        if (entry == NULL) {
+            // LCOV_EXCL_START
+            return -1;
+            // LCOV_EXCL_STOP
+        }
+        for (uint32_t ii = max; ii > sched->max_entries; ii--) {
+            entry[ii - 1].next = sched->free;
+            sched->free = ii - 1;
+        }
+        sched->entry = entry;
+        sched->max_entries = max;
+    }
+
+    // Moving the wheel first, if the cycle count was moved since it was
+    // last used, keeps the actions at the current cycle in order
+    epio_schedule_advance(epio);
+
+    uint32_t index = sched->free;
+    epio_schedule_entry_t *entry = &sched->entry[index];
+    sched->free = entry->next;
+    entry->action = *action;
+    entry->cycle = cycle;
+    entry->seq = sched->seq++;
+    sched->pending++;
+    epio_schedule_file(sched, index);
+    epio_schedule_update_next(sched);
+
+    return 0;
+}
+
+int epio_schedule_in(epio_t *epio, uint64_t cycles, const epio_action_t *action) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(cycles <= UINT64_MAX - epio->cycle_count && "Cycle out of range");
+    return epio_schedule_at(epio, epio->cycle_count + cycles, action);
+}
+
+uint32_t epio_schedule_pending(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    return (SCHEDULE == NULL) ? 0 : SCHEDULE->pending;
+}
+
+void epio_schedule_clear(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (SCHEDULE == NULL) {
+        return;
+    }
+    assert(!SCHEDULE->performing && "Cannot clear the schedule from an action");
+    free(SCHEDULE->entry);
+    free(SCHEDULE);
+    SCHEDULE = NULL;
+}
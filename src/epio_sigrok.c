@@ -0,0 +1,508 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// sigrok session (.sr) file writer
+//
+// A session file is a ZIP archive, holding a "version" file, a "metadata"
+// INI file describing the channels and samplerate, and the samples, in
+// files "logic-1-1", "logic-1-2" etc, each of up to SIGROK_CHUNK_BYTES.  A
+// sample is unitsize bytes, little-endian, with bit N being the Nth
+// channel.
+//
+// Edges are turned into runs of identical samples, which are compressed as
+// they are written, using deflate with its fixed Huffman codes.  A run is
+// one literal sample, if it differs from the previous sample, followed by
+// matches of up to 258 bytes at a distance of one sample, so a long run
+// costs a few bits per 258 bytes, and no samples are ever held in memory.
+// The CRC and sizes of each sample file are written after its data, in a
+// data descriptor, so the file is written sequentially.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+#define SIGROK_BUF_SIZE     (64 * 1024)
+
+// Maximum uncompressed size of each sample file
+#define SIGROK_CHUNK_BYTES  (4 * 1024 * 1024)
+
+#define SIGROK_MAX_NAME     16
+#define SIGROK_MAX_METADATA 1024
+
+// ZIP signatures and fields
+#define ZIP_LOCAL_SIG       0x04034B50
+#define ZIP_CENTRAL_SIG     0x02014B50
+#define ZIP_DESCRIPTOR_SIG  0x08074B50
+#define ZIP_END_SIG         0x06054B50
+#define ZIP_VERSION         20
+#define ZIP_FLAG_DESCRIPTOR 0x0008
+#define ZIP_METHOD_STORE    0
+#define ZIP_METHOD_DEFLATE  8
+#define ZIP_DATE            0x0021      // 1980-01-01
+
+// Deflate fixed Huffman block symbols
+#define DEFLATE_END_BLOCK   256
+#define DEFLATE_FIRST_LEN   257
+#define DEFLATE_MIN_MATCH   3
+#define DEFLATE_MAX_MATCH   258
+
+// Base lengths and extra bits for length symbols 257 to 285
+static const uint16_t len_base[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t len_extra[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+#define NUM_LEN_CODES       (sizeof(len_base) / sizeof(len_base[0]))
+
+// A file in the archive, for the central directory
+typedef struct {
+    char name[SIGROK_MAX_NAME];
+    uint16_t flags;
+    uint16_t method;
+    uint32_t crc;
+    uint32_t csize;
+    uint32_t usize;
+    uint32_t offset;
+} epio_sigrok_entry_t;
+
+struct epio_sigrok_t {
+    FILE *file;
+
+    // Set if any write failed
+    uint8_t error;
+
+    // GPIO of each channel, and bytes per sample
+    uint8_t pins[NUM_GPIOS];
+    uint8_t num_pins;
+    uint8_t unitsize;
+
+    // Set once the first edge is written, after which value is the sample
+    // from cycle onwards, not yet written
+    uint8_t started;
+    uint64_t cycle;
+    uint64_t value;
+
+    // Sample file being written, if any, and the samples in it so far, the
+    // last of them, and the offset of its data
+    uint8_t in_chunk;
+    uint64_t chunk_samples;
+    uint64_t prev;
+    uint64_t data_offset;
+
+    // Deflate output bits not yet written
+    uint64_t bits;
+    uint8_t num_bits;
+
+    // Files in the archive
+    epio_sigrok_entry_t *entries;
+    uint32_t num_entries;
+    uint32_t max_entries;
+
+    uint32_t crc_table[256];
+
+    // Bytes written to the buffer since the file was opened, and the buffer
+    uint64_t offset;
+    size_t len;
+    uint8_t buf[SIGROK_BUF_SIZE];
+};
+
+// Writes the buffer to the file
+static void sigrok_flush(epio_sigrok_t *sigrok) {
+    if ((sigrok->len > 0) && (fwrite(sigrok->buf, sigrok->len, 1, sigrok->file) != 1)) {
+        sigrok->error = 1;
+    }
+    sigrok->len = 0;
+}
+
+static void sigrok_byte(epio_sigrok_t *sigrok, uint8_t byte) {
+    if (sigrok->len == sizeof(sigrok->buf)) {
+        sigrok_flush(sigrok);
+    }
+    sigrok->buf[sigrok->len++] = byte;
+    sigrok->offset++;
+}
+
+static void sigrok_u16(epio_sigrok_t *sigrok, uint16_t value) {
+    sigrok_byte(sigrok, (uint8_t)value);
+    sigrok_byte(sigrok, (uint8_t)(value >> 8));
+}
+
+static void sigrok_u32(epio_sigrok_t *sigrok, uint32_t value) {
+    sigrok_u16(sigrok, (uint16_t)value);
+    sigrok_u16(sigrok, (uint16_t)(value >> 16));
+}
+
+static void sigrok_bytes(epio_sigrok_t *sigrok, const void *data, size_t len) {
+    for (size_t ii = 0; ii < len; ii++) {
+        sigrok_byte(sigrok, ((const uint8_t *)data)[ii]);
+    }
+}
+
+static uint32_t sigrok_crc(const epio_sigrok_t *sigrok, uint32_t crc, uint8_t byte) {
+    return sigrok->crc_table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+}
+
+// Adds a file to the archive, and writes its local header, with the CRC
+// and sizes, if not using a data descriptor
+static epio_sigrok_entry_t *sigrok_entry(epio_sigrok_t *sigrok, const char *name, uint16_t flags, uint16_t method, uint32_t crc, uint32_t size) {
+    if (sigrok->num_entries == sigrok->max_entries) {
+        uint32_t max = sigrok->max_entries ? sigrok->max_entries * 2 : 8;
+        epio_sigrok_entry_t *entries = (epio_sigrok_entry_t *)realloc(sigrok->entries, max * sizeof(epio_sigrok_entry_t));
+        if (entries == NULL) {
+            // LCOV_EXCL_START
+            sigrok->error = 1;
+            return NULL;
+            // LCOV_EXCL_STOP
+        }
+        sigrok->entries = entries;
+        sigrok->max_entries = max;
+    }
+    epio_sigrok_entry_t *entry = &sigrok->entries[sigrok->num_entries++];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->flags = flags;
+    entry->method = method;
+    entry->crc = crc;
+    entry->csize = size;
+    entry->usize = size;
+    entry->offset = (uint32_t)sigrok->offset;
+
+    uint16_t name_len = (uint16_t)strlen(entry->name);
+    sigrok_u32(sigrok, ZIP_LOCAL_SIG);
+    sigrok_u16(sigrok, ZIP_VERSION);
+    sigrok_u16(sigrok, flags);
+    sigrok_u16(sigrok, method);
+    sigrok_u16(sigrok, 0);
+    sigrok_u16(sigrok, ZIP_DATE);
+    sigrok_u32(sigrok, crc);
+    sigrok_u32(sigrok, size);
+    sigrok_u32(sigrok, size);
+    sigrok_u16(sigrok, name_len);
+    sigrok_u16(sigrok, 0);
+    sigrok_bytes(sigrok, entry->name, name_len);
+    return entry;
+}
+
+// Writes an uncompressed file to the archive
+static void sigrok_stored(epio_sigrok_t *sigrok, const char *name, const char *data) {
+    uint32_t size = (uint32_t)strlen(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t ii = 0; ii < size; ii++) {
+        crc = sigrok_crc(sigrok, crc, (uint8_t)data[ii]);
+    }
+    if (sigrok_entry(sigrok, name, 0, ZIP_METHOD_STORE, ~crc, size) != NULL) {
+        sigrok_bytes(sigrok, data, size);
+    }
+}
+
+// Writes deflate output bits, LSB first
+static void sigrok_bits(epio_sigrok_t *sigrok, uint32_t value, uint8_t count) {
+    sigrok->bits |= (uint64_t)value << sigrok->num_bits;
+    sigrok->num_bits += count;
+    while (sigrok->num_bits >= 8) {
+        sigrok_byte(sigrok, (uint8_t)sigrok->bits);
+        sigrok->bits >>= 8;
+        sigrok->num_bits -= 8;
+    }
+}
+
+// Writes a Huffman code, which deflate packs MSB first
+static void sigrok_code(epio_sigrok_t *sigrok, uint32_t code, uint8_t count) {
+    uint32_t reversed = 0;
+    for (uint8_t ii = 0; ii < count; ii++) {
+        reversed = (reversed << 1) | ((code >> ii) & 1);
+    }
+    sigrok_bits(sigrok, reversed, count);
+}
+
+// Writes a literal/length symbol with the fixed Huffman codes
+static void sigrok_symbol(epio_sigrok_t *sigrok, uint16_t symbol) {
+    if (symbol < 144) {
+        sigrok_code(sigrok, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        sigrok_code(sigrok, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        sigrok_code(sigrok, symbol - 256, 7);
+    } else {
+        sigrok_code(sigrok, 0xC0 + symbol - 280, 8);
+    }
+}
+
+// Writes a match of len bytes, one sample back
+static void sigrok_match(epio_sigrok_t *sigrok, uint32_t len) {
+    uint8_t code = NUM_LEN_CODES - 1;
+    while (len_base[code] > len) {
+        code--;
+    }
+    sigrok_symbol(sigrok, DEFLATE_FIRST_LEN + code);
+    sigrok_bits(sigrok, len - len_base[code], len_extra[code]);
+
+    // Distance codes 0 to 3 are distances 1 to 4, and code 4 is 5 or 6
+    if (sigrok->unitsize <= 4) {
+        sigrok_code(sigrok, sigrok->unitsize - 1, 5);
+    } else {
+        sigrok_code(sigrok, 4, 5);
+        sigrok_bits(sigrok, sigrok->unitsize - 5, 1);
+    }
+}
+
+// Starts a sample file, and its single fixed Huffman block
+static void sigrok_chunk_start(epio_sigrok_t *sigrok) {
+    char name[SIGROK_MAX_NAME];
+    snprintf(name, sizeof(name), "logic-1-%u", sigrok->num_entries - 1);
+    if (sigrok_entry(sigrok, name, ZIP_FLAG_DESCRIPTOR, ZIP_METHOD_DEFLATE, 0xFFFFFFFF, 0) != NULL) {
+        sigrok->in_chunk = 1;
+        sigrok->chunk_samples = 0;
+        sigrok->data_offset = sigrok->offset;
+        sigrok_bits(sigrok, 1, 1);      // BFINAL
+        sigrok_bits(sigrok, 1, 2);      // BTYPE - fixed Huffman
+    }
+}
+
+// Ends the sample file, and writes its data descriptor.  The CRC is
+// accumulated in the entry as samples are written.
+static void sigrok_chunk_end(epio_sigrok_t *sigrok) {
+    epio_sigrok_entry_t *entry = &sigrok->entries[sigrok->num_entries - 1];
+    sigrok_symbol(sigrok, DEFLATE_END_BLOCK);
+    sigrok_bits(sigrok, 0, 7);      // pad to a byte
+    sigrok->num_bits = 0;
+    sigrok->bits = 0;
+    sigrok->in_chunk = 0;
+
+    entry->crc = ~entry->crc;
+    entry->csize = (uint32_t)(sigrok->offset - sigrok->data_offset);
+    entry->usize = (uint32_t)(sigrok->chunk_samples * sigrok->unitsize);
+    sigrok_u32(sigrok, ZIP_DESCRIPTOR_SIG);
+    sigrok_u32(sigrok, entry->crc);
+    sigrok_u32(sigrok, entry->csize);
+    sigrok_u32(sigrok, entry->usize);
+}
+
+// Writes count samples of value to the current sample file
+static void sigrok_run(epio_sigrok_t *sigrok, uint64_t value, uint64_t count) {
+    epio_sigrok_entry_t *entry = &sigrok->entries[sigrok->num_entries - 1];
+    uint8_t unitsize = sigrok->unitsize;
+
+    uint32_t crc = entry->crc;
+    for (uint64_t ii = 0; ii < count; ii++) {
+        for (uint8_t byte = 0; byte < unitsize; byte++) {
+            crc = sigrok_crc(sigrok, crc, (uint8_t)(value >> (byte * 8)));
+        }
+    }
+    entry->crc = crc;
+
+    // Samples are literals unless they can be matched to a previous one,
+    // and a match must be at least DEFLATE_MIN_MATCH bytes
+    uint64_t literals = ((sigrok->chunk_samples == 0) || (value != sigrok->prev)) ? 1 : 0;
+    if ((count - literals) * unitsize < DEFLATE_MIN_MATCH) {
+        literals = count;
+    }
+    for (uint64_t ii = 0; ii < literals; ii++) {
+        for (uint8_t byte = 0; byte < unitsize; byte++) {
+            sigrok_symbol(sigrok, (uint8_t)(value >> (byte * 8)));
+        }
+    }
+    uint64_t remaining = (count - literals) * unitsize;
+    while (remaining > 0) {
+        uint32_t len = (remaining < DEFLATE_MAX_MATCH) ? (uint32_t)remaining : DEFLATE_MAX_MATCH;
+        if ((remaining - len > 0) && (remaining - len < DEFLATE_MIN_MATCH)) {
+            // Leave enough for a final match
+            len -= DEFLATE_MIN_MATCH - 1;
+        }
+        sigrok_match(sigrok, len);
+        remaining -= len;
+    }
+
+    sigrok->chunk_samples += count;
+    sigrok->prev = value;
+}
+
+// Writes count samples of value, across as many sample files as needed
+static void sigrok_samples(epio_sigrok_t *sigrok, uint64_t value, uint64_t count) {
+    uint64_t max = SIGROK_CHUNK_BYTES / sigrok->unitsize;
+    while ((count > 0) && !sigrok->error) {
+        if (!sigrok->in_chunk) {
+            sigrok_chunk_start(sigrok);
+            continue;
+        }
+        uint64_t run = max - sigrok->chunk_samples;
+        run = (count < run) ? count : run;
+        sigrok_run(sigrok, value, run);
+        count -= run;
+        if (sigrok->chunk_samples == max) {
+            sigrok_chunk_end(sigrok);
+        }
+    }
+}
+
+// Writes the metadata file
+static void sigrok_metadata(epio_sigrok_t *sigrok, uint32_t samplerate) {
+    char metadata[SIGROK_MAX_METADATA];
+    size_t len;
+    const char *unit = "";
+    uint32_t rate = samplerate;
+    if (rate % 1000000000 == 0) {
+        rate /= 1000000000;
+        unit = "G";
+    } else if (rate % 1000000 == 0) {
+        rate /= 1000000;
+        unit = "M";
+    } else if (rate % 1000 == 0) {
+        rate /= 1000;
+        unit = "k";
+    }
+    len = (size_t)snprintf(metadata, sizeof(metadata),
+        "[global]\n"
+        "sigrok version=0.5.2\n"
+        "\n"
+        "[device 1]\n"
+        "capturefile=logic-1\n"
+        "total probes=%u\n"
+        "samplerate=%u %sHz\n"
+        "total analog=0\n",
+        sigrok->num_pins, rate, unit);
+    for (uint8_t ii = 0; ii < sigrok->num_pins; ii++) {
+        len += (size_t)snprintf(metadata + len, sizeof(metadata) - len, "probe%u=GPIO%u\n", ii + 1, sigrok->pins[ii]);
+    }
+    snprintf(metadata + len, sizeof(metadata) - len, "unitsize=%u\n", sigrok->unitsize);
+    sigrok_stored(sigrok, "metadata", metadata);
+}
+
+epio_sigrok_t *epio_sigrok_open(const char *path, uint64_t mask, uint32_t samplerate) {
+    assert(path != NULL && "Session path cannot be NULL");
+    CHECK_GPIO_MASK(mask);
+    assert(mask != 0 && "Must write at least one GPIO");
+    assert(samplerate > 0 && "Samplerate must be non-zero");
+
+    epio_sigrok_t *sigrok = (epio_sigrok_t *)calloc(1, sizeof(epio_sigrok_t));
+    if (sigrok == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    sigrok->file = fopen(path, "wb");
+    if (sigrok->file == NULL) {
+        free(sigrok);
+        return NULL;
+    }
+
+    for (uint8_t pin = 0; pin < NUM_GPIOS; pin++) {
+        if (mask & (1ULL << pin)) {
+            sigrok->pins[sigrok->num_pins++] = pin;
+        }
+    }
+    sigrok->unitsize = (sigrok->num_pins + 7) / 8;
+    for (uint32_t ii = 0; ii < 256; ii++) {
+        uint32_t crc = ii;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+        sigrok->crc_table[ii] = crc;
+    }
+
+    sigrok_stored(sigrok, "version", "2");
+    sigrok_metadata(sigrok, samplerate);
+
+    return sigrok;
+}
+
+// Returns the sample for GPIO levels, with channel N in bit N
+static uint64_t sigrok_pack(const epio_sigrok_t *sigrok, uint64_t levels) {
+    uint64_t value = 0;
+    for (uint8_t ii = 0; ii < sigrok->num_pins; ii++) {
+        value |= ((levels >> sigrok->pins[ii]) & 1) << ii;
+    }
+    return value;
+}
+
+void epio_sigrok_write(epio_sigrok_t *sigrok, const epio_edge_t *edges, uint32_t count) {
+    assert(sigrok != NULL && "Writer cannot be NULL");
+    assert(((edges != NULL) || (count == 0)) && "Edges cannot be NULL");
+
+    for (uint32_t ii = 0; ii < count; ii++) {
+        uint64_t value = sigrok_pack(sigrok, edges[ii].value);
+        if (!sigrok->started) {
+            sigrok->started = 1;
+            sigrok->cycle = edges[ii].cycle;
+            sigrok->value = value;
+            continue;
+        }
+        assert(edges[ii].cycle >= sigrok->cycle && "Edges must be in cycle order");
+
+        // Edges of other GPIOs don't end the run
+        if (value != sigrok->value) {
+            sigrok_samples(sigrok, sigrok->value, edges[ii].cycle - sigrok->cycle);
+            sigrok->cycle = edges[ii].cycle;
+            sigrok->value = value;
+        }
+    }
+}
+
+void epio_sigrok_capture(void *sigrok, const epio_edge_t *edges, uint32_t count) {
+    epio_sigrok_write((epio_sigrok_t *)sigrok, edges, count);
+}
+
+int epio_sigrok_close(epio_sigrok_t *sigrok, uint64_t end) {
+    assert(sigrok != NULL && "Writer cannot be NULL");
+
+    if (sigrok->started) {
+        assert(end >= sigrok->cycle && "End cannot be before the last edge");
+        sigrok_samples(sigrok, sigrok->value, end - sigrok->cycle + 1);
+    }
+    if (sigrok->in_chunk) {
+        sigrok_chunk_end(sigrok);
+    }
+
+    // Central directory, and its end record
+    uint64_t central = sigrok->offset;
+    for (uint32_t ii = 0; ii < sigrok->num_entries; ii++) {
+        const epio_sigrok_entry_t *entry = &sigrok->entries[ii];
+        uint16_t name_len = (uint16_t)strlen(entry->name);
+        sigrok_u32(sigrok, ZIP_CENTRAL_SIG);
+        sigrok_u16(sigrok, ZIP_VERSION);
+        sigrok_u16(sigrok, ZIP_VERSION);
+        sigrok_u16(sigrok, entry->flags);
+        sigrok_u16(sigrok, entry->method);
+        sigrok_u16(sigrok, 0);
+        sigrok_u16(sigrok, ZIP_DATE);
+        sigrok_u32(sigrok, entry->crc);
+        sigrok_u32(sigrok, entry->csize);
+        sigrok_u32(sigrok, entry->usize);
+        sigrok_u16(sigrok, name_len);
+        sigrok_u16(sigrok, 0);          // extra field length
+        sigrok_u16(sigrok, 0);          // comment length
+        sigrok_u16(sigrok, 0);          // disk number
+        sigrok_u16(sigrok, 0);          // internal attributes
+        sigrok_u32(sigrok, 0);          // external attributes
+        sigrok_u32(sigrok, entry->offset);
+        sigrok_bytes(sigrok, entry->name, name_len);
+    }
+    uint32_t central_size = (uint32_t)(sigrok->offset - central);
+    sigrok_u32(sigrok, ZIP_END_SIG);
+    sigrok_u16(sigrok, 0);
+    sigrok_u16(sigrok, 0);
+    sigrok_u16(sigrok, (uint16_t)sigrok->num_entries);
+    sigrok_u16(sigrok, (uint16_t)sigrok->num_entries);
+    sigrok_u32(sigrok, central_size);
+    sigrok_u32(sigrok, (uint32_t)central);
+    sigrok_u16(sigrok, 0);
+
+    // Offsets are 32-bit, and the number of files 16-bit
+    sigrok->error |= (sigrok->offset > UINT32_MAX) || (sigrok->num_entries > UINT16_MAX);
+
+    sigrok_flush(sigrok);
+    if (fclose(sigrok->file) != 0) {
+        sigrok->error = 1;
+    }
+    int rc = sigrok->error ? -1 : 0;
+    free(sigrok->entries);
+    free(sigrok);
+
+    return rc;
+}
@@ -5,63 +5,279 @@
 // A PIO emulator to test One ROM
 //
 // SRAM emulation
+//
+// SRAM is sparse - it is held as a table of SRAM_PAGE_SIZE pages, each of
+// which is allocated on first write.  Reads from a page which has never been
+// written return zero.  As halfword and word accesses must be aligned, they
+// never straddle a page boundary.
+//
+// Pages may also be shared read-only with a template (see epio_template.c).
+// A shared page is copied to a private page the first time it is written.
 
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
 #include <epio_priv.h>
 
-uint8_t *epio_sram_init(epio_t *epio) {
-    epio->sram = calloc(1, SRAM_SIZE);
-    return epio->sram;
+#define SRAM_PAGE_NUM(ADDR)     (((ADDR) - MIN_SRAM_ADDR) / SRAM_PAGE_SIZE)
+#define SRAM_PAGE_OFFSET(ADDR)  (((ADDR) - MIN_SRAM_ADDR) % SRAM_PAGE_SIZE)
+
+#define SRAM_PAGE_IS_DIRTY(EPIO, PAGE) \
+    (((EPIO)->sram_dirty[(PAGE) / 32] >> ((PAGE) % 32)) & 1)
+
+// Resets the SRAM hash cache to that of all-zero SRAM
+static void epio_sram_hash_clear(epio_t *epio) {
+    memset(epio->sram_page_hash, 0, sizeof(epio->sram_page_hash));
+    memset(epio->sram_dirty, 0, sizeof(epio->sram_dirty));
+    epio->sram_hash = 0;
+}
+
+// Marks a page as possibly changed, removing its cached hash from the total
+static inline void epio_sram_page_dirty(epio_t *epio, uint32_t page_num) {
+    if (!SRAM_PAGE_IS_DIRTY(epio, page_num)) {
+        epio->sram_hash ^= epio->sram_page_hash[page_num];
+        epio->sram_dirty[page_num / 32] |= (1U << (page_num % 32));
+    }
+}
+
+void epio_sram_init(epio_t *epio) {
+    memset(epio->sram_page, 0, sizeof(epio->sram_page));
+    memset(epio->sram_shared, 0, sizeof(epio->sram_shared));
+    epio->sram_resident_pages = 0;
+    epio->sram_writes = 0;
+    memset(epio->sram_ckpt_dirty, 0, sizeof(epio->sram_ckpt_dirty));
+    epio_sram_hash_clear(epio);
+}
+
+#define SRAM_PAGE_SET_SHARED(EPIO, PAGE) \
+    (EPIO)->sram_shared[(PAGE) / 32] |= (1U << ((PAGE) % 32))
+#define SRAM_PAGE_CLEAR_SHARED(EPIO, PAGE) \
+    (EPIO)->sram_shared[(PAGE) / 32] &= ~(1U << ((PAGE) % 32))
+
+// Allocates a new private page, copying the contents of src if non-NULL
+static uint8_t *epio_sram_alloc_page(const uint8_t *src) {
+    uint8_t *page = src ? malloc(SRAM_PAGE_SIZE) : calloc(1, SRAM_PAGE_SIZE);
+    assert(page != NULL && "Failed to allocate SRAM page");
+    if (src != NULL) {
+        memcpy(page, src, SRAM_PAGE_SIZE);
+    }
+    return page;
+}
+
+// Returns a pointer to addr within its page, or NULL if that page has never
+// been written.
+static inline uint8_t *epio_sram_read_ptr(epio_t *epio, uint32_t addr) {
+    uint8_t *page = epio->sram_page[SRAM_PAGE_NUM(addr)];
+    if (page == NULL) {
+        return NULL;
+    }
+    return page + SRAM_PAGE_OFFSET(addr);
+}
+
+// Returns a pointer to addr within its page, allocating the page if this is
+// the first write to it, or taking a private copy if it is shared.
+static uint8_t *epio_sram_write_ptr(epio_t *epio, uint32_t addr) {
+    uint32_t page_num = SRAM_PAGE_NUM(addr);
+    uint8_t *page = epio->sram_page[page_num];
+    if (page == NULL) {
+        page = epio_sram_alloc_page(NULL);
+        epio->sram_page[page_num] = page;
+        epio->sram_resident_pages++;
+    } else if (SRAM_PAGE_IS_SHARED(epio, page_num)) {
+        page = epio_sram_alloc_page(page);
+        epio->sram_page[page_num] = page;
+        SRAM_PAGE_CLEAR_SHARED(epio, page_num);
+    }
+    epio_sram_page_dirty(epio, page_num);
+    epio->sram_ckpt_dirty[page_num / 32] |= (1U << (page_num % 32));
+    epio->sram_writes++;
+    return page + SRAM_PAGE_OFFSET(addr);
 }
 
 void epio_sram_set(epio_t *epio, uint32_t addr, uint8_t *data, size_t len) {
     uint32_t final_addr = addr + len - 1;
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ADDR(final_addr);
-    memcpy(epio->sram + (addr - MIN_SRAM_ADDR), data, len);
+
+    // Copy a page at a time, as pages are not contiguous
+    while (len > 0) {
+        size_t chunk = SRAM_PAGE_SIZE - SRAM_PAGE_OFFSET(addr);
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(epio_sram_write_ptr(epio, addr), data, chunk);
+        addr += chunk;
+        data += chunk;
+        len -= chunk;
+    }
 }
 
 uint8_t epio_sram_read_byte(epio_t *epio, uint32_t addr) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 1);
-    return epio->sram[addr - MIN_SRAM_ADDR];
+    uint8_t *ptr = epio_sram_read_ptr(epio, addr);
+    return ptr ? *ptr : 0;
 }
 
 uint16_t epio_sram_read_halfword(epio_t *epio, uint32_t addr) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 2);
-    return *(uint16_t *)(epio->sram + addr - MIN_SRAM_ADDR);
+    uint8_t *ptr = epio_sram_read_ptr(epio, addr);
+    return ptr ? *(uint16_t *)ptr : 0;
 }
 
 uint32_t epio_sram_read_word(epio_t *epio, uint32_t addr) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 4);
-    return *(uint32_t *)(epio->sram + addr - MIN_SRAM_ADDR);
+    uint8_t *ptr = epio_sram_read_ptr(epio, addr);
+    return ptr ? *(uint32_t *)ptr : 0;
 }
 
 void epio_sram_write_byte(epio_t *epio, uint32_t addr, uint8_t value) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 1);
-    epio->sram[addr - MIN_SRAM_ADDR] = value;
+    *epio_sram_write_ptr(epio, addr) = value;
 }
 
 void epio_sram_write_halfword(epio_t *epio, uint32_t addr, uint16_t value) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 2);
-    *(uint16_t *)(epio->sram + addr - MIN_SRAM_ADDR) = value;
+    *(uint16_t *)epio_sram_write_ptr(epio, addr) = value;
 }
 
 void epio_sram_write_word(epio_t *epio, uint32_t addr, uint32_t value) {
     CHECK_SRAM_ADDR(addr);
     CHECK_SRAM_ALIGN(addr, 4);
-    *(uint32_t *)(epio->sram + addr - MIN_SRAM_ADDR) = value;
+    *(uint32_t *)epio_sram_write_ptr(epio, addr) = value;
+}
+
+uint32_t epio_sram_resident_pages(epio_t *epio) {
+    return epio->sram_resident_pages;
+}
+
+uint8_t *epio_sram_page(epio_t *epio, uint32_t addr) {
+    CHECK_SRAM_ADDR(addr);
+    return epio_sram_write_ptr(epio, addr - SRAM_PAGE_OFFSET(addr));
+}
+
+// Zeroes the contents of all SRAM, but keeps any resident pages owned by
+// this instance allocated.  Shared pages are dropped.
+void epio_sram_zero(epio_t *epio) {
+    for (int ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if (epio->sram_page[ii] == NULL) {
+            continue;
+        }
+        if (SRAM_PAGE_IS_SHARED(epio, ii)) {
+            epio->sram_page[ii] = NULL;
+            SRAM_PAGE_CLEAR_SHARED(epio, ii);
+            epio->sram_resident_pages--;
+        } else {
+            memset(epio->sram_page[ii], 0, SRAM_PAGE_SIZE);
+        }
+    }
+    epio_sram_hash_clear(epio);
 }
 
 void epio_sram_free(epio_t *epio) {
-    if (epio->sram != NULL) {
-        free(epio->sram);
-        epio->sram = NULL;
+    for (int ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if ((epio->sram_page[ii] != NULL) && !SRAM_PAGE_IS_SHARED(epio, ii)) {
+            free(epio->sram_page[ii]);
+        }
+    }
+    epio_sram_init(epio);
+}
+
+// Gives dst, which must have no resident pages, a private copy of every
+// resident page in src.
+void epio_sram_copy_pages(epio_t *dst, const epio_t *src) {
+    assert(dst->sram_resident_pages == 0 && "Destination SRAM not empty");
+    for (int ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if (src->sram_page[ii] != NULL) {
+            dst->sram_page[ii] = epio_sram_alloc_page(src->sram_page[ii]);
+        }
+    }
+    dst->sram_resident_pages = src->sram_resident_pages;
+
+    // The page contents are the same, so their hashes are too
+    memcpy(dst->sram_page_hash, src->sram_page_hash, sizeof(dst->sram_page_hash));
+    memcpy(dst->sram_dirty, src->sram_dirty, sizeof(dst->sram_dirty));
+    dst->sram_hash = src->sram_hash;
+}
+
+// Maps every resident page in src, which must own all of its pages, into
+// dst, which must have no resident pages, as shared.
+void epio_sram_share_pages(epio_t *dst, const epio_t *src) {
+    assert(dst->sram_resident_pages == 0 && "Destination SRAM not empty");
+    for (int ii = 0; ii < SRAM_NUM_PAGES; ii++) {
+        if (src->sram_page[ii] != NULL) {
+            epio_sram_map_shared_page(dst, ii, src->sram_page[ii]);
+        }
+    }
+
+    // The pages are the same, so their hashes are too
+    memcpy(dst->sram_page_hash, src->sram_page_hash, sizeof(dst->sram_page_hash));
+    memcpy(dst->sram_dirty, src->sram_dirty, sizeof(dst->sram_dirty));
+    dst->sram_hash = src->sram_hash;
+}
+
+// Maps page, which is owned by someone else, into epio as shared.
+void epio_sram_map_shared_page(epio_t *epio, uint32_t page_num, const uint8_t *page) {
+    assert(epio->sram_page[page_num] == NULL && "SRAM page already resident");
+    epio->sram_page[page_num] = (uint8_t *)page;
+    SRAM_PAGE_SET_SHARED(epio, page_num);
+    epio->sram_resident_pages++;
+    epio_sram_page_dirty(epio, page_num);
+}
+
+// Returns whether page is all zero, so reads the same as an unwritten page.
+static int epio_sram_page_is_zero(const uint8_t *page) {
+    const uint64_t *word = (const uint64_t *)page;
+    uint64_t any = 0;
+    for (size_t ii = 0; ii < SRAM_PAGE_SIZE / sizeof(uint64_t); ii++) {
+        any |= word[ii];
     }
-}
\ No newline at end of file
+    return any == 0;
+}
+
+// Returns the combined hash of all SRAM pages, rehashing only those which
+// are dirty.  Only resident pages are ever dirty.
+uint64_t epio_sram_hash(epio_t *epio) {
+    for (uint32_t word = 0; word < SRAM_SHARED_WORDS; word++) {
+        while (epio->sram_dirty[word] != 0) {
+            uint32_t page_num = word * 32 + __builtin_ctz(epio->sram_dirty[word]);
+            uint64_t hash = 0;
+            if (!epio_sram_page_is_zero(epio->sram_page[page_num])) {
+                hash = epio_hash_data(epio->sram_page[page_num], SRAM_PAGE_SIZE, page_num + 1);
+            }
+            epio->sram_page_hash[page_num] = hash;
+            epio->sram_hash ^= hash;
+            epio->sram_dirty[word] &= ~(1U << (page_num % 32));
+        }
+    }
+    return epio->sram_hash;
+}
+
+// Restores a page to the given contents, or to unwritten if data is NULL.
+void epio_sram_restore_page(epio_t *epio, uint32_t page_num, const uint8_t *data) {
+    if (data != NULL) {
+        uint32_t addr = MIN_SRAM_ADDR + page_num * SRAM_PAGE_SIZE;
+        memcpy(epio_sram_write_ptr(epio, addr), data, SRAM_PAGE_SIZE);
+        return;
+    }
+
+    // Pages only become shared when an instance is created, so a shared page
+    // is never restored to unwritten
+    uint8_t *page = epio->sram_page[page_num];
+    if (page == NULL) {
+        return;
+    }
+    assert(!SRAM_PAGE_IS_SHARED(epio, page_num) && "Cannot restore shared page to unwritten");
+    free(page);
+    epio->sram_page[page_num] = NULL;
+    epio->sram_resident_pages--;
+
+    // An unwritten page hashes to 0
+    epio_sram_page_dirty(epio, page_num);
+    epio->sram_page_hash[page_num] = 0;
+    epio->sram_dirty[page_num / 32] &= ~(1U << (page_num % 32));
+}
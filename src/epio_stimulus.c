@@ -0,0 +1,734 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// GPIO stimulus playback, from VCD or binary edge list files
+//
+// The file is read through a fixed buffer, a group of edges at a time.  The
+// next group - all the GPIO changes at a single timestamp - is held, with
+// the cycle it applies at, until epio_step_cycles() reaches that cycle.
+// epio_step_cycles() runs up to that cycle in one go, so the step loop
+// itself is unaffected by playback.
+//
+// Only VCD signals mapped to GPIOs are tracked during playback.  They are
+// held sorted by VCD identifier code, so each value change is a binary
+// search, and changes to other signals are skipped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+#define STIM_BUF_SIZE       (64 * 1024)
+
+// Longest token kept in full.  Longer tokens keep their first character and
+// at least their last STIM_TOKEN_MAX / 2 characters, which is enough for the
+// low 64 bits of any vector value.
+#define STIM_TOKEN_MAX      256
+
+// Maximum VCD scope nesting, and hierarchical name length
+#define STIM_MAX_SCOPES     64
+#define STIM_MAX_NAME       1024
+
+// Maximum number of bits of a vector which can be mapped
+#define STIM_MAX_BITS       64
+
+#define EDGES_MAGIC         "EPIOEDGE"
+#define EDGES_VERSION       1
+
+#define FS_PER_SECOND       1000000000000000ULL
+
+typedef enum {
+    STIM_VCD,
+    STIM_EDGES,
+} epio_stimulus_format_t;
+
+// A signal declared in the VCD header
+typedef struct {
+    // Full hierarchical name, and a pointer to the reference within it
+    char *name;
+    const char *ref;
+
+    // VCD identifier code
+    char *id;
+
+    // Width in bits, and any declared range or bit index
+    uint32_t width;
+    uint8_t has_range;
+    int32_t msb;
+    int32_t lsb;
+} epio_stimulus_var_t;
+
+// A VCD identifier code with at least one bit mapped to a GPIO
+typedef struct {
+    char *id;
+
+    // Which bits are mapped, and the GPIO each is mapped to
+    uint64_t bits;
+    uint8_t gpio[STIM_MAX_BITS];
+} epio_stimulus_sig_t;
+
+struct epio_stimulus_t {
+    epio_stimulus_format_t format;
+    FILE *file;
+
+    // Whether attached to an instance
+    uint8_t attached;
+
+    // Set if playback stopped because the file is malformed
+    uint8_t error;
+
+    // Set once the end of the file has been reached
+    uint8_t eof;
+
+    // VCD signals, and those which are mapped, sorted by id
+    epio_stimulus_var_t *vars;
+    uint32_t num_vars;
+    epio_stimulus_sig_t *sigs;
+    uint32_t num_sigs;
+    uint64_t mapped_gpios;
+
+    // VCD timescale, in femtoseconds, and the timestamp of the value changes
+    // currently being read
+    uint64_t timescale_fs;
+    uint64_t time;
+
+    // Conversion from time to cycles, and the cycle playback started at
+    uint32_t sys_clock_hz;
+    uint64_t start_cycle;
+
+    // The next group of edges - at cycle, drive the GPIOs in drive to
+    // level, and release those in release
+    uint8_t has_next;
+    uint64_t cycle;
+    uint64_t drive;
+    uint64_t level;
+    uint64_t release;
+
+    // Read buffer
+    size_t pos;
+    size_t len;
+    uint8_t buf[STIM_BUF_SIZE];
+};
+
+#define STIMULUS            epio->stimulus
+
+// Returns the next byte of the file, or EOF
+static int stim_getc(epio_stimulus_t *stim) {
+    if (stim->pos == stim->len) {
+        stim->len = fread(stim->buf, 1, sizeof(stim->buf), stim->file);
+        stim->pos = 0;
+        if (stim->len == 0) {
+            return EOF;
+        }
+    }
+    return stim->buf[stim->pos++];
+}
+
+static int stim_is_space(int ch) {
+    return (ch == ' ') || (ch == '\t') || (ch == '\n') || (ch == '\r') || (ch == '\f') || (ch == '\v');
+}
+
+// Reads the next whitespace delimited token into tok, which must be
+// STIM_TOKEN_MAX bytes.  Returns its length as stored, or 0 at end of file.
+static size_t stim_token(epio_stimulus_t *stim, char *tok) {
+    int ch;
+    do {
+        ch = stim_getc(stim);
+    } while (stim_is_space(ch));
+
+    size_t len = 0;
+    while ((ch != EOF) && !stim_is_space(ch)) {
+        if (len == STIM_TOKEN_MAX - 1) {
+            // Keep the first character, and drop the oldest half of the rest
+            memmove(tok + 1, tok + 1 + STIM_TOKEN_MAX / 2, len - 1 - STIM_TOKEN_MAX / 2);
+            len -= STIM_TOKEN_MAX / 2;
+        }
+        tok[len++] = (char)ch;
+        ch = stim_getc(stim);
+    }
+    tok[len] = '\0';
+
+    return len;
+}
+
+// Skips tokens up to and including the next $end.  Returns 0 if the end of
+// the file is reached first.
+static int stim_skip_to_end(epio_stimulus_t *stim, char *tok) {
+    while (stim_token(stim, tok) > 0) {
+        if (strcmp(tok, "$end") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parses an unsigned decimal number, which must be the whole of str.
+// Returns 0 if it is not a valid number.
+static int stim_parse_u64(const char *str, uint64_t *value) {
+    if (*str == '\0') {
+        return 0;
+    }
+    uint64_t result = 0;
+    for (; *str != '\0'; str++) {
+        if ((*str < '0') || (*str > '9')) {
+            return 0;
+        }
+        uint64_t digit = (uint64_t)(*str - '0');
+        if (result > (UINT64_MAX - digit) / 10) {
+            return 0;
+        }
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return 1;
+}
+
+// Parses the contents of a $timescale, such as "1ns" or "10 ps", up to and
+// including its $end.  Returns 0 if it is malformed.
+static int vcd_parse_timescale(epio_stimulus_t *stim, char *tok) {
+    char text[32] = "";
+    while (1) {
+        if (stim_token(stim, tok) == 0) {
+            return 0;
+        }
+        if (strcmp(tok, "$end") == 0) {
+            break;
+        }
+        if (strlen(text) + strlen(tok) >= sizeof(text)) {
+            return 0;
+        }
+        strcat(text, tok);
+    }
+
+    static const struct {
+        const char *unit;
+        uint64_t fs;
+    } units[] = {
+        { "s", FS_PER_SECOND },
+        { "ms", 1000000000000ULL },
+        { "us", 1000000000ULL },
+        { "ns", 1000000ULL },
+        { "ps", 1000ULL },
+        { "fs", 1ULL },
+    };
+    static const char *multipliers[] = { "1", "10", "100" };
+    uint64_t scale = 1;
+    for (size_t ii = 0; ii < sizeof(multipliers) / sizeof(multipliers[0]); ii++, scale *= 10) {
+        size_t len = strlen(multipliers[ii]);
+        if ((strncmp(text, multipliers[ii], len) != 0) || (text[len] < 'a')) {
+            continue;
+        }
+        for (size_t jj = 0; jj < sizeof(units) / sizeof(units[0]); jj++) {
+            if (strcmp(text + len, units[jj].unit) == 0) {
+                stim->timescale_fs = scale * units[jj].fs;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Parses a bit index or range, such as "[3]" or "[7:0]", into var.  Returns
+// 0 if it is malformed.
+static int vcd_parse_range(epio_stimulus_var_t *var, const char *str) {
+    int consumed = 0;
+    if ((sscanf(str, "[%d:%d]%n", &var->msb, &var->lsb, &consumed) == 2) && (str[consumed] == '\0')) {
+        var->has_range = 1;
+        return 1;
+    }
+    if ((sscanf(str, "[%d]%n", &var->msb, &consumed) == 1) && (str[consumed] == '\0')) {
+        var->lsb = var->msb;
+        var->has_range = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Parses the contents of a $var, up to and including its $end, adding it to
+// the stimulus' signals.  scope is the current hierarchical scope.  Returns
+// 0 if it is malformed.
+static int vcd_parse_var(epio_stimulus_t *stim, char *tok, const char *scope) {
+    char id[STIM_TOKEN_MAX];
+    char name[STIM_MAX_NAME];
+    uint64_t width;
+
+    // Type, which is ignored, then width, identifier code and reference
+    if ((stim_token(stim, tok) == 0)
+        || (stim_token(stim, tok) == 0) || !stim_parse_u64(tok, &width) || (width == 0) || (width > UINT32_MAX)
+        || (stim_token(stim, id) == 0)
+        || (stim_token(stim, tok) == 0)) {
+        return 0;
+    }
+
+    epio_stimulus_var_t var = { .width = (uint32_t)width };
+    int len = snprintf(name, sizeof(name), "%s%s%s", scope, (scope[0] != '\0') ? "." : "", tok);
+    if (len >= (int)sizeof(name)) {
+        return 0;
+    }
+
+    // The reference may be followed by a bit index or range, either attached
+    // or as a separate token
+    char *bracket = strchr(name, '[');
+    if (bracket != NULL) {
+        if (!vcd_parse_range(&var, bracket)) {
+            return 0;
+        }
+        *bracket = '\0';
+    }
+    while (1) {
+        if (stim_token(stim, tok) == 0) {
+            return 0;
+        }
+        if (strcmp(tok, "$end") == 0) {
+            break;
+        }
+        if (var.has_range || !vcd_parse_range(&var, tok)) {
+            return 0;
+        }
+    }
+
+    epio_stimulus_var_t *vars = realloc(stim->vars, (stim->num_vars + 1) * sizeof(*vars));
+    if (vars == NULL) {
+        // LCOV_EXCL_START
+        return 0;
+        // LCOV_EXCL_STOP
+    }
+    stim->vars = vars;
+    var.name = strdup(name);
+    var.id = strdup(id);
+    if ((var.name == NULL) || (var.id == NULL)) {
+        // LCOV_EXCL_START
+        free(var.name);
+        free(var.id);
+        return 0;
+        // LCOV_EXCL_STOP
+    }
+    const char *dot = strrchr(var.name, '.');
+    var.ref = (dot != NULL) ? dot + 1 : var.name;
+    stim->vars[stim->num_vars++] = var;
+
+    return 1;
+}
+
+// Parses the VCD header, up to and including $enddefinitions.  Returns 0 if
+// it is malformed.
+static int vcd_parse_header(epio_stimulus_t *stim) {
+    char tok[STIM_TOKEN_MAX];
+    char scope[STIM_MAX_NAME] = "";
+    size_t scope_len[STIM_MAX_SCOPES];
+    uint32_t depth = 0;
+
+    // If there is no $timescale, assume 1ns
+    stim->timescale_fs = 1000000ULL;
+
+    while (stim_token(stim, tok) > 0) {
+        if (strcmp(tok, "$enddefinitions") == 0) {
+            return stim_skip_to_end(stim, tok);
+        } else if (strcmp(tok, "$timescale") == 0) {
+            if (!vcd_parse_timescale(stim, tok)) {
+                return 0;
+            }
+        } else if (strcmp(tok, "$scope") == 0) {
+            // Type, which is ignored, then name
+            size_t len = strlen(scope);
+            if ((depth == STIM_MAX_SCOPES)
+                || (stim_token(stim, tok) == 0)
+                || (stim_token(stim, tok) == 0)
+                || (len + 1 + strlen(tok) >= sizeof(scope))) {
+                return 0;
+            }
+            scope_len[depth++] = len;
+            if (len > 0) {
+                strcat(scope, ".");
+            }
+            strcat(scope, tok);
+            if (!stim_skip_to_end(stim, tok)) {
+                return 0;
+            }
+        } else if (strcmp(tok, "$upscope") == 0) {
+            if (depth == 0) {
+                return 0;
+            }
+            scope[scope_len[--depth]] = '\0';
+            if (!stim_skip_to_end(stim, tok)) {
+                return 0;
+            }
+        } else if (strcmp(tok, "$var") == 0) {
+            if (!vcd_parse_var(stim, tok, scope)) {
+                return 0;
+            }
+        } else if (tok[0] == '$') {
+            // $date, $version, $comment, etc
+            if (!stim_skip_to_end(stim, tok)) {
+                return 0;
+            }
+        } else {
+            return 0;
+        }
+    }
+
+    // Reached the end of the file without $enddefinitions
+    return 0;
+}
+
+// Returns the mapped signal with the given id, or NULL if there is none
+static epio_stimulus_sig_t *vcd_find_sig(epio_stimulus_t *stim, const char *id) {
+    uint32_t lo = 0;
+    uint32_t hi = stim->num_sigs;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        int cmp = strcmp(id, stim->sigs[mid].id);
+        if (cmp == 0) {
+            return &stim->sigs[mid];
+        } else if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+// Applies a value change to the next group of edges.  value holds len
+// characters, most significant bit first.
+static void vcd_change(epio_stimulus_t *stim, const char *id, const char *value, size_t len) {
+    epio_stimulus_sig_t *sig = vcd_find_sig(stim, id);
+    if (sig == NULL) {
+        return;
+    }
+
+    for (uint64_t bits = sig->bits; bits != 0; bits &= bits - 1) {
+        uint32_t bit = (uint32_t)__builtin_ctzll(bits);
+
+        // Values shorter than the vector are extended with 0, unless their
+        // first bit is x or z, which is extended instead
+        char ch;
+        if (bit < len) {
+            ch = value[len - 1 - bit];
+        } else {
+            ch = (value[0] == '1') ? '0' : value[0];
+        }
+
+        uint64_t pin = 1ULL << sig->gpio[bit];
+        if ((ch == '0') || (ch == '1')) {
+            stim->drive |= pin;
+            stim->release &= ~pin;
+            stim->level = (ch == '1') ? (stim->level | pin) : (stim->level & ~pin);
+        } else {
+            stim->release |= pin;
+            stim->drive &= ~pin;
+        }
+    }
+}
+
+// Reads the next group of value changes which affect a mapped GPIO.
+// Returns 1 if one was read, 0 at the end of the file, or -1 if the file is
+// malformed.
+static int vcd_read_group(epio_stimulus_t *stim) {
+    char tok[STIM_TOKEN_MAX];
+    char id[STIM_TOKEN_MAX];
+
+    while (!stim->eof) {
+        uint64_t time = stim->time;
+        stim->drive = 0;
+        stim->level = 0;
+        stim->release = 0;
+
+        // Read changes until the next timestamp
+        while (1) {
+            size_t len = stim_token(stim, tok);
+            if (len == 0) {
+                stim->eof = 1;
+                break;
+            }
+            if (tok[0] == '#') {
+                if (!stim_parse_u64(tok + 1, &stim->time) || (stim->time < time)) {
+                    return -1;
+                }
+                break;
+            } else if (strcmp(tok, "$comment") == 0) {
+                if (!stim_skip_to_end(stim, tok)) {
+                    return -1;
+                }
+            } else if (tok[0] == '$') {
+                // $dumpvars, $dumpoff, $end, etc - the value changes within
+                // them are processed as normal
+            } else if ((tok[0] == 'b') || (tok[0] == 'B')) {
+                if (stim_token(stim, id) == 0) {
+                    return -1;
+                }
+                vcd_change(stim, id, tok + 1, len - 1);
+            } else if ((tok[0] == 'r') || (tok[0] == 'R')) {
+                // Real values cannot be mapped
+                if (stim_token(stim, id) == 0) {
+                    return -1;
+                }
+            } else if (strchr("01xXzZ", tok[0]) != NULL) {
+                vcd_change(stim, tok + 1, tok, 1);
+            } else {
+                return -1;
+            }
+        }
+
+        if ((stim->drive | stim->release) != 0) {
+            stim->cycle = stim->start_cycle
+                + (uint64_t)((unsigned __int128)time * stim->timescale_fs * stim->sys_clock_hz / FS_PER_SECOND);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Reads an unsigned LEB128 value.  Returns 1 if one was read, 0 if the file
+// ended before it started, or -1 if it is truncated or too large.
+static int edges_read_value(epio_stimulus_t *stim, uint64_t *value) {
+    *value = 0;
+    for (uint32_t shift = 0; ; shift += 7) {
+        int ch = stim_getc(stim);
+        if (ch == EOF) {
+            return (shift == 0) ? 0 : -1;
+        }
+        if ((shift == 63) && (ch > 1)) {
+            // Too large, or more than 10 bytes long
+            return -1;
+        }
+        *value |= (uint64_t)(ch & 0x7F) << shift;
+        if ((ch & 0x80) == 0) {
+            return 1;
+        }
+    }
+}
+
+// Reads the next edge record.  Returns 1 if one was read, 0 at the end of the
+// file, or -1 if the file is malformed.
+static int edges_read_group(epio_stimulus_t *stim) {
+    uint64_t delta;
+    int rc = edges_read_value(stim, &delta);
+    if (rc <= 0) {
+        return rc;
+    }
+    if ((edges_read_value(stim, &stim->drive) != 1)
+        || (edges_read_value(stim, &stim->level) != 1)
+        || (edges_read_value(stim, &stim->release) != 1)
+        || ((stim->drive | stim->release) & ~GPIO_ALL_MASK)
+        || (stim->level & ~stim->drive)
+        || (stim->drive & stim->release)) {
+        return -1;
+    }
+    stim->cycle += delta;
+    return 1;
+}
+
+// Reads the next group of edges into the stimulus, or stops playback if
+// there are none, or the file is malformed
+static void stim_read_next(epio_stimulus_t *stim) {
+    int rc = (stim->format == STIM_VCD) ? vcd_read_group(stim) : edges_read_group(stim);
+    stim->has_next = (rc == 1);
+    if ((rc < 0) || ferror(stim->file)) {
+        stim->has_next = 0;
+        stim->error = 1;
+    }
+}
+
+// Opens path, returning a stimulus for it, or NULL on failure
+static epio_stimulus_t *stim_open(const char *path, epio_stimulus_format_t format) {
+    assert(path != NULL && "Stimulus path cannot be NULL");
+
+    epio_stimulus_t *stim = (epio_stimulus_t *)calloc(1, sizeof(epio_stimulus_t));
+    if (stim == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    stim->format = format;
+    stim->file = fopen(path, "rb");
+    if (stim->file == NULL) {
+        free(stim);
+        return NULL;
+    }
+
+    return stim;
+}
+
+epio_stimulus_t *epio_stimulus_open_vcd(const char *path) {
+    epio_stimulus_t *stim = stim_open(path, STIM_VCD);
+    if ((stim != NULL) && !vcd_parse_header(stim)) {
+        epio_stimulus_free(stim);
+        return NULL;
+    }
+    return stim;
+}
+
+epio_stimulus_t *epio_stimulus_open_edges(const char *path) {
+    epio_stimulus_t *stim = stim_open(path, STIM_EDGES);
+    if (stim == NULL) {
+        return NULL;
+    }
+
+    uint8_t header[12];
+    for (size_t ii = 0; ii < sizeof(header); ii++) {
+        int ch = stim_getc(stim);
+        if (ch == EOF) {
+            epio_stimulus_free(stim);
+            return NULL;
+        }
+        header[ii] = (uint8_t)ch;
+    }
+    uint32_t version = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+    if ((memcmp(header, EDGES_MAGIC, 8) != 0) || (version != EDGES_VERSION)) {
+        epio_stimulus_free(stim);
+        return NULL;
+    }
+
+    return stim;
+}
+
+int epio_stimulus_map(epio_stimulus_t *stim, const char *signal, uint8_t gpio) {
+    assert(stim != NULL && "Stimulus cannot be NULL");
+    assert(signal != NULL && "Signal name cannot be NULL");
+    assert(!stim->attached && "Stimulus signals must be mapped before it is attached");
+    CHECK_GPIO(gpio);
+
+    if ((stim->format != STIM_VCD) || (stim->mapped_gpios & (1ULL << gpio))) {
+        return -1;
+    }
+
+    // Split off any bit index
+    char name[STIM_MAX_NAME];
+    if (strlen(signal) >= sizeof(name)) {
+        return -1;
+    }
+    strcpy(name, signal);
+    epio_stimulus_var_t index = { 0 };
+    char *bracket = strchr(name, '[');
+    if (bracket != NULL) {
+        if (!vcd_parse_range(&index, bracket) || (index.msb != index.lsb)) {
+            return -1;
+        }
+        *bracket = '\0';
+    }
+
+    // Find the first matching signal, and the bit within it
+    epio_stimulus_var_t *var = NULL;
+    uint32_t bit = 0;
+    for (uint32_t ii = 0; (ii < stim->num_vars) && (var == NULL); ii++) {
+        epio_stimulus_var_t *cand = &stim->vars[ii];
+        if ((strcmp(name, cand->name) != 0) && (strcmp(name, cand->ref) != 0)) {
+            continue;
+        }
+        if (!index.has_range) {
+            // A whole signal, which must be a single bit
+            if (cand->width == 1) {
+                var = cand;
+            }
+        } else if (cand->has_range) {
+            int32_t offset = (cand->msb >= cand->lsb) ? (index.msb - cand->lsb) : (cand->lsb - index.msb);
+            if ((offset >= 0) && ((uint32_t)offset < cand->width)) {
+                var = cand;
+                bit = (uint32_t)offset;
+            }
+        }
+    }
+    if ((var == NULL) || (bit >= STIM_MAX_BITS)) {
+        return -1;
+    }
+
+    // Find or insert the mapped signal for this id, keeping them sorted
+    epio_stimulus_sig_t *sig = vcd_find_sig(stim, var->id);
+    if (sig == NULL) {
+        epio_stimulus_sig_t *sigs = realloc(stim->sigs, (stim->num_sigs + 1) * sizeof(*sigs));
+        if (sigs == NULL) {
+            // LCOV_EXCL_START
+            return -1;
+            // LCOV_EXCL_STOP
+        }
+        stim->sigs = sigs;
+        uint32_t pos = 0;
+        while ((pos < stim->num_sigs) && (strcmp(stim->sigs[pos].id, var->id) < 0)) {
+            pos++;
+        }
+        memmove(&stim->sigs[pos + 1], &stim->sigs[pos], (stim->num_sigs - pos) * sizeof(*sigs));
+        stim->num_sigs++;
+        sig = &stim->sigs[pos];
+        memset(sig, 0, sizeof(*sig));
+        sig->id = var->id;
+    }
+    if (sig->bits & (1ULL << bit)) {
+        // Already mapped to another GPIO
+        return -1;
+    }
+    sig->bits |= (1ULL << bit);
+    sig->gpio[bit] = gpio;
+    stim->mapped_gpios |= (1ULL << gpio);
+
+    return 0;
+}
+
+void epio_stimulus_attach(epio_t *epio, epio_stimulus_t *stim) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(stim != NULL && "Stimulus cannot be NULL");
+    assert(!stim->attached && "Stimulus is already attached");
+
+    epio_stimulus_detach(epio);
+    STIMULUS = stim;
+    stim->attached = 1;
+    stim->sys_clock_hz = epio->sys_clock_hz;
+    stim->start_cycle = epio->cycle_count;
+    stim->cycle = epio->cycle_count;
+
+    stim_read_next(stim);
+    epio_stimulus_apply(epio);
+}
+
+void epio_stimulus_detach(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (STIMULUS != NULL) {
+        STIMULUS->attached = 0;
+        epio_stimulus_free(STIMULUS);
+        STIMULUS = NULL;
+    }
+}
+
+int epio_stimulus_status(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    if (STIMULUS == NULL) {
+        return 0;
+    }
+    if (STIMULUS->error) {
+        return -1;
+    }
+    return STIMULUS->has_next;
+}
+
+void epio_stimulus_free(epio_stimulus_t *stim) {
+    assert(stim != NULL && "Stimulus cannot be NULL");
+    assert(!stim->attached && "Stimulus is attached - use epio_stimulus_detach()");
+    for (uint32_t ii = 0; ii < stim->num_vars; ii++) {
+        free(stim->vars[ii].name);
+        free(stim->vars[ii].id);
+    }
+    free(stim->vars);
+    free(stim->sigs);
+    fclose(stim->file);
+    free(stim);
+}
+
+// Returns the cycle of the next edge to be applied, which is always after
+// the current cycle, or UINT64_MAX if there is none
+uint64_t epio_stimulus_next_cycle(epio_t *epio) {
+    return STIMULUS->has_next ? STIMULUS->cycle : UINT64_MAX;
+}
+
+// Applies all edges at or before the current cycle
+void epio_stimulus_apply(epio_t *epio) {
+    epio_stimulus_t *stim = STIMULUS;
+    while (stim->has_next && (stim->cycle <= epio->cycle_count)) {
+        epio_drive_gpios_masked(epio, stim->drive | stim->release, stim->drive, stim->level);
+        stim_read_next(stim);
+    }
+}
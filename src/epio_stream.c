@@ -0,0 +1,273 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Streams of words to TX FIFOs and from RX FIFOs
+//
+// While any stream is attached, epio_after_step() calls epio_streams_step()
+// after every cycle.  Attached streams are kept in a bitmap per direction,
+// so only their SMs are visited, and each SM's underruns and overruns are
+// read from the SM events set by the instructions which stall on, or drop
+// data because of, a FIFO.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+typedef struct {
+    // Buffer, its size, and the next word in it, or NULL for a callback
+    const uint32_t *words;
+    uint32_t *rx_words;
+    uint32_t count;
+    uint32_t pos;
+
+    // Callbacks and their context
+    epio_stream_fill_t fill;
+    epio_stream_drain_t drain;
+    void *ctx;
+
+    epio_stream_stats_t stats;
+} epio_stream_t;
+
+struct epio_streams_t {
+    epio_stream_t tx[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+    epio_stream_t rx[NUM_PIO_BLOCKS][NUM_SMS_PER_BLOCK];
+
+    // Attached streams, bit (block * NUM_SMS_PER_BLOCK + sm)
+    uint32_t tx_attached;
+    uint32_t rx_attached;
+};
+
+#define STREAMS     epio->streams
+#define STREAM_BIT(BLOCK, _SM)  (1U << ((BLOCK) * NUM_SMS_PER_BLOCK + (_SM)))
+
+// Refills an SM's TX FIFO from its source
+static void epio_stream_fill(epio_t *epio, uint8_t block, uint8_t sm) {
+    epio_stream_t *stream = &STREAMS->tx[block][sm];
+    uint32_t room = TX_FIFO_CAPACITY(block, sm) - TX_FIFO_LEVEL(block, sm);
+    if (room == 0) {
+        return;
+    }
+
+    uint32_t words[MAX_JOINED_FIFO_DEPTH];
+    const uint32_t *src = words;
+    uint32_t count;
+    if (stream->fill != NULL) {
+        count = stream->fill(stream->ctx, epio, words, room);
+        assert(count <= room && "Fill callback supplied too many words");
+    } else {
+        count = stream->count - stream->pos;
+        if (count > room) {
+            count = room;
+        }
+        src = stream->words + stream->pos;
+        stream->pos += count;
+        stream->stats.done = (stream->pos == stream->count);
+    }
+
+    for (uint32_t ii = 0; ii < count; ii++) {
+        epio_fifo_push_tx(epio, block, sm, src[ii]);
+    }
+    stream->stats.words += count;
+}
+
+// Drains an SM's RX FIFO into its sink
+static void epio_stream_drain(epio_t *epio, uint8_t block, uint8_t sm) {
+    epio_stream_t *stream = &STREAMS->rx[block][sm];
+    uint32_t count = RX_FIFO_LEVEL(block, sm);
+    if (count == 0) {
+        return;
+    }
+
+    if (stream->drain != NULL) {
+        uint32_t words[MAX_JOINED_FIFO_DEPTH];
+        for (uint32_t ii = 0; ii < count; ii++) {
+            words[ii] = RX_FIFO_ENTRY(block, sm, ii);
+        }
+        count = stream->drain(stream->ctx, epio, words, count);
+        assert(count <= RX_FIFO_LEVEL(block, sm) && "Drain callback accepted too many words");
+        for (uint32_t ii = 0; ii < count; ii++) {
+            epio_fifo_pop_rx(epio, block, sm);
+        }
+    } else {
+        if (count > stream->count - stream->pos) {
+            count = stream->count - stream->pos;
+        }
+        for (uint32_t ii = 0; ii < count; ii++) {
+            stream->rx_words[stream->pos++] = epio_fifo_pop_rx(epio, block, sm);
+        }
+        stream->stats.done = (stream->pos == stream->count);
+    }
+    stream->stats.words += count;
+}
+
+// Records a cycle a stream's SM underran or overran on
+static void epio_stream_stall(epio_stream_t *stream, uint64_t cycle) {
+    stream->stats.stall_cycles++;
+    if (stream->stats.first_stall == UINT64_MAX) {
+        stream->stats.first_stall = cycle;
+    }
+    stream->stats.last_stall = cycle;
+}
+
+// Attaches a stream, returning it, or NULL on allocation failure
+static epio_stream_t *epio_stream_attach(epio_t *epio, uint8_t block, uint8_t sm, uint8_t tx) {
+    if (STREAMS == NULL) {
+        STREAMS = (epio_streams_t *)calloc(1, sizeof(epio_streams_t));
+        if (STREAMS == NULL) {
+            // LCOV_EXCL_START
+            return NULL;
+            // LCOV_EXCL_STOP
+        }
+        memset(epio->sm_events, 0, sizeof(epio->sm_events));
+    }
+
+    epio_stream_t *stream;
+    if (tx) {
+        stream = &STREAMS->tx[block][sm];
+        STREAMS->tx_attached |= STREAM_BIT(block, sm);
+    } else {
+        stream = &STREAMS->rx[block][sm];
+        STREAMS->rx_attached |= STREAM_BIT(block, sm);
+    }
+    memset(stream, 0, sizeof(*stream));
+    stream->stats.first_stall = UINT64_MAX;
+    stream->stats.last_stall = UINT64_MAX;
+    return stream;
+}
+
+int epio_stream_tx_buffer(epio_t *epio, uint8_t block, uint8_t sm, const uint32_t *words, uint32_t count) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+    assert((words != NULL || count == 0) && "Words cannot be NULL");
+
+    epio_stream_t *stream = epio_stream_attach(epio, block, sm, 1);
+    if (stream == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    stream->words = words;
+    stream->count = count;
+    stream->stats.done = (count == 0);
+    epio_stream_fill(epio, block, sm);
+    return 0;
+}
+
+int epio_stream_tx_callback(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_fill_t fill, void *ctx) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+    assert(fill != NULL && "Fill callback cannot be NULL");
+
+    epio_stream_t *stream = epio_stream_attach(epio, block, sm, 1);
+    if (stream == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    stream->fill = fill;
+    stream->ctx = ctx;
+    epio_stream_fill(epio, block, sm);
+    return 0;
+}
+
+int epio_stream_rx_buffer(epio_t *epio, uint8_t block, uint8_t sm, uint32_t *words, uint32_t max) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+    assert((words != NULL || max == 0) && "Words cannot be NULL");
+
+    epio_stream_t *stream = epio_stream_attach(epio, block, sm, 0);
+    if (stream == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    stream->rx_words = words;
+    stream->count = max;
+    stream->stats.done = (max == 0);
+    epio_stream_drain(epio, block, sm);
+    return 0;
+}
+
+int epio_stream_rx_callback(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_drain_t drain, void *ctx) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+    assert(drain != NULL && "Drain callback cannot be NULL");
+
+    epio_stream_t *stream = epio_stream_attach(epio, block, sm, 0);
+    if (stream == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    stream->drain = drain;
+    stream->ctx = ctx;
+    epio_stream_drain(epio, block, sm);
+    return 0;
+}
+
+void epio_stream_stats(epio_t *epio, uint8_t block, uint8_t sm, epio_stream_stats_t *tx, epio_stream_stats_t *rx) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+
+    epio_stream_stats_t none = {
+        .first_stall = UINT64_MAX,
+        .last_stall = UINT64_MAX,
+    };
+    if (tx != NULL) {
+        uint8_t attached = (STREAMS != NULL) && (STREAMS->tx_attached & STREAM_BIT(block, sm));
+        *tx = attached ? STREAMS->tx[block][sm].stats : none;
+    }
+    if (rx != NULL) {
+        uint8_t attached = (STREAMS != NULL) && (STREAMS->rx_attached & STREAM_BIT(block, sm));
+        *rx = attached ? STREAMS->rx[block][sm].stats : none;
+    }
+}
+
+void epio_stream_detach(epio_t *epio, uint8_t block, uint8_t sm) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    CHECK_BLOCK_SM();
+    if (STREAMS == NULL) {
+        return;
+    }
+    STREAMS->tx_attached &= ~STREAM_BIT(block, sm);
+    STREAMS->rx_attached &= ~STREAM_BIT(block, sm);
+    if ((STREAMS->tx_attached | STREAMS->rx_attached) == 0) {
+        epio_streams_free(epio);
+    }
+}
+
+void epio_streams_free(epio_t *epio) {
+    free(STREAMS);
+    STREAMS = NULL;
+}
+
+void epio_streams_step(epio_t *epio) {
+    // Drain first, so RX sinks have the words pushed on this cycle, in case
+    // a callback feeds them back to a TX FIFO
+    uint32_t attached = STREAMS->rx_attached;
+    while (attached) {
+        uint32_t bit = __builtin_ctz(attached);
+        attached &= attached - 1;
+        uint8_t block = bit / NUM_SMS_PER_BLOCK;
+        uint8_t sm = bit % NUM_SMS_PER_BLOCK;
+        if (SM_EVENTS(block, sm) & (SM_EVENT_RX_STALL | SM_EVENT_RX_LOST)) {
+            epio_stream_stall(&STREAMS->rx[block][sm], epio->cycle_count);
+        }
+        epio_stream_drain(epio, block, sm);
+    }
+
+    attached = STREAMS->tx_attached;
+    while (attached) {
+        uint32_t bit = __builtin_ctz(attached);
+        attached &= attached - 1;
+        uint8_t block = bit / NUM_SMS_PER_BLOCK;
+        uint8_t sm = bit % NUM_SMS_PER_BLOCK;
+        if (SM_EVENTS(block, sm) & SM_EVENT_TX_STALL) {
+            epio_stream_stall(&STREAMS->tx[block][sm], epio->cycle_count);
+        }
+        epio_stream_fill(epio, block, sm);
+    }
+}
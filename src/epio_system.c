@@ -0,0 +1,184 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Systems of several chips connected by GPIO nets
+//
+// Each net holds a GPIO mask per chip.  With wired-AND resolution a net is
+// only low if some chip drives one of its GPIOs low, so after each cycle
+// only each chip's mask of netted GPIOs being driven low is sampled, and
+// if none has changed, nothing else is done.
+//
+// The chips are stepped one after another, on the calling thread.  As the
+// nets are resolved after every cycle, a barrier per cycle between threads
+// would cost far more than the cycle itself.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+// A net has at least two GPIOs
+#define MAX_NETS    (EPIO_SYSTEM_MAX_CHIPS * NUM_GPIOS / 2)
+#define NO_NET      0xFF
+
+struct epio_system_t {
+    epio_t *chip[EPIO_SYSTEM_MAX_CHIPS];
+    uint8_t num_chips;
+
+    // The net each GPIO of each chip is in, or NO_NET
+    uint8_t net_of[EPIO_SYSTEM_MAX_CHIPS][NUM_GPIOS];
+
+    // Each net's GPIOs on each chip
+    uint64_t net_mask[MAX_NETS][EPIO_SYSTEM_MAX_CHIPS];
+    uint32_t num_nets;
+
+    // Each chip's GPIOs in any net, and which of those it drove low when
+    // last sampled
+    uint64_t netted[EPIO_SYSTEM_MAX_CHIPS];
+    uint64_t low[EPIO_SYSTEM_MAX_CHIPS];
+};
+
+#define CHECK_CHIP(SYS, CHIP) \
+    assert((CHIP) < (SYS)->num_chips && "Invalid chip index")
+
+epio_system_t *epio_system_create(void) {
+    epio_system_t *sys = (epio_system_t *)calloc(1, sizeof(epio_system_t));
+    if (sys == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+    memset(sys->net_of, NO_NET, sizeof(sys->net_of));
+    return sys;
+}
+
+void epio_system_free(epio_system_t *sys) {
+    assert(sys != NULL && "System cannot be NULL");
+    for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+        epio_free(sys->chip[ii]);
+    }
+    free(sys);
+}
+
+int epio_system_add(epio_system_t *sys, epio_t *epio) {
+    assert(sys != NULL && "System cannot be NULL");
+    assert(epio != NULL && "epio instance cannot be NULL");
+    for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+        assert(sys->chip[ii] != epio && "Chip is already in the system");
+    }
+
+    if (sys->num_chips == EPIO_SYSTEM_MAX_CHIPS) {
+        return -1;
+    }
+    sys->chip[sys->num_chips] = epio;
+    return sys->num_chips++;
+}
+
+epio_t *epio_system_chip(epio_system_t *sys, uint8_t chip) {
+    assert(sys != NULL && "System cannot be NULL");
+    CHECK_CHIP(sys, chip);
+    return sys->chip[chip];
+}
+
+// Samples which netted GPIOs each chip drives low.  Returns whether any
+// has changed since the last sample.
+static uint8_t epio_system_sample(epio_system_t *sys) {
+    uint8_t changed = 0;
+    for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+        epio_t *epio = sys->chip[ii];
+        uint64_t low = epio->gpio.gpio_direction & ~epio->gpio.gpio_output_state & sys->netted[ii];
+        changed |= (low != sys->low[ii]);
+        sys->low[ii] = low;
+    }
+    return changed;
+}
+
+// Resolves every net from the last sample, and drives the results onto
+// each chip's netted GPIOs
+static void epio_system_resolve(epio_system_t *sys) {
+    uint64_t levels[EPIO_SYSTEM_MAX_CHIPS];
+    memcpy(levels, sys->netted, sizeof(levels));
+
+    for (uint32_t net = 0; net < sys->num_nets; net++) {
+        const uint64_t *mask = sys->net_mask[net];
+        for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+            if (sys->low[ii] & mask[ii]) {
+                for (uint8_t jj = 0; jj < sys->num_chips; jj++) {
+                    levels[jj] &= ~mask[jj];
+                }
+                break;
+            }
+        }
+    }
+
+    for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+        if (sys->netted[ii] != 0) {
+            epio_drive_gpios_masked(sys->chip[ii], sys->netted[ii], sys->netted[ii], levels[ii]);
+        }
+    }
+}
+
+// Adds a GPIO to a net
+static void epio_system_join(epio_system_t *sys, uint32_t net, uint8_t chip, uint8_t gpio) {
+    sys->net_of[chip][gpio] = net;
+    sys->net_mask[net][chip] |= 1ULL << gpio;
+    sys->netted[chip] |= 1ULL << gpio;
+}
+
+// Moves every GPIO of net from into net to, leaving from empty
+static void epio_system_move(epio_system_t *sys, uint32_t from, uint32_t to) {
+    for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+        for (uint8_t gpio = 0; gpio < NUM_GPIOS; gpio++) {
+            if ((sys->net_mask[from][ii] >> gpio) & 1) {
+                sys->net_of[ii][gpio] = to;
+            }
+        }
+        sys->net_mask[to][ii] |= sys->net_mask[from][ii];
+        sys->net_mask[from][ii] = 0;
+    }
+}
+
+void epio_system_connect(epio_system_t *sys, uint8_t chip_a, uint8_t gpio_a, uint8_t chip_b, uint8_t gpio_b) {
+    assert(sys != NULL && "System cannot be NULL");
+    CHECK_CHIP(sys, chip_a);
+    CHECK_CHIP(sys, chip_b);
+    CHECK_GPIO(gpio_a);
+    CHECK_GPIO(gpio_b);
+
+    uint8_t net_a = sys->net_of[chip_a][gpio_a];
+    uint8_t net_b = sys->net_of[chip_b][gpio_b];
+    if ((net_a == NO_NET) && (net_b == NO_NET)) {
+        uint32_t net = sys->num_nets++;
+        epio_system_join(sys, net, chip_a, gpio_a);
+        epio_system_join(sys, net, chip_b, gpio_b);
+    } else if (net_a == NO_NET) {
+        epio_system_join(sys, net_b, chip_a, gpio_a);
+    } else if (net_b == NO_NET) {
+        epio_system_join(sys, net_a, chip_b, gpio_b);
+    } else if (net_a != net_b) {
+        // Merge b into a, and fill b's slot with the last net
+        epio_system_move(sys, net_b, net_a);
+        sys->num_nets--;
+        if (net_b != sys->num_nets) {
+            epio_system_move(sys, sys->num_nets, net_b);
+        }
+    }
+
+    epio_system_sample(sys);
+    epio_system_resolve(sys);
+}
+
+void epio_system_step_cycles(epio_system_t *sys, uint32_t cycles) {
+    assert(sys != NULL && "System cannot be NULL");
+
+    for (uint32_t cycle = 0; cycle < cycles; cycle++) {
+        for (uint8_t ii = 0; ii < sys->num_chips; ii++) {
+            epio_step_cycles(sys->chip[ii], 1);
+        }
+        if (epio_system_sample(sys)) {
+            epio_system_resolve(sys);
+        }
+    }
+}
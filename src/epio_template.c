@@ -0,0 +1,69 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Templates - configure a machine state once, and create many instances from
+// it cheaply.
+//
+// A template holds a complete machine state, plus SRAM pages which it owns.
+// Creating an instance from it is a single copy of the machine state, with
+// the template's SRAM pages mapped into the instance as shared, so they are
+// only copied if and when the instance writes to them.
+
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+epio_template_t *epio_template_from_epio(epio_t *epio) {
+    assert(epio != NULL && "Cannot create a template from a NULL epio instance");
+
+    epio_template_t *tmpl = (epio_template_t *)calloc(1, sizeof(epio_template_t));
+    if (tmpl == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+
+    memcpy(&tmpl->epio, epio, EPIO_MACHINE_STATE_SIZE);
+
+    // The template must own all of its pages, even if the instance it was
+    // created from is sharing some of its own with another template.
+    epio_sram_init(&tmpl->epio);
+    epio_sram_copy_pages(&tmpl->epio, epio);
+
+    return tmpl;
+}
+
+// Creates an instance from a template in epio, which must have no SRAM
+// resident.
+static epio_t *epio_apply_template(epio_t *epio, const epio_template_t *tmpl) {
+    memcpy(epio, &tmpl->epio, EPIO_MACHINE_STATE_SIZE);
+    epio_sram_share_pages(epio, &tmpl->epio);
+    return epio;
+}
+
+epio_t *epio_from_template(const epio_template_t *tmpl) {
+    assert(tmpl != NULL && "Template cannot be NULL");
+
+    epio_t *epio = epio_alloc();
+    if (epio == NULL) {
+        // LCOV_EXCL_START
+        return NULL;
+        // LCOV_EXCL_STOP
+    }
+
+    return epio_apply_template(epio, tmpl);
+}
+
+epio_t *epio_from_template_in(const epio_template_t *tmpl, void *mem, size_t size) {
+    assert(tmpl != NULL && "Template cannot be NULL");
+    return epio_apply_template(epio_place_in(mem, size), tmpl);
+}
+
+void epio_template_free(epio_template_t *tmpl) {
+    assert(tmpl != NULL && "Cannot free a NULL template");
+    epio_sram_free(&tmpl->epio);
+    free(tmpl);
+}
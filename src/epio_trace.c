@@ -0,0 +1,395 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// VCD waveform trace writer
+//
+// While a trace is being written, epio_run_cycles() calls
+// epio_trace_sample() before each cycle and after the last, and it is not
+// called at all otherwise.  Each sample compares the traced signals to their
+// last written values, and writes only those which changed, preceded by a
+// timestamp if this is the first change at this cycle.
+//
+// GPIOs are compared a 64-bit word at a time.  SM signals are held in a
+// table of what to sample, with the last value written.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <epio_priv.h>
+
+#define TRACE_BUF_SIZE      (1024 * 1024)
+
+// Longest single line written to the buffer - a 32-bit vector value
+#define TRACE_MAX_LINE      64
+
+#define PS_PER_SECOND       1000000000000ULL
+
+// VCD identifier codes are printable ASCII, from '!' to '~'
+#define ID_FIRST            '!'
+#define ID_RADIX            ('~' - '!' + 1)
+#define ID_MAX              4
+
+// Maximum number of SM and IRQ signals
+#define MAX_SIGS            (NUM_PIO_BLOCKS * (NUM_SMS_PER_BLOCK * 8 + 1))
+
+typedef enum {
+    SIG_PC,
+    SIG_X,
+    SIG_Y,
+    SIG_ISR_COUNT,
+    SIG_OSR_COUNT,
+    SIG_TX_LEVEL,
+    SIG_RX_LEVEL,
+    SIG_STALLED,
+    SIG_IRQ,
+} epio_trace_kind_t;
+
+// Name and width of each kind of signal, in the order of the
+// EPIO_TRACE_SM_* flags
+static const struct {
+    const char *name;
+    uint8_t width;
+} sig_info[] = {
+    [SIG_PC] = { "pc", 5 },
+    [SIG_X] = { "x", 32 },
+    [SIG_Y] = { "y", 32 },
+    [SIG_ISR_COUNT] = { "isr_count", 6 },
+    [SIG_OSR_COUNT] = { "osr_count", 6 },
+    [SIG_TX_LEVEL] = { "tx_level", 4 },
+    [SIG_RX_LEVEL] = { "rx_level", 4 },
+    [SIG_STALLED] = { "stalled", 1 },
+    [SIG_IRQ] = { "irq", NUM_IRQS_PER_BLOCK },
+};
+
+// An SM or IRQ signal being traced
+typedef struct {
+    epio_trace_kind_t kind;
+    uint8_t block;
+    uint8_t sm;
+    char id[ID_MAX + 1];
+    uint32_t last;
+} epio_trace_sig_t;
+
+struct epio_trace_t {
+    FILE *file;
+
+    // Set if any write failed
+    uint8_t error;
+
+    epio_trace_config_t config;
+
+    // System clock frequency, for converting cycles to timestamps
+    uint32_t sys_clock_hz;
+
+    // The cycle a timestamp was last written for
+    uint64_t time_cycle;
+
+    // The last cycle sampled.  Earlier cycles are being replayed, so are not
+    // written again.
+    uint64_t cycle;
+
+    // Last written GPIO levels and directions, and their identifier codes
+    uint64_t levels;
+    uint64_t dirs;
+    char level_id[NUM_GPIOS][ID_MAX + 1];
+    char dir_id[NUM_GPIOS][ID_MAX + 1];
+
+    // SM and IRQ signals
+    epio_trace_sig_t sigs[MAX_SIGS];
+    uint32_t num_sigs;
+
+    // Write buffer
+    size_t len;
+    char buf[TRACE_BUF_SIZE];
+};
+
+#define TRACE               epio->trace
+
+// Writes the buffer to the file
+static void trace_flush(epio_trace_t *trace) {
+    if ((trace->len > 0) && (fwrite(trace->buf, trace->len, 1, trace->file) != 1)) {
+        trace->error = 1;
+    }
+    trace->len = 0;
+}
+
+// Makes room in the buffer for a line of up to TRACE_MAX_LINE characters
+static inline void trace_reserve(epio_trace_t *trace) {
+    if (trace->len + TRACE_MAX_LINE > sizeof(trace->buf)) {
+        trace_flush(trace);
+    }
+}
+
+// Writes a string.  Only used for the header and initial values, which are
+// written to an empty buffer, and fit in it.
+static void trace_puts(epio_trace_t *trace, const char *str) {
+    size_t len = strlen(str);
+    memcpy(trace->buf + trace->len, str, len);
+    trace->len += len;
+}
+
+// Writes a value change for a signal of the given width
+static void trace_value(epio_trace_t *trace, const char *id, uint8_t width, uint32_t value) {
+    trace_reserve(trace);
+    char *out = trace->buf + trace->len;
+    if (width == 1) {
+        *out++ = (char)('0' + (value & 1));
+    } else {
+        // Leading zeros are omitted
+        *out++ = 'b';
+        int bit = 31 - __builtin_clz(value | 1);
+        for (; bit >= 0; bit--) {
+            *out++ = (char)('0' + ((value >> bit) & 1));
+        }
+        *out++ = ' ';
+    }
+    while (*id != '\0') {
+        *out++ = *id++;
+    }
+    *out++ = '\n';
+    trace->len = (size_t)(out - trace->buf);
+}
+
+// Writes the timestamp of the given cycle
+static void trace_time(epio_trace_t *trace, uint64_t cycle) {
+    // Rounded up, so that reading it back and rounding down gives the cycle
+    unsigned __int128 ps = ((unsigned __int128)cycle * PS_PER_SECOND + trace->sys_clock_hz - 1) / trace->sys_clock_hz;
+    trace_reserve(trace);
+    trace->len += (size_t)snprintf(trace->buf + trace->len, TRACE_MAX_LINE, "#%llu\n", (unsigned long long)ps);
+    trace->time_cycle = cycle;
+}
+
+// Sets id to the identifier code for signal number num
+static void trace_make_id(char *id, uint32_t num) {
+    size_t len = 0;
+    do {
+        id[len++] = (char)(ID_FIRST + num % ID_RADIX);
+        num /= ID_RADIX;
+    } while (num > 0);
+    id[len] = '\0';
+}
+
+// Returns the current value of an SM or IRQ signal
+static uint32_t trace_sig_value(epio_t *epio, const epio_trace_sig_t *sig) {
+    uint8_t block = sig->block;
+    uint8_t sm = sig->sm;
+    switch (sig->kind) {
+        case SIG_PC:
+            return PC(block, sm);
+        case SIG_X:
+            return SM(block, sm).x;
+        case SIG_Y:
+            return SM(block, sm).y;
+        case SIG_ISR_COUNT:
+            return SM(block, sm).isr_count;
+        case SIG_OSR_COUNT:
+            return SM(block, sm).osr_count;
+        case SIG_TX_LEVEL:
+            return FIFO(block, sm).tx_fifo_count;
+        case SIG_RX_LEVEL:
+            return FIFO(block, sm).rx_fifo_count;
+        case SIG_STALLED:
+            return SM(block, sm).stalled;
+        default:
+            return IRQ(block).irq;
+    }
+}
+
+// Writes a $var declaration for a signal
+static void trace_var(epio_trace_t *trace, const char *id, uint8_t width, const char *name) {
+    char line[128];
+    if (width == 1) {
+        snprintf(line, sizeof(line), "$var wire 1 %s %s $end\n", id, name);
+    } else {
+        snprintf(line, sizeof(line), "$var wire %d %s %s [%d:0] $end\n", width, id, name, width - 1);
+    }
+    trace_puts(trace, line);
+}
+
+// Adds a signal to the table, and declares it
+static void trace_add_sig(epio_trace_t *trace, epio_trace_kind_t kind, uint8_t block, uint8_t sm, uint32_t num) {
+    epio_trace_sig_t *sig = &trace->sigs[trace->num_sigs++];
+    sig->kind = kind;
+    sig->block = block;
+    sig->sm = sm;
+    trace_make_id(sig->id, num);
+    trace_var(trace, sig->id, sig_info[kind].width, sig_info[kind].name);
+}
+
+// Writes the VCD header, declaring every traced signal
+static void trace_header(epio_trace_t *trace) {
+    const epio_trace_config_t *config = &trace->config;
+    char line[64];
+    uint32_t num = 0;
+
+    trace_puts(trace, "$version epio $end\n$timescale 1ps $end\n$scope module epio $end\n");
+
+    if (config->gpio_levels | config->gpio_dirs) {
+        trace_puts(trace, "$scope module gpio $end\n");
+        for (uint8_t pin = 0; pin < NUM_GPIOS; pin++) {
+            if ((config->gpio_levels >> pin) & 1) {
+                trace_make_id(trace->level_id[pin], num++);
+                snprintf(line, sizeof(line), "gpio%d", pin);
+                trace_var(trace, trace->level_id[pin], 1, line);
+            }
+            if ((config->gpio_dirs >> pin) & 1) {
+                trace_make_id(trace->dir_id[pin], num++);
+                snprintf(line, sizeof(line), "gpio%d_oe", pin);
+                trace_var(trace, trace->dir_id[pin], 1, line);
+            }
+        }
+        trace_puts(trace, "$upscope $end\n");
+    }
+
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        uint16_t block_sms = (config->sms >> (block * NUM_SMS_PER_BLOCK)) & ((1 << NUM_SMS_PER_BLOCK) - 1);
+        uint8_t irq = (config->irq_blocks >> block) & 1;
+        if (!irq && ((block_sms == 0) || (config->sm_signals == 0))) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "$scope module pio%d $end\n", block);
+        trace_puts(trace, line);
+        if (irq) {
+            trace_add_sig(trace, SIG_IRQ, block, 0, num++);
+        }
+        for (uint8_t sm = 0; (sm < NUM_SMS_PER_BLOCK) && (config->sm_signals != 0); sm++) {
+            if (!((block_sms >> sm) & 1)) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "$scope module sm%d $end\n", sm);
+            trace_puts(trace, line);
+            for (int kind = SIG_PC; kind <= SIG_STALLED; kind++) {
+                if ((config->sm_signals >> kind) & 1) {
+                    trace_add_sig(trace, (epio_trace_kind_t)kind, block, sm, num++);
+                }
+            }
+            trace_puts(trace, "$upscope $end\n");
+        }
+        trace_puts(trace, "$upscope $end\n");
+    }
+
+    trace_puts(trace, "$upscope $end\n$enddefinitions $end\n");
+}
+
+// Writes the value of every traced signal at the current cycle
+static void trace_dump(epio_t *epio) {
+    epio_trace_t *trace = TRACE;
+    trace_time(trace, epio->cycle_count);
+    trace_puts(trace, "$dumpvars\n");
+
+    trace->levels = epio_gpio_levels(epio);
+    trace->dirs = epio->gpio.gpio_direction;
+    for (uint8_t pin = 0; pin < NUM_GPIOS; pin++) {
+        if ((trace->config.gpio_levels >> pin) & 1) {
+            trace_value(trace, trace->level_id[pin], 1, (trace->levels >> pin) & 1);
+        }
+        if ((trace->config.gpio_dirs >> pin) & 1) {
+            trace_value(trace, trace->dir_id[pin], 1, (trace->dirs >> pin) & 1);
+        }
+    }
+    for (uint32_t ii = 0; ii < trace->num_sigs; ii++) {
+        epio_trace_sig_t *sig = &trace->sigs[ii];
+        sig->last = trace_sig_value(epio, sig);
+        trace_value(trace, sig->id, sig_info[sig->kind].width, sig->last);
+    }
+
+    trace_puts(trace, "$end\n");
+}
+
+int epio_trace_start(epio_t *epio, const char *path, const epio_trace_config_t *config) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    assert(path != NULL && "Trace path cannot be NULL");
+    assert(config != NULL && "Trace configuration cannot be NULL");
+    CHECK_GPIO_MASK(config->gpio_levels);
+    CHECK_GPIO_MASK(config->gpio_dirs);
+    assert((config->sms >> (NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK)) == 0 && "Invalid SM bit(s) set");
+    assert((config->sm_signals & ~EPIO_TRACE_SM_ALL) == 0 && "Invalid SM signal bit(s) set");
+    assert((config->irq_blocks >> NUM_PIO_BLOCKS) == 0 && "Invalid block bit(s) set");
+
+    epio_trace_stop(epio);
+
+    epio_trace_t *trace = (epio_trace_t *)calloc(1, sizeof(epio_trace_t));
+    if (trace == NULL) {
+        // LCOV_EXCL_START
+        return -1;
+        // LCOV_EXCL_STOP
+    }
+    trace->file = fopen(path, "w");
+    if (trace->file == NULL) {
+        free(trace);
+        return -1;
+    }
+    trace->config = *config;
+    trace->sys_clock_hz = epio->sys_clock_hz;
+    trace->cycle = epio->cycle_count;
+
+    TRACE = trace;
+    trace_header(trace);
+    trace_dump(epio);
+
+    return 0;
+}
+
+int epio_trace_stop(epio_t *epio) {
+    assert(epio != NULL && "epio instance cannot be NULL");
+    epio_trace_t *trace = TRACE;
+    if (trace == NULL) {
+        return 0;
+    }
+
+    trace_flush(trace);
+    if (fclose(trace->file) != 0) {
+        trace->error = 1;
+    }
+    int rc = trace->error ? -1 : 0;
+    free(trace);
+    TRACE = NULL;
+
+    return rc;
+}
+
+// Writes any traced signals which have changed since they were last written
+void epio_trace_sample(epio_t *epio) {
+    epio_trace_t *trace = TRACE;
+    uint64_t cycle = epio->cycle_count;
+    if (cycle < trace->cycle) {
+        // Replaying cycles which have already been written
+        return;
+    }
+    trace->cycle = cycle;
+
+    uint64_t levels = epio_gpio_levels(epio);
+    uint64_t dirs = epio->gpio.gpio_direction;
+    uint64_t level_changes = (levels ^ trace->levels) & trace->config.gpio_levels;
+    uint64_t dir_changes = (dirs ^ trace->dirs) & trace->config.gpio_dirs;
+    if ((level_changes | dir_changes) != 0) {
+        if (cycle != trace->time_cycle) {
+            trace_time(trace, cycle);
+        }
+        for (; level_changes != 0; level_changes &= level_changes - 1) {
+            int pin = __builtin_ctzll(level_changes);
+            trace_value(trace, trace->level_id[pin], 1, (levels >> pin) & 1);
+        }
+        for (; dir_changes != 0; dir_changes &= dir_changes - 1) {
+            int pin = __builtin_ctzll(dir_changes);
+            trace_value(trace, trace->dir_id[pin], 1, (dirs >> pin) & 1);
+        }
+        trace->levels = levels;
+        trace->dirs = dirs;
+    }
+
+    for (uint32_t ii = 0; ii < trace->num_sigs; ii++) {
+        epio_trace_sig_t *sig = &trace->sigs[ii];
+        uint32_t value = trace_sig_value(epio, sig);
+        if (value != sig->last) {
+            if (cycle != trace->time_cycle) {
+                trace_time(trace, cycle);
+            }
+            trace_value(trace, sig->id, sig_info[sig->kind].width, value);
+            sig->last = value;
+        }
+    }
+}
@@ -7,6 +7,7 @@
 // Unit tests for apio related functions from apio.c
 
 #define APIO_LOG_IMPL
+#include <stdlib.h>
 #include "test.h"
 #include "pio_basic_programs.h"
 
@@ -195,6 +196,55 @@ static void invert_transfers_via_apio(void **state) {
     epio_free(epio);
 }
 
+static void template_from_apio_matches(void **state) {
+    setup_gpiobase_16(state);
+
+    epio_t *direct = epio_from_apio();
+    assert_non_null(direct);
+    epio_template_t *tmpl = epio_template_from_apio();
+    assert_non_null(tmpl);
+
+    epio_t *epio = epio_from_template(tmpl);
+    assert_non_null(epio);
+    assert_memory_equal(epio, direct, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_get_gpiobase(epio, 0), 16);
+
+    epio_free(epio);
+    epio_free(direct);
+    epio_template_free(tmpl);
+}
+
+static void from_apio_ctx_independent_of_globals(void **state) {
+    setup_gpiobase_16(state);
+
+    epio_apio_ctx_t *ctx = malloc(sizeof(epio_apio_ctx_t));
+    assert_non_null(ctx);
+    epio_apio_ctx_capture(ctx);
+    epio_t *direct = epio_from_apio();
+    assert_non_null(direct);
+
+    // Reuse apio's globals for a different configuration
+    setup_basic_pio_apio(state);
+
+    // Instances from the context must match the original configuration
+    for (int ii = 0; ii < 2; ii++) {
+        epio_t *epio = epio_from_apio_ctx(ctx);
+        assert_non_null(epio);
+        assert_memory_equal(epio, direct, EPIO_MACHINE_STATE_SIZE);
+        assert_int_equal(epio_get_gpiobase(epio, 0), 16);
+        epio_free(epio);
+    }
+
+    epio_free(direct);
+    free(ctx);
+}
+
+static void from_apio_ctx_null(void **state) {
+    (void)state;
+    expect_assert_failure(epio_apio_ctx_capture(NULL));
+    expect_assert_failure(epio_from_apio_ctx(NULL));
+}
+
 int main(void) {
     (void)disassembly_basic_pio_apio;
     const struct CMUnitTest tests[] = {
@@ -204,6 +254,9 @@ int main(void) {
         cmocka_unit_test(force_input_low_transfers_via_apio),
         cmocka_unit_test(force_input_high_transfers_via_apio),
         cmocka_unit_test(invert_transfers_via_apio),
+        cmocka_unit_test(template_from_apio_matches),
+        cmocka_unit_test(from_apio_ctx_independent_of_globals),
+        cmocka_unit_test(from_apio_ctx_null),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for GPIO edge capture from epio_capture.c
+
+#define APIO_LOG_IMPL
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define MAX_EDGES   64
+
+// Captures 40 cycles of square_wave() into a large buffer, with GPIO 5
+// driven externally, which is not captured
+static uint32_t capture_reference(epio_edge_t *edges, uint64_t *total) {
+    epio_t *epio = square_wave();
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_step_cycles(epio, 20);
+    epio_drive_gpios_ext(epio, 1 << 5, 0);
+    epio_step_cycles(epio, 20);
+    uint32_t count = epio_capture_stop(epio, total);
+    epio_free(epio);
+    return count;
+}
+
+static void capture_edges(void **state) {
+    (void)state;
+    epio_edge_t edges[MAX_EDGES];
+    uint64_t total;
+    uint32_t count = capture_reference(edges, &total);
+
+    // GPIO 0 starts high, is driven low by the cycle before count 5, and
+    // then changes every 4 cycles
+    assert_int_equal(count, 10);
+    assert_int_equal(total, 10);
+    assert_int_equal(edges[0].cycle, 0);
+    assert_int_equal(edges[0].changed, 0);
+    assert_int_equal(edges[0].value, 1);
+    for (uint32_t ii = 1; ii < count; ii++) {
+        assert_int_equal(edges[ii].cycle, 1 + 4 * ii);
+        assert_int_equal(edges[ii].changed, 1);
+        assert_int_equal(edges[ii].value, ii % 2 ? 0 : 1);
+    }
+
+    // The levels at each cycle are those of the last edge at or before it
+    epio_t *epio = square_wave();
+    uint32_t edge = 0;
+    for (uint64_t cycle = 0; cycle <= 40; cycle++) {
+        while ((edge + 1 < count) && (edges[edge + 1].cycle <= cycle)) {
+            edge++;
+        }
+        assert_int_equal(epio_read_pin_states(epio) & 1, edges[edge].value);
+        if (cycle < 40) {
+            epio_step_cycles(epio, 1);
+        }
+    }
+    epio_free(epio);
+}
+
+static void capture_api_changes(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_edge_t edges[MAX_EDGES];
+    uint64_t levels = epio_read_pin_states(epio);
+
+    // Changes made between runs are captured at the cycle count they were
+    // made at
+    assert_int_equal(epio_capture_start(epio, 0xF0, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_step_cycles(epio, 3);
+    epio_drive_gpios_ext(epio, 0x30, 0x10);
+    epio_step_cycles(epio, 3);
+    epio_drive_gpios_ext(epio, 0x30, 0);
+    epio_step_cycles(epio, 1);
+    epio_drive_gpios_ext(epio, 0xC0, 0x40);
+
+    // Not sampled until the next run
+    assert_int_equal(epio_capture_stop(epio, NULL), 3);
+    assert_int_equal(edges[0].cycle, 0);
+    assert_int_equal(edges[0].value, levels & 0xF0);
+    assert_int_equal(edges[1].cycle, 3);
+    assert_int_equal(edges[1].changed, 0x20);
+    assert_int_equal(edges[1].value, 0xD0);
+    assert_int_equal(edges[2].cycle, 6);
+    assert_int_equal(edges[2].changed, 0x10);
+    assert_int_equal(edges[2].value, 0xC0);
+
+    epio_free(epio);
+}
+
+static void capture_overflow_stop(void **state) {
+    (void)state;
+    epio_edge_t ref[MAX_EDGES];
+    capture_reference(ref, NULL);
+
+    // Later edges are dropped, but still counted
+    epio_t *epio = square_wave();
+    epio_edge_t edges[3];
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, 3, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_step_cycles(epio, 40);
+    uint64_t total;
+    assert_int_equal(epio_capture_stop(epio, &total), 3);
+    assert_int_equal(total, 10);
+    assert_memory_equal(edges, ref, sizeof(edges));
+    epio_free(epio);
+}
+
+static void capture_overflow_wrap(void **state) {
+    (void)state;
+    epio_edge_t ref[MAX_EDGES];
+    capture_reference(ref, NULL);
+
+    // The most recent edges are kept, and returned in order, whether or not
+    // the last edge was written to the end of the buffer
+    for (uint32_t size = 4; size <= 5; size++) {
+        epio_t *epio = square_wave();
+        epio_edge_t edges[5];
+        assert_int_equal(epio_capture_start(epio, 0x1, edges, size, EPIO_CAPTURE_WRAP, NULL, NULL), 0);
+        epio_step_cycles(epio, 40);
+        uint64_t total;
+        assert_int_equal(epio_capture_stop(epio, &total), size);
+        assert_int_equal(total, 10);
+        assert_memory_equal(edges, ref + 10 - size, size * sizeof(epio_edge_t));
+        epio_free(epio);
+    }
+}
+
+typedef struct {
+    epio_edge_t edges[MAX_EDGES];
+    uint32_t count;
+    uint32_t calls;
+} flushed_t;
+
+static void flush_edges(void *arg, const epio_edge_t *edges, uint32_t count) {
+    flushed_t *flushed = (flushed_t *)arg;
+    memcpy(&flushed->edges[flushed->count], edges, count * sizeof(epio_edge_t));
+    flushed->count += count;
+    flushed->calls++;
+}
+
+static void capture_overflow_callback(void **state) {
+    (void)state;
+    epio_edge_t ref[MAX_EDGES];
+    capture_reference(ref, NULL);
+
+    // Each full buffer is passed to the callback, and the rest are left in
+    // the buffer
+    epio_t *epio = square_wave();
+    epio_edge_t edges[3];
+    flushed_t flushed = { 0 };
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, 3, EPIO_CAPTURE_CALLBACK, flush_edges, &flushed), 0);
+    epio_step_cycles(epio, 40);
+    uint64_t total;
+    assert_int_equal(epio_capture_stop(epio, &total), 1);
+    assert_int_equal(total, 10);
+    assert_int_equal(flushed.calls, 3);
+    assert_int_equal(flushed.count, 9);
+    memcpy(&flushed.edges[9], edges, sizeof(epio_edge_t));
+    assert_memory_equal(flushed.edges, ref, 10 * sizeof(epio_edge_t));
+    epio_free(epio);
+}
+
+static void capture_with_history(void **state) {
+    (void)state;
+    epio_edge_t ref[MAX_EDGES];
+    uint32_t ref_count = capture_reference(ref, NULL);
+
+    // Replayed cycles are not captured again, so seeking back and stepping
+    // forward captures the same edges as running straight through
+    epio_t *epio = square_wave();
+    epio_edge_t edges[MAX_EDGES];
+    assert_int_equal(epio_history_enable(epio, 4), 0);
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_step_cycles(epio, 20);
+    epio_drive_gpios_ext(epio, 1 << 5, 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_seek(epio, 7), 0);
+    epio_step_cycles(epio, 33);
+    assert_int_equal(epio_capture_stop(epio, NULL), ref_count);
+    assert_memory_equal(edges, ref, ref_count * sizeof(epio_edge_t));
+    epio_free(epio);
+}
+
+static void capture_start_and_stop(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+    epio_edge_t edges[MAX_EDGES];
+    uint64_t total = 1;
+
+    // Stopping with no capture does nothing
+    assert_int_equal(epio_capture_stop(epio, &total), 0);
+    assert_int_equal(total, 0);
+    assert_int_equal(epio_capture_stop(epio, NULL), 0);
+
+    // Starting again restarts the capture
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    assert_int_equal(edges[0].cycle, 10);
+    assert_int_equal(epio_capture_stop(epio, NULL), 1);
+
+    // Stopped by reset and resetting the cycle count
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_capture_stop(epio, NULL), 0);
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_reset(epio);
+    assert_int_equal(epio_capture_stop(epio, NULL), 0);
+
+    // Freed with the instance
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    epio_free(epio);
+}
+
+static void capture_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_edge_t edges[4];
+    flushed_t flushed;
+
+    expect_assert_failure(epio_capture_start(NULL, 0x1, edges, 4, EPIO_CAPTURE_STOP, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 1ULL << NUM_GPIOS, edges, 4, EPIO_CAPTURE_STOP, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 0x1, NULL, 4, EPIO_CAPTURE_STOP, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 0x1, edges, 0, EPIO_CAPTURE_STOP, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 0x1, edges, 4, EPIO_CAPTURE_CALLBACK + 1, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 0x1, edges, 4, EPIO_CAPTURE_CALLBACK, NULL, NULL));
+    expect_assert_failure(epio_capture_start(epio, 0x1, edges, 4, EPIO_CAPTURE_WRAP, flush_edges, &flushed));
+    expect_assert_failure(epio_capture_stop(NULL, NULL));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(capture_edges),
+        cmocka_unit_test(capture_api_changes),
+        cmocka_unit_test(capture_overflow_stop),
+        cmocka_unit_test(capture_overflow_wrap),
+        cmocka_unit_test(capture_overflow_callback),
+        cmocka_unit_test(capture_with_history),
+        cmocka_unit_test(capture_start_and_stop),
+        cmocka_unit_test(capture_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,264 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for timing checks from epio_check.c
+
+#define APIO_LOG_IMPL
+#include "test.h"
+
+static void check_period(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+    epio_violation_t violations[8];
+
+    assert_int_equal(epio_check_period(epio, 0, 8, 0), 0);
+    assert_int_equal(epio_check_period(epio, 0, 10, 1), 1);
+    epio_step_cycles(epio, 40);
+
+    // Rising edges on cycles 16, 24 and 32 are 1 cycle too early for the
+    // second check
+    assert_int_equal(epio_check_violations(epio, violations, 8), 3);
+    for (int ii = 0; ii < 3; ii++) {
+        assert_int_equal(violations[ii].cycle, 16 + ii * 8);
+        assert_int_equal(violations[ii].id, 1);
+        assert_int_equal(violations[ii].type, EPIO_CHECK_PERIOD);
+    }
+
+    // With the SM stopped, the next rising edge becomes overdue for each
+    // check, once
+    epio_disable_sm(epio, 0, 0);
+    epio_step_cycles(epio, 20);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 5);
+    assert_int_equal(violations[3].cycle, 41);
+    assert_int_equal(violations[3].id, 0);
+    assert_int_equal(violations[4].cycle, 44);
+    assert_int_equal(violations[4].id, 1);
+
+    // Once restarted, the first rising edge restarts each measurement
+    epio_enable_sm(epio, 0, 0);
+    epio_step_cycles(epio, 20);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 7);
+    assert_int_equal(violations[5].id, 1);
+    assert_int_equal(violations[6].id, 1);
+
+    // A late rising edge fails
+    epio_check_clear(epio);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 0);
+    assert_int_equal(epio_check_period(epio, 0, 6, 1), 0);
+    epio_step_cycles(epio, 16);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 1);
+    assert_int_equal(violations[0].id, 0);
+
+    epio_free(epio);
+}
+
+static void check_response(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_violation_t violations[8];
+
+    // A memory with an active low chip select on GPIO 8, which drives its
+    // data GPIOs 0-7 4 cycles after the cycle it is selected on
+    static const uint8_t image[2] = { 0x12, 0x34 };
+    epio_mem_config_t config = {
+        .addr_pins = { 9 },
+        .num_addr_pins = 1,
+        .data_pins = { 0, 1, 2, 3, 4, 5, 6, 7 },
+        .num_data_pins = 8,
+        .cs_pin = 8,
+        .oe_pin = EPIO_MEM_NO_PIN,
+        .latency = 3,
+    };
+    epio_drive_gpios_ext(epio, 0x300, 0x300);
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), 0);
+    assert_int_equal(epio_check_response(epio, 8, 0, 0xFF, 4), 0);
+    assert_int_equal(epio_check_response(epio, 8, 0, 0xFF, 3), 1);
+
+    // Selected on cycle 2
+    epio_step_cycles(epio, 2);
+    epio_drive_gpios_ext(epio, 0x300, 0x200);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 1);
+    assert_int_equal(violations[0].cycle, 5);
+    assert_int_equal(violations[0].id, 1);
+    assert_int_equal(violations[0].type, EPIO_CHECK_RESPONSE);
+
+    // Deselecting first abandons the check
+    epio_drive_gpios_ext(epio, 0x300, 0x300);
+    epio_step_cycles(epio, 10);
+    epio_drive_gpios_ext(epio, 0x300, 0x200);
+    epio_step_cycles(epio, 1);
+    epio_drive_gpios_ext(epio, 0x300, 0x300);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 1);
+
+    epio_free(epio);
+}
+
+static void check_fifo(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_violation_t violations[128];
+
+    // Each SM repeats a single instruction
+    epio_sm_reg_t reg = { .clkdiv = 0x00010000 };
+    epio_set_instr(epio, 0, 0, 0x8020);     // push block
+    epio_set_instr(epio, 0, 1, 0x8000);     // push noblock
+    epio_set_instr(epio, 0, 2, 0x80A0);     // pull block
+    epio_set_instr(epio, 0, 3, 0x6001);     // out pins, 1
+    epio_set_instr(epio, 1, 0, 0x4020);     // in x, 32
+    for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+        reg.execctrl = (sm << 12) | (sm << 7);
+        reg.shiftctrl = (sm == 3) ? (1 << 17) : 0;
+        epio_set_sm_reg(epio, 0, sm, &reg);
+        epio_exec_instr_sm(epio, 0, sm, sm);    // jmp sm
+        epio_enable_sm(epio, 0, sm);
+    }
+    reg.execctrl = 0;
+    reg.shiftctrl = (1 << 16);
+    epio_set_sm_reg(epio, 1, 0, &reg);
+    epio_enable_sm(epio, 1, 0);
+
+    assert_int_equal(epio_check_rx_overflow(epio, 0, 0), 0);
+    assert_int_equal(epio_check_rx_overflow(epio, 0, 1), 1);
+    assert_int_equal(epio_check_tx_underrun(epio, 0, 2), 2);
+    assert_int_equal(epio_check_tx_underrun(epio, 0, 3), 3);
+    assert_int_equal(epio_check_rx_overflow(epio, 1, 0), 4);
+    assert_int_equal(epio_check_max_stall(epio, 0, 2, 5), 5);
+    assert_int_equal(epio_check_max_stall(epio, 0, 0, 4), 6);
+    assert_int_equal(epio_check_tx_underrun(epio, 1, 1), 7);
+    epio_step_cycles(epio, 8);
+
+    // The RX FIFOs fill after 4 cycles, and the TX FIFOs start empty
+    uint32_t count[8] = { 0 };
+    uint64_t first[8];
+    uint64_t total = epio_check_violations(epio, violations, 128);
+    assert_int_equal(total, 4 + 4 + 8 + 8 + 4 + 1 + 0);
+    for (uint64_t ii = 0; ii < total; ii++) {
+        int id = violations[ii].id;
+        if (count[id]++ == 0) {
+            first[id] = violations[ii].cycle;
+        }
+    }
+    assert_int_equal(first[0], 4);
+    assert_int_equal(first[1], 4);
+    assert_int_equal(first[2], 0);
+    assert_int_equal(first[3], 0);
+    assert_int_equal(first[4], 4);
+    assert_int_equal(first[5], 5);
+    assert_int_equal(count[5], 1);
+
+    // Draining the RX FIFO ends a stall, so the next is counted afresh
+    epio_pop_rx_fifo(epio, 0, 0);
+    epio_step_cycles(epio, 4);
+    epio_pop_rx_fifo(epio, 0, 0);
+    epio_step_cycles(epio, 6);
+    total = epio_check_violations(epio, violations, 128);
+    assert_int_equal(violations[total - 1].id, 6);
+
+    // Stalls of a disabled SM are not counted
+    epio_check_clear(epio);
+    epio_disable_sm(epio, 0, 2);
+    assert_int_equal(epio_check_max_stall(epio, 0, 2, 0), 0);
+    epio_step_cycles(epio, 2);
+    assert_int_equal(epio_check_violations(epio, NULL, 0), 0);
+
+    epio_free(epio);
+}
+
+static void check_replay(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+    epio_violation_t violations[8];
+
+    assert_int_equal(epio_history_enable(epio, 16), 0);
+    assert_int_equal(epio_check_period(epio, 0, 7, 0), 0);
+    epio_step_cycles(epio, 20);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 1);
+    assert_int_equal(violations[0].cycle, 16);
+
+    // Replayed cycles are not checked again, but new ones are
+    assert_int_equal(epio_seek(epio, 3), 0);
+    epio_step_cycles(epio, 17);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 1);
+    epio_step_cycles(epio, 5);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 2);
+    assert_int_equal(violations[1].cycle, 24);
+
+    // Reset removes the checks
+    epio_reset(epio);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 0);
+    assert_int_equal(epio_check_period(epio, 0, 7, 0), 0);
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_check_violations(epio, violations, 8), 0);
+
+    epio_free(epio);
+}
+
+static void check_limits(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+
+    for (int ii = 0; ii < EPIO_MAX_CHECKS; ii++) {
+        assert_int_equal(epio_check_period(epio, 0, 2, 0), ii);
+    }
+    assert_int_equal(epio_check_period(epio, 0, 2, 0), -1);
+    assert_int_equal(epio_check_response(epio, 0, 0, 0x2, 1), -1);
+    assert_int_equal(epio_check_rx_overflow(epio, 0, 0), -1);
+
+    // Violations past the maximum are counted, but not recorded
+    epio_step_cycles(epio, 100);
+    uint64_t total = epio_check_violations(epio, NULL, 0);
+    assert_true(total > EPIO_MAX_VIOLATIONS);
+    epio_violation_t violations[EPIO_MAX_VIOLATIONS + 1];
+    violations[EPIO_MAX_VIOLATIONS].id = -1;
+    assert_int_equal(epio_check_violations(epio, violations, EPIO_MAX_VIOLATIONS + 1), total);
+    assert_int_equal(violations[EPIO_MAX_VIOLATIONS].id, -1);
+    assert_int_equal(violations[EPIO_MAX_VIOLATIONS - 1].id, EPIO_MAX_CHECKS - 1);
+
+    epio_free(epio);
+}
+
+static void check_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_violation_t violation;
+
+    expect_assert_failure(epio_check_period(NULL, 0, 2, 0));
+    expect_assert_failure(epio_check_period(epio, NUM_GPIOS, 2, 0));
+    expect_assert_failure(epio_check_period(epio, 0, 0, 0));
+    expect_assert_failure(epio_check_period(epio, 0, 2, 2));
+    expect_assert_failure(epio_check_response(NULL, 0, 0, 0x2, 1));
+    expect_assert_failure(epio_check_response(epio, NUM_GPIOS, 0, 0x2, 1));
+    expect_assert_failure(epio_check_response(epio, 0, 2, 0x2, 1));
+    expect_assert_failure(epio_check_response(epio, 0, 0, 1ULL << NUM_GPIOS, 1));
+    expect_assert_failure(epio_check_response(epio, 0, 0, 0, 1));
+    expect_assert_failure(epio_check_rx_overflow(NULL, 0, 0));
+    expect_assert_failure(epio_check_rx_overflow(epio, NUM_PIO_BLOCKS, 0));
+    expect_assert_failure(epio_check_tx_underrun(epio, 0, NUM_SMS_PER_BLOCK));
+    expect_assert_failure(epio_check_max_stall(epio, NUM_PIO_BLOCKS, 0, 1));
+    expect_assert_failure(epio_check_violations(NULL, &violation, 1));
+    expect_assert_failure(epio_check_violations(epio, NULL, 1));
+    expect_assert_failure(epio_check_clear(NULL));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(check_period),
+        cmocka_unit_test(check_response),
+        cmocka_unit_test(check_fifo),
+        cmocka_unit_test(check_replay),
+        cmocka_unit_test(check_limits),
+        cmocka_unit_test(check_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,502 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the protocol decoders from epio_decode.c
+
+#define APIO_LOG_IMPL
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define MAX_EDGES   256
+#define MAX_FRAMES  32
+
+// Edges built up by a test
+typedef struct {
+    epio_edge_t edge[MAX_EDGES];
+    uint32_t count;
+    uint64_t levels;
+} edges_t;
+
+// Frames received from a decoder
+typedef struct {
+    epio_frame_t frame[MAX_FRAMES];
+    uint32_t count;
+} frames_t;
+
+static void edges_init(edges_t *edges, uint64_t levels) {
+    edges->edge[0] = (epio_edge_t){ .cycle = 0, .changed = 0, .value = levels };
+    edges->count = 1;
+    edges->levels = levels;
+}
+
+// Sets the masked pins to value at cycle
+static void edges_set(edges_t *edges, uint64_t cycle, uint64_t mask, uint64_t value) {
+    uint64_t levels = (edges->levels & ~mask) | (value & mask);
+    assert_true(edges->count < MAX_EDGES);
+    edges->edge[edges->count++] = (epio_edge_t){ .cycle = cycle, .changed = levels ^ edges->levels, .value = levels };
+    edges->levels = levels;
+}
+
+static void collect_frame(void *arg, const epio_frame_t *frame) {
+    frames_t *frames = (frames_t *)arg;
+    assert_true(frames->count < MAX_FRAMES);
+    frames->frame[frames->count++] = *frame;
+}
+
+static void check_frame(const frames_t *frames, uint32_t index, uint8_t type, uint64_t cycle, uint64_t end, uint32_t data, uint32_t data_in, uint8_t flags) {
+    assert_true(index < frames->count);
+    const epio_frame_t *frame = &frames->frame[index];
+    assert_int_equal(frame->type, type);
+    assert_int_equal(frame->cycle, cycle);
+    assert_int_equal(frame->end, end);
+    assert_int_equal(frame->data, data);
+    assert_int_equal(frame->data_in, data_in);
+    assert_int_equal(frame->flags, flags);
+}
+
+// Sends a UART character on GPIO 0 at 10 cycles per bit, starting at cycle
+// start.  bits includes the data, any parity bit and the stop bits.
+static uint64_t uart_send(edges_t *edges, uint64_t start, uint32_t bits, uint8_t count) {
+    edges_set(edges, start, 1, 0);
+    for (uint8_t ii = 0; ii < count; ii++) {
+        edges_set(edges, start + 10 * (ii + 1), 1, (bits >> ii) & 1);
+    }
+    return start + 10 * (count + 1);
+}
+
+static void decode_uart(void **state) {
+    (void)state;
+    edges_t edges;
+    frames_t frames = { 0 };
+    epio_uart_config_t config = {
+        .pin = 0,
+        .bit_cycles = 10,
+        .data_bits = 8,
+        .parity = EPIO_UART_PARITY_EVEN,
+        .stop_bits = 1,
+    };
+    epio_decoder_t *decoder = epio_decoder_uart(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+
+    edges_init(&edges, 1);
+    uint64_t cycle = uart_send(&edges, 100, 0x2A5, 10);     // 0xA5, parity 0, stop
+    cycle = uart_send(&edges, cycle + 3, 0x301, 10);        // 0x01, parity 1, stop
+    cycle = uart_send(&edges, cycle, 0x1FF, 10);            // 0xFF, parity 1, stop low
+
+    // A low pulse shorter than half a bit is ignored
+    edges_set(&edges, cycle, 1, 1);
+    edges_set(&edges, cycle + 20, 1, 0);
+    edges_set(&edges, cycle + 24, 1, 1);
+
+    // The line changes several times while a character is being received
+    uart_send(&edges, cycle + 100, 0x355, 10);              // 0x55, parity 0, stop
+
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+
+    // The final stop bit is only decoded once the levels are known up to its
+    // middle
+    assert_int_equal(frames.count, 3);
+    check_frame(&frames, 0, EPIO_FRAME_DATA, 100, 205, 0xA5, 0, 0);
+    check_frame(&frames, 1, EPIO_FRAME_DATA, 213, 318, 0x01, 0, 0);
+    check_frame(&frames, 2, EPIO_FRAME_DATA, 323, 428, 0xFF, 0, EPIO_FRAME_ERR_PARITY | EPIO_FRAME_ERR_FRAMING);
+    epio_decoder_flush(decoder, 638);
+    assert_int_equal(frames.count, 3);
+    epio_decoder_flush(decoder, 639);
+    assert_int_equal(frames.count, 4);
+    check_frame(&frames, 3, EPIO_FRAME_DATA, 533, 638, 0x55, 0, EPIO_FRAME_ERR_PARITY);
+
+    epio_decoder_free(decoder);
+}
+
+static void decode_uart_formats(void **state) {
+    (void)state;
+    edges_t edges;
+    frames_t frames = { 0 };
+
+    // 9 data bits, odd parity, 2 stop bits
+    epio_uart_config_t config = {
+        .pin = 0,
+        .bit_cycles = 10,
+        .data_bits = 9,
+        .parity = EPIO_UART_PARITY_ODD,
+        .stop_bits = 2,
+    };
+    epio_decoder_t *decoder = epio_decoder_uart(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+    edges_init(&edges, 1);
+    uint64_t cycle = uart_send(&edges, 10, 0xD01, 12);      // 0x101, parity 0, stop, stop
+    uart_send(&edges, cycle, 0x501, 12);                    // 0x101, parity 0, stop low
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+    epio_decoder_flush(decoder, 1000);
+    assert_int_equal(frames.count, 2);
+    check_frame(&frames, 0, EPIO_FRAME_DATA, 10, 135, 0x101, 0, EPIO_FRAME_ERR_PARITY);
+    check_frame(&frames, 1, EPIO_FRAME_DATA, 140, 265, 0x101, 0, EPIO_FRAME_ERR_PARITY | EPIO_FRAME_ERR_FRAMING);
+    epio_decoder_free(decoder);
+
+    // 5 data bits, no parity
+    frames.count = 0;
+    config.data_bits = 5;
+    config.parity = EPIO_UART_PARITY_NONE;
+    config.stop_bits = 1;
+    decoder = epio_decoder_uart(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+    edges_init(&edges, 1);
+    uart_send(&edges, 10, 0x35, 6);
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+    epio_decoder_flush(decoder, 1000);
+    assert_int_equal(frames.count, 1);
+    check_frame(&frames, 0, EPIO_FRAME_DATA, 10, 75, 0x15, 0, 0);
+    epio_decoder_free(decoder);
+}
+
+// Sends count bits of SPI on GPIOs 0 (SCK), 1 (MOSI) and 2 (MISO), 4 cycles
+// per bit, MSB first, starting at cycle start
+static uint64_t spi_send(edges_t *edges, uint8_t mode, uint64_t start, uint32_t mosi, uint32_t miso, uint8_t count) {
+    uint64_t cpol = mode >> 1;
+    uint64_t cycle = start;
+    for (int ii = count - 1; ii >= 0; ii--) {
+        uint64_t data = (((mosi >> ii) & 1) << 1) | (((miso >> ii) & 1) << 2);
+        if (mode & 1) {
+            // Data changes on the leading edge
+            edges_set(edges, cycle, 0x7, data | (cpol ^ 1));
+            edges_set(edges, cycle + 2, 0x1, cpol);
+        } else {
+            edges_set(edges, cycle, 0x6, data);
+            edges_set(edges, cycle + 2, 0x1, cpol ^ 1);
+            edges_set(edges, cycle + 4, 0x1, cpol);
+        }
+        cycle += 4;
+    }
+    return cycle;
+}
+
+static void decode_spi(void **state) {
+    (void)state;
+    for (uint8_t mode = 0; mode < 4; mode++) {
+        edges_t edges;
+        frames_t frames = { 0 };
+        epio_spi_config_t config = {
+            .sck = 0,
+            .mosi = 1,
+            .miso = 2,
+            .cs = 3,
+            .mode = mode,
+            .bits = 8,
+            .lsb_first = 0,
+        };
+        epio_decoder_t *decoder = epio_decoder_spi(&config, collect_frame, &frames);
+        assert_non_null(decoder);
+
+        // Clocks while deselected are ignored
+        uint64_t cpol = mode >> 1;
+        edges_init(&edges, 0x8 | cpol);
+        uint64_t cycle = spi_send(&edges, mode, 10, 0xFF, 0xFF, 4);
+        edges_set(&edges, cycle, 0x8, 0);
+        cycle = spi_send(&edges, mode, cycle + 2, 0xA5, 0x3C, 8);
+        cycle = spi_send(&edges, mode, cycle, 0x5, 0x2, 3);
+        edges_set(&edges, cycle + 2, 0x8, 0x8);
+        epio_decoder_feed(decoder, edges.edge, edges.count);
+
+        // Sampled on the rising edge in modes 0 and 3, and the falling edge in
+        // modes 1 and 2, 2 cycles into each bit
+        assert_int_equal(frames.count, 4);
+        check_frame(&frames, 0, EPIO_FRAME_START, 26, 26, 0, 0, 0);
+        check_frame(&frames, 1, EPIO_FRAME_DATA, 30, 58, 0xA5, 0x3C, 0);
+        check_frame(&frames, 2, EPIO_FRAME_DATA, 62, 74, 0x5, 0x2, EPIO_FRAME_ERR_FRAMING);
+        check_frame(&frames, 3, EPIO_FRAME_STOP, 74, 74, 0, 0, 0);
+        epio_decoder_free(decoder);
+    }
+}
+
+static void decode_spi_lsb_first(void **state) {
+    (void)state;
+    edges_t edges;
+    frames_t frames = { 0 };
+
+    // No chip select or MISO
+    epio_spi_config_t config = {
+        .sck = 0,
+        .mosi = 1,
+        .miso = EPIO_DECODE_NO_PIN,
+        .cs = EPIO_DECODE_NO_PIN,
+        .mode = 0,
+        .bits = 32,
+        .lsb_first = 1,
+    };
+    epio_decoder_t *decoder = epio_decoder_spi(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+    edges_init(&edges, 0);
+    spi_send(&edges, 0, 10, 0x12345678, 0xFFFFFFFF, 32);
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+    assert_int_equal(frames.count, 1);
+    check_frame(&frames, 0, EPIO_FRAME_DATA, 12, 136, 0x1E6A2C48, 0, 0);
+    epio_decoder_free(decoder);
+}
+
+// Sends an I2C byte on GPIOs 5 (SCL) and 6 (SDA), with SCL low at start, 2
+// cycles per half bit, followed by the acknowledge bit
+static uint64_t i2c_send(edges_t *edges, uint64_t start, uint16_t bits, uint8_t count) {
+    uint64_t cycle = start;
+    for (int ii = count - 1; ii >= 0; ii--) {
+        edges_set(edges, cycle, 1 << 6, (uint64_t)((bits >> ii) & 1) << 6);
+        edges_set(edges, cycle + 2, 1 << 5, 1 << 5);
+        edges_set(edges, cycle + 4, 1 << 5, 0);
+        cycle += 4;
+    }
+    return cycle;
+}
+
+static void decode_i2c(void **state) {
+    (void)state;
+    edges_t edges;
+    frames_t frames = { 0 };
+    epio_i2c_config_t config = {
+        .scl = 5,
+        .sda = 6,
+    };
+    epio_decoder_t *decoder = epio_decoder_i2c(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+
+    // Clocks before a start condition are ignored
+    edges_init(&edges, 0x60);
+    edges_set(&edges, 2, 1 << 5, 0);
+    uint64_t cycle = i2c_send(&edges, 4, 0x1FF, 9);
+    edges_set(&edges, cycle, 0x60, 0x60);
+
+    // Start, address 0x50 write ACKed, data 0x3C NACKed
+    edges_set(&edges, 100, 1 << 6, 0);
+    edges_set(&edges, 102, 1 << 5, 0);
+    cycle = i2c_send(&edges, 104, 0xA0 << 1, 9);
+    cycle = i2c_send(&edges, cycle, (0x3C << 1) | 1, 9);
+
+    // Repeated start, address 0x50 read ACKed, then a byte cut short by a
+    // stop condition
+    edges_set(&edges, cycle, 1 << 6, 1 << 6);
+    edges_set(&edges, cycle + 2, 1 << 5, 1 << 5);
+    edges_set(&edges, cycle + 4, 1 << 6, 0);
+    edges_set(&edges, cycle + 6, 1 << 5, 0);
+    cycle = i2c_send(&edges, cycle + 8, 0xA1 << 1, 9);
+    cycle = i2c_send(&edges, cycle, 0x5, 3);
+    edges_set(&edges, cycle, 1 << 6, 0);
+    edges_set(&edges, cycle + 2, 1 << 5, 1 << 5);
+    edges_set(&edges, cycle + 4, 1 << 6, 1 << 6);
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+
+    assert_int_equal(frames.count, 7);
+    check_frame(&frames, 0, EPIO_FRAME_START, 100, 100, 0, 0, 0);
+    check_frame(&frames, 1, EPIO_FRAME_ADDRESS, 106, 138, 0xA0, 0, 0);
+    check_frame(&frames, 2, EPIO_FRAME_DATA, 142, 174, 0x3C, 0, EPIO_FRAME_NACK);
+    check_frame(&frames, 3, EPIO_FRAME_START, 180, 180, 0, 0, 0);
+    check_frame(&frames, 4, EPIO_FRAME_ADDRESS, 186, 218, 0xA1, 0, 0);
+    check_frame(&frames, 5, EPIO_FRAME_DATA, 222, 236, 0x5, 0, EPIO_FRAME_ERR_FRAMING);
+    check_frame(&frames, 6, EPIO_FRAME_STOP, 236, 236, 0, 0, 0);
+
+    // An address cut short is still an address
+    frames.count = 0;
+    edges_init(&edges, 0x60);
+    edges_set(&edges, 10, 1 << 6, 0);
+    edges_set(&edges, 12, 1 << 5, 0);
+    cycle = i2c_send(&edges, 14, 0x2, 2);
+    edges_set(&edges, cycle, 1 << 5, 1 << 5);
+    edges_set(&edges, cycle + 2, 1 << 6, 1 << 6);
+    epio_decoder_feed(decoder, edges.edge, edges.count);
+    assert_int_equal(frames.count, 3);
+    check_frame(&frames, 1, EPIO_FRAME_ADDRESS, 16, 24, 0x2, 0, EPIO_FRAME_ERR_FRAMING);
+    epio_decoder_free(decoder);
+}
+
+static void decode_parallel(void **state) {
+    (void)state;
+    for (uint8_t strobe_edge = EPIO_EDGE_RISING; strobe_edge <= EPIO_EDGE_FALLING; strobe_edge <<= 1) {
+        edges_t edges;
+        frames_t frames = { 0 };
+        epio_parallel_config_t config = {
+            .data_base = 32,
+            .data_count = 8,
+            .strobe = 40,
+            .strobe_edge = strobe_edge,
+        };
+        epio_decoder_t *decoder = epio_decoder_parallel(&config, collect_frame, &frames);
+        assert_non_null(decoder);
+
+        // Data changing with the strobe is latched before the change
+        edges_init(&edges, 0);
+        edges_set(&edges, 10, 0xFFULL << 32, 0x12ULL << 32);
+        edges_set(&edges, 12, 1ULL << 40, 1ULL << 40);
+        edges_set(&edges, 14, 0xFFULL << 32, 0x34ULL << 32);
+        edges_set(&edges, 16, (0xFFULL << 32) | (1ULL << 40), 0x56ULL << 32);
+        epio_decoder_feed(decoder, edges.edge, edges.count);
+
+        assert_int_equal(frames.count, 1);
+        if (strobe_edge == EPIO_EDGE_RISING) {
+            check_frame(&frames, 0, EPIO_FRAME_DATA, 12, 12, 0x12, 0, 0);
+        } else {
+            check_frame(&frames, 0, EPIO_FRAME_DATA, 16, 16, 0x34, 0, 0);
+        }
+        epio_decoder_free(decoder);
+    }
+}
+
+static void decode_live(void **state) {
+    (void)state;
+
+    // Block 0 SM 0 is a UART transmitter on GPIO 4, at 8 cycles per bit
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (5 << 12),              // wrap top 5, wrap bottom 0
+        .shiftctrl = (1 << 19),             // shift OSR right
+        .pinctrl = (1 << 26) | (4 << 5) | (1 << 20) | 4,  // set and out pin 4
+    };
+    epio_set_instr(epio, 0, 0, 0x80A0);     // pull block
+    epio_set_instr(epio, 0, 1, 0xE600);     // set pins, 0 [6]
+    epio_set_instr(epio, 0, 2, 0xE027);     // set x, 7
+    epio_set_instr(epio, 0, 3, 0x6001);     // out pins, 1
+    epio_set_instr(epio, 0, 4, 0x0643);     // jmp x--, 3 [6]
+    epio_set_instr(epio, 0, 5, 0xE701);     // set pins, 1 [7]
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 4, 0);
+    epio_exec_instr_sm(epio, 0, 0, 0xE081); // set pindirs, 1
+    epio_exec_instr_sm(epio, 0, 0, 0xE001); // set pins, 1
+    epio_enable_sm(epio, 0, 0);
+
+    frames_t frames = { 0 };
+    epio_uart_config_t config = {
+        .pin = 4,
+        .bit_cycles = 8,
+        .data_bits = 8,
+        .parity = EPIO_UART_PARITY_NONE,
+        .stop_bits = 1,
+    };
+    epio_decoder_t *decoder = epio_decoder_uart(&config, collect_frame, &frames);
+    assert_non_null(decoder);
+
+    // Decoded as the capture buffer fills
+    epio_edge_t edges[4];
+    const char *text = "Hello, PIO";
+    assert_int_equal(epio_capture_start(epio, 1 << 4, edges, 4, EPIO_CAPTURE_CALLBACK, epio_decoder_capture, decoder), 0);
+    for (size_t ii = 0; ii < strlen(text); ii++) {
+        epio_push_tx_fifo(epio, 0, 0, (uint8_t)text[ii]);
+        epio_step_cycles(epio, 100);
+    }
+    assert_true(frames.count >= strlen(text) - 1);
+    uint32_t count = epio_capture_stop(epio, NULL);
+    epio_decoder_feed(decoder, edges, count);
+    epio_decoder_flush(decoder, epio_get_cycle_count(epio));
+
+    assert_int_equal(frames.count, strlen(text));
+    for (size_t ii = 0; ii < strlen(text); ii++) {
+        assert_int_equal(frames.frame[ii].data, (uint8_t)text[ii]);
+        assert_int_equal(frames.frame[ii].flags, 0);
+    }
+
+    epio_decoder_free(decoder);
+    epio_free(epio);
+}
+
+static void decode_invalid_args(void **state) {
+    (void)state;
+    frames_t frames;
+    epio_uart_config_t uart = { .pin = 0, .bit_cycles = 8, .data_bits = 8, .parity = EPIO_UART_PARITY_NONE, .stop_bits = 1 };
+    epio_spi_config_t spi = { .sck = 0, .mosi = 1, .miso = EPIO_DECODE_NO_PIN, .cs = EPIO_DECODE_NO_PIN, .mode = 0, .bits = 8, .lsb_first = 0 };
+    epio_i2c_config_t i2c = { .scl = 0, .sda = 1 };
+    epio_parallel_config_t parallel = { .data_base = 0, .data_count = 8, .strobe = 8, .strobe_edge = EPIO_EDGE_RISING };
+
+    expect_assert_failure(epio_decoder_uart(NULL, collect_frame, &frames));
+    expect_assert_failure(epio_decoder_uart(&uart, NULL, &frames));
+    uart.pin = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.pin = 0;
+    uart.bit_cycles = 0;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.bit_cycles = 8;
+    uart.data_bits = 4;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.data_bits = 10;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.data_bits = 8;
+    uart.parity = EPIO_UART_PARITY_ODD + 1;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.parity = EPIO_UART_PARITY_NONE;
+    uart.stop_bits = 0;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+    uart.stop_bits = 3;
+    expect_assert_failure(epio_decoder_uart(&uart, collect_frame, &frames));
+
+    expect_assert_failure(epio_decoder_spi(NULL, collect_frame, &frames));
+    spi.sck = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.sck = 0;
+    spi.mosi = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.mosi = 1;
+    spi.miso = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.miso = EPIO_DECODE_NO_PIN;
+    spi.cs = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.cs = EPIO_DECODE_NO_PIN;
+    spi.mode = 4;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.mode = 0;
+    spi.bits = 0;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.bits = 33;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+    spi.bits = 8;
+    spi.lsb_first = 2;
+    expect_assert_failure(epio_decoder_spi(&spi, collect_frame, &frames));
+
+    expect_assert_failure(epio_decoder_i2c(NULL, collect_frame, &frames));
+    i2c.scl = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_i2c(&i2c, collect_frame, &frames));
+    i2c.scl = 0;
+    i2c.sda = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_i2c(&i2c, collect_frame, &frames));
+    i2c.sda = 1;
+
+    expect_assert_failure(epio_decoder_parallel(NULL, collect_frame, &frames));
+    parallel.data_count = 0;
+    expect_assert_failure(epio_decoder_parallel(&parallel, collect_frame, &frames));
+    parallel.data_count = 33;
+    expect_assert_failure(epio_decoder_parallel(&parallel, collect_frame, &frames));
+    parallel.data_count = 8;
+    parallel.data_base = NUM_GPIOS - 7;
+    expect_assert_failure(epio_decoder_parallel(&parallel, collect_frame, &frames));
+    parallel.data_base = 0;
+    parallel.strobe = NUM_GPIOS;
+    expect_assert_failure(epio_decoder_parallel(&parallel, collect_frame, &frames));
+    parallel.strobe = 8;
+    parallel.strobe_edge = EPIO_EDGE_ANY;
+    expect_assert_failure(epio_decoder_parallel(&parallel, collect_frame, &frames));
+
+    epio_decoder_t *decoder = epio_decoder_i2c(&i2c, collect_frame, &frames);
+    assert_non_null(decoder);
+    expect_assert_failure(epio_decoder_feed(NULL, NULL, 0));
+    expect_assert_failure(epio_decoder_feed(decoder, NULL, 1));
+    epio_decoder_feed(decoder, NULL, 0);
+    expect_assert_failure(epio_decoder_flush(NULL, 0));
+    expect_assert_failure(epio_decoder_free(NULL));
+    epio_decoder_flush(decoder, 0);
+    epio_decoder_free(decoder);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(decode_uart),
+        cmocka_unit_test(decode_uart_formats),
+        cmocka_unit_test(decode_spi),
+        cmocka_unit_test(decode_spi_lsb_first),
+        cmocka_unit_test(decode_i2c),
+        cmocka_unit_test(decode_parallel),
+        cmocka_unit_test(decode_live),
+        cmocka_unit_test(decode_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,261 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for program description files from epio_desc.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define DESC_PATH   "/tmp/epio_test_desc"
+#define DATA_PATH   "/tmp/epio_test_desc_data"
+#define SRAM_BASE   0x20000000
+
+// Writes text as the description, and loads it, returning the line of any
+// error
+static epio_t *load_text(const char *text, uint32_t *error_line) {
+    write_text(DESC_PATH, text);
+    epio_t *epio = epio_load_desc(DESC_PATH, error_line);
+    unlink(DESC_PATH);
+    return epio;
+}
+
+static void desc_program(void **state) {
+    (void)state;
+    uint32_t error_line = 99;
+    epio_t *epio = load_text(
+        "# Square wave on GPIO 16\n"
+        "sysclk 200000000\n"
+        "gpiobase 1 16\n"
+        "\n"
+        "instr 1 4 0xE081 0xE301 0xE300   # set pindirs 1, set pins 1 [3], set pins 0 [3]\n"
+        "sm 1 2 0x00010000 0x6280 0 0x04000000\n"
+        "exec 1 2 0x0004                  # jmp 4\n"
+        "output 16 1\n"
+        "enable 1 2\n",
+        &error_line);
+    assert_non_null(epio);
+    assert_int_equal(error_line, 0);
+
+    assert_int_equal(epio_get_sys_clock_hz(epio), 200000000);
+    assert_int_equal(epio_get_gpiobase(epio, 1), 16);
+    assert_int_equal(epio_get_instr(epio, 1, 5), 0xE301);
+    epio_sm_reg_t reg;
+    epio_get_sm_reg(epio, 1, 2, &reg);
+    assert_int_equal(reg.execctrl, 0x6280);
+    assert_int_equal(reg.pinctrl, 0x04000000);
+    assert_int_equal(epio_peek_sm_pc(epio, 1, 2), 4);
+    assert_true(epio_is_sm_enabled(epio, 1, 2));
+
+    // Wraps from 6 to 5, so GPIO 16 has a period of 8 cycles
+    epio_step_cycles(epio, 2);
+    assert_int_equal((epio_read_pin_states(epio) >> 16) & 1, 1);
+    epio_step_cycles(epio, 4);
+    assert_int_equal((epio_read_pin_states(epio) >> 16) & 1, 0);
+    epio_step_cycles(epio, 4);
+    assert_int_equal((epio_read_pin_states(epio) >> 16) & 1, 1);
+
+    epio_free(epio);
+}
+
+static void desc_state(void **state) {
+    (void)state;
+    uint8_t data[SRAM_PAGE_SIZE + 10];
+    for (size_t ii = 0; ii < sizeof(data); ii++) {
+        data[ii] = ii * 7;
+    }
+    write_file(DATA_PATH, data, sizeof(data));
+
+    epio_t *epio = load_text(
+        "tx 0 1 0x11\n"
+        "tx 0 1 0x22\n"
+        "rx 2 3 0x33\n"
+        "invert 3\n"
+        "force-low 4\n"
+        "force-high 5\n"
+        "drive 0x3 0x2\n"
+        "dma 2 0 1 4 2 3 5 16\n"
+        "sram 0x20000010 1 2 0xff\n"
+        "sram-file 0x20001000 " DATA_PATH "\n"
+        "sm 1 0 0x10000 0 0xC000 0\n"      // RX FIFO PUT/GET
+        "exec 1 0 0xE03F\n"                // set x, 31
+        "exec 1 0 0xA041\n"                // mov y, x
+        "exec 1 0 0x4040\n"                // in y, 32
+        "exec 1 0 0x8018\n"                // mov rxfifo[0], isr
+        "exec 1 0 0x8098\n"                // mov osr, rxfifo[0]
+        "exec 1 1 0x8000\n",               // push noblock
+        NULL);
+    unlink(DATA_PATH);
+    assert_non_null(epio);
+
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 1), 2);
+    assert_int_equal(epio_peek_tx_fifo(epio, 0, 1, 1), 0x22);
+    assert_int_equal(epio_peek_rx_fifo(epio, 2, 3, 0), 0x33);
+    assert_int_equal(epio_get_gpio_input_inverted(epio, 3), 1);
+    assert_int_equal(epio_get_gpio_force_input_low(epio, 4), 1);
+    assert_int_equal(epio_get_gpio_force_input_high(epio, 5), 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3, 0x2);
+    assert_int_equal(epio->dma[2].read_cycles, 4);
+    assert_int_equal(epio->dma[2].write_sm, 3);
+    assert_int_equal(epio->dma[2].bit_mode, 16);
+    assert_int_equal(epio_sram_read_word(epio, SRAM_BASE + 0x10), 0x00FF0201);
+    for (size_t ii = 0; ii < sizeof(data); ii++) {
+        assert_int_equal(epio_sram_read_byte(epio, SRAM_BASE + 0x1000 + ii), data[ii]);
+    }
+    assert_int_equal(epio_get_rx_putget(epio, 1, 0, 0), 31);
+    assert_int_equal(SM(1, 0).osr, 31);
+    assert_int_equal(epio_rx_fifo_depth(epio, 1, 1), 1);
+
+    epio_free(epio);
+}
+
+static void desc_errors(void **state) {
+    (void)state;
+    static const char *bad[] = {
+        "bogus 1\n",                        // Unknown directive
+        "enable 0\n",                       // Too few arguments
+        "enable 0 0 0\n",                   // Too many arguments
+        "enable 0 x\n",                     // Not a number
+        "enable 0 1z\n",                    // Not a number
+        "enable 0 -1\n",                    // Negative
+        "sysclk 0\n",
+        "sysclk 0x100000000\n",
+        "gpiobase 3 0\n",
+        "gpiobase 0 8\n",
+        "instr 3 0 0\n",
+        "instr 0 31 0 0\n",                 // Past the end of instruction memory
+        "instr 0 0 0x10000\n",
+        "instr 0 0xFFFFFFFFFFFFFFFF 0xA042\n", // Slot wraps when added to
+        "instr 0 32 0xA042\n",
+        "sm 0 4 0 0 0 0\n",
+        "sm 3 0 0 0 0 0\n",
+        "sm 0 0 0x100000000 0 0 0\n",
+        "sm 0 0 0x10000 0 0xC0000000 0\n", // Both FIFO joins
+        "sm 0 0 0x10000 0 0x80008000 0\n", // Join with RX FIFO PUT
+        "sm 0 0 0x10000 0 0x40004000 0\n", // Join with RX FIFO GET
+        "exec 0 0 0x10000\n",
+        "exec 0 0 0x4080\n",               // Reserved IN source
+        "exec 0 0 0x8001\n",               // Reserved PUSH encoding
+        "exec 0 0 0x8081\n",               // Reserved PULL encoding
+        "exec 0 0 0x8014\n",               // Reserved MOV to RX FIFO encoding
+        "exec 0 0 0x8011\n",               // MOV to RX FIFO index without IdxI
+        "exec 0 0 0x8018\n",               // MOV to RX FIFO without PUT
+        "exec 0 0 0x8098\n",               // MOV from RX FIFO without GET
+        "sm 0 0 0x10000 0 0x4000 0\nexec 0 0 0x8018\n",
+        "sm 0 0 0x10000 0 0x8000 0\nexec 0 0 0x8098\n",
+        "exec 0 0 0xA024\n",               // Reserved MOV source
+        "exec 0 0 0xA039\n",               // Reserved MOV operation
+        "exec 0 0 0xE060\n",               // Reserved SET destination
+        "exec 0 0 0xE0A0\n",
+        "exec 0 4 0\n",
+        "tx 0 0 0x100000000\n",
+        "tx 0 0 1\ntx 0 0 1\ntx 0 0 1\ntx 0 0 1\ntx 0 0 1\n",
+        "rx 0 0 1\nrx 0 0 1\nrx 0 0 1\nrx 0 0 1\nrx 0 0 1\n",
+        "enable 0 4\n",
+        "output 48 0\n",
+        "output 0 3\n",
+        "invert 48\n",
+        "force-low 48\n",
+        "force-high 48\n",
+        "drive 0x1000000000000 0\n",
+        "drive 0 0x1000000000000\n",
+        "dma 16 0 0 1 0 0 1 8\n",
+        "dma 0 3 0 1 0 0 1 8\n",
+        "dma 0 0 4 1 0 0 1 8\n",
+        "dma 0 0 0 0 0 0 1 8\n",
+        "dma 0 0 0 256 0 0 1 8\n",
+        "dma 0 0 0 1 3 0 1 8\n",
+        "dma 0 0 0 1 0 4 1 8\n",
+        "dma 0 0 0 1 0 0 0 8\n",
+        "dma 0 0 0 1 0 0 256 8\n",
+        "dma 0 0 0 1 0 0 1 12\n",
+        "sram 0x1fffffff 0\n",
+        "sram 0x20081fff 0 0\n",            // Runs off the end of SRAM
+        "sram 0x20000000 256\n",
+        "sram 0xFFFFFFFFFFFFFFFF 1 2\n",   // Address wraps when added to
+        "sram-file 0x1fffffff " DATA_PATH "\n",
+        "sram-file 0x20000000\n",           // No path
+        "sram-file 0x20000000 a b\n",       // Two paths
+        "sram-file 0x20000000 /nonexistent/epio\n",
+        "sram-file 0x20081000 " DATA_PATH "\n", // File runs off the end of SRAM
+    };
+
+    // A file larger than the last SRAM page
+    uint8_t data[SRAM_PAGE_SIZE + 1] = { 0 };
+    write_file(DATA_PATH, data, sizeof(data));
+
+    for (size_t ii = 0; ii < sizeof(bad) / sizeof(bad[0]); ii++) {
+        uint32_t error_line = 0;
+        assert_null(load_text(bad[ii], &error_line));
+        assert_int_not_equal(error_line, 0);
+        assert_null(load_text(bad[ii], NULL));
+    }
+    unlink(DATA_PATH);
+
+    // The line number of the error is reported
+    uint32_t error_line;
+    assert_null(load_text("# Comment\n\nenable 0 0\nenable 0 9\nenable 0 1\n", &error_line));
+    assert_int_equal(error_line, 4);
+
+    // As is a line which is too long
+    char long_line[5000];
+    memset(long_line, ' ', sizeof(long_line));
+    long_line[sizeof(long_line) - 1] = '\0';
+    assert_null(load_text(long_line, &error_line));
+    assert_int_equal(error_line, 1);
+
+    // A file which can't be opened is line 0
+    error_line = 99;
+    assert_null(epio_load_desc("/nonexistent/epio", &error_line));
+    assert_int_equal(error_line, 0);
+
+    expect_assert_failure(epio_load_desc(NULL, NULL));
+}
+
+static void desc_long_lines(void **state) {
+    (void)state;
+
+    // The longest line which fits, without a newline, and a full program
+    // written with a single instr directive
+    char text[4096 + 200];
+    memset(text, ' ', 4095);
+    memcpy(text, "enable 0 3", 10);
+    text[4095] = '\0';
+    epio_t *epio = load_text(text, NULL);
+    assert_non_null(epio);
+    assert_true(epio_is_sm_enabled(epio, 0, 3));
+    epio_free(epio);
+
+    // And with a newline, followed by another line
+    strcpy(text + 4095, "\nenable 0 2\n");
+    epio = load_text(text, NULL);
+    assert_non_null(epio);
+    assert_true(epio_is_sm_enabled(epio, 0, 2));
+    epio_free(epio);
+
+    strcpy(text, "instr 2 0");
+    for (int ii = 0; ii < NUM_INSTRS_PER_BLOCK; ii++) {
+        sprintf(text + strlen(text), " %d", ii + 1);
+    }
+    epio = load_text(text, NULL);
+    assert_non_null(epio);
+    assert_int_equal(epio_get_instr(epio, 2, NUM_INSTRS_PER_BLOCK - 1), NUM_INSTRS_PER_BLOCK);
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(desc_program),
+        cmocka_unit_test(desc_state),
+        cmocka_unit_test(desc_errors),
+        cmocka_unit_test(desc_long_lines),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
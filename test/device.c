@@ -0,0 +1,281 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for device models from epio_device.c
+
+#define APIO_LOG_IMPL
+#include "test.h"
+
+#define MAX_CALLS   64
+
+typedef struct {
+    uint32_t steps;
+    uint32_t changes;
+    uint64_t cycle[MAX_CALLS];
+    uint64_t levels[MAX_CALLS];
+    uint64_t changed[MAX_CALLS];
+    uint32_t freed;
+
+    // If set, detach this device from the callbacks
+    int detach_id;
+} device_log_t;
+
+static void log_step(void *ctx, epio_t *epio) {
+    (void)epio;
+    device_log_t *log = ctx;
+    log->steps++;
+}
+
+static void log_pins_changed(void *ctx, epio_t *epio, uint64_t levels, uint64_t changed) {
+    device_log_t *log = ctx;
+    if (log->changes < MAX_CALLS) {
+        log->cycle[log->changes] = epio_get_cycle_count(epio);
+        log->levels[log->changes] = levels;
+        log->changed[log->changes] = changed;
+    }
+    log->changes++;
+    if (log->detach_id >= 0) {
+        int id = log->detach_id;
+        log->detach_id = -1;
+        epio_device_detach(epio, id);
+    }
+}
+
+static void log_free(void *ctx) {
+    device_log_t *log = ctx;
+    log->freed++;
+}
+
+static const epio_device_ops_t log_ops = {
+    .step = log_step,
+    .pins_changed = log_pins_changed,
+    .free = log_free,
+};
+
+static void device_pins_changed(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+    device_log_t gpio0 = { .detach_id = -1 };
+    device_log_t gpio1 = { .detach_id = -1 };
+    epio_device_ops_t changes_only = { .pins_changed = log_pins_changed };
+
+    assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &gpio0), 0);
+    assert_int_equal(epio_device_attach(epio, 0x2, &changes_only, &gpio1), 1);
+    epio_step_cycles(epio, 20);
+
+    // Every cycle is stepped, but only GPIO 0's changes are passed, after
+    // the cycle which changed it.  GPIO 0 starts high.
+    assert_int_equal(gpio0.steps, 20);
+    assert_int_equal(gpio0.changes, 4);
+    uint64_t expected_levels = 0x0;
+    for (uint32_t ii = 0; ii < gpio0.changes; ii++) {
+        assert_int_equal(gpio0.cycle[ii], (ii + 1) * 4);
+        assert_int_equal(gpio0.changed[ii], 0x1);
+        assert_int_equal(gpio0.levels[ii] & 0x3, 0x2 | expected_levels);
+        expected_levels ^= 1;
+    }
+    assert_int_equal(gpio1.changes, 0);
+
+    // Free calls the free callbacks
+    epio_free(epio);
+    assert_int_equal(gpio0.freed, 1);
+    assert_int_equal(gpio1.freed, 0);
+}
+
+// Echoes GPIO 0 to GPIO 1
+static void echo_pins_changed(void *ctx, epio_t *epio, uint64_t levels, uint64_t changed) {
+    (void)ctx;
+    (void)changed;
+    epio_device_drive(epio, 0x2, (levels & 0x1) << 1);
+}
+
+static void device_drives_sm(void **state) {
+    (void)state;
+    static const epio_device_ops_t echo_ops = { .pins_changed = echo_pins_changed };
+
+    // Block 0 SM 0 lowers and raises GPIO 0, waits for GPIO 1 to go high,
+    // then lowers GPIO 0 again
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (31 << 12),
+        .pinctrl = (1 << 26),
+    };
+    epio_set_instr(epio, 0, 0, 0xE081);     // set pindirs, 1
+    epio_set_instr(epio, 0, 1, 0xE000);     // set pins, 0
+    epio_set_instr(epio, 0, 2, 0xE001);     // set pins, 1
+    epio_set_instr(epio, 0, 3, 0x2081);     // wait 1 gpio 1
+    epio_set_instr(epio, 0, 4, 0xE000);     // set pins, 0
+    epio_set_instr(epio, 0, 5, 0x0005);     // jmp 5
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_drive_gpios_ext(epio, 0x2, 0x0);
+    epio_enable_sm(epio, 0, 0);
+    epio_template_t *tmpl = epio_template_from_epio(epio);
+    assert_non_null(tmpl);
+
+    // Without the model, the SM waits forever
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_peek_sm_pc(epio, 0, 0), 3);
+    epio_free(epio);
+
+    // With it, GPIO 1 follows GPIO 0 a cycle later, which the SM sees on the
+    // cycle after that
+    epio = epio_from_template(tmpl);
+    assert_non_null(epio);
+    assert_int_equal(epio_device_attach(epio, 0x1, &echo_ops, NULL), 0);
+    epio_step_cycles(epio, 3);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3, 0x3);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_peek_sm_pc(epio, 0, 0), 4);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3, 0x0);
+    assert_int_equal(epio_peek_sm_pc(epio, 0, 0), 5);
+
+    // Driving from a model leaves other GPIOs alone, and releasing pulls up
+    epio_drive_gpios_ext(epio, 0x30, 0x10);
+    epio_device_drive(epio, 0x4, 0x0);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3C, 0x18);
+    epio_device_release(epio, 0x4);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3C, 0x1C);
+    assert_int_equal(epio_read_driven_pins(epio) & 0x3C, 0x30);
+
+    epio_free(epio);
+    epio_template_free(tmpl);
+}
+
+static void device_history(void **state) {
+    (void)state;
+    static const epio_device_ops_t echo_ops = { .pins_changed = echo_pins_changed };
+    epio_t *epio = square_wave();
+    assert_int_equal(epio_history_enable(epio, 16), 0);
+    int id = epio_device_attach(epio, 0x1, &echo_ops, NULL);
+    assert_int_equal(id, 0);
+    epio_step_cycles(epio, 10);
+
+    // Driven GPIOs aren't recorded, so those cycles can't be replayed
+    assert_int_equal(epio_seek(epio, 5), -1);
+    epio_device_detach(epio, id);
+    assert_int_equal(epio_seek(epio, 5), -1);
+    assert_int_equal(epio_get_cycle_count(epio), 10);
+
+    // But later cycles can, and return to the recorded state
+    uint64_t hashes[21];
+    hashes[0] = epio_state_hash(epio);
+    for (uint32_t ii = 1; ii <= 20; ii++) {
+        epio_step_cycles(epio, 1);
+        hashes[ii] = epio_state_hash(epio);
+    }
+    for (uint32_t ii = 0; ii <= 20; ii += 4) {
+        assert_int_equal(epio_seek(epio, 10 + ii), 0);
+        assert_int_equal(epio_state_hash(epio), hashes[ii]);
+    }
+
+    epio_free(epio);
+}
+
+static void device_detach(void **state) {
+    (void)state;
+    epio_t *epio = square_wave();
+    device_log_t logs[EPIO_MAX_DEVICES];
+
+    // Fill every slot
+    for (int ii = 0; ii < EPIO_MAX_DEVICES; ii++) {
+        logs[ii] = (device_log_t){ .detach_id = -1 };
+        assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &logs[ii]), ii);
+    }
+    device_log_t extra = { .detach_id = -1 };
+    assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &extra), -1);
+
+    // Detaching frees a slot, which is reused
+    epio_device_detach(epio, 3);
+    assert_int_equal(logs[3].freed, 1);
+    assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &extra), 3);
+
+    // A model can detach another, or itself, from a callback.  GPIO 0 first
+    // changes on cycle 4, when device 5 is detached by device 4 before it is
+    // called.
+    logs[4].detach_id = 5;
+    logs[6].detach_id = 6;
+    epio_step_cycles(epio, 5);
+    assert_int_equal(logs[4].changes, 1);
+    assert_int_equal(logs[5].changes, 0);
+    assert_int_equal(logs[5].steps, 4);
+    assert_int_equal(logs[5].freed, 1);
+    assert_int_equal(logs[6].changes, 1);
+    assert_int_equal(logs[6].freed, 1);
+    assert_int_equal(logs[7].changes, 1);
+
+    for (int ii = 0; ii < EPIO_MAX_DEVICES; ii++) {
+        if ((ii != 3) && (ii != 5) && (ii != 6)) {
+            epio_device_detach(epio, ii);
+        }
+    }
+    epio_device_detach(epio, 3);
+    assert_int_equal(extra.freed, 1);
+
+    // With none attached, stepping costs nothing, and models can be
+    // attached again
+    epio_step_cycles(epio, 4);
+    assert_int_equal(logs[0].steps, 5);
+    assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &logs[0]), 0);
+    epio_step_cycles(epio, 4);
+    assert_int_equal(logs[0].steps, 9);
+    assert_int_equal(logs[0].changes, 2);
+
+    // A model detaching the last model from a callback
+    logs[0].detach_id = 0;
+    epio_step_cycles(epio, 4);
+    assert_int_equal(logs[0].changes, 3);
+    assert_int_equal(logs[0].freed, 2);
+    assert_int_equal(logs[0].steps, 13);
+
+    // Models are kept by reset
+    device_log_t kept = { .detach_id = -1 };
+    epio_device_ops_t no_free = { .step = log_step };
+    assert_int_equal(epio_device_attach(epio, 0x1, &no_free, &kept), 0);
+    epio_reset(epio);
+    epio_step_cycles(epio, 2);
+    assert_int_equal(kept.steps, 2);
+    epio_free(epio);
+}
+
+static void device_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    device_log_t log = { .detach_id = -1 };
+
+    expect_assert_failure(epio_device_attach(NULL, 0x1, &log_ops, &log));
+    expect_assert_failure(epio_device_attach(epio, 1ULL << NUM_GPIOS, &log_ops, &log));
+    expect_assert_failure(epio_device_attach(epio, 0x1, NULL, &log));
+    expect_assert_failure(epio_device_detach(NULL, 0));
+    expect_assert_failure(epio_device_detach(epio, -1));
+    expect_assert_failure(epio_device_detach(epio, EPIO_MAX_DEVICES));
+    expect_assert_failure(epio_device_detach(epio, 0));
+    assert_int_equal(epio_device_attach(epio, 0x1, &log_ops, &log), 0);
+    expect_assert_failure(epio_device_detach(epio, 1));
+    expect_assert_failure(epio_device_drive(NULL, 0x1, 0x1));
+    expect_assert_failure(epio_device_drive(epio, 1ULL << NUM_GPIOS, 0));
+    expect_assert_failure(epio_device_drive(epio, 0x1, 1ULL << NUM_GPIOS));
+    expect_assert_failure(epio_device_release(NULL, 0x1));
+    expect_assert_failure(epio_device_release(epio, 1ULL << NUM_GPIOS));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(device_pins_changed),
+        cmocka_unit_test(device_drives_sm),
+        cmocka_unit_test(device_history),
+        cmocka_unit_test(device_detach),
+        cmocka_unit_test(device_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -4,7 +4,7 @@
 
 // epio - A PIO emulator
 //
-// Unit tests for FIFO functions from epio.c
+// Unit tests for FIFO functions from epio.c, and SM snapshots
 
 #define APIO_LOG_IMPL
 #include "test.h"
@@ -330,6 +330,38 @@ static void rx_fifo_wrap_around(void **state) {
     epio_free(epio);
 }
 
+static void fifo_wrap_partially_full(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Keep both FIFOs part full, so entries straddle the end of the ring
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    for (int round = 0; round < 3 * MAX_FIFO_DEPTH; round++) {
+        while (epio_tx_fifo_depth(epio, 0, 1) < MAX_FIFO_DEPTH - 1) {
+            epio_push_tx_fifo(epio, 0, 1, next_in);
+            epio_push_rx_fifo(epio, 0, 1, ~next_in);
+            next_in++;
+        }
+
+        epio_sm_snapshot_t snapshots[NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK];
+        epio_peek_sms(epio, snapshots);
+        for (uint8_t entry = 0; entry < MAX_FIFO_DEPTH - 1; entry++) {
+            assert_int_equal(epio_peek_tx_fifo(epio, 0, 1, entry), next_out + entry);
+            assert_int_equal(epio_peek_rx_fifo(epio, 0, 1, entry), ~(next_out + entry));
+            assert_int_equal(snapshots[1].tx_fifo[entry], next_out + entry);
+            assert_int_equal(snapshots[1].rx_fifo[entry], ~(next_out + entry));
+        }
+
+        assert_int_equal(epio_pop_tx_fifo(epio, 0, 1), next_out);
+        assert_int_equal(epio_pop_rx_fifo(epio, 0, 1), ~next_out);
+        next_out++;
+    }
+
+    epio_free(epio);
+}
+
 // --- Interleaved push/pop ---
 
 static void tx_fifo_interleaved(void **state) {
@@ -385,6 +417,211 @@ static void fifo_edge_values(void **state) {
     epio_free(epio);
 }
 
+static void peek_sms_snapshot(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    epio_push_tx_fifo(epio, 1, 2, 0x11);
+    epio_push_tx_fifo(epio, 1, 2, 0x22);
+    epio_push_rx_fifo(epio, 2, 3, 0x33);
+    epio_exec_instr_sm(epio, 0, 1, 0xE025);  // set x, 5
+    epio_exec_instr_sm(epio, 0, 1, 0x4025);  // in x, 5
+    epio_enable_sm(epio, 0, 0);
+
+    // Matches the individual peeks for every SM
+    epio_sm_snapshot_t snapshots[NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK];
+    epio_peek_sms(epio, snapshots);
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            const epio_sm_snapshot_t *snapshot = &snapshots[block * NUM_SMS_PER_BLOCK + sm];
+            assert_int_equal(snapshot->x, epio_peek_sm_x(epio, block, sm));
+            assert_int_equal(snapshot->y, epio_peek_sm_y(epio, block, sm));
+            assert_int_equal(snapshot->isr, epio_peek_sm_isr(epio, block, sm));
+            assert_int_equal(snapshot->osr, epio_peek_sm_osr(epio, block, sm));
+            assert_int_equal(snapshot->pc, epio_peek_sm_pc(epio, block, sm));
+            assert_int_equal(snapshot->isr_count, epio_peek_sm_isr_count(epio, block, sm));
+            assert_int_equal(snapshot->osr_count, epio_peek_sm_osr_count(epio, block, sm));
+            assert_int_equal(snapshot->enabled, epio_is_sm_enabled(epio, block, sm));
+            assert_int_equal(snapshot->stalled, epio_peek_sm_stalled(epio, block, sm));
+            assert_int_equal(snapshot->delay, epio_peek_sm_delay(epio, block, sm));
+            assert_int_equal(snapshot->exec_pending, epio_peek_sm_exec_pending(epio, block, sm));
+            assert_int_equal(snapshot->exec_instr, epio_peek_sm_exec_instr(epio, block, sm));
+            assert_int_equal(snapshot->tx_fifo_count, epio_tx_fifo_depth(epio, block, sm));
+            assert_int_equal(snapshot->rx_fifo_count, epio_rx_fifo_depth(epio, block, sm));
+            for (uint8_t entry = 0; entry < snapshot->tx_fifo_count; entry++) {
+                assert_int_equal(snapshot->tx_fifo[entry], epio_peek_tx_fifo(epio, block, sm, entry));
+            }
+            for (uint8_t entry = 0; entry < snapshot->rx_fifo_count; entry++) {
+                assert_int_equal(snapshot->rx_fifo[entry], epio_peek_rx_fifo(epio, block, sm, entry));
+            }
+        }
+    }
+    assert_int_equal(snapshots[1].isr, 5);
+    assert_int_equal(snapshots[1 * NUM_SMS_PER_BLOCK + 2].tx_fifo_count, 2);
+    assert_int_equal(snapshots[1 * NUM_SMS_PER_BLOCK + 2].tx_fifo[1], 0x22);
+    assert_int_equal(snapshots[2 * NUM_SMS_PER_BLOCK + 3].rx_fifo[0], 0x33);
+
+    expect_assert_failure(epio_peek_sms(NULL, snapshots));
+    expect_assert_failure(epio_peek_sms(epio, NULL));
+
+    epio_free(epio);
+}
+
+// --- Joined FIFOs and RX PUT/GET ---
+
+static void set_shiftctrl(epio_t *epio, uint8_t sm, uint32_t shiftctrl) {
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .shiftctrl = shiftctrl,
+    };
+    epio_set_sm_reg(epio, 0, sm, &reg);
+}
+
+static void fifo_join_capacities(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    assert_int_equal(epio_tx_fifo_capacity(epio, 0, 0), MAX_FIFO_DEPTH);
+    assert_int_equal(epio_rx_fifo_capacity(epio, 0, 0), MAX_FIFO_DEPTH);
+
+    // FJOIN_TX doubles the TX FIFO, and disables the RX FIFO
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_TX);
+    assert_int_equal(epio_tx_fifo_capacity(epio, 0, 0), MAX_JOINED_FIFO_DEPTH);
+    assert_int_equal(epio_rx_fifo_capacity(epio, 0, 0), 0);
+    for (uint32_t ii = 0; ii < MAX_JOINED_FIFO_DEPTH; ii++) {
+        epio_push_tx_fifo(epio, 0, 0, ii);
+    }
+    expect_assert_failure(epio_push_tx_fifo(epio, 0, 0, 99));
+    expect_assert_failure(epio_push_rx_fifo(epio, 0, 0, 99));
+    assert_int_equal(epio_peek_tx_fifo(epio, 0, 0, 7), 7);
+
+    // Rewriting the same FJOIN bits keeps the contents
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_TX | (1 << 17));
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 0), MAX_JOINED_FIFO_DEPTH);
+
+    // Changing them flushes both FIFOs
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_RX);
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 0), 0);
+    assert_int_equal(epio_tx_fifo_capacity(epio, 0, 0), 0);
+    assert_int_equal(epio_rx_fifo_capacity(epio, 0, 0), MAX_JOINED_FIFO_DEPTH);
+    expect_assert_failure(epio_push_tx_fifo(epio, 0, 0, 99));
+
+    // PUT/GET mode disables the RX FIFO only
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_RX_PUT);
+    assert_int_equal(epio_tx_fifo_capacity(epio, 0, 0), MAX_FIFO_DEPTH);
+    assert_int_equal(epio_rx_fifo_capacity(epio, 0, 0), 0);
+
+    set_shiftctrl(epio, 0, 0);
+    assert_int_equal(epio_tx_fifo_capacity(epio, 0, 0), MAX_FIFO_DEPTH);
+    assert_int_equal(epio_rx_fifo_capacity(epio, 0, 0), MAX_FIFO_DEPTH);
+
+    expect_assert_failure(set_shiftctrl(epio, 1, SHIFTCTRL_FJOIN_TX | SHIFTCTRL_FJOIN_RX));
+    expect_assert_failure(set_shiftctrl(epio, 2, SHIFTCTRL_FJOIN_RX | SHIFTCTRL_FJOIN_RX_GET));
+    expect_assert_failure(epio_tx_fifo_capacity(epio, NUM_PIO_BLOCKS, 0));
+    expect_assert_failure(epio_rx_fifo_capacity(epio, 0, NUM_SMS_PER_BLOCK));
+
+    epio_free(epio);
+}
+
+static void fifo_join_exec(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // push block, with STATUS as RX level < 6
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (0 << 12) | (1 << 5) | 6,
+        .shiftctrl = SHIFTCTRL_FJOIN_RX,
+    };
+    epio_set_instr(epio, 0, 0, 0x8020);
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_enable_sm(epio, 0, 0);
+
+    // The SM pushes 8 words before stalling
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), MAX_JOINED_FIFO_DEPTH);
+    assert_int_equal(epio_peek_sm_stalled(epio, 0, 0), 1);
+
+    // mov x, status
+    epio_exec_instr_sm(epio, 0, 0, 0xA025);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), 0);
+    for (int ii = 0; ii < 3; ii++) {
+        epio_pop_rx_fifo(epio, 0, 0);
+    }
+    epio_exec_instr_sm(epio, 0, 0, 0xA025);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), 0xFFFFFFFF);
+
+    // With FJOIN_TX, the TX FIFO is always empty to a pull
+    reg.shiftctrl = SHIFTCTRL_FJOIN_TX;
+    epio_set_instr(epio, 0, 0, 0x80A0);
+    epio_set_sm_reg(epio, 0, 1, &reg);
+    epio_enable_sm(epio, 0, 1);
+    for (uint32_t ii = 0; ii < MAX_JOINED_FIFO_DEPTH; ii++) {
+        epio_push_tx_fifo(epio, 0, 1, 0x100 + ii);
+    }
+    epio_step_cycles(epio, MAX_JOINED_FIFO_DEPTH);
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 1), 0);
+    assert_int_equal(epio_peek_sm_osr(epio, 0, 1), 0x107);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_peek_sm_stalled(epio, 0, 1), 1);
+
+    epio_free(epio);
+}
+
+static void rx_putget(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    expect_assert_failure(epio_get_rx_putget(epio, 0, 0, 0));
+    expect_assert_failure(epio_set_rx_putget(epio, 0, 0, 0, 1));
+
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (3 << 12),
+        .shiftctrl = SHIFTCTRL_FJOIN_RX_PUT | SHIFTCTRL_FJOIN_RX_GET,
+    };
+    epio_set_instr(epio, 0, 0, 0xE043);     // set y, 3
+    epio_set_instr(epio, 0, 1, 0x8090);     // mov osr, rxfifo[y]
+    epio_set_instr(epio, 0, 2, 0xA0C7);     // mov isr, osr
+    epio_set_instr(epio, 0, 3, 0x8019);     // mov rxfifo[1], isr
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_rx_putget(epio, 0, 0, 3, 0x12345678);
+    epio_enable_sm(epio, 0, 0);
+
+    epio_step_cycles(epio, 4);
+    assert_int_equal(epio_peek_sm_osr(epio, 0, 0), 0x12345678);
+    assert_int_equal(epio_peek_sm_osr_count(epio, 0, 0), 0);
+    assert_int_equal(epio_peek_sm_isr(epio, 0, 0), 0x12345678);
+    assert_int_equal(epio_get_rx_putget(epio, 0, 0, 1), 0x12345678);
+    assert_int_equal(epio_get_rx_putget(epio, 0, 0, 3), 0x12345678);
+    assert_int_equal(epio_get_rx_putget(epio, 0, 0, 0), 0);
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), 0);
+
+    // mov osr, rxfifo[2]
+    epio_set_rx_putget(epio, 0, 0, 2, 0xCAFE);
+    epio_exec_instr_sm(epio, 0, 0, 0x809A);
+    assert_int_equal(epio_peek_sm_osr(epio, 0, 0), 0xCAFE);
+
+    expect_assert_failure(epio_get_rx_putget(epio, 0, 0, NUM_RX_PUTGET));
+    expect_assert_failure(epio_set_rx_putget(epio, 0, 0, NUM_RX_PUTGET, 1));
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8011));
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8014));
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8008));
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8088));
+
+    // Each direction requires its own mode
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_RX_PUT);
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8098));
+    set_shiftctrl(epio, 0, SHIFTCTRL_FJOIN_RX_GET);
+    expect_assert_failure(epio_exec_instr_sm(epio, 0, 0, 0x8018));
+
+    epio_free(epio);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         // TX FIFO
@@ -411,11 +648,16 @@ int main(void) {
         // Wrap-around
         cmocka_unit_test(tx_fifo_wrap_around),
         cmocka_unit_test(rx_fifo_wrap_around),
+        cmocka_unit_test(fifo_wrap_partially_full),
         // Interleaved
         cmocka_unit_test(tx_fifo_interleaved),
         // Other
         cmocka_unit_test(tx_rx_independent_same_sm),
         cmocka_unit_test(fifo_edge_values),
+        cmocka_unit_test(peek_sms_snapshot),
+        cmocka_unit_test(fifo_join_capacities),
+        cmocka_unit_test(fifo_join_exec),
+        cmocka_unit_test(rx_putget),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for FIFO statistics from epio_fifo_stats.c
+
+#define APIO_LOG_IMPL
+#include "test.h"
+
+#define NUM_SMS     (NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK)
+
+// Runs block 0 SM sm on a single instruction
+static void single(epio_t *epio, uint8_t sm, uint16_t instr) {
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (sm << 12) | (sm << 7),
+    };
+    epio_set_instr(epio, 0, sm, instr);
+    epio_set_sm_reg(epio, 0, sm, &reg);
+    PC(0, sm) = sm;
+    epio_enable_sm(epio, 0, sm);
+}
+
+// SM0 pushes without blocking, SM2 pulls and SM3 pushes, both blocking, and
+// SM1 is left to the host
+static epio_t *setup(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    single(epio, 0, 0x8000);    // push noblock
+    single(epio, 2, 0x80A0);    // pull block
+    single(epio, 3, 0x8020);    // push block
+    return epio;
+}
+
+static uint64_t sum(const uint64_t *cycles) {
+    uint64_t total = 0;
+    for (int ii = 0; ii <= MAX_JOINED_FIFO_DEPTH; ii++) {
+        total += cycles[ii];
+    }
+    return total;
+}
+
+static void fifo_stats_counts(void **state) {
+    (void)state;
+    epio_t *epio = setup();
+
+    // Nothing is collected until enabled
+    epio_fifo_stats_t stats[NUM_SMS];
+    memset(stats, 0xFF, sizeof(stats));
+    epio_fifo_stats(epio, stats);
+    for (int ii = 0; ii < NUM_SMS; ii++) {
+        assert_int_equal(sum(stats[ii].tx_level_cycles), 0);
+        assert_int_equal(stats[ii].rx_lost, 0);
+    }
+
+    assert_int_equal(epio_fifo_stats_enable(epio), 0);
+    for (uint32_t ii = 0; ii < 3; ii++) {
+        epio_push_tx_fifo(epio, 0, 1, ii);
+    }
+    epio_step_cycles(epio, 10);
+    epio_pop_tx_fifo(epio, 0, 1);
+    epio_step_cycles(epio, 5);
+
+    epio_fifo_stats(epio, stats);
+    for (int ii = 0; ii < NUM_SMS; ii++) {
+        assert_int_equal(sum(stats[ii].tx_level_cycles), 15);
+        assert_int_equal(sum(stats[ii].rx_level_cycles), 15);
+    }
+
+    // Host pushes and pops
+    assert_int_equal(stats[1].tx_level_cycles[3], 10);
+    assert_int_equal(stats[1].tx_level_cycles[2], 5);
+
+    // SM0 fills its RX FIFO on cycles 0 to 3, then loses every word
+    assert_int_equal(stats[0].rx_level_cycles[0], 0);
+    assert_int_equal(stats[0].rx_level_cycles[1], 1);
+    assert_int_equal(stats[0].rx_level_cycles[3], 1);
+    assert_int_equal(stats[0].rx_level_cycles[4], 12);
+    assert_int_equal(stats[0].rx_lost, 11);
+    assert_int_equal(stats[0].rx_stall_cycles, 0);
+
+    // SM2 underruns throughout, and SM3 overruns once full
+    assert_int_equal(stats[2].tx_level_cycles[0], 15);
+    assert_int_equal(stats[2].tx_stall_cycles, 15);
+    assert_int_equal(stats[3].rx_level_cycles[4], 12);
+    assert_int_equal(stats[3].rx_stall_cycles, 11);
+    assert_int_equal(stats[3].rx_lost, 0);
+    assert_int_equal(stats[4].tx_level_cycles[0], 15);
+
+    // Re-enabling restarts from zero
+    assert_int_equal(epio_fifo_stats_enable(epio), 0);
+    epio_step_cycles(epio, 2);
+    epio_fifo_stats(epio, stats);
+    assert_int_equal(stats[1].tx_level_cycles[2], 2);
+    assert_int_equal(sum(stats[1].tx_level_cycles), 2);
+    assert_int_equal(stats[2].tx_stall_cycles, 2);
+
+    // Disabled by resetting the cycle count
+    epio_reset_cycle_count(epio);
+    epio_fifo_stats(epio, stats);
+    assert_int_equal(stats[2].tx_stall_cycles, 0);
+
+    expect_assert_failure(epio_fifo_stats_enable(NULL));
+    expect_assert_failure(epio_fifo_stats_disable(NULL));
+    expect_assert_failure(epio_fifo_stats(NULL, stats));
+    expect_assert_failure(epio_fifo_stats(epio, NULL));
+
+    epio_free(epio);
+}
+
+static void fifo_stats_join_flush(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    assert_int_equal(epio_fifo_stats_enable(epio), 0);
+
+    for (uint32_t ii = 0; ii < 3; ii++) {
+        epio_push_tx_fifo(epio, 0, 1, ii);
+    }
+    epio_step_cycles(epio, 4);
+
+    // Joining flushes the FIFO, after accounting for its level
+    epio_sm_reg_t reg = {
+        .shiftctrl = (1U << 30),
+    };
+    epio_set_sm_reg(epio, 0, 1, &reg);
+    for (uint32_t ii = 0; ii < MAX_JOINED_FIFO_DEPTH; ii++) {
+        epio_push_tx_fifo(epio, 0, 1, ii);
+    }
+    epio_step_cycles(epio, 6);
+
+    epio_fifo_stats_t stats[NUM_SMS];
+    epio_fifo_stats(epio, stats);
+    assert_int_equal(stats[1].tx_level_cycles[3], 4);
+    assert_int_equal(stats[1].tx_level_cycles[MAX_JOINED_FIFO_DEPTH], 6);
+    assert_int_equal(sum(stats[1].tx_level_cycles), 10);
+
+    epio_fifo_stats_disable(epio);
+    epio_fifo_stats(epio, stats);
+    assert_int_equal(sum(stats[1].tx_level_cycles), 0);
+
+    epio_free(epio);
+}
+
+static void fifo_stats_replay(void **state) {
+    (void)state;
+
+    // Straight run
+    epio_t *epio = setup();
+    assert_int_equal(epio_fifo_stats_enable(epio), 0);
+    epio_step_cycles(epio, 40);
+    epio_fifo_stats_t expected[NUM_SMS];
+    epio_fifo_stats(epio, expected);
+    epio_free(epio);
+
+    // Stepping back and replaying counts each cycle once
+    epio = setup();
+    assert_int_equal(epio_history_enable(epio, 16), 0);
+    assert_int_equal(epio_fifo_stats_enable(epio), 0);
+    epio_step_cycles(epio, 30);
+    assert_int_equal(epio_seek(epio, 2), 0);
+
+    epio_fifo_stats_t stats[NUM_SMS];
+    epio_fifo_stats(epio, stats);
+    assert_int_equal(stats[2].tx_stall_cycles, 30);
+    assert_int_equal(sum(stats[0].rx_level_cycles), 30);
+
+    epio_step_cycles(epio, 38);
+    epio_fifo_stats(epio, stats);
+    assert_memory_equal(stats, expected, sizeof(stats));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(fifo_stats_counts),
+        cmocka_unit_test(fifo_stats_join_flush),
+        cmocka_unit_test(fifo_stats_replay),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,204 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for state hashing from epio_hash.c
+
+#define APIO_LOG_IMPL
+#include <unistd.h>
+#include "test.h"
+
+#define IMAGE_PATH  "/tmp/epio_test_hash.bin"
+
+static void hash_fresh_instances_equal(void **state) {
+    (void)state;
+    epio_t *a = epio_init();
+    epio_t *b = epio_init();
+    assert_non_null(a);
+    assert_non_null(b);
+
+    assert_int_equal(epio_state_hash(a), epio_state_hash(b));
+    assert_int_equal(epio_state_hash(a), epio_state_hash(a));
+
+    epio_free(a);
+    epio_free(b);
+}
+
+static void hash_tracks_machine_state(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    uint64_t initial = epio_state_hash(epio);
+
+    epio_set_instr(epio, 2, 31, 0xA042);
+    uint64_t with_instr = epio_state_hash(epio);
+    assert_int_not_equal(with_instr, initial);
+
+    epio_push_tx_fifo(epio, 1, 3, 0xDEADBEEF);
+    uint64_t with_fifo = epio_state_hash(epio);
+    assert_int_not_equal(with_fifo, with_instr);
+
+    epio_set_block_irq(epio, 0, 7);
+    uint64_t with_irq = epio_state_hash(epio);
+    assert_int_not_equal(with_irq, with_fifo);
+
+    epio_drive_gpios_ext(epio, 0x1, 0x1);
+    uint64_t with_gpio = epio_state_hash(epio);
+    assert_int_not_equal(with_gpio, with_irq);
+
+    // Undoing each change returns to each earlier hash
+    epio_drive_gpios_ext(epio, 0, 0);
+    assert_int_equal(epio_state_hash(epio), with_irq);
+    epio_clear_block_irq(epio, 0, 7);
+    assert_int_equal(epio_state_hash(epio), with_fifo);
+    epio_pop_tx_fifo(epio, 1, 3);
+    assert_int_equal(epio_state_hash(epio), with_instr);
+    epio_set_instr(epio, 2, 31, 0);
+    assert_int_equal(epio_state_hash(epio), initial);
+
+    epio_free(epio);
+}
+
+static void hash_ignores_fifo_head(void **state) {
+    (void)state;
+    epio_t *a = epio_init();
+    epio_t *b = epio_init();
+    assert_non_null(a);
+    assert_non_null(b);
+
+    // The same FIFO contents, at different positions in the ring
+    epio_push_tx_fifo(a, 1, 2, 1);
+    epio_push_tx_fifo(a, 1, 2, 7);
+    epio_pop_tx_fifo(a, 1, 2);
+    epio_push_tx_fifo(b, 1, 2, 7);
+    epio_push_rx_fifo(a, 0, 3, 1);
+    epio_push_rx_fifo(a, 0, 3, 2);
+    epio_push_rx_fifo(a, 0, 3, 3);
+    epio_pop_rx_fifo(a, 0, 3);
+    epio_push_rx_fifo(b, 0, 3, 2);
+    epio_push_rx_fifo(b, 0, 3, 3);
+    assert_int_equal(epio_state_hash(a), epio_state_hash(b));
+
+    // But different contents still differ
+    epio_push_tx_fifo(b, 1, 2, 8);
+    assert_int_not_equal(epio_state_hash(a), epio_state_hash(b));
+
+    epio_free(a);
+    epio_free(b);
+}
+
+static void hash_excludes_cycle_count(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    uint64_t initial = epio_state_hash(epio);
+
+    // Nothing is enabled, so only the cycle count changes
+    epio_step_cycles(epio, 100);
+    assert_int_equal(epio_get_cycle_count(epio), 100);
+    assert_int_equal(epio_state_hash(epio), initial);
+
+    epio_free(epio);
+}
+
+static void hash_tracks_sram(void **state) {
+    (void)state;
+    epio_t *a = epio_init();
+    epio_t *b = epio_init();
+    assert_non_null(a);
+    assert_non_null(b);
+    uint64_t initial = epio_state_hash(a);
+
+    // Writing zeros is the same as never writing
+    epio_sram_write_word(a, 0x20001000, 0);
+    assert_int_equal(epio_sram_resident_pages(a), 1);
+    assert_int_equal(epio_state_hash(a), initial);
+
+    // Non-zero contents change the hash, and rewriting zero restores it
+    epio_sram_write_word(a, 0x20001000, 0x12345678);
+    uint64_t written = epio_state_hash(a);
+    assert_int_not_equal(written, initial);
+    epio_sram_write_word(a, 0x20001000, 0);
+    assert_int_equal(epio_state_hash(a), initial);
+
+    // The same contents at a different page hash differently
+    epio_sram_write_word(a, 0x20001000, 0x12345678);
+    epio_sram_write_word(b, 0x20002000, 0x12345678);
+    assert_int_not_equal(epio_state_hash(a), epio_state_hash(b));
+
+    // And the same contents reached differently hash the same
+    uint8_t data[SRAM_PAGE_SIZE * 2] = {0};
+    data[0x10] = 0x78;
+    data[0x11] = 0x56;
+    epio_sram_write_word(b, 0x20002000, 0);
+    epio_sram_set(b, 0x20000FF0, data, sizeof(data));
+    assert_int_equal(epio_sram_read_word(b, 0x20001000), 0x5678);
+    epio_sram_write_word(a, 0x20001000, 0x5678);
+    assert_int_equal(epio_state_hash(a), epio_state_hash(b));
+
+    // Reset returns to the initial hash
+    epio_reset(a);
+    assert_int_equal(epio_state_hash(a), initial);
+
+    epio_free(a);
+    epio_free(b);
+}
+
+static void hash_preserved_by_template_and_image(void **state) {
+    (void)state;
+    epio_t *src = epio_init();
+    assert_non_null(src);
+    epio_set_instr(src, 0, 0, 0xE001);
+    epio_sram_write_word(src, 0x20000000, 0xAABBCCDD);
+    epio_sram_write_word(src, 0x20010000, 0x11223344);
+    uint64_t hash = epio_state_hash(src);
+
+    // Template made with the cache clean, then used with it dirty
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    epio_sram_write_word(src, 0x20010000, 0x11223344);
+    epio_template_t *tmpl2 = epio_template_from_epio(src);
+    epio_t *clone = epio_from_template(tmpl);
+    epio_t *clone2 = epio_from_template(tmpl2);
+    assert_int_equal(epio_state_hash(clone), hash);
+    assert_int_equal(epio_state_hash(clone2), hash);
+
+    // A clone which writes a shared page, then restores it
+    epio_sram_write_word(clone, 0x20000000, 0);
+    assert_int_not_equal(epio_state_hash(clone), hash);
+    epio_sram_write_word(clone, 0x20000000, 0xAABBCCDD);
+    assert_int_equal(epio_state_hash(clone), hash);
+
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+    epio_t *loaded = epio_load_image(IMAGE_PATH);
+    assert_non_null(loaded);
+    assert_int_equal(epio_state_hash(loaded), hash);
+    epio_free(loaded);
+    unlink(IMAGE_PATH);
+
+    epio_free(clone);
+    epio_free(clone2);
+    epio_template_free(tmpl);
+    epio_template_free(tmpl2);
+    epio_free(src);
+}
+
+static void hash_null(void **state) {
+    (void)state;
+    expect_assert_failure(epio_state_hash(NULL));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(hash_fresh_instances_equal),
+        cmocka_unit_test(hash_tracks_machine_state),
+        cmocka_unit_test(hash_ignores_fifo_head),
+        cmocka_unit_test(hash_excludes_cycle_count),
+        cmocka_unit_test(hash_tracks_sram),
+        cmocka_unit_test(hash_preserved_by_template_and_image),
+        cmocka_unit_test(hash_null),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,302 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for reverse execution from epio_history.c
+
+#define APIO_LOG_IMPL
+#include <stdlib.h>
+#include "test.h"
+
+#define RUN_CYCLES  1000
+
+// Block 0 SM 0 decrements X every cycle, so X is -cycle, and block 1 SM 0
+// pulls from its TX FIFO into X whenever there is data.
+static epio_t *counting_epio(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = 0,          // wrap top 0, wrap bottom 0
+        .shiftctrl = 0,
+        .pinctrl = 0,
+    };
+    epio_set_instr(epio, 0, 0, 0x0040); // jmp x--, 0
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_enable_sm(epio, 0, 0);
+
+    epio_set_instr(epio, 1, 0, 0x80A0); // pull block
+    epio_set_instr(epio, 1, 1, 0xA027); // mov x, osr
+    reg.execctrl = (1 << 12);           // wrap top 1, wrap bottom 0
+    epio_set_sm_reg(epio, 1, 0, &reg);
+    epio_enable_sm(epio, 1, 0);
+
+    return epio;
+}
+
+// Applies some external inputs, depending on the cycle
+static void apply_inputs(epio_t *epio, uint64_t cycle, uint32_t seed) {
+    switch (cycle) {
+        case 100:
+            epio_push_tx_fifo(epio, 1, 0, seed);
+            break;
+        case 250:
+            epio_sram_write_word(epio, 0x20003000, seed);
+            epio_drive_gpios_ext(epio, 0xF, seed & 0xF);
+            break;
+        case 333:
+            epio_set_block_irq(epio, 2, seed % 8);
+            epio_sram_write_word(epio, 0x20000000, seed + 1);
+            break;
+        case 600:
+            epio_sram_write_word(epio, 0x20003004, seed + 2);
+            epio_sram_write_word(epio, 0x20010000, seed + 3);
+            break;
+        default:
+            break;
+    }
+}
+
+// Runs an instance for RUN_CYCLES single cycles with inputs, recording the
+// state hash at each cycle, after that cycle's inputs
+static uint64_t *record_run(epio_t *epio, uint32_t seed) {
+    uint64_t *hashes = calloc(RUN_CYCLES + 1, sizeof(uint64_t));
+    assert_non_null(hashes);
+    for (uint64_t cycle = 0; cycle <= RUN_CYCLES; cycle++) {
+        apply_inputs(epio, cycle, seed);
+        hashes[cycle] = epio_state_hash(epio);
+        if (cycle < RUN_CYCLES) {
+            epio_step_cycles(epio, 1);
+        }
+    }
+    return hashes;
+}
+
+static void seek_without_inputs(void **state) {
+    (void)state;
+    epio_t *epio = counting_epio();
+    assert_int_equal(epio_history_enable(epio, 100), 0);
+
+    epio_step_cycles(epio, RUN_CYCLES);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-RUN_CYCLES);
+
+    assert_int_equal(epio_seek(epio, 537), 0);
+    assert_int_equal(epio_get_cycle_count(epio), 537);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-537);
+
+    assert_int_equal(epio_step_back(epio, 37), 0);
+    assert_int_equal(epio_get_cycle_count(epio), 500);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-500);
+
+    assert_int_equal(epio_seek(epio, 0), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), 0);
+
+    // Forwards again, to and past the end of the history
+    assert_int_equal(epio_seek(epio, RUN_CYCLES), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-RUN_CYCLES);
+    assert_int_equal(epio_seek(epio, RUN_CYCLES + 250), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-(RUN_CYCLES + 250));
+
+    // Stepping from there takes a checkpoint before continuing
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_step_back(epio, 5), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-(RUN_CYCLES + 255));
+
+    epio_free(epio);
+}
+
+static void seek_replays_inputs(void **state) {
+    (void)state;
+    epio_t *epio = counting_epio();
+    assert_int_equal(epio_history_enable(epio, 64), 0);
+    uint64_t *hashes = record_run(epio, 0x1234);
+
+    // Every cycle, in a scattered order
+    for (uint64_t ii = 0; ii <= RUN_CYCLES; ii++) {
+        uint64_t cycle = (ii * 389) % (RUN_CYCLES + 1);
+        assert_int_equal(epio_seek(epio, cycle), 0);
+        assert_int_equal(epio_get_cycle_count(epio), cycle);
+        assert_int_equal(epio_state_hash(epio), hashes[cycle]);
+    }
+
+    // Check some inputs directly
+    assert_int_equal(epio_seek(epio, 101), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 1, 0), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20003000), 0);
+    assert_int_equal(epio_seek(epio, 260), 0);
+    assert_int_equal(epio_peek_sm_x(epio, 1, 0), 0x1234);
+    assert_int_equal(epio_sram_read_word(epio, 0x20003000), 0x1234);
+    assert_int_equal(epio_sram_resident_pages(epio), 1);
+    assert_int_equal(epio_seek(epio, 700), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20010000), 0x1237);
+    assert_int_equal(epio_sram_resident_pages(epio), 3);
+    assert_int_equal(epio_seek(epio, 249), 0);
+    assert_int_equal(epio_sram_resident_pages(epio), 0);
+
+    free(hashes);
+    epio_free(epio);
+}
+
+static void step_after_seek_starts_new_timeline(void **state) {
+    (void)state;
+    epio_t *epio = counting_epio();
+    assert_int_equal(epio_history_enable(epio, 50), 0);
+    uint64_t *old = record_run(epio, 0x1111);
+
+    // Reference run of the new timeline, which diverges at cycle 300
+    epio_t *ref = counting_epio();
+    uint64_t *new = calloc(RUN_CYCLES + 1, sizeof(uint64_t));
+    assert_non_null(new);
+    for (uint64_t cycle = 0; cycle <= RUN_CYCLES; cycle++) {
+        apply_inputs(ref, cycle, (cycle < 300) ? 0x1111 : 0x2222);
+        if (cycle == 300) {
+            epio_sram_write_byte(ref, 0x20003001, 0x99);
+        }
+        new[cycle] = epio_state_hash(ref);
+        if (cycle < RUN_CYCLES) {
+            epio_step_cycles(ref, 1);
+        }
+    }
+
+    // Rewind, change an input, and carry on with the new inputs
+    assert_int_equal(epio_seek(epio, 300), 0);
+    epio_sram_write_byte(epio, 0x20003001, 0x99);
+    for (uint64_t cycle = 300; cycle < RUN_CYCLES; cycle++) {
+        if (cycle != 300) {
+            apply_inputs(epio, cycle, 0x2222);
+        }
+        epio_step_cycles(epio, 1);
+    }
+    assert_int_equal(epio_state_hash(epio), new[RUN_CYCLES]);
+
+    for (uint64_t cycle = 0; cycle <= RUN_CYCLES; cycle += 7) {
+        assert_int_equal(epio_seek(epio, cycle), 0);
+        assert_int_equal(epio_state_hash(epio), (cycle < 300) ? old[cycle] : new[cycle]);
+    }
+
+    free(old);
+    free(new);
+    epio_free(ref);
+    epio_free(epio);
+}
+
+static void inputs_at_end_kept_when_seeking(void **state) {
+    (void)state;
+    epio_t *epio = counting_epio();
+    assert_int_equal(epio_history_enable(epio, 100), 0);
+
+    // A checkpoint is taken at cycle 200, then inputs made at that cycle
+    epio_step_cycles(epio, 200);
+    epio_push_tx_fifo(epio, 1, 0, 0xABCD);
+    epio_sram_write_word(epio, 0x20000000, 0xABCD);
+    uint64_t hash = epio_state_hash(epio);
+
+    assert_int_equal(epio_seek(epio, 150), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0);
+    assert_int_equal(epio_seek(epio, 200), 0);
+    assert_int_equal(epio_state_hash(epio), hash);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xABCD);
+
+    // Further inputs at the same cycle update the same checkpoint
+    epio_sram_write_word(epio, 0x20000000, 0xDCBA);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_seek(epio, 200), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xDCBA);
+    assert_int_equal(epio_peek_tx_fifo(epio, 1, 0, 0), 0xABCD);
+
+    epio_free(epio);
+}
+
+static void history_with_preloaded_sram(void **state) {
+    (void)state;
+    epio_t *src = counting_epio();
+    epio_sram_write_word(src, 0x20002000, 0x5555);
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    epio_free(src);
+
+    // Pages shared with a template are part of the first checkpoint
+    epio_t *epio = epio_from_template(tmpl);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_history_enable(epio, 100), 0);
+    epio_step_cycles(epio, 10);
+    epio_sram_write_word(epio, 0x20002000, 0x6666);
+    epio_step_cycles(epio, 10);
+
+    assert_int_equal(epio_seek(epio, 15), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20002000), 0x5555);
+    assert_int_equal(epio_seek(epio, 25), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20002000), 0x6666);
+
+    // Before history was enabled
+    assert_int_equal(epio_seek(epio, 9), -1);
+    assert_int_equal(epio_step_back(epio, 16), -1);
+    assert_int_equal(epio_get_cycle_count(epio), 25);
+
+    epio_free(epio);
+    epio_template_free(tmpl);
+}
+
+static void history_disabled(void **state) {
+    (void)state;
+    epio_t *epio = counting_epio();
+
+    // Not enabled
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_seek(epio, 5), -1);
+    assert_int_equal(epio_step_back(epio, 11), -1);
+
+    // Re-enabling restarts history
+    assert_int_equal(epio_history_enable(epio, 10), 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_history_enable(epio, 10), 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_seek(epio, 15), -1);
+    assert_int_equal(epio_seek(epio, 25), 0);
+
+    // Disabling
+    epio_history_disable(epio);
+    assert_int_equal(epio_step_back(epio, 1), -1);
+    epio_history_disable(epio);
+
+    // Reset and resetting the cycle count disable history
+    assert_int_equal(epio_history_enable(epio, 10), 0);
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_seek(epio, 0), -1);
+    assert_int_equal(epio_history_enable(epio, 10), 0);
+    epio_reset(epio);
+    assert_int_equal(epio_seek(epio, 0), -1);
+
+    // Freeing with history enabled
+    assert_int_equal(epio_history_enable(epio, 10), 0);
+    epio_step_cycles(epio, 1000);
+    epio_free(epio);
+}
+
+static void history_invalid(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    expect_assert_failure(epio_history_enable(NULL, 10));
+    expect_assert_failure(epio_history_enable(epio, 0));
+    expect_assert_failure(epio_history_disable(NULL));
+    expect_assert_failure(epio_seek(NULL, 0));
+    expect_assert_failure(epio_step_back(NULL, 0));
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(seek_without_inputs),
+        cmocka_unit_test(seek_replays_inputs),
+        cmocka_unit_test(step_after_seek_starts_new_timeline),
+        cmocka_unit_test(inputs_at_end_kept_when_seeking),
+        cmocka_unit_test(history_with_preloaded_sram),
+        cmocka_unit_test(history_disabled),
+        cmocka_unit_test(history_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,256 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for image save and load from epio_image.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define IMAGE_PATH  "/tmp/epio_test_image.bin"
+
+// configured_epio(), with some debug, IRQ and DMA state, run for 3 cycles
+static epio_t *imaged_epio(void) {
+    epio_t *epio = configured_epio();
+    epio_sm_debug_t debug = {
+        .first_instr = 0,
+        .start_instr = 0,
+        .end_instr = 1,
+    };
+    epio_set_sm_debug(epio, 0, 0, &debug);
+    epio_set_block_irq(epio, 2, 3);
+    epio_dma_setup_read_pio_chain(epio, 0, 1, 0, 4, 1, 1, 4, 32);
+    epio_step_cycles(epio, 3);
+    return epio;
+}
+
+static void image_round_trip(void **state) {
+    (void)state;
+    epio_t *src = imaged_epio();
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+
+    epio_t *epio = epio_load_image(IMAGE_PATH);
+    assert_non_null(epio);
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_get_cycle_count(epio), 3);
+    assert_int_equal(epio_sram_resident_pages(epio), 2);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xAABBCCDD);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 5), 0x11223344);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 6), 0);
+
+    // Continues running as the original would
+    epio_step_cycles(src, 5);
+    epio_step_cycles(epio, 5);
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+
+    epio_free(epio);
+    epio_free(src);
+    unlink(IMAGE_PATH);
+}
+
+static void image_no_sram(void **state) {
+    (void)state;
+    epio_t *src = epio_init();
+    assert_non_null(src);
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+
+    epio_t *epio = epio_load_image(IMAGE_PATH);
+    assert_non_null(epio);
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_sram_resident_pages(epio), 0);
+
+    epio_free(epio);
+    epio_free(src);
+    unlink(IMAGE_PATH);
+}
+
+static void image_sram_copy_on_write(void **state) {
+    (void)state;
+    epio_t *src = imaged_epio();
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+    epio_free(src);
+
+    epio_t *a = epio_load_image(IMAGE_PATH);
+    epio_t *b = epio_load_image(IMAGE_PATH);
+    assert_non_null(a);
+    assert_non_null(b);
+
+    epio_sram_write_byte(a, 0x20000000, 0x55);
+    assert_int_equal(epio_sram_read_word(a, 0x20000000), 0xAABBCC55);
+    assert_int_equal(epio_sram_read_word(b, 0x20000000), 0xAABBCCDD);
+    assert_int_equal(epio_sram_resident_pages(a), 2);
+
+    // Resetting drops the shared page, and zeroes the private one
+    epio_reset(a);
+    assert_int_equal(epio_sram_resident_pages(a), 1);
+    assert_int_equal(epio_sram_read_word(a, 0x20000000), 0);
+    epio_free(a);
+    epio_free(b);
+
+    // The file is unchanged
+    epio_t *c = epio_load_image(IMAGE_PATH);
+    assert_non_null(c);
+    assert_int_equal(epio_sram_read_word(c, 0x20000000), 0xAABBCCDD);
+
+    // And can be captured as a template which outlives the instance
+    epio_template_t *tmpl = epio_template_from_epio(c);
+    epio_free(c);
+    unlink(IMAGE_PATH);
+    epio_t *d = epio_from_template(tmpl);
+    assert_int_equal(epio_sram_read_word(d, 0x20000000 + SRAM_PAGE_SIZE * 5), 0x11223344);
+    epio_free(d);
+    epio_template_free(tmpl);
+}
+
+// Saves a valid image, corrupts the 32-bit word at offset, and checks it
+// is rejected
+static void check_corrupt_word_rejected(size_t offset) {
+    epio_t *src = imaged_epio();
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+    epio_free(src);
+
+    size_t size;
+    uint8_t *data = (uint8_t *)read_file(IMAGE_PATH, &size);
+    uint32_t word;
+    memcpy(&word, data + offset, sizeof(word));
+    word ^= 1;
+    memcpy(data + offset, &word, sizeof(word));
+    write_file(IMAGE_PATH, data, size);
+    free(data);
+
+    assert_null(epio_load_image(IMAGE_PATH));
+}
+
+// Corrupts one field of a machine state, returning 0 once there are no more
+static int corrupt_state(epio_t *epio, int which) {
+    switch (which) {
+        case 0: epio->block[0].sm[0].pc = NUM_INSTRS_PER_BLOCK; break;
+        case 1: epio->block[0].sm[1].isr_count = 33; break;
+        case 2: epio->block[0].sm[1].osr_count = 33; break;
+        case 3: epio->block[1].sm[2].fifo.tx_fifo_count = MAX_FIFO_DEPTH + 1; break;
+        case 4: epio->block[1].sm[2].fifo.rx_fifo_count = MAX_FIFO_DEPTH + 1; break;
+        case 5: epio->block[1].sm[2].fifo.tx_fifo_head = MAX_JOINED_FIFO_DEPTH; break;
+        case 6: epio->block[1].sm[2].fifo.rx_fifo_head = MAX_JOINED_FIFO_DEPTH; break;
+        case 7: epio->block[1].sm[2].fifo.tx_fifo_capacity = 255; break;
+        case 8: epio->block[1].sm[2].fifo.rx_fifo_capacity = 255; break;
+        case 9: epio->block[2].sm[3].reg.shiftctrl |= (3U << 30); break;
+        case 10: epio->block[2].sm[3].reg.shiftctrl |= (1U << 30) | (1U << 15); break;
+        case 11: epio->block[2].gpio_base = 8; break;
+        case 12: epio->dma[0].read_block = NUM_PIO_BLOCKS; break;
+        case 13: epio->dma[0].read_sm = NUM_SMS_PER_BLOCK; break;
+        case 14: epio->dma[0].write_block = NUM_PIO_BLOCKS; break;
+        case 15: epio->dma[0].write_sm = NUM_SMS_PER_BLOCK; break;
+        case 16: epio->dma[0].bit_mode = 12; break;
+        default: return 0;
+    }
+    return 1;
+}
+
+static void image_invalid_state_rejected(void **state) {
+    (void)state;
+    size_t state_offset = 8 + 4 * 6 + 4 * ((SRAM_NUM_PAGES + 31) / 32) + 4 * 2;
+    epio_t *src = imaged_epio();
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+    epio_free(src);
+    size_t size;
+    uint8_t *data = (uint8_t *)read_file(IMAGE_PATH, &size);
+
+    // Each field which indexes or bounds an array must be in range
+    epio_t *copy = epio_init();
+    assert_non_null(copy);
+    for (int ii = 0; ; ii++) {
+        memcpy(copy, data + state_offset, EPIO_MACHINE_STATE_SIZE);
+        if (!corrupt_state(copy, ii)) {
+            break;
+        }
+        uint8_t *bad = malloc(size);
+        assert_non_null(bad);
+        memcpy(bad, data, size);
+        memcpy(bad + state_offset, copy, EPIO_MACHINE_STATE_SIZE);
+        write_file(IMAGE_PATH, bad, size);
+        free(bad);
+        assert_null(epio_load_image(IMAGE_PATH));
+    }
+
+    // An unused DMA channel's fields aren't checked
+    memcpy(copy, data + state_offset, EPIO_MACHINE_STATE_SIZE);
+    copy->dma[1].bit_mode = 12;
+    memcpy(data + state_offset, copy, EPIO_MACHINE_STATE_SIZE);
+    write_file(IMAGE_PATH, data, size);
+    epio_t *epio = epio_load_image(IMAGE_PATH);
+    assert_non_null(epio);
+    epio_free(epio);
+
+    epio_free(copy);
+    free(data);
+    unlink(IMAGE_PATH);
+}
+
+static void image_invalid_rejected(void **state) {
+    (void)state;
+
+    // Missing
+    unlink(IMAGE_PATH);
+    assert_null(epio_load_image(IMAGE_PATH));
+
+    // Empty
+    write_file(IMAGE_PATH, NULL, 0);
+    assert_null(epio_load_image(IMAGE_PATH));
+
+    // Every header field - magic, version, endian, state size, page size,
+    // number of pages, resident pages, page map, state and pages offsets
+    size_t header_words = (8 + 4 * 6 + 4 * ((SRAM_NUM_PAGES + 31) / 32) + 4 * 2) / 4;
+    for (size_t ii = 0; ii < header_words; ii++) {
+        check_corrupt_word_rejected(ii * 4);
+    }
+
+    // Truncated
+    epio_t *src = imaged_epio();
+    assert_int_equal(epio_save_image(src, IMAGE_PATH), 0);
+    epio_free(src);
+    size_t size;
+    uint8_t *data = (uint8_t *)read_file(IMAGE_PATH, &size);
+    write_file(IMAGE_PATH, data, size - 1);
+    assert_null(epio_load_image(IMAGE_PATH));
+    free(data);
+
+    unlink(IMAGE_PATH);
+}
+
+static void image_save_fails(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    assert_int_equal(epio_save_image(epio, "/nonexistent/dir/epio.bin"), -1);
+    epio_free(epio);
+}
+
+static void image_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    expect_assert_failure(epio_save_image(NULL, IMAGE_PATH));
+    expect_assert_failure(epio_save_image(epio, NULL));
+    expect_assert_failure(epio_load_image(NULL));
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(image_round_trip),
+        cmocka_unit_test(image_no_sram),
+        cmocka_unit_test(image_sram_copy_on_write),
+        cmocka_unit_test(image_invalid_rejected),
+        cmocka_unit_test(image_invalid_state_rejected),
+        cmocka_unit_test(image_save_fails),
+        cmocka_unit_test(image_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,199 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the captured edge index from epio_index.c
+
+#define APIO_LOG_IMPL
+#include <stdlib.h>
+#include "test.h"
+
+#define RUN_CYCLES  1000
+#define MAX_EDGES   (RUN_CYCLES / 4 + 2)
+
+// GPIO 0 starts high, and GPIOs 1 and 2 low.  GPIO 0 falls at 10 and 30 and
+// rises at 15 and 35, GPIO 1 rises at 10 and falls at 20, and GPIO 2 never
+// changes.
+static const epio_edge_t test_edges[] = {
+    { .cycle = 5, .changed = 0, .value = 0b001 },
+    { .cycle = 10, .changed = 0b011, .value = 0b010 },
+    { .cycle = 15, .changed = 0b001, .value = 0b011 },
+    { .cycle = 20, .changed = 0b010, .value = 0b001 },
+    { .cycle = 30, .changed = 0b001, .value = 0b000 },
+    { .cycle = 35, .changed = 0b001, .value = 0b001 },
+};
+#define NUM_TEST_EDGES  (sizeof(test_edges) / sizeof(test_edges[0]))
+
+static void index_level(void **state) {
+    (void)state;
+    epio_index_t *index = epio_index_build(test_edges, NUM_TEST_EDGES);
+    assert_non_null(index);
+
+    assert_int_equal(epio_index_level(index, 0, 4), -1);
+    assert_int_equal(epio_index_level(index, 0, 5), 1);
+    assert_int_equal(epio_index_level(index, 0, 9), 1);
+    assert_int_equal(epio_index_level(index, 0, 10), 0);
+    assert_int_equal(epio_index_level(index, 0, 14), 0);
+    assert_int_equal(epio_index_level(index, 0, 15), 1);
+    assert_int_equal(epio_index_level(index, 0, 30), 0);
+    assert_int_equal(epio_index_level(index, 0, 1000000), 1);
+    assert_int_equal(epio_index_level(index, 1, 9), 0);
+    assert_int_equal(epio_index_level(index, 1, 19), 1);
+    assert_int_equal(epio_index_level(index, 1, 20), 0);
+    assert_int_equal(epio_index_level(index, 2, 5), 0);
+    assert_int_equal(epio_index_level(index, 47, 100), 0);
+
+    epio_index_free(index);
+}
+
+static void index_edges(void **state) {
+    (void)state;
+    epio_index_t *index = epio_index_build(test_edges, NUM_TEST_EDGES);
+    assert_non_null(index);
+    uint64_t edge;
+
+    // Next edges are after the cycle
+    assert_int_equal(epio_index_next_edge(index, 0, 0, EPIO_EDGE_ANY, &edge), 0);
+    assert_int_equal(edge, 10);
+    assert_int_equal(epio_index_next_edge(index, 0, 10, EPIO_EDGE_ANY, &edge), 0);
+    assert_int_equal(edge, 15);
+    assert_int_equal(epio_index_next_edge(index, 0, 9, EPIO_EDGE_RISING, &edge), 0);
+    assert_int_equal(edge, 15);
+    assert_int_equal(epio_index_next_edge(index, 0, 10, EPIO_EDGE_FALLING, &edge), 0);
+    assert_int_equal(edge, 30);
+    assert_int_equal(epio_index_next_edge(index, 1, 0, EPIO_EDGE_FALLING, &edge), 0);
+    assert_int_equal(edge, 20);
+    assert_int_equal(epio_index_next_edge(index, 0, 35, EPIO_EDGE_ANY, &edge), -1);
+    assert_int_equal(epio_index_next_edge(index, 0, 31, EPIO_EDGE_FALLING, &edge), -1);
+    assert_int_equal(epio_index_next_edge(index, 2, 0, EPIO_EDGE_ANY, &edge), -1);
+
+    // Previous edges are at or before the cycle
+    assert_int_equal(epio_index_prev_edge(index, 0, 10, EPIO_EDGE_ANY, &edge), 0);
+    assert_int_equal(edge, 10);
+    assert_int_equal(epio_index_prev_edge(index, 0, 29, EPIO_EDGE_FALLING, &edge), 0);
+    assert_int_equal(edge, 10);
+    assert_int_equal(epio_index_prev_edge(index, 0, 34, EPIO_EDGE_RISING, &edge), 0);
+    assert_int_equal(edge, 15);
+    assert_int_equal(epio_index_prev_edge(index, 1, 1000, EPIO_EDGE_RISING, &edge), 0);
+    assert_int_equal(edge, 10);
+    assert_int_equal(epio_index_prev_edge(index, 0, 9, EPIO_EDGE_ANY, &edge), -1);
+    assert_int_equal(epio_index_prev_edge(index, 0, 14, EPIO_EDGE_RISING, &edge), -1);
+    assert_int_equal(epio_index_prev_edge(index, 2, 1000, EPIO_EDGE_ANY, &edge), -1);
+
+    epio_index_free(index);
+}
+
+static void index_pulses(void **state) {
+    (void)state;
+    epio_index_t *index = epio_index_build(test_edges, NUM_TEST_EDGES);
+    assert_non_null(index);
+    uint64_t width, period;
+
+    assert_int_equal(epio_index_pulse_width(index, 0, 12, &width), 0);
+    assert_int_equal(width, 5);
+    assert_int_equal(epio_index_pulse_width(index, 0, 15, &width), 0);
+    assert_int_equal(width, 15);
+    assert_int_equal(epio_index_pulse_width(index, 1, 19, &width), 0);
+    assert_int_equal(width, 10);
+    assert_int_equal(epio_index_pulse_width(index, 0, 9, &width), -1);
+    assert_int_equal(epio_index_pulse_width(index, 0, 35, &width), -1);
+
+    assert_int_equal(epio_index_period(index, 0, 20, &period), 0);
+    assert_int_equal(period, 20);
+    assert_int_equal(epio_index_period(index, 0, 12, &period), -1);
+    assert_int_equal(epio_index_period(index, 1, 12, &period), -1);
+
+    epio_index_free(index);
+}
+
+static void index_capture(void **state) {
+    (void)state;
+
+    // Block 0 SM 0 drives GPIO 0 high for 4 cycles, then low for 4 cycles
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12),              // wrap top 1, wrap bottom 0
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE301);     // set pins, 1 [3]
+    epio_set_instr(epio, 0, 1, 0xE300);     // set pins, 0 [3]
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_set_gpio_output(epio, 0);
+    epio_enable_sm(epio, 0, 0);
+
+    epio_edge_t *edges = malloc(MAX_EDGES * sizeof(epio_edge_t));
+    assert_non_null(edges);
+    uint8_t levels[RUN_CYCLES + 1];
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, MAX_EDGES, EPIO_CAPTURE_STOP, NULL, NULL), 0);
+    for (int cycle = 0; cycle <= RUN_CYCLES; cycle++) {
+        levels[cycle] = epio_read_pin_states(epio) & 1;
+        if (cycle < RUN_CYCLES) {
+            epio_step_cycles(epio, 1);
+        }
+    }
+    uint32_t count = epio_capture_stop(epio, NULL);
+    epio_free(epio);
+
+    epio_index_t *index = epio_index_build(edges, count);
+    assert_non_null(index);
+    free(edges);
+
+    for (int cycle = 0; cycle <= RUN_CYCLES; cycle++) {
+        assert_int_equal(epio_index_level(index, 0, cycle), levels[cycle]);
+    }
+    uint64_t value;
+    assert_int_equal(epio_index_period(index, 0, 500, &value), 0);
+    assert_int_equal(value, 8);
+    assert_int_equal(epio_index_pulse_width(index, 0, 500, &value), 0);
+    assert_int_equal(value, 4);
+    assert_int_equal(epio_index_next_edge(index, 0, 500, EPIO_EDGE_RISING, &value), 0);
+    assert_int_equal(value, 505);
+
+    epio_index_free(index);
+}
+
+static void index_invalid_args(void **state) {
+    (void)state;
+    epio_index_t *index = epio_index_build(test_edges, NUM_TEST_EDGES);
+    assert_non_null(index);
+    uint64_t value;
+    epio_edge_t unordered[] = {
+        { .cycle = 10, .changed = 0, .value = 0 },
+        { .cycle = 9, .changed = 1, .value = 1 },
+    };
+
+    expect_assert_failure(epio_index_build(NULL, 1));
+    expect_assert_failure(epio_index_build(test_edges, 0));
+    expect_assert_failure(epio_index_build(unordered, 2));
+    expect_assert_failure(epio_index_free(NULL));
+    expect_assert_failure(epio_index_level(NULL, 0, 0));
+    expect_assert_failure(epio_index_level(index, NUM_GPIOS, 0));
+    expect_assert_failure(epio_index_next_edge(index, NUM_GPIOS, 0, EPIO_EDGE_ANY, &value));
+    expect_assert_failure(epio_index_next_edge(index, 0, 0, 0, &value));
+    expect_assert_failure(epio_index_next_edge(index, 0, 0, EPIO_EDGE_ANY + 1, &value));
+    expect_assert_failure(epio_index_next_edge(index, 0, 0, EPIO_EDGE_ANY, NULL));
+    expect_assert_failure(epio_index_prev_edge(NULL, 0, 0, EPIO_EDGE_ANY, &value));
+    expect_assert_failure(epio_index_prev_edge(index, 0, 0, 0, &value));
+    expect_assert_failure(epio_index_prev_edge(index, 0, 0, EPIO_EDGE_ANY, NULL));
+    expect_assert_failure(epio_index_pulse_width(index, 0, 0, NULL));
+    expect_assert_failure(epio_index_period(index, 0, 0, NULL));
+
+    epio_index_free(index);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(index_level),
+        cmocka_unit_test(index_edges),
+        cmocka_unit_test(index_pulses),
+        cmocka_unit_test(index_capture),
+        cmocka_unit_test(index_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -7,6 +7,7 @@
 // Unit tests for init and related functions from epio.c
 
 #define APIO_LOG_IMPL
+#include <string.h>
 #include "test.h"
 
 static void init_returns_valid_instance(void **state) {
@@ -159,6 +160,112 @@ static void set_sm_debug_invalid(void **state) {
     epio_free(epio);
 }
 
+static void sizeof_matches_instance(void **state) {
+    (void)state;
+    assert_int_equal(epio_sizeof(), sizeof(epio_t));
+}
+
+static void init_in_static_buffer(void **state) {
+    (void)state;
+    static _Alignas(max_align_t) uint8_t buffer[sizeof(epio_t)];
+    memset(buffer, 0xA5, sizeof(buffer));
+
+    epio_t *epio = epio_init_in(buffer, sizeof(buffer));
+    assert_ptr_equal(epio, buffer);
+
+    // Must be in the same state as a heap allocated instance
+    epio_t *heap = epio_init();
+    assert_non_null(heap);
+    assert_memory_equal(epio, heap, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_sram_resident_pages(epio), 0);
+    assert_int_equal(epio_read_pin_states(epio), epio_read_pin_states(heap));
+    epio_free(heap);
+
+    // Use it, including SRAM, then free it, which must not free the buffer
+    epio_sram_write_word(epio, 0x20000000, 0x12345678);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0x12345678);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_get_cycle_count(epio), 10);
+    epio_free(epio);
+
+    // And it can be reused
+    epio = epio_init_in(buffer, sizeof(buffer));
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0);
+    epio_free(epio);
+}
+
+static void init_in_invalid(void **state) {
+    (void)state;
+    static _Alignas(max_align_t) uint8_t buffer[sizeof(epio_t) + 1];
+
+    expect_assert_failure(epio_init_in(NULL, sizeof(buffer)));
+    expect_assert_failure(epio_init_in(buffer, sizeof(epio_t) - 1));
+    expect_assert_failure(epio_init_in(buffer + 1, sizeof(epio_t)));
+}
+
+static void reset_restores_power_on_state(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_t *fresh = epio_init();
+    assert_non_null(fresh);
+
+    // Change as much state as possible
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = 0x0001F000,
+        .shiftctrl = 0x00000000,
+        .pinctrl = 0x04000000,
+    };
+    epio_sm_debug_t debug = {
+        .first_instr = 0,
+        .start_instr = 0,
+        .end_instr = 1,
+    };
+    epio_set_instr(epio, 1, 0, 0xE081); // set pindirs, 1
+    epio_set_instr(epio, 1, 1, 0xA042); // nop
+    epio_set_sm_reg(epio, 1, 2, &reg);
+    epio_set_sm_debug(epio, 1, 2, &debug);
+    epio_enable_sm(epio, 1, 2);
+    epio_set_gpiobase(epio, 2, 16);
+    epio_push_tx_fifo(epio, 0, 3, 0xDEADBEEF);
+    epio_push_rx_fifo(epio, 2, 0, 0xCAFEBABE);
+    epio_set_block_irq(epio, 0, 5);
+    epio_set_gpio_output_control(epio, 0, 1);
+    epio_set_gpio_input_inverted(epio, 3, 1);
+    epio_set_gpio_force_input_low(epio, 4, 1);
+    epio_drive_gpios_ext(epio, 0xFF00, 0x0F00);
+    epio_dma_setup_read_pio_chain(epio, 0, 0, 1, 4, 0, 2, 4, 8);
+    epio_sram_write_word(epio, 0x20001000, 0x11223344);
+    epio_sram_write_byte(epio, 0x20040000, 0x55);
+    epio_step_cycles(epio, 5);
+    assert_int_equal(epio_sram_resident_pages(epio), 2);
+
+    epio_reset(epio);
+
+    // Machine state must match a newly initialised instance
+    assert_memory_equal(epio, fresh, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_get_cycle_count(epio), 0);
+    assert_false(epio_is_sm_enabled(epio, 1, 2));
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 3), 0);
+    assert_int_equal(epio_peek_block_irq(epio, 0), 0);
+    assert_int_equal(epio_read_pin_states(epio), GPIO_ALL_MASK);
+    assert_int_equal(epio_read_driven_pins(epio), 0);
+
+    // SRAM pages are kept, but zeroed
+    assert_int_equal(epio_sram_resident_pages(epio), 2);
+    assert_int_equal(epio_sram_read_word(epio, 0x20001000), 0);
+    assert_int_equal(epio_sram_read_byte(epio, 0x20040000), 0);
+
+    epio_free(fresh);
+    epio_free(epio);
+}
+
+static void reset_null(void **state) {
+    (void)state;
+    expect_assert_failure(epio_reset(NULL));
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(init_returns_valid_instance),
@@ -170,6 +277,11 @@ int main(void) {
         cmocka_unit_test(set_sm_debug_invalid),
         cmocka_unit_test(sm_reg_null),
         cmocka_unit_test(block_sm_invalid),
+        cmocka_unit_test(sizeof_matches_instance),
+        cmocka_unit_test(init_in_static_buffer),
+        cmocka_unit_test(init_in_invalid),
+        cmocka_unit_test(reset_restores_power_on_state),
+        cmocka_unit_test(reset_null),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,301 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the memory responder from epio_mem.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <unistd.h>
+#include "test.h"
+
+#define IMAGE_PATH  "/tmp/epio_test_mem"
+
+// Address GPIOs, scattered across several bytes of GPIOs, and out of order
+static const uint8_t addr_pins[] = { 20, 17, 30, 43 };
+
+#define CS_PIN      40
+#define OE_PIN      41
+
+static epio_mem_config_t bus_config(uint8_t num_data_pins, uint32_t latency) {
+    epio_mem_config_t config = {
+        .num_addr_pins = sizeof(addr_pins),
+        .num_data_pins = num_data_pins,
+        .cs_pin = CS_PIN,
+        .oe_pin = OE_PIN,
+        .latency = latency,
+    };
+    for (uint8_t ii = 0; ii < sizeof(addr_pins); ii++) {
+        config.addr_pins[ii] = addr_pins[ii];
+    }
+    for (uint8_t ii = 0; ii < num_data_pins; ii++) {
+        config.data_pins[ii] = ii;
+    }
+    return config;
+}
+
+// Drives the address and control GPIOs, as the host would
+static void drive_bus(epio_t *epio, uint32_t addr, uint8_t cs, uint8_t oe) {
+    uint64_t gpios = (1ULL << CS_PIN) | (1ULL << OE_PIN);
+    uint64_t level = ((uint64_t)cs << CS_PIN) | ((uint64_t)oe << OE_PIN);
+    for (uint8_t ii = 0; ii < sizeof(addr_pins); ii++) {
+        gpios |= 1ULL << addr_pins[ii];
+        level |= (uint64_t)((addr >> ii) & 1) << addr_pins[ii];
+    }
+    epio_drive_gpios_ext(epio, gpios, level);
+}
+
+static void mem_bus(void **state) {
+    (void)state;
+    uint8_t image[16];
+    for (uint8_t ii = 0; ii < sizeof(image); ii++) {
+        image[ii] = ii * 0x11;
+    }
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Deselected, so the data GPIOs are released on attach
+    drive_bus(epio, 0, 1, 0);
+    epio_mem_config_t config = bus_config(8, 0);
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), 0);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+
+    // Selected, data follows the address a cycle later
+    drive_bus(epio, 5, 0, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0xFF);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0x55);
+    drive_bus(epio, 0xE, 0, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0xEE);
+
+    // Either control GPIO high releases the data GPIOs
+    drive_bus(epio, 0xE, 0, 1);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+    drive_bus(epio, 0xE, 0, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0xEE);
+    drive_bus(epio, 0xE, 1, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+
+    epio_free(epio);
+}
+
+static void mem_wide(void **state) {
+    (void)state;
+
+    // 7 words of 12 bits, in 2 bytes each, and a trailing partial word
+    uint8_t image[15];
+    for (uint8_t ii = 0; ii < sizeof(image); ii++) {
+        image[ii] = 0xA0 + ii;
+    }
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    drive_bus(epio, 3, 0, 0);
+    epio_mem_config_t config = bus_config(12, 0);
+    config.cs_pin = EPIO_MEM_NO_PIN;
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), 0);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFFFF, 0xFFF);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFFF, 0x7A6);
+
+    // Past the end, including the partial word, reads as all ones
+    drive_bus(epio, 7, 1, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFFF, 0xFFF);
+    drive_bus(epio, 0xF, 1, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFFF, 0xFFF);
+    drive_bus(epio, 6, 1, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFFF, 0xDAC);
+
+    // Without an output enable GPIO either, the data is always driven
+    epio_free(epio);
+    epio = epio_init();
+    assert_non_null(epio);
+    config.oe_pin = EPIO_MEM_NO_PIN;
+    assert_int_equal(epio_mem_attach(epio, &config, NULL, 0), 0);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFFF, 0xFFF);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFFFF, 0xFFF);
+
+    epio_free(epio);
+}
+
+static void mem_latency(void **state) {
+    (void)state;
+    uint8_t image[16];
+    for (uint8_t ii = 0; ii < sizeof(image); ii++) {
+        image[ii] = ii * 0x11;
+    }
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    drive_bus(epio, 1, 0, 0);
+    epio_mem_config_t config = bus_config(8, 3);
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), 0);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0x11);
+
+    // The change is seen after the first cycle, and the data updated 3
+    // cycles after that.  epio_drive_gpios_ext() released the data GPIOs.
+    drive_bus(epio, 2, 0, 0);
+    epio_step_cycles(epio, 3);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0x22);
+
+    // A further change restarts the access
+    drive_bus(epio, 3, 0, 0);
+    epio_step_cycles(epio, 2);
+    drive_bus(epio, 4, 0, 0);
+    epio_step_cycles(epio, 3);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0x44);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0x44);
+
+    epio_free(epio);
+}
+
+static void mem_sm_reads(void **state) {
+    (void)state;
+    static const uint8_t image[] = { 0x11, 0x22, 0x33, 0x44 };
+
+    // Block 0 SM 0 drives address GPIOs 8-9 with 2, then reads data GPIOs
+    // 0-7 into its RX FIFO
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (31 << 12),
+        .pinctrl = (2 << 26) | (8 << 5),    // set count 2, set base 8
+    };
+    epio_set_instr(epio, 0, 0, 0xE083);     // set pindirs, 3
+    epio_set_instr(epio, 0, 1, 0xE002);     // set pins, 2
+    epio_set_instr(epio, 0, 2, 0x4008);     // in pins, 8
+    epio_set_instr(epio, 0, 3, 0x8020);     // push block
+    epio_set_instr(epio, 0, 4, 0x0004);     // jmp 4
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 8, 0);
+    epio_set_gpio_output_control(epio, 9, 0);
+    epio_enable_sm(epio, 0, 0);
+
+    epio_mem_config_t config = {
+        .addr_pins = { 8, 9 },
+        .num_addr_pins = 2,
+        .data_pins = { 0, 1, 2, 3, 4, 5, 6, 7 },
+        .num_data_pins = 8,
+        .cs_pin = EPIO_MEM_NO_PIN,
+        .oe_pin = EPIO_MEM_NO_PIN,
+    };
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), 0);
+    epio_step_cycles(epio, 4);
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), 1);
+    assert_int_equal(epio_pop_rx_fifo(epio, 0, 0), 0x33);
+
+    epio_free(epio);
+}
+
+static void mem_file(void **state) {
+    (void)state;
+    uint8_t image[16];
+    for (uint8_t ii = 0; ii < sizeof(image); ii++) {
+        image[ii] = 0xF0 - ii;
+    }
+    write_file(IMAGE_PATH, image, sizeof(image));
+
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    drive_bus(epio, 9, 0, 0);
+    epio_mem_config_t config = bus_config(8, 0);
+    int id = epio_mem_attach_file(epio, &config, IMAGE_PATH);
+    assert_int_equal(id, 0);
+    assert_int_equal(epio_read_pin_states(epio) & 0xFF, 0xE7);
+
+    // Once detached, the file is unmapped and the data GPIOs no longer
+    // follow the address
+    epio_device_detach(epio, id);
+    drive_bus(epio, 2, 0, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio) & 0xFF, 0);
+
+    // Missing and empty files can't be attached
+    assert_int_equal(epio_mem_attach_file(epio, &config, "/nonexistent/epio"), -1);
+    write_file(IMAGE_PATH, NULL, 0);
+    assert_int_equal(epio_mem_attach_file(epio, &config, IMAGE_PATH), -1);
+
+    // Nor can any responder when every device slot is in use
+    assert_int_equal(epio_mem_attach_file(epio, &config, IMAGE_PATH), -1);
+    epio_device_ops_t none = { 0 };
+    for (int ii = 0; ii < EPIO_MAX_DEVICES; ii++) {
+        assert_int_equal(epio_device_attach(epio, 0x1, &none, NULL), ii);
+    }
+    assert_int_equal(epio_mem_attach(epio, &config, image, sizeof(image)), -1);
+    write_file(IMAGE_PATH, image, sizeof(image));
+    assert_int_equal(epio_mem_attach_file(epio, &config, IMAGE_PATH), -1);
+    unlink(IMAGE_PATH);
+
+    epio_free(epio);
+}
+
+static void mem_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    uint8_t image[1] = { 0 };
+    epio_mem_config_t config = bus_config(8, 0);
+
+    expect_assert_failure(epio_mem_attach(NULL, &config, image, 1));
+    expect_assert_failure(epio_mem_attach(epio, NULL, image, 1));
+    expect_assert_failure(epio_mem_attach(epio, &config, NULL, 1));
+    expect_assert_failure(epio_mem_attach_file(NULL, &config, IMAGE_PATH));
+    expect_assert_failure(epio_mem_attach_file(epio, NULL, IMAGE_PATH));
+    expect_assert_failure(epio_mem_attach_file(epio, &config, NULL));
+
+    config = bus_config(8, 0);
+    config.num_addr_pins = 0;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config.num_addr_pins = EPIO_MEM_MAX_ADDR_PINS + 1;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config = bus_config(8, 0);
+    config.num_data_pins = 0;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config.num_data_pins = EPIO_MEM_MAX_DATA_PINS + 1;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config = bus_config(8, 0);
+    config.cs_pin = NUM_GPIOS;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config = bus_config(8, 0);
+    config.oe_pin = NUM_GPIOS;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config = bus_config(8, 0);
+    config.addr_pins[1] = NUM_GPIOS;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config = bus_config(8, 0);
+    config.data_pins[7] = NUM_GPIOS;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config.data_pins[7] = addr_pins[2];
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config.data_pins[7] = CS_PIN;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+    config.data_pins[7] = OE_PIN;
+    expect_assert_failure(epio_mem_attach(epio, &config, image, 1));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(mem_bus),
+        cmocka_unit_test(mem_wide),
+        cmocka_unit_test(mem_latency),
+        cmocka_unit_test(mem_sm_reads),
+        cmocka_unit_test(mem_file),
+        cmocka_unit_test(mem_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
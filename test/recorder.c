@@ -0,0 +1,232 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the in-memory event recorder from epio_recorder.c
+
+#define APIO_LOG_IMPL
+#include <stdlib.h>
+#include "test.h"
+
+// Block 0 SM 0 sets X, pulls a value, drives GPIO 0 low and sets IRQ 0, then
+// wraps and stalls on the second pull
+static epio_t *pulling_epio(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (3 << 12),              // wrap top 3, wrap bottom 0
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE025);     // set x, 5
+    epio_set_instr(epio, 0, 1, 0x80A0);     // pull block
+    epio_set_instr(epio, 0, 2, 0xE000);     // set pins, 0
+    epio_set_instr(epio, 0, 3, 0xC000);     // irq set 0
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_set_gpio_output(epio, 0);
+    epio_enable_sm(epio, 0, 0);
+    return epio;
+}
+
+static void check_event(epio_t *epio, uint32_t index, uint64_t cycle, uint8_t type, uint8_t block, uint8_t sm, uint64_t value) {
+    epio_event_t event;
+    epio_recorder_read(epio, index, &event);
+    assert_int_equal(event.cycle, cycle);
+    assert_int_equal(event.type, type);
+    assert_int_equal(event.block, block);
+    assert_int_equal(event.sm, sm);
+    assert_int_equal(event.value, value);
+}
+
+static void recorder_records_changes(void **state) {
+    (void)state;
+    epio_t *epio = pulling_epio();
+    uint64_t levels = epio_read_pin_states(epio);
+    assert_int_equal(epio_recorder_enable(epio, 64), 0);
+
+    epio_push_tx_fifo(epio, 0, 0, 0x1234);
+    epio_step_cycles(epio, 6);
+
+    // The X write after wrapping writes the same value, and the stalled pull
+    // doesn't change the PC, so are not recorded
+    assert_int_equal(epio_recorder_count(epio), 11);
+    assert_int_equal(epio_recorder_total(epio), 11);
+    check_event(epio, 0, 0, EPIO_EVENT_TX_PUSH, 0, 0, 0x1234);
+    check_event(epio, 1, 0, EPIO_EVENT_PC, 0, 0, 1);
+    check_event(epio, 2, 0, EPIO_EVENT_X, 0, 0, 5);
+    check_event(epio, 3, 1, EPIO_EVENT_TX_POP, 0, 0, 0x1234);
+    check_event(epio, 4, 1, EPIO_EVENT_PC, 0, 0, 2);
+    check_event(epio, 5, 1, EPIO_EVENT_OSR, 0, 0, 0x1234);
+    check_event(epio, 6, 2, EPIO_EVENT_PC, 0, 0, 3);
+    check_event(epio, 7, 2, EPIO_EVENT_GPIO, 0, 0, levels & ~1ULL);
+    check_event(epio, 8, 3, EPIO_EVENT_PC, 0, 0, 0);
+    check_event(epio, 9, 3, EPIO_EVENT_IRQ, 0, 0, 1);
+    check_event(epio, 10, 4, EPIO_EVENT_PC, 0, 0, 1);
+
+    epio_free(epio);
+}
+
+static void recorder_records_all_types(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    uint64_t levels = epio_read_pin_states(epio);
+    assert_int_equal(epio_recorder_enable(epio, 64), 0);
+
+    // API changes between cycles are recorded in the next cycle to run
+    epio_push_rx_fifo(epio, 2, 3, 0xAAAA5555);
+    assert_int_equal(epio_pop_rx_fifo(epio, 2, 3), 0xAAAA5555);
+    epio_push_tx_fifo(epio, 2, 3, 0x5555AAAA);
+    assert_int_equal(epio_pop_tx_fifo(epio, 2, 3), 0x5555AAAA);
+    epio_exec_instr_sm(epio, 2, 3, 0xE041);  // set y, 1
+    epio_exec_instr_sm(epio, 2, 3, 0xE03F);  // set x, 31
+    epio_exec_instr_sm(epio, 2, 3, 0x4025);  // in x, 5
+    epio_set_block_irq(epio, 1, 7);
+    epio_drive_gpios_ext(epio, 1ULL << 40, 0);
+    epio_step_cycles(epio, 1);
+
+    assert_int_equal(epio_recorder_count(epio), 9);
+    check_event(epio, 0, 0, EPIO_EVENT_RX_PUSH, 2, 3, 0xAAAA5555);
+    check_event(epio, 1, 0, EPIO_EVENT_RX_POP, 2, 3, 0xAAAA5555);
+    check_event(epio, 2, 0, EPIO_EVENT_TX_PUSH, 2, 3, 0x5555AAAA);
+    check_event(epio, 3, 0, EPIO_EVENT_TX_POP, 2, 3, 0x5555AAAA);
+    check_event(epio, 4, 0, EPIO_EVENT_IRQ, 1, 0, 1 << 7);
+    check_event(epio, 5, 0, EPIO_EVENT_X, 2, 3, 31);
+    check_event(epio, 6, 0, EPIO_EVENT_Y, 2, 3, 1);
+    check_event(epio, 7, 0, EPIO_EVENT_ISR, 2, 3, 31);
+    check_event(epio, 8, 0, EPIO_EVENT_GPIO, 0, 0, levels & ~(1ULL << 40));
+
+    epio_free(epio);
+}
+
+static void recorder_ring_wraps(void **state) {
+    (void)state;
+    epio_t *epio = toggling_epio();
+
+    // Rounded up to 8 events
+    assert_int_equal(epio_recorder_enable(epio, 5), 0);
+    epio_step_cycles(epio, 100);
+
+    // Each cycle changes the PC and the GPIO levels, except the first, which
+    // drives the already high GPIO high
+    assert_int_equal(epio_recorder_total(epio), 199);
+    assert_int_equal(epio_recorder_count(epio), 8);
+    check_event(epio, 0, 96, EPIO_EVENT_PC, 0, 0, 1);
+    check_event(epio, 1, 96, EPIO_EVENT_GPIO, 0, 0, epio_read_pin_states(epio) | 1);
+    check_event(epio, 6, 99, EPIO_EVENT_PC, 0, 0, 0);
+    check_event(epio, 7, 99, EPIO_EVENT_GPIO, 0, 0, epio_read_pin_states(epio));
+
+    // Idle cycles after wrapping don't overwrite the oldest event
+    epio_disable_sm(epio, 0, 0);
+    epio_step_cycles(epio, 2);
+    assert_int_equal(epio_recorder_total(epio), 199);
+    assert_int_equal(epio_recorder_count(epio), 8);
+    check_event(epio, 0, 96, EPIO_EVENT_PC, 0, 0, 1);
+    check_event(epio, 1, 96, EPIO_EVENT_GPIO, 0, 0, epio_read_pin_states(epio) | 1);
+
+    epio_free(epio);
+}
+
+static void recorder_with_history(void **state) {
+    (void)state;
+    epio_t *ref = pulling_epio();
+    assert_int_equal(epio_recorder_enable(ref, 64), 0);
+    epio_push_tx_fifo(ref, 0, 0, 0x1234);
+    epio_step_cycles(ref, 12);
+
+    // Replayed cycles are not recorded again, so seeking back and stepping
+    // forward records the same events as running straight through
+    epio_t *epio = pulling_epio();
+    assert_int_equal(epio_history_enable(epio, 4), 0);
+    assert_int_equal(epio_recorder_enable(epio, 64), 0);
+    epio_push_tx_fifo(epio, 0, 0, 0x1234);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_seek(epio, 1), 0);
+    epio_step_cycles(epio, 11);
+
+    assert_int_equal(epio_recorder_count(epio), epio_recorder_count(ref));
+    for (uint32_t ii = 0; ii < epio_recorder_count(ref); ii++) {
+        epio_event_t event, ref_event;
+        epio_recorder_read(epio, ii, &event);
+        epio_recorder_read(ref, ii, &ref_event);
+        assert_memory_equal(&event, &ref_event, sizeof(event));
+    }
+
+    epio_free(ref);
+    epio_free(epio);
+}
+
+static void recorder_enable_disable(void **state) {
+    (void)state;
+    epio_t *epio = toggling_epio();
+
+    // Disabled
+    epio_recorder_disable(epio);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_recorder_count(epio), 0);
+    assert_int_equal(epio_recorder_total(epio), 0);
+
+    // Re-enabling discards the events recorded
+    assert_int_equal(epio_recorder_enable(epio, 16), 0);
+    epio_step_cycles(epio, 2);
+    assert_int_equal(epio_recorder_count(epio), 4);
+    assert_int_equal(epio_recorder_enable(epio, 16), 0);
+    assert_int_equal(epio_recorder_count(epio), 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_recorder_count(epio), 2);
+
+    // Disabled by reset and resetting the cycle count
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_recorder_count(epio), 0);
+    assert_int_equal(epio_recorder_enable(epio, 16), 0);
+    epio_reset(epio);
+    assert_int_equal(epio_recorder_total(epio), 0);
+
+    // Freed with the instance
+    assert_int_equal(epio_recorder_enable(epio, 16), 0);
+    epio_free(epio);
+}
+
+static void recorder_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_event_t event;
+
+    expect_assert_failure(epio_recorder_enable(NULL, 16));
+    expect_assert_failure(epio_recorder_enable(epio, 0));
+    expect_assert_failure(epio_recorder_enable(epio, (1U << 31) + 1));
+    expect_assert_failure(epio_recorder_disable(NULL));
+    expect_assert_failure(epio_recorder_count(NULL));
+    expect_assert_failure(epio_recorder_total(NULL));
+    expect_assert_failure(epio_recorder_read(NULL, 0, &event));
+
+    // Reading with nothing recorded, or beyond the last event
+    expect_assert_failure(epio_recorder_read(epio, 0, &event));
+    assert_int_equal(epio_recorder_enable(epio, 16), 0);
+    expect_assert_failure(epio_recorder_read(epio, 0, &event));
+    epio_set_block_irq(epio, 0, 0);
+    epio_step_cycles(epio, 1);
+    epio_recorder_read(epio, 0, &event);
+    expect_assert_failure(epio_recorder_read(epio, 1, &event));
+    expect_assert_failure(epio_recorder_read(epio, 0, NULL));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(recorder_records_changes),
+        cmocka_unit_test(recorder_records_all_types),
+        cmocka_unit_test(recorder_ring_wraps),
+        cmocka_unit_test(recorder_with_history),
+        cmocka_unit_test(recorder_enable_disable),
+        cmocka_unit_test(recorder_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,318 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for scheduled host actions from epio_schedule.c
+
+#define APIO_LOG_IMPL
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define STIM_PATH   "/tmp/epio_test_schedule"
+
+// Records the cycles, and a tag, of each callback performed
+typedef struct {
+    epio_t *epio;
+    uint64_t cycle[256];
+    int tag[256];
+    uint32_t count;
+} record_t;
+
+typedef struct {
+    record_t *record;
+    int tag;
+} tagged_t;
+
+static void record_cb(void *ctx, epio_t *epio) {
+    tagged_t *tagged = (tagged_t *)ctx;
+    record_t *record = tagged->record;
+    assert_ptr_equal(epio, record->epio);
+    assert_true(record->count < 256);
+    record->cycle[record->count] = epio_get_cycle_count(epio);
+    record->tag[record->count] = tagged->tag;
+    record->count++;
+}
+
+static int schedule_cb(epio_t *epio, uint64_t cycle, tagged_t *tagged) {
+    epio_action_t action = {
+        .type = EPIO_ACTION_CALLBACK,
+        .callback = record_cb,
+        .ctx = tagged,
+    };
+    return epio_schedule_at(epio, cycle, &action);
+}
+
+static void schedule_builtin_actions(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    wait_then_count(epio);
+
+    epio_action_t action = { .type = EPIO_ACTION_DRIVE, .gpios = 0x24, .level = 0x04 };
+    assert_int_equal(epio_schedule_at(epio, 10, &action), 0);
+    action = (epio_action_t){ .type = EPIO_ACTION_RELEASE, .gpios = 0x20 };
+    assert_int_equal(epio_schedule_at(epio, 30, &action), 0);
+    action = (epio_action_t){ .type = EPIO_ACTION_PUSH_TX, .block = 1, .sm = 2, .value = 0x1234 };
+    assert_int_equal(epio_schedule_in(epio, 20, &action), 0);
+    action = (epio_action_t){ .type = EPIO_ACTION_SET_IRQ, .block = 2, .irq = 3 };
+    assert_int_equal(epio_schedule_at(epio, 40, &action), 0);
+    action = (epio_action_t){ .type = EPIO_ACTION_CLEAR_IRQ, .block = 2, .irq = 3 };
+    assert_int_equal(epio_schedule_at(epio, 50, &action), 0);
+    assert_int_equal(epio_schedule_pending(epio), 5);
+
+    // The SM sees GPIO 5 go low on cycle 10, within a single long step, so
+    // decrements X on each of cycles 11 to 44.  Other GPIOs are unaffected.
+    epio_drive_gpios_ext(epio, 0x01, 0x00);
+    epio_step_cycles(epio, 45);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-34);
+    assert_int_equal(epio_read_driven_pins(epio), 0x05);
+    assert_int_equal(epio_read_pin_states(epio) & 0x3F, 0x3E);
+    assert_int_equal(epio_tx_fifo_depth(epio, 1, 2), 1);
+    assert_int_equal(epio_peek_tx_fifo(epio, 1, 2, 0), 0x1234);
+    assert_int_equal(epio_peek_block_irq_num(epio, 2, 3), 1);
+    assert_int_equal(epio_schedule_pending(epio), 1);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(epio_peek_block_irq_num(epio, 2, 3), 0);
+    assert_int_equal(epio_schedule_pending(epio), 0);
+
+    epio_free(epio);
+}
+
+static void schedule_order(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    record_t record = { .epio = epio };
+    tagged_t tagged[4];
+    for (int ii = 0; ii < 4; ii++) {
+        tagged[ii] = (tagged_t){ &record, ii };
+    }
+
+    // Scheduled from different distances, so filed in different levels,
+    // but performed in the order scheduled
+    assert_int_equal(schedule_cb(epio, 5000, &tagged[0]), 0);
+    epio_step_cycles(epio, 4990);
+    assert_int_equal(schedule_cb(epio, 5000, &tagged[1]), 0);
+    assert_int_equal(schedule_cb(epio, 4990, &tagged[2]), 0);
+    assert_int_equal(record.count, 0);
+
+    // Actions due now are performed before the next cycle executes
+    epio_step_cycles(epio, 1);
+    assert_int_equal(record.count, 1);
+    assert_int_equal(record.tag[0], 2);
+    assert_int_equal(record.cycle[0], 4990);
+    epio_step_cycles(epio, 20);
+    assert_int_equal(record.count, 3);
+    assert_int_equal(record.tag[1], 0);
+    assert_int_equal(record.tag[2], 1);
+    assert_int_equal(record.cycle[1], 5000);
+    assert_int_equal(record.cycle[2], 5000);
+
+    epio_free(epio);
+}
+
+// Schedules tag 1 now and tag 2 on the next cycle
+static void chain_cb(void *ctx, epio_t *epio) {
+    tagged_t *tagged = (tagged_t *)ctx;
+    record_cb(&tagged[0], epio);
+    assert_int_equal(schedule_cb(epio, epio_get_cycle_count(epio), &tagged[1]), 0);
+    assert_int_equal(schedule_cb(epio, epio_get_cycle_count(epio) + 1, &tagged[2]), 0);
+    expect_assert_failure(epio_schedule_clear(epio));
+}
+
+static void schedule_from_callback(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    record_t record = { .epio = epio };
+    tagged_t tagged[3] = { { &record, 0 }, { &record, 1 }, { &record, 2 } };
+
+    epio_action_t action = { .type = EPIO_ACTION_CALLBACK, .callback = chain_cb, .ctx = tagged };
+    assert_int_equal(epio_schedule_in(epio, 7, &action), 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(record.count, 3);
+    assert_int_equal(record.cycle[0], 7);
+    assert_int_equal(record.cycle[1], 7);
+    assert_int_equal(record.cycle[2], 8);
+    assert_int_equal(record.tag[1], 1);
+    assert_int_equal(record.tag[2], 2);
+
+    epio_free(epio);
+}
+
+static void schedule_far_and_many(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    record_t record = { .epio = epio };
+    tagged_t tagged[200];
+    uint64_t expected[200];
+
+    // Spread across every level, and past the top level, with several on
+    // the same cycles
+    uint32_t seed = 1;
+    for (int ii = 0; ii < 200; ii++) {
+        seed = seed * 1103515245 + 12345;
+        uint64_t cycle = seed % (1U << (ii % 26));
+        tagged[ii] = (tagged_t){ &record, ii };
+        expected[ii] = cycle;
+        assert_int_equal(schedule_cb(epio, cycle, &tagged[ii]), 0);
+    }
+    assert_int_equal(epio_schedule_pending(epio), 200);
+
+    // Performed in cycle order, and for the same cycle in scheduled order
+    epio_step_cycles(epio, 1U << 25);
+    assert_int_equal(record.count, 200);
+    for (uint32_t ii = 0; ii < 200; ii++) {
+        assert_int_equal(record.cycle[ii], expected[record.tag[ii]]);
+        if (ii > 0) {
+            assert_true(record.cycle[ii] >= record.cycle[ii - 1]);
+            if (record.cycle[ii] == record.cycle[ii - 1]) {
+                assert_true(record.tag[ii] > record.tag[ii - 1]);
+            }
+        }
+    }
+    assert_int_equal(epio_schedule_pending(epio), 0);
+
+    epio_free(epio);
+}
+
+static void schedule_cycle_moved(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    record_t record = { .epio = epio };
+    tagged_t tagged[4];
+    for (int ii = 0; ii < 4; ii++) {
+        tagged[ii] = (tagged_t){ &record, ii };
+    }
+    assert_int_equal(epio_history_enable(epio, 16), 0);
+
+    // Performed actions are not repeated after seeking back
+    assert_int_equal(schedule_cb(epio, 10, &tagged[0]), 0);
+    assert_int_equal(schedule_cb(epio, 300, &tagged[1]), 0);
+    epio_step_cycles(epio, 100);
+    assert_int_equal(record.count, 1);
+    assert_int_equal(epio_seek(epio, 5), 0);
+    epio_step_cycles(epio, 100);
+    assert_int_equal(record.count, 1);
+
+    // Pending actions are still performed at their cycle
+    epio_step_cycles(epio, 200);
+    assert_int_equal(record.count, 2);
+    assert_int_equal(record.cycle[1], 300);
+
+    // Actions passed by running outside epio_step_cycles(), or scheduled
+    // in the past, are performed before the next cycle executes
+    assert_int_equal(schedule_cb(epio, 400, &tagged[2]), 0);
+    epio_run_cycles(epio, 200);
+    assert_int_equal(schedule_cb(epio, 100, &tagged[3]), 0);
+    assert_int_equal(record.count, 2);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(record.count, 4);
+    assert_int_equal(record.tag[2], 2);
+    assert_int_equal(record.tag[3], 3);
+    assert_int_equal(record.cycle[2], 505);
+    assert_int_equal(record.cycle[3], 505);
+
+    // Reset removes scheduled actions
+    assert_int_equal(schedule_cb(epio, 1000, &tagged[0]), 0);
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_schedule_pending(epio), 0);
+    assert_int_equal(schedule_cb(epio, 1000, &tagged[0]), 0);
+    epio_reset(epio);
+    assert_int_equal(epio_schedule_pending(epio), 0);
+    epio_schedule_clear(epio);
+
+    epio_free(epio);
+}
+
+static void schedule_with_stimulus(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    record_t record = { .epio = epio };
+    tagged_t tagged[2] = { { &record, 0 }, { &record, 1 } };
+
+    const char *vcd =
+        "$timescale 1 ns $end\n"
+        "$var wire 1 ! cs $end\n"
+        "$enddefinitions $end\n"
+        "#10\n0!\n"
+        "#30\n1!\n";
+    write_text(STIM_PATH, vcd);
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "cs", 5), 0);
+    epio_set_sys_clock_hz(epio, 1000000000);
+    epio_stimulus_attach(epio, stim);
+
+    // Actions between, and on the same cycle as, stimulus edges, which are
+    // applied first
+    assert_int_equal(schedule_cb(epio, 20, &tagged[0]), 0);
+    assert_int_equal(schedule_cb(epio, 30, &tagged[1]), 0);
+    wait_then_count(epio);
+    epio_step_cycles(epio, 40);
+    assert_int_equal(record.count, 2);
+    assert_int_equal(record.cycle[0], 20);
+    assert_int_equal(record.cycle[1], 30);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-29);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void schedule_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_action_t action = { .type = EPIO_ACTION_DRIVE };
+
+    expect_assert_failure(epio_schedule_at(NULL, 0, &action));
+    expect_assert_failure(epio_schedule_at(epio, 0, NULL));
+    action.gpios = 1ULL << NUM_GPIOS;
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action.gpios = 0;
+    action.level = 1ULL << NUM_GPIOS;
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_RELEASE, .gpios = 1ULL << NUM_GPIOS };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_PUSH_TX, .block = NUM_PIO_BLOCKS };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_PUSH_TX, .sm = NUM_SMS_PER_BLOCK };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_SET_IRQ, .block = NUM_PIO_BLOCKS };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_CLEAR_IRQ, .irq = NUM_IRQS_PER_BLOCK };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_CALLBACK };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = (epio_action_type_t)99 };
+    expect_assert_failure(epio_schedule_at(epio, 0, &action));
+    action = (epio_action_t){ .type = EPIO_ACTION_RELEASE };
+    expect_assert_failure(epio_schedule_in(NULL, 0, &action));
+    epio_step_cycles(epio, 1);
+    expect_assert_failure(epio_schedule_in(epio, UINT64_MAX, &action));
+    expect_assert_failure(epio_schedule_pending(NULL));
+    expect_assert_failure(epio_schedule_clear(NULL));
+    assert_int_equal(epio_schedule_pending(epio), 0);
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(schedule_builtin_actions),
+        cmocka_unit_test(schedule_order),
+        cmocka_unit_test(schedule_from_callback),
+        cmocka_unit_test(schedule_far_and_many),
+        cmocka_unit_test(schedule_cycle_moved),
+        cmocka_unit_test(schedule_with_stimulus),
+        cmocka_unit_test(schedule_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
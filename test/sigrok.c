@@ -0,0 +1,471 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the sigrok session writer from epio_sigrok.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define SIGROK_PATH "/tmp/epio_test_session.sr"
+#define MAX_EDGES   1024
+
+// A session file, read into memory
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} session_t;
+
+static uint32_t get_u16(const uint8_t *data) {
+    return data[0] | (data[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *data) {
+    return get_u16(data) | (get_u16(data + 2) << 16);
+}
+
+static void read_session(session_t *session) {
+    session->data = (uint8_t *)read_file(SIGROK_PATH, &session->size);
+}
+
+// Reads deflate bits, LSB first
+typedef struct {
+    const uint8_t *data;
+    size_t pos;
+    uint8_t bit;
+} bits_t;
+
+static uint32_t get_bits(bits_t *bits, uint8_t count) {
+    uint32_t value = 0;
+    for (uint8_t ii = 0; ii < count; ii++) {
+        value |= (uint32_t)((bits->data[bits->pos] >> bits->bit) & 1) << ii;
+        if (++bits->bit == 8) {
+            bits->bit = 0;
+            bits->pos++;
+        }
+    }
+    return value;
+}
+
+// Reads a Huffman code, MSB first
+static uint32_t get_code(bits_t *bits, uint8_t count) {
+    uint32_t code = 0;
+    for (uint8_t ii = 0; ii < count; ii++) {
+        code = (code << 1) | get_bits(bits, 1);
+    }
+    return code;
+}
+
+// Reads a literal/length symbol with the fixed Huffman codes
+static uint32_t get_symbol(bits_t *bits) {
+    uint32_t code = get_code(bits, 7);
+    if (code <= 0x17) {
+        return 256 + code;
+    }
+    code = (code << 1) | get_bits(bits, 1);
+    if (code <= 0xBF) {
+        return code - 0x30;
+    }
+    if (code <= 0xC7) {
+        return 280 + code - 0xC0;
+    }
+    code = (code << 1) | get_bits(bits, 1);
+    return 144 + code - 0x190;
+}
+
+// Inflates a single fixed Huffman block, as written by epio
+static size_t inflate_fixed(const uint8_t *in, uint8_t *out, size_t max) {
+    static const uint16_t len_base[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t len_extra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t dist_base[] = { 1, 2, 3, 4, 5, 7 };
+    static const uint8_t dist_extra[] = { 0, 0, 0, 0, 1, 1 };
+    bits_t bits = { .data = in };
+    size_t len = 0;
+
+    assert_int_equal(get_bits(&bits, 1), 1);    // BFINAL
+    assert_int_equal(get_bits(&bits, 2), 1);    // BTYPE
+    for (;;) {
+        uint32_t symbol = get_symbol(&bits);
+        if (symbol < 256) {
+            assert_true(len < max);
+            out[len++] = (uint8_t)symbol;
+        } else if (symbol == 256) {
+            return len;
+        } else {
+            symbol -= 257;
+            uint32_t length = len_base[symbol] + get_bits(&bits, len_extra[symbol]);
+            uint32_t code = get_code(&bits, 5);
+            assert_true(code < 6);
+            uint32_t distance = dist_base[code] + get_bits(&bits, dist_extra[code]);
+            assert_true(distance <= len);
+            assert_true(len + length <= max);
+            for (uint32_t ii = 0; ii < length; ii++, len++) {
+                out[len] = out[len - distance];
+            }
+        }
+    }
+}
+
+static uint32_t crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t ii = 0; ii < len; ii++) {
+        crc ^= data[ii];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
+
+// Returns the number of files in the session
+static uint32_t session_files(const session_t *session) {
+    const uint8_t *end = session->data + session->size - 22;
+    assert_int_equal(get_u32(end), 0x06054B50);
+    assert_int_equal(get_u32(end + 16) + get_u32(end + 12), session->size - 22);
+    return get_u16(end + 10);
+}
+
+// Returns a file's contents, NUL terminated, checking its headers and CRC,
+// or NULL if it is not in the session
+static uint8_t *session_file(const session_t *session, const char *name, size_t *size) {
+    const uint8_t *end = session->data + session->size - 22;
+    const uint8_t *entry = session->data + get_u32(end + 16);
+    for (uint32_t ii = 0; ii < get_u16(end + 10); ii++) {
+        assert_int_equal(get_u32(entry), 0x02014B50);
+        uint32_t name_len = get_u16(entry + 28);
+        if ((name_len == strlen(name)) && (memcmp(entry + 46, name, name_len) == 0)) {
+            uint32_t method = get_u16(entry + 10);
+            uint32_t crc = get_u32(entry + 16);
+            uint32_t csize = get_u32(entry + 20);
+            uint32_t usize = get_u32(entry + 24);
+            const uint8_t *local = session->data + get_u32(entry + 42);
+            assert_int_equal(get_u32(local), 0x04034B50);
+            assert_int_equal(get_u16(local + 8), method);
+            assert_memory_equal(local + 30, name, name_len);
+            const uint8_t *data = local + 30 + name_len + get_u16(local + 28);
+
+            uint8_t *contents = malloc(usize + 1);
+            assert_non_null(contents);
+            if (method == 0) {
+                assert_int_equal(csize, usize);
+                memcpy(contents, data, usize);
+            } else {
+                // Deflated, with a data descriptor
+                assert_int_equal(method, 8);
+                assert_int_equal(get_u16(local + 6), 0x0008);
+                assert_int_equal(inflate_fixed(data, contents, usize), usize);
+                assert_int_equal(get_u32(data + csize), 0x08074B50);
+                assert_int_equal(get_u32(data + csize + 4), crc);
+                assert_int_equal(get_u32(data + csize + 8), csize);
+                assert_int_equal(get_u32(data + csize + 12), usize);
+            }
+            assert_int_equal(crc32(contents, usize), crc);
+            contents[usize] = 0;
+            *size = usize;
+            return contents;
+        }
+        entry += 46 + name_len + get_u16(entry + 30) + get_u16(entry + 32);
+    }
+    return NULL;
+}
+
+// Returns all of the samples in the session
+static uint8_t *session_samples(const session_t *session, size_t *size) {
+    uint8_t *samples = NULL;
+    *size = 0;
+    for (uint32_t chunk = 1; ; chunk++) {
+        char name[32];
+        size_t len;
+        snprintf(name, sizeof(name), "logic-1-%u", chunk);
+        uint8_t *data = session_file(session, name, &len);
+        if (data == NULL) {
+            return samples;
+        }
+        samples = realloc(samples, *size + len);
+        assert_non_null(samples);
+        memcpy(samples + *size, data, len);
+        *size += len;
+        free(data);
+    }
+}
+
+// Writes edges in batches, then checks the samples against the levels of
+// the masked GPIOs at every cycle from the first edge to end
+static void check_samples(const epio_edge_t *edges, uint32_t count, uint64_t mask, uint64_t end, uint32_t batch) {
+    epio_sigrok_t *sigrok = epio_sigrok_open(SIGROK_PATH, mask, 150000000);
+    assert_non_null(sigrok);
+    for (uint32_t ii = 0; ii < count; ii += batch) {
+        epio_sigrok_write(sigrok, edges + ii, (count - ii < batch) ? count - ii : batch);
+    }
+    assert_int_equal(epio_sigrok_close(sigrok, end), 0);
+
+    session_t session;
+    read_session(&session);
+    size_t size;
+    uint8_t *samples = session_samples(&session, &size);
+    uint32_t unitsize = (__builtin_popcountll(mask) + 7) / 8;
+    assert_int_equal(size, (end - edges[0].cycle + 1) * unitsize);
+
+    uint32_t edge = 0;
+    for (uint64_t cycle = edges[0].cycle; cycle <= end; cycle++) {
+        while ((edge + 1 < count) && (edges[edge + 1].cycle <= cycle)) {
+            edge++;
+        }
+        uint64_t expected = 0;
+        uint32_t channel = 0;
+        for (int pin = 0; pin < NUM_GPIOS; pin++) {
+            if (mask & (1ULL << pin)) {
+                expected |= ((edges[edge].value >> pin) & 1) << channel++;
+            }
+        }
+        const uint8_t *sample = samples + (cycle - edges[0].cycle) * unitsize;
+        for (uint32_t byte = 0; byte < unitsize; byte++) {
+            assert_int_equal(sample[byte], (uint8_t)(expected >> (byte * 8)));
+        }
+    }
+
+    free(samples);
+    free(session.data);
+}
+
+static void sigrok_metadata(void **state) {
+    (void)state;
+    static const struct {
+        uint32_t samplerate;
+        const char *text;
+    } rates[] = {
+        { 150000000, "150 MHz" },
+        { 1000000000, "1 GHz" },
+        { 125000, "125 kHz" },
+        { 12345, "12345 Hz" },
+    };
+
+    for (size_t ii = 0; ii < sizeof(rates) / sizeof(rates[0]); ii++) {
+        epio_sigrok_t *sigrok = epio_sigrok_open(SIGROK_PATH, 0x8030, rates[ii].samplerate);
+        assert_non_null(sigrok);
+        assert_int_equal(epio_sigrok_close(sigrok, 100), 0);
+
+        // No edges, so no samples
+        session_t session;
+        size_t size;
+        read_session(&session);
+        assert_int_equal(session_files(&session), 2);
+        uint8_t *version = session_file(&session, "version", &size);
+        assert_non_null(version);
+        assert_string_equal((char *)version, "2");
+        free(version);
+
+        char expected[512];
+        snprintf(expected, sizeof(expected),
+            "[global]\n"
+            "sigrok version=0.5.2\n"
+            "\n"
+            "[device 1]\n"
+            "capturefile=logic-1\n"
+            "total probes=3\n"
+            "samplerate=%s\n"
+            "total analog=0\n"
+            "probe1=GPIO4\n"
+            "probe2=GPIO5\n"
+            "probe3=GPIO15\n"
+            "unitsize=1\n",
+            rates[ii].text);
+        uint8_t *metadata = session_file(&session, "metadata", &size);
+        assert_non_null(metadata);
+        assert_string_equal((char *)metadata, expected);
+        free(metadata);
+        free(session.data);
+    }
+}
+
+static void sigrok_samples(void **state) {
+    (void)state;
+
+    // Short and long runs, values which need 8 and 9 bit literal codes,
+    // edges in the same cycle, and edges of other GPIOs
+    static const epio_edge_t edges[] = {
+        { .cycle = 7, .changed = 0, .value = 0x1A5 },
+        { .cycle = 8, .changed = 0xFF, .value = 0x15A },
+        { .cycle = 10, .changed = 0xFF, .value = 0x1A5 },
+        { .cycle = 10, .changed = 0x01, .value = 0x1A4 },
+        { .cycle = 13, .changed = 0x100, .value = 0x0A4 },
+        { .cycle = 14, .changed = 0xFF, .value = 0x000 },
+        { .cycle = 1014, .changed = 0xFF, .value = 0x0FF },
+        { .cycle = 1272, .changed = 0xFF, .value = 0x000 },
+        { .cycle = 1532, .changed = 0x80, .value = 0x080 },
+    };
+    uint32_t count = sizeof(edges) / sizeof(edges[0]);
+    for (uint32_t batch = 1; batch <= count; batch += count - 1) {
+        check_samples(edges, count, 0xFF, 1800, batch);
+    }
+
+    // The end can be the last edge
+    check_samples(edges, count, 0xFF, 1532, count);
+}
+
+static void sigrok_unitsizes(void **state) {
+    (void)state;
+    epio_edge_t *edges = malloc(MAX_EDGES * sizeof(epio_edge_t));
+    assert_non_null(edges);
+
+    // Pseudo-random edges, with runs of 1 to 32 cycles
+    uint64_t levels = 0;
+    uint64_t cycle = 100;
+    uint32_t seed = 1;
+    for (uint32_t ii = 0; ii < MAX_EDGES; ii++) {
+        seed = seed * 1103515245 + 12345;
+        uint64_t changed = ((uint64_t)seed << 20 | seed) & ((1ULL << NUM_GPIOS) - 1);
+        levels ^= ii ? changed : 0;
+        edges[ii] = (epio_edge_t){ .cycle = cycle, .changed = ii ? changed : 0, .value = levels };
+        cycle += 1 + ((seed >> 24) & 0x1F);
+    }
+
+    // 1 to 6 bytes per sample
+    static const uint64_t masks[] = {
+        0x1, 0x3, 0x7, 0xFF00, 0x1FF, 0xFFFFFF, 0xFFFFFFFF, 0xFFFFFFFFFF, (1ULL << NUM_GPIOS) - 1,
+    };
+    for (size_t ii = 0; ii < sizeof(masks) / sizeof(masks[0]); ii++) {
+        check_samples(edges, MAX_EDGES, masks[ii], cycle + 300, 100);
+    }
+
+    free(edges);
+}
+
+static void sigrok_chunks(void **state) {
+    (void)state;
+
+    // Long enough for several sample files, and a sample every cycle for
+    // long enough to fill the write buffer more than once
+    epio_edge_t *edges = malloc(MAX_EDGES * 256 * sizeof(epio_edge_t));
+    assert_non_null(edges);
+    uint32_t count = 0;
+    edges[count++] = (epio_edge_t){ .cycle = 0, .changed = 0, .value = 0x3 };
+    edges[count++] = (epio_edge_t){ .cycle = 5000000, .changed = 0x1, .value = 0x2 };
+    for (uint64_t cycle = 9000000; count < MAX_EDGES * 256; cycle++) {
+        edges[count] = (epio_edge_t){ .cycle = cycle, .changed = 0x3, .value = edges[count - 1].value ^ 0x3 };
+        count++;
+    }
+    check_samples(edges, count, 0x3, edges[count - 1].cycle + 5000000, MAX_EDGES);
+
+    session_t session;
+    read_session(&session);
+    assert_int_equal(session_files(&session), 2 + 4);
+    free(session.data);
+
+    free(edges);
+}
+
+static void sigrok_live(void **state) {
+    (void)state;
+
+    // Block 0 SM 0 drives GPIO 0 high for 4 cycles, then low for 4 cycles
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12),              // wrap top 1, wrap bottom 0
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE301);     // set pins, 1 [3]
+    epio_set_instr(epio, 0, 1, 0xE300);     // set pins, 0 [3]
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_set_gpio_output(epio, 0);
+    epio_enable_sm(epio, 0, 0);
+    epio_set_sys_clock_hz(epio, 200000000);
+
+    // Written as the capture buffer fills
+    uint8_t levels[1001];
+    epio_edge_t edges[8];
+    epio_sigrok_t *sigrok = epio_sigrok_open(SIGROK_PATH, 0x1, epio_get_sys_clock_hz(epio));
+    assert_non_null(sigrok);
+    assert_int_equal(epio_capture_start(epio, 0x1, edges, 8, EPIO_CAPTURE_CALLBACK, epio_sigrok_capture, sigrok), 0);
+    for (int cycle = 0; cycle <= 1000; cycle++) {
+        levels[cycle] = epio_read_pin_states(epio) & 1;
+        if (cycle < 1000) {
+            epio_step_cycles(epio, 1);
+        }
+    }
+    uint32_t count = epio_capture_stop(epio, NULL);
+    epio_sigrok_write(sigrok, edges, count);
+    assert_int_equal(epio_sigrok_close(sigrok, epio_get_cycle_count(epio)), 0);
+    epio_free(epio);
+
+    session_t session;
+    read_session(&session);
+    size_t size;
+    uint8_t *metadata = session_file(&session, "metadata", &size);
+    assert_non_null(strstr((char *)metadata, "samplerate=200 MHz\n"));
+    free(metadata);
+    uint8_t *samples = session_samples(&session, &size);
+    assert_int_equal(size, 1001);
+    assert_memory_equal(samples, levels, 1001);
+    free(samples);
+    free(session.data);
+}
+
+static void sigrok_write_errors(void **state) {
+    (void)state;
+    epio_edge_t edges[2] = {
+        { .cycle = 0, .changed = 0, .value = 0 },
+        { .cycle = 10000000, .changed = 1, .value = 1 },
+    };
+
+    assert_null(epio_sigrok_open("/nonexistent/session.sr", 0x1, 150000000));
+
+    epio_sigrok_t *sigrok = epio_sigrok_open("/dev/full", 0x1, 150000000);
+    assert_non_null(sigrok);
+    assert_int_equal(epio_sigrok_close(sigrok, 0), -1);
+
+    // Stops writing samples once the buffer can't be written
+    sigrok = epio_sigrok_open("/dev/full", 0x1, 150000000);
+    assert_non_null(sigrok);
+    for (uint32_t ii = 0; ii < 100000; ii++) {
+        edges[1].cycle = ii + 1;
+        edges[1].value ^= 1;
+        epio_sigrok_write(sigrok, &edges[ii ? 1 : 0], ii ? 1 : 2);
+    }
+    assert_int_equal(epio_sigrok_close(sigrok, 100000000), -1);
+}
+
+static void sigrok_invalid_args(void **state) {
+    (void)state;
+    epio_edge_t edges[2] = {
+        { .cycle = 10, .changed = 0, .value = 0 },
+        { .cycle = 9, .changed = 1, .value = 1 },
+    };
+
+    expect_assert_failure(epio_sigrok_open(NULL, 0x1, 150000000));
+    expect_assert_failure(epio_sigrok_open(SIGROK_PATH, 0, 150000000));
+    expect_assert_failure(epio_sigrok_open(SIGROK_PATH, 1ULL << NUM_GPIOS, 150000000));
+    expect_assert_failure(epio_sigrok_open(SIGROK_PATH, 0x1, 0));
+
+    epio_sigrok_t *sigrok = epio_sigrok_open(SIGROK_PATH, 0x1, 150000000);
+    assert_non_null(sigrok);
+    expect_assert_failure(epio_sigrok_write(NULL, edges, 1));
+    expect_assert_failure(epio_sigrok_write(sigrok, NULL, 1));
+    epio_sigrok_write(sigrok, NULL, 0);
+    expect_assert_failure(epio_sigrok_write(sigrok, edges, 2));
+    expect_assert_failure(epio_sigrok_close(sigrok, 9));
+    expect_assert_failure(epio_sigrok_close(NULL, 0));
+    assert_int_equal(epio_sigrok_close(sigrok, 10), 0);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(sigrok_metadata),
+        cmocka_unit_test(sigrok_samples),
+        cmocka_unit_test(sigrok_unitsizes),
+        cmocka_unit_test(sigrok_chunks),
+        cmocka_unit_test(sigrok_live),
+        cmocka_unit_test(sigrok_write_errors),
+        cmocka_unit_test(sigrok_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -7,6 +7,7 @@
 // Unit tests for SRAM API
 
 #define APIO_LOG_IMPL
+#include <stdlib.h>
 #include "test.h"
 
 #define TEST_SRAM_BASE  0x20000000
@@ -190,6 +191,131 @@ static void sram_set_bulk_boundary(void **state) {
     epio_free(epio);
 }
 
+// --- Sparse page allocation ---
+
+static void sram_no_pages_on_init(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    assert_int_equal(epio_sram_resident_pages(epio), 0);
+
+    epio_free(epio);
+}
+
+static void sram_unwritten_reads_zero(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    assert_int_equal(epio_sram_read_byte(epio, TEST_SRAM_BASE), 0);
+    assert_int_equal(epio_sram_read_halfword(epio, TEST_SRAM_BASE + 0x1000), 0);
+    assert_int_equal(epio_sram_read_word(epio, TEST_SRAM_END - 4), 0);
+
+    // Reads must not allocate pages
+    assert_int_equal(epio_sram_resident_pages(epio), 0);
+
+    epio_free(epio);
+}
+
+static void sram_write_allocates_one_page(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    epio_sram_write_word(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 8, 0x12345678);
+    assert_int_equal(epio_sram_resident_pages(epio), 1);
+
+    // Further writes to the same page don't allocate
+    epio_sram_write_byte(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE, 0x01);
+    epio_sram_write_halfword(epio, TEST_SRAM_BASE + (2 * SRAM_PAGE_SIZE) - 2, 0x0203);
+    assert_int_equal(epio_sram_resident_pages(epio), 1);
+
+    // Other bytes in the page read as zero, and neighbouring pages too
+    assert_int_equal(epio_sram_read_word(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 4), 0);
+    assert_int_equal(epio_sram_read_word(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE - 4), 0);
+    assert_int_equal(epio_sram_read_word(epio, TEST_SRAM_BASE + (2 * SRAM_PAGE_SIZE)), 0);
+    assert_int_equal(epio_sram_read_word(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 8), 0x12345678);
+
+    // A write to a different page allocates another
+    epio_sram_write_byte(epio, TEST_SRAM_END - 1, 0xFF);
+    assert_int_equal(epio_sram_resident_pages(epio), 2);
+
+    epio_free(epio);
+}
+
+static void sram_set_spans_pages(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Write 2 pages worth of data starting part way into a page, so it
+    // touches 3 pages
+    size_t len = 2 * SRAM_PAGE_SIZE;
+    uint8_t *data = malloc(len);
+    assert_non_null(data);
+    for (size_t ii = 0; ii < len; ii++) {
+        data[ii] = (uint8_t)(ii * 7);
+    }
+    uint32_t addr = TEST_SRAM_BASE + SRAM_PAGE_SIZE - 3;
+    epio_sram_set(epio, addr, data, len);
+    assert_int_equal(epio_sram_resident_pages(epio), 3);
+
+    for (size_t ii = 0; ii < len; ii++) {
+        assert_int_equal(epio_sram_read_byte(epio, addr + ii), data[ii]);
+    }
+    assert_int_equal(epio_sram_read_byte(epio, addr - 1), 0);
+    assert_int_equal(epio_sram_read_byte(epio, addr + len), 0);
+
+    free(data);
+    epio_free(epio);
+}
+
+static void sram_page_pointer(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Any address in the page gives the same page, allocating it once
+    uint8_t *page = epio_sram_page(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 100);
+    assert_non_null(page);
+    assert_ptr_equal(epio_sram_page(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE), page);
+    assert_ptr_equal(epio_sram_page(epio, TEST_SRAM_BASE + 2 * SRAM_PAGE_SIZE - 1), page);
+    assert_int_equal(epio_sram_resident_pages(epio), 1);
+    assert_int_equal(page[0], 0);
+
+    // Writes through the pointer are SRAM writes, and vice versa
+    uint64_t hash = epio_state_hash(epio);
+    page = epio_sram_page(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE);
+    page[4] = 0x78;
+    page[5] = 0x56;
+    assert_int_equal(epio_sram_read_halfword(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 4), 0x5678);
+    assert_int_not_equal(epio_state_hash(epio), hash);
+    epio_sram_write_byte(epio, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 6, 0x34);
+    assert_int_equal(page[6], 0x34);
+
+    // A page shared with a template is copied, leaving the template alone
+    epio_template_t *tmpl = epio_template_from_epio(epio);
+    assert_non_null(tmpl);
+    epio_t *copy = epio_from_template(tmpl);
+    assert_non_null(copy);
+    uint8_t *copy_page = epio_sram_page(copy, TEST_SRAM_BASE + SRAM_PAGE_SIZE);
+    assert_ptr_not_equal(copy_page, page);
+    assert_int_equal(copy_page[4], 0x78);
+    copy_page[4] = 0;
+    epio_t *other = epio_from_template(tmpl);
+    assert_non_null(other);
+    assert_int_equal(epio_sram_read_byte(other, TEST_SRAM_BASE + SRAM_PAGE_SIZE + 4), 0x78);
+    epio_free(other);
+    epio_free(copy);
+    epio_template_free(tmpl);
+
+    expect_assert_failure(epio_sram_page(epio, TEST_SRAM_BASE - 1));
+    expect_assert_failure(epio_sram_page(epio, TEST_SRAM_END));
+
+    epio_free(epio);
+}
+
 // --- Start address below SRAM ---
 
 static void sram_read_byte_below_base(void **state) {
@@ -394,6 +520,12 @@ int main(void) {
         cmocka_unit_test(sram_boundary_last_word),
         cmocka_unit_test(sram_overwrite),
         cmocka_unit_test(sram_set_bulk_boundary),
+        // Sparse page allocation
+        cmocka_unit_test(sram_no_pages_on_init),
+        cmocka_unit_test(sram_unwritten_reads_zero),
+        cmocka_unit_test(sram_write_allocates_one_page),
+        cmocka_unit_test(sram_set_spans_pages),
+        cmocka_unit_test(sram_page_pointer),
         // Start address below SRAM
         cmocka_unit_test(sram_read_byte_below_base),
         cmocka_unit_test(sram_write_byte_below_base),
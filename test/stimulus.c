@@ -0,0 +1,647 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for GPIO stimulus playback from epio_stimulus.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define STIM_PATH   "/tmp/epio_test_stimulus"
+
+#define VCD_HEADER \
+    "$date today $end\n" \
+    "$version test $end\n" \
+    "$timescale 1 ns $end\n" \
+    "$scope module top $end\n" \
+    "$var wire 1 ! cs $end\n" \
+    "$var wire 4 \" bus [3:0] $end\n" \
+    "$scope module sub $end\n" \
+    "$var wire 1 # cs $end\n" \
+    "$var wire 1 $ data[5] $end\n" \
+    "$var real 64 % level $end\n" \
+    "$upscope $end\n" \
+    "$upscope $end\n" \
+    "$enddefinitions $end\n"
+
+// Opens a VCD of VCD_HEADER followed by body, with the first cs mapped to
+// GPIO 5
+static epio_stimulus_t *open_vcd(const char *body) {
+    char text[4096];
+    snprintf(text, sizeof(text), "%s%s", VCD_HEADER, body);
+    write_text(STIM_PATH, text);
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "cs", 5), 0);
+    return stim;
+}
+
+// An instance running at 1GHz, so each VCD nanosecond is one cycle
+static epio_t *epio_1ghz(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_set_sys_clock_hz(epio, 1000000000);
+    return epio;
+}
+
+static void sys_clock(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    assert_int_equal(epio_get_sys_clock_hz(epio), EPIO_DEFAULT_SYS_CLOCK_HZ);
+    epio_set_sys_clock_hz(epio, 48000000);
+    assert_int_equal(epio_get_sys_clock_hz(epio), 48000000);
+    epio_reset(epio);
+    assert_int_equal(epio_get_sys_clock_hz(epio), EPIO_DEFAULT_SYS_CLOCK_HZ);
+    expect_assert_failure(epio_set_sys_clock_hz(epio, 0));
+    expect_assert_failure(epio_set_sys_clock_hz(NULL, 1));
+    expect_assert_failure(epio_get_sys_clock_hz(NULL));
+    epio_free(epio);
+}
+
+static void vcd_edges_at_exact_cycles(void **state) {
+    (void)state;
+    epio_t *epio = epio_1ghz();
+    wait_then_count(epio);
+    epio_stimulus_t *stim = open_vcd(
+        "$dumpvars\n1!\n$end\n"
+        "#10\n0!\n"
+        "#25\n1!\n");
+    epio_stimulus_attach(epio, stim);
+    assert_int_equal(epio_stimulus_status(epio), 1);
+    assert_int_equal(epio_read_driven_pins(epio), 1ULL << 5);
+    assert_int_equal(epio_get_gpio_input(epio, 5), 1);
+
+    // The SM sees GPIO 5 go low on cycle 10, within a single long step, so
+    // decrements X on each of cycles 11 to 99
+    epio_step_cycles(epio, 100);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-89);
+    assert_int_equal(epio_get_gpio_input(epio, 5), 1);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_edge_applied_at_step_boundary(void **state) {
+    (void)state;
+    epio_t *epio = epio_1ghz();
+    epio_stimulus_attach(epio, open_vcd("#3\n0!\n1#\n#4\n1!\n"));
+
+    epio_step_cycles(epio, 2);
+    assert_int_equal(epio_get_gpio_input(epio, 5), 1);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 5), 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 5), 1);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_vectors_and_release(void **state) {
+    (void)state;
+    epio_t *epio = epio_1ghz();
+    epio_stimulus_t *stim = open_vcd(
+        "#0\nb1010 \"\n0#\n"
+        "#5\nb1 \"\nz!\n1$\n"
+        "#6\nbx \"\nr1.5 %\n"
+        "#7\nb0 \"\n"
+        "$comment a comment with #1 in it $end\n"
+        "#8\nbz1 \"\n");
+    assert_int_equal(epio_stimulus_map(stim, "top.bus[3]", 10), 0);
+    assert_int_equal(epio_stimulus_map(stim, "bus[0]", 11), 0);
+    assert_int_equal(epio_stimulus_map(stim, "top.sub.cs", 12), 0);
+    assert_int_equal(epio_stimulus_map(stim, "data[5]", 13), 0);
+
+    // The first cs is top.cs, which is unchanged at cycle 0
+    epio_drive_gpios_ext(epio, 1ULL << 20, 0);
+    epio_stimulus_attach(epio, stim);
+    assert_int_equal(epio_read_driven_pins(epio), (1ULL << 20) | (1ULL << 10) | (1ULL << 11) | (1ULL << 12));
+    assert_int_equal(epio_get_gpio_input(epio, 20), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 10), 1);
+    assert_int_equal(epio_get_gpio_input(epio, 11), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 12), 0);
+
+    // b1 is zero extended, and top.cs is released
+    epio_step_cycles(epio, 5);
+    assert_int_equal(epio_get_gpio_input(epio, 10), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 11), 1);
+    assert_int_equal(epio_get_gpio_input(epio, 13), 1);
+    assert_int_equal(epio_read_driven_pins(epio) & (1ULL << 5), 0);
+
+    // bx is x extended, so releases both
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio), (1ULL << 20) | (1ULL << 12) | (1ULL << 13));
+    assert_int_equal(epio_get_gpio_input(epio, 10), 1);
+    assert_int_equal(epio_get_gpio_input(epio, 11), 1);
+
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 10), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 11), 0);
+
+    // bz1 is z extended
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio) & (1ULL << 10), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 11), 1);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_timescale_conversion(void **state) {
+    (void)state;
+
+    // 10ps units at 150MHz, so 1000 units is 1.5 cycles, rounded down
+    write_text(STIM_PATH, 
+        "$timescale 10ps $end\n"
+        "$var wire 1 ! cs $end\n"
+        "$enddefinitions $end\n"
+        "#1000 0!\n#2000 1!\n");
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "cs", 0), 0);
+
+    // Relative to the cycle it is attached at
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_step_cycles(epio, 100);
+    epio_stimulus_attach(epio, stim);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_timescale_units(void **state) {
+    (void)state;
+    static const struct {
+        const char *timescale;
+        uint64_t cycle;
+    } cases[] = {
+        { "1s", 1000000000000000ULL },
+        { "100ms", 100000000000000ULL },
+        { "10 us", 10000000000ULL },
+        { "1ns", 1000000ULL },
+        { "100 ps", 100000ULL },
+        { "1 fs", 1ULL },
+    };
+
+    // 1000000 units at 1GHz
+    for (size_t ii = 0; ii < sizeof(cases) / sizeof(cases[0]); ii++) {
+        char text[256];
+        snprintf(text, sizeof(text),
+            "$timescale %s $end\n$var wire 1 ! cs $end\n$enddefinitions $end\n#1000000 0!\n",
+            cases[ii].timescale);
+        write_text(STIM_PATH, text);
+        epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+        assert_non_null(stim);
+        assert_int_equal(epio_stimulus_map(stim, "cs", 0), 0);
+        epio_t *epio = epio_1ghz();
+        epio_stimulus_attach(epio, stim);
+        assert_int_equal(epio_stimulus_next_cycle(epio), cases[ii].cycle);
+        epio_free(epio);
+    }
+
+    unlink(STIM_PATH);
+}
+
+static void vcd_long_vector_value(void **state) {
+    (void)state;
+    char text[2048];
+    char value[600];
+    memset(value, '0', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    value[sizeof(value) - 2] = '1';
+    snprintf(text, sizeof(text),
+        "$var wire 599 ! wide [598:0] $end\n$enddefinitions $end\n#1 b%s !\n", value);
+    write_text(STIM_PATH, text);
+
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "wide[0]", 0), 0);
+    assert_int_equal(epio_stimulus_map(stim, "wide[1]", 1), 0);
+    assert_int_equal(epio_stimulus_map(stim, "wide[64]", 2), -1);
+    epio_t *epio = epio_1ghz();
+    epio_stimulus_attach(epio, stim);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_read_driven_pins(epio), 0x3);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+    assert_int_equal(epio_get_gpio_input(epio, 1), 0);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_map_errors(void **state) {
+    (void)state;
+    write_text(STIM_PATH, 
+        "$var wire 4 & rev [0:3] $end\n"
+        "$var wire 4 \" bus [3:0] $end\n"
+        "$var wire 1 ! cs $end\n"
+        "$var wire 1 ! alias $end\n"
+        "$enddefinitions $end\n");
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+
+    // Unknown signals, vectors without an index, ranges and out of range
+    // indices
+    assert_int_equal(epio_stimulus_map(stim, "nothing", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "bus", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "bus[1:0]", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "bus[4]", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "bus[x]", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "cs[0]", 0), -1);
+
+    char longname[1100];
+    memset(longname, 'a', sizeof(longname) - 1);
+    longname[sizeof(longname) - 1] = '\0';
+    assert_int_equal(epio_stimulus_map(stim, longname, 0), -1);
+
+    // Reversed ranges are indexed by declared bit number
+    assert_int_equal(epio_stimulus_map(stim, "rev[0]", 0), 0);
+    assert_int_equal(epio_stimulus_map(stim, "rev[3]", 1), 0);
+
+    // A GPIO or bit can only be mapped once, including via an alias
+    assert_int_equal(epio_stimulus_map(stim, "cs", 0), -1);
+    assert_int_equal(epio_stimulus_map(stim, "cs", 2), 0);
+    assert_int_equal(epio_stimulus_map(stim, "alias", 3), -1);
+    assert_int_equal(epio_stimulus_map(stim, "rev[0]", 4), -1);
+
+    epio_stimulus_free(stim);
+    unlink(STIM_PATH);
+}
+
+static void vcd_reversed_range(void **state) {
+    (void)state;
+    write_text(STIM_PATH, 
+        "$var wire 4 & rev [0:3] $end\n"
+        "$enddefinitions $end\n"
+        "#0 b0001 &\n");
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "rev[0]", 0), 0);
+    assert_int_equal(epio_stimulus_map(stim, "rev[3]", 1), 0);
+    epio_t *epio = epio_1ghz();
+    epio_stimulus_attach(epio, stim);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 1), 1);
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void vcd_invalid_headers(void **state) {
+    (void)state;
+    static const char *headers[] = {
+        // Empty, or no $enddefinitions
+        "",
+        "$var wire 1 ! cs $end\n",
+        "$enddefinitions",
+        // Bad timescales
+        "$timescale 2ns $end $enddefinitions $end",
+        "$timescale 1xs $end $enddefinitions $end",
+        "$timescale 1 $end $enddefinitions $end",
+        "$timescale 100000000000000000000000000000000ns $end $enddefinitions $end",
+        "$timescale 1ns",
+        // Bad scopes
+        "$scope module $end",
+        "$scope module top",
+        "$upscope $end",
+        "$scope module top $end $upscope",
+        // Bad vars
+        "$var wire",
+        "$var wire 0 ! cs $end",
+        "$var wire x ! cs $end",
+        "$var wire 1 !",
+        "$var wire 1 ! cs",
+        "$var wire 1 ! cs[ $end",
+        "$var wire 1 ! cs [1] [2] $end",
+        "$var wire 1 ! cs junk $end",
+        "$var wire 99999999999 ! cs $end",
+        // Unterminated and unknown sections
+        "$comment",
+        "junk",
+    };
+    for (size_t ii = 0; ii < sizeof(headers) / sizeof(headers[0]); ii++) {
+        write_text(STIM_PATH, headers[ii]);
+        assert_null(epio_stimulus_open_vcd(STIM_PATH));
+    }
+
+    // Too deep
+    char text[2048] = "";
+    for (int ii = 0; ii < 65; ii++) {
+        strcat(text, "$scope module m $end ");
+    }
+    write_text(STIM_PATH, text);
+    assert_null(epio_stimulus_open_vcd(STIM_PATH));
+
+    // Names too long
+    char scope[1100] = "";
+    char name[251];
+    memset(name, 'n', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    for (int ii = 0; ii < 4; ii++) {
+        strcat(scope, "$scope module ");
+        strcat(scope, name);
+        strcat(scope, " $end ");
+    }
+    snprintf(text, sizeof(text), "%s$scope module %s $end", scope, name);
+    write_text(STIM_PATH, text);
+    assert_null(epio_stimulus_open_vcd(STIM_PATH));
+    snprintf(text, sizeof(text), "%s$var wire 1 ! %.30s $end", scope, name);
+    write_text(STIM_PATH, text);
+    assert_null(epio_stimulus_open_vcd(STIM_PATH));
+
+    // Missing file
+    unlink(STIM_PATH);
+    assert_null(epio_stimulus_open_vcd(STIM_PATH));
+}
+
+static void vcd_invalid_body(void **state) {
+    (void)state;
+    static const char *bodies[] = {
+        "#10 0! #5 1!",
+        "#x",
+        "# 1!",
+        "#99999999999999999999 1!",
+        "#1 b0",
+        "#1 r1.0",
+        "#1 $comment",
+        "#1 q!",
+    };
+    for (size_t ii = 0; ii < sizeof(bodies) / sizeof(bodies[0]); ii++) {
+        epio_t *epio = epio_1ghz();
+        epio_stimulus_attach(epio, open_vcd(bodies[ii]));
+        epio_step_cycles(epio, 20);
+        assert_int_equal(epio_stimulus_status(epio), -1);
+        epio_free(epio);
+    }
+    unlink(STIM_PATH);
+}
+
+// Appends an unsigned LEB128 value to buf
+static size_t put_leb128(uint8_t *buf, uint64_t value) {
+    size_t len = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buf[len++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return len;
+}
+
+// Writes an edge list with the given records, each of delta, drive, level
+// and release, truncated by trim bytes
+static void write_edges(const uint64_t (*records)[4], size_t num, size_t trim) {
+    uint8_t buf[1024];
+    size_t len = 0;
+    memcpy(buf, "EPIOEDGE\x01\x00\x00\x00", 12);
+    len += 12;
+    for (size_t ii = 0; ii < num; ii++) {
+        for (size_t jj = 0; jj < 4; jj++) {
+            len += put_leb128(buf + len, records[ii][jj]);
+        }
+    }
+    write_file(STIM_PATH, buf, len - trim);
+}
+
+static void edges_playback(void **state) {
+    (void)state;
+    static const uint64_t records[][4] = {
+        { 0, 1ULL << 5, 1ULL << 5, 0 },
+        { 10, 1ULL << 5, 0, 0 },
+        { 15, (1ULL << 47) | 1, 1ULL << 47, 1ULL << 5 },
+        { 0, 1, 1, 0 },
+    };
+    write_edges(records, 4, 0);
+    epio_stimulus_t *stim = epio_stimulus_open_edges(STIM_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "cs", 0), -1);
+
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    wait_then_count(epio);
+    epio_stimulus_attach(epio, stim);
+    epio_step_cycles(epio, 100);
+    assert_int_equal(epio_peek_sm_x(epio, 0, 0), (uint32_t)-89);
+    assert_int_equal(epio_read_driven_pins(epio), (1ULL << 47) | 1);
+    assert_int_equal(epio_get_gpio_input(epio, 47), 1);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void edges_forced_inputs(void **state) {
+    (void)state;
+    static const uint64_t records[][4] = {
+        { 0, 0x3, 0x1, 0 },
+        { 1, 0, 0, 0x3 },
+    };
+    write_edges(records, 2, 0);
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_set_gpio_force_input_low(epio, 0, 1);
+    epio_set_gpio_force_input_high(epio, 1, 1);
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 1), 1);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 1), 1);
+    assert_int_equal(epio_read_driven_pins(epio), 0);
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void edges_invalid(void **state) {
+    (void)state;
+
+    // Bad headers, and a missing file
+    write_file(STIM_PATH, "EPIOEDG", 7);
+    assert_null(epio_stimulus_open_edges(STIM_PATH));
+    write_file(STIM_PATH, "EPIOEDGE\x02\x00\x00\x00", 12);
+    assert_null(epio_stimulus_open_edges(STIM_PATH));
+    write_file(STIM_PATH, "EPIOEDGX\x01\x00\x00\x00", 12);
+    assert_null(epio_stimulus_open_edges(STIM_PATH));
+    unlink(STIM_PATH);
+    assert_null(epio_stimulus_open_edges(STIM_PATH));
+
+    // Bad records
+    static const uint64_t bad[][4] = {
+        { 1, 1ULL << 48, 0, 0 },
+        { 1, 0, 0, 1ULL << 48 },
+        { 1, 1, 2, 0 },
+        { 1, 1, 1, 1 },
+    };
+    for (size_t ii = 0; ii < sizeof(bad) / sizeof(bad[0]); ii++) {
+        write_edges(&bad[ii], 1, 0);
+        epio_t *epio = epio_init();
+        assert_non_null(epio);
+        epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+        assert_int_equal(epio_stimulus_status(epio), -1);
+        epio_free(epio);
+    }
+
+    // Truncated within a record, and within a value
+    static const uint64_t good[][4] = {
+        { 1, 1, 1, 0 },
+        { 1, 1, 0, 0 },
+        { 1000, 1, 0, 0 },
+    };
+    for (size_t trim = 1; trim <= 4; trim += 3) {
+        write_edges(good, 3, trim);
+        epio_t *epio = epio_init();
+        assert_non_null(epio);
+        epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+        epio_step_cycles(epio, 2000);
+        assert_int_equal(epio_stimulus_status(epio), -1);
+        assert_int_equal(epio_read_driven_pins(epio), 1);
+        assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+        epio_free(epio);
+    }
+
+    // A value which overflows 64 bits
+    uint8_t overflow[12 + 10];
+    memcpy(overflow, "EPIOEDGE\x01\x00\x00\x00", 12);
+    memset(overflow + 12, 0xFF, 9);
+    overflow[21] = 0x02;
+    write_file(STIM_PATH, overflow, sizeof(overflow));
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    assert_int_equal(epio_stimulus_status(epio), -1);
+    epio_free(epio);
+
+    unlink(STIM_PATH);
+}
+
+static void stimulus_with_history(void **state) {
+    (void)state;
+    static const uint64_t records[][4] = {
+        { 10, 1, 0, 0 },
+        { 10, 1, 1, 0 },
+    };
+    write_edges(records, 2, 0);
+
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    assert_int_equal(epio_history_enable(epio, 1000), 0);
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    epio_step_cycles(epio, 30);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+
+    // Edges are recorded as inputs, so seeking restores them
+    assert_int_equal(epio_seek(epio, 15), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 0);
+    assert_int_equal(epio_seek(epio, 5), 0);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+    assert_int_equal(epio_read_driven_pins(epio), 0);
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void stimulus_detach(void **state) {
+    (void)state;
+    static const uint64_t records[][4] = {
+        { 10, 1, 0, 0 },
+    };
+    write_edges(records, 1, 0);
+
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+    epio_stimulus_detach(epio);
+
+    // Attaching replaces any attached stimulus
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    assert_int_equal(epio_stimulus_status(epio), 1);
+    epio_stimulus_detach(epio);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+    epio_step_cycles(epio, 20);
+    assert_int_equal(epio_get_gpio_input(epio, 0), 1);
+
+    // Reset and resetting the cycle count detach
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    epio_reset(epio);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_stimulus_status(epio), 0);
+
+    // Freeing an instance frees its stimulus
+    epio_stimulus_attach(epio, epio_stimulus_open_edges(STIM_PATH));
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+static void stimulus_invalid_args(void **state) {
+    (void)state;
+    static const uint64_t records[][4] = {
+        { 10, 1, 0, 0 },
+    };
+    write_edges(records, 1, 0);
+    epio_stimulus_t *stim = epio_stimulus_open_edges(STIM_PATH);
+    assert_non_null(stim);
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    expect_assert_failure(epio_stimulus_open_vcd(NULL));
+    expect_assert_failure(epio_stimulus_open_edges(NULL));
+    expect_assert_failure(epio_stimulus_map(NULL, "cs", 0));
+    expect_assert_failure(epio_stimulus_map(stim, NULL, 0));
+    expect_assert_failure(epio_stimulus_map(stim, "cs", NUM_GPIOS));
+    expect_assert_failure(epio_stimulus_attach(NULL, stim));
+    expect_assert_failure(epio_stimulus_attach(epio, NULL));
+    expect_assert_failure(epio_stimulus_detach(NULL));
+    expect_assert_failure(epio_stimulus_status(NULL));
+    expect_assert_failure(epio_stimulus_free(NULL));
+
+    // Attached stimuli cannot be mapped, reattached or freed
+    epio_stimulus_attach(epio, stim);
+    expect_assert_failure(epio_stimulus_map(stim, "cs", 0));
+    expect_assert_failure(epio_stimulus_attach(epio, stim));
+    expect_assert_failure(epio_stimulus_free(stim));
+
+    epio_free(epio);
+    unlink(STIM_PATH);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(sys_clock),
+        cmocka_unit_test(vcd_edges_at_exact_cycles),
+        cmocka_unit_test(vcd_edge_applied_at_step_boundary),
+        cmocka_unit_test(vcd_vectors_and_release),
+        cmocka_unit_test(vcd_timescale_conversion),
+        cmocka_unit_test(vcd_timescale_units),
+        cmocka_unit_test(vcd_long_vector_value),
+        cmocka_unit_test(vcd_map_errors),
+        cmocka_unit_test(vcd_reversed_range),
+        cmocka_unit_test(vcd_invalid_headers),
+        cmocka_unit_test(vcd_invalid_body),
+        cmocka_unit_test(edges_playback),
+        cmocka_unit_test(edges_forced_inputs),
+        cmocka_unit_test(edges_invalid),
+        cmocka_unit_test(stimulus_with_history),
+        cmocka_unit_test(stimulus_detach),
+        cmocka_unit_test(stimulus_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
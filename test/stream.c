@@ -0,0 +1,340 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for FIFO streams from epio_stream.c
+
+#define APIO_LOG_IMPL
+#include "test.h"
+
+// Configures block 0 SM sm to pull a word, move it to the ISR and push it,
+// taking 3 cycles per word
+static void loopback(epio_t *epio, uint8_t sm) {
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (2 << 12),
+    };
+    epio_set_instr(epio, 0, 0, 0x80A0);     // pull block
+    epio_set_instr(epio, 0, 1, 0x60C0);     // out isr, 32
+    epio_set_instr(epio, 0, 2, 0x8020);     // push block
+    epio_set_sm_reg(epio, 0, sm, &reg);
+    epio_enable_sm(epio, 0, sm);
+}
+
+static void stream_buffers(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    loopback(epio, 0);
+
+    uint32_t tx[100];
+    uint32_t rx[100] = { 0 };
+    for (uint32_t ii = 0; ii < 100; ii++) {
+        tx[ii] = ii * 0x01010101 + 7;
+    }
+    assert_int_equal(epio_stream_tx_buffer(epio, 0, 0, tx, 100), 0);
+    assert_int_equal(epio_stream_rx_buffer(epio, 0, 0, rx, 100), 0);
+
+    // The source fills the TX FIFO when attached
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 0), MAX_FIFO_DEPTH);
+
+    // Each word is pulled on cycle 3n and pushed on 3n+2, so the FIFOs never
+    // limit the transfer, and the SM underruns from cycle 300
+    epio_step_cycles(epio, 400);
+    assert_memory_equal(rx, tx, sizeof(tx));
+    epio_stream_stats_t tx_stats;
+    epio_stream_stats_t rx_stats;
+    epio_stream_stats(epio, 0, 0, &tx_stats, &rx_stats);
+    assert_int_equal(tx_stats.words, 100);
+    assert_int_equal(tx_stats.done, 1);
+    assert_int_equal(tx_stats.stall_cycles, 100);
+    assert_int_equal(tx_stats.first_stall, 300);
+    assert_int_equal(tx_stats.last_stall, 399);
+    assert_int_equal(rx_stats.words, 100);
+    assert_int_equal(rx_stats.done, 1);
+    assert_int_equal(rx_stats.stall_cycles, 0);
+    assert_int_equal(rx_stats.first_stall, UINT64_MAX);
+    assert_int_equal(rx_stats.last_stall, UINT64_MAX);
+
+    epio_free(epio);
+}
+
+static void stream_rx_overrun(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    loopback(epio, 0);
+
+    uint32_t tx[100];
+    uint32_t rx[10];
+    for (uint32_t ii = 0; ii < 100; ii++) {
+        tx[ii] = ii;
+    }
+    assert_int_equal(epio_stream_tx_buffer(epio, 0, 0, tx, 100), 0);
+    assert_int_equal(epio_stream_rx_buffer(epio, 0, 0, rx, 10), 0);
+
+    // Once the sink is full, 4 more words fill the RX FIFO, and the SM
+    // stalls pushing the next on cycle 44
+    epio_step_cycles(epio, 100);
+    assert_memory_equal(rx, tx, sizeof(rx));
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), MAX_FIFO_DEPTH);
+    epio_stream_stats_t tx_stats;
+    epio_stream_stats_t rx_stats;
+    epio_stream_stats(epio, 0, 0, &tx_stats, &rx_stats);
+    assert_int_equal(rx_stats.words, 10);
+    assert_int_equal(rx_stats.done, 1);
+    assert_int_equal(rx_stats.stall_cycles, 56);
+    assert_int_equal(rx_stats.first_stall, 44);
+    assert_int_equal(rx_stats.last_stall, 99);
+    assert_int_equal(tx_stats.words, 15 + MAX_FIFO_DEPTH);
+    assert_int_equal(tx_stats.done, 0);
+    assert_int_equal(tx_stats.stall_cycles, 0);
+
+    // Replacing the sink drains the RX FIFO immediately, and restarts its
+    // statistics
+    uint32_t more[10];
+    assert_int_equal(epio_stream_rx_buffer(epio, 0, 0, more, 10), 0);
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), 0);
+    assert_int_equal(more[0], 10);
+    assert_int_equal(more[3], 13);
+    epio_stream_stats(epio, 0, 0, NULL, &rx_stats);
+    assert_int_equal(rx_stats.words, 4);
+    assert_int_equal(rx_stats.stall_cycles, 0);
+
+    epio_free(epio);
+}
+
+typedef struct {
+    uint32_t next;
+    uint32_t limit;
+    uint32_t calls;
+} source_t;
+
+// Supplies up to limit words counting up, at most 2 per call
+static uint32_t fill_cb(void *ctx, epio_t *epio, uint32_t *words, uint32_t max) {
+    (void)epio;
+    source_t *source = (source_t *)ctx;
+    assert_true(max > 0 && max <= MAX_FIFO_DEPTH);
+    source->calls++;
+    uint32_t count = 0;
+    while ((count < max) && (count < 2) && (source->next < source->limit)) {
+        words[count++] = source->next++;
+    }
+    return count;
+}
+
+typedef struct {
+    uint32_t words[256];
+    uint32_t count;
+    uint32_t accept;
+} sink_t;
+
+// Accepts at most accept words per call
+static uint32_t drain_cb(void *ctx, epio_t *epio, const uint32_t *words, uint32_t count) {
+    (void)epio;
+    sink_t *sink = (sink_t *)ctx;
+    assert_true(count > 0 && count <= MAX_FIFO_DEPTH);
+    if (count > sink->accept) {
+        count = sink->accept;
+    }
+    for (uint32_t ii = 0; ii < count; ii++) {
+        sink->words[sink->count++] = words[ii];
+    }
+    return count;
+}
+
+static void stream_callbacks(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    loopback(epio, 0);
+
+    source_t source = { .limit = 50 };
+    sink_t sink = { .accept = 1 };
+    assert_int_equal(epio_stream_tx_callback(epio, 0, 0, fill_cb, &source), 0);
+    assert_int_equal(epio_stream_rx_callback(epio, 0, 0, drain_cb, &sink), 0);
+    assert_int_equal(epio_tx_fifo_depth(epio, 0, 0), 2);
+
+    epio_step_cycles(epio, 200);
+    assert_int_equal(sink.count, 50);
+    for (uint32_t ii = 0; ii < 50; ii++) {
+        assert_int_equal(sink.words[ii], ii);
+    }
+    epio_stream_stats_t tx_stats;
+    epio_stream_stats_t rx_stats;
+    epio_stream_stats(epio, 0, 0, &tx_stats, &rx_stats);
+    assert_int_equal(tx_stats.words, 50);
+    assert_int_equal(tx_stats.done, 0);
+    assert_int_equal(tx_stats.first_stall, 150);
+    assert_int_equal(rx_stats.words, 50);
+    assert_int_equal(rx_stats.stall_cycles, 0);
+
+    // Only called when there is room, or words to drain
+    uint32_t calls = source.calls;
+    epio_step_cycles(epio, 10);
+    assert_int_equal(source.calls, calls + 10);
+    epio_stream_detach(epio, 0, 0);
+    epio_stream_stats(epio, 0, 0, &tx_stats, &rx_stats);
+    assert_int_equal(tx_stats.words, 0);
+    assert_int_equal(tx_stats.first_stall, UINT64_MAX);
+    assert_int_equal(rx_stats.words, 0);
+    epio_step_cycles(epio, 10);
+    assert_int_equal(source.calls, calls + 10);
+
+    epio_free(epio);
+}
+
+static void stream_rx_lost(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Block 1 SM 3 pushes without blocking every cycle, to a sink which
+    // accepts nothing
+    epio_sm_reg_t reg = { .clkdiv = 0x00010000 };
+    epio_set_instr(epio, 1, 0, 0x8000);     // push noblock
+    epio_set_sm_reg(epio, 1, 3, &reg);
+    epio_enable_sm(epio, 1, 3);
+    sink_t sink = { .accept = 0 };
+    assert_int_equal(epio_stream_rx_callback(epio, 1, 3, drain_cb, &sink), 0);
+
+    // A check on the same SM sees the same events
+    assert_int_equal(epio_check_rx_overflow(epio, 1, 3), 0);
+    epio_step_cycles(epio, 10);
+    epio_stream_stats_t rx_stats;
+    epio_stream_stats(epio, 1, 3, NULL, &rx_stats);
+    assert_int_equal(rx_stats.words, 0);
+    assert_int_equal(rx_stats.stall_cycles, 6);
+    assert_int_equal(rx_stats.first_stall, 4);
+    assert_int_equal(epio_check_violations(epio, NULL, 0), 6);
+
+    // Once accepted, after the FIFO was found full on the next cycle, no
+    // more are lost
+    sink.accept = MAX_FIFO_DEPTH;
+    epio_step_cycles(epio, 10);
+    epio_stream_stats(epio, 1, 3, NULL, &rx_stats);
+    assert_int_equal(rx_stats.words, 13);
+    assert_int_equal(rx_stats.stall_cycles, 7);
+    assert_int_equal(rx_stats.last_stall, 10);
+
+    // Reset detaches streams
+    epio_reset_cycle_count(epio);
+    epio_stream_stats(epio, 1, 3, NULL, &rx_stats);
+    assert_int_equal(rx_stats.words, 0);
+    assert_int_equal(epio_stream_rx_callback(epio, 1, 3, drain_cb, &sink), 0);
+    epio_reset(epio);
+    epio_stream_stats(epio, 1, 3, NULL, &rx_stats);
+    assert_int_equal(rx_stats.words, 0);
+
+    epio_free(epio);
+}
+
+static void stream_empty_buffers(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Empty buffers are done immediately, and detaching one SM's streams
+    // leaves another's
+    assert_int_equal(epio_stream_tx_buffer(epio, 2, 1, NULL, 0), 0);
+    assert_int_equal(epio_stream_rx_buffer(epio, 2, 2, NULL, 0), 0);
+    epio_stream_detach(epio, 2, 0);
+    epio_stream_detach(epio, 2, 1);
+    epio_stream_stats_t tx_stats;
+    epio_stream_stats_t rx_stats;
+    epio_stream_stats(epio, 2, 2, &tx_stats, &rx_stats);
+    assert_int_equal(tx_stats.done, 0);
+    assert_int_equal(rx_stats.done, 1);
+    epio_push_rx_fifo(epio, 2, 2, 5);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_rx_fifo_depth(epio, 2, 2), 1);
+    epio_stream_detach(epio, 2, 2);
+    epio_stream_detach(epio, 2, 2);
+
+    epio_free(epio);
+}
+
+static void stream_history(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    loopback(epio, 0);
+    assert_int_equal(epio_history_enable(epio, 16), 0);
+
+    uint32_t tx[20];
+    uint32_t rx[20] = { 0 };
+    for (uint32_t ii = 0; ii < 20; ii++) {
+        tx[ii] = ii + 1;
+    }
+    assert_int_equal(epio_stream_tx_buffer(epio, 0, 0, tx, 20), 0);
+    assert_int_equal(epio_stream_rx_buffer(epio, 0, 0, rx, 20), 0);
+    epio_step_cycles(epio, 10);
+
+    // Streamed words aren't recorded, so those cycles can't be replayed
+    assert_int_equal(epio_seek(epio, 5), -1);
+    assert_int_equal(epio_seek(epio, 10), -1);
+    epio_stream_detach(epio, 0, 0);
+    assert_int_equal(epio_seek(epio, 5), -1);
+    assert_int_equal(epio_step_back(epio, 1), -1);
+    assert_int_equal(epio_get_cycle_count(epio), 10);
+
+    // But later cycles can, and return to the recorded state
+    uint64_t hashes[31];
+    hashes[0] = epio_state_hash(epio);
+    for (uint32_t ii = 1; ii <= 30; ii++) {
+        epio_step_cycles(epio, 1);
+        hashes[ii] = epio_state_hash(epio);
+    }
+    for (uint32_t ii = 0; ii <= 30; ii += 5) {
+        assert_int_equal(epio_seek(epio, 10 + ii), 0);
+        assert_int_equal(epio_state_hash(epio), hashes[ii]);
+    }
+    assert_int_equal(epio_rx_fifo_depth(epio, 0, 0), MAX_FIFO_DEPTH);
+
+    epio_free(epio);
+}
+
+static void stream_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    uint32_t words[4] = { 0 };
+    source_t source = { 0 };
+    sink_t sink = { 0 };
+
+    expect_assert_failure(epio_stream_tx_buffer(NULL, 0, 0, words, 4));
+    expect_assert_failure(epio_stream_tx_buffer(epio, NUM_PIO_BLOCKS, 0, words, 4));
+    expect_assert_failure(epio_stream_tx_buffer(epio, 0, NUM_SMS_PER_BLOCK, words, 4));
+    expect_assert_failure(epio_stream_tx_buffer(epio, 0, 0, NULL, 4));
+    expect_assert_failure(epio_stream_tx_callback(NULL, 0, 0, fill_cb, &source));
+    expect_assert_failure(epio_stream_tx_callback(epio, NUM_PIO_BLOCKS, 0, fill_cb, &source));
+    expect_assert_failure(epio_stream_tx_callback(epio, 0, 0, NULL, &source));
+    expect_assert_failure(epio_stream_rx_buffer(NULL, 0, 0, words, 4));
+    expect_assert_failure(epio_stream_rx_buffer(epio, 0, NUM_SMS_PER_BLOCK, words, 4));
+    expect_assert_failure(epio_stream_rx_buffer(epio, 0, 0, NULL, 4));
+    expect_assert_failure(epio_stream_rx_callback(NULL, 0, 0, drain_cb, &sink));
+    expect_assert_failure(epio_stream_rx_callback(epio, NUM_PIO_BLOCKS, 0, drain_cb, &sink));
+    expect_assert_failure(epio_stream_rx_callback(epio, 0, 0, NULL, &sink));
+    expect_assert_failure(epio_stream_stats(NULL, 0, 0, NULL, NULL));
+    expect_assert_failure(epio_stream_stats(epio, NUM_PIO_BLOCKS, 0, NULL, NULL));
+    expect_assert_failure(epio_stream_detach(NULL, 0, 0));
+    expect_assert_failure(epio_stream_detach(epio, 0, NUM_SMS_PER_BLOCK));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(stream_buffers),
+        cmocka_unit_test(stream_rx_overrun),
+        cmocka_unit_test(stream_callbacks),
+        cmocka_unit_test(stream_rx_lost),
+        cmocka_unit_test(stream_empty_buffers),
+        cmocka_unit_test(stream_history),
+        cmocka_unit_test(stream_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
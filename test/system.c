@@ -0,0 +1,224 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for systems of connected chips from epio_system.c
+
+#define APIO_LOG_IMPL
+#include "test.h"
+
+static uint8_t level(epio_system_t *sys, uint8_t chip, uint8_t gpio) {
+    return (epio_read_pin_states(epio_system_chip(sys, chip)) >> gpio) & 1;
+}
+
+static void drive_low(epio_system_t *sys, uint8_t chip, uint8_t gpio, uint8_t low) {
+    epio_t *epio = epio_system_chip(sys, chip);
+    if (low) {
+        epio_set_gpio_output(epio, gpio);
+        epio_set_gpio_output_level(epio, gpio, 0);
+    } else {
+        epio_set_gpio_input(epio, gpio);
+    }
+}
+
+// Creates a system of num_chips idle chips
+static epio_system_t *create_system(uint8_t num_chips) {
+    epio_system_t *sys = epio_system_create();
+    assert_non_null(sys);
+    for (uint8_t ii = 0; ii < num_chips; ii++) {
+        epio_t *epio = epio_init();
+        assert_non_null(epio);
+        assert_int_equal(epio_system_add(sys, epio), ii);
+        assert_ptr_equal(epio_system_chip(sys, ii), epio);
+    }
+    return sys;
+}
+
+static void system_wired_and(void **state) {
+    (void)state;
+    epio_system_t *sys = create_system(2);
+
+    // Undriven nets are pulled up
+    epio_system_connect(sys, 0, 0, 1, 0);
+    epio_system_connect(sys, 0, 2, 0, 0);
+    assert_int_equal(level(sys, 0, 2), 1);
+    assert_int_equal(level(sys, 1, 0), 1);
+
+    // Either chip driving low pulls the whole net low, on the next cycle
+    drive_low(sys, 0, 0, 1);
+    assert_int_equal(level(sys, 1, 0), 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 1, 0), 0);
+    assert_int_equal(level(sys, 0, 2), 0);
+
+    // Driving high doesn't override another chip driving low
+    epio_set_gpio_output(epio_system_chip(sys, 1), 0);
+    epio_set_gpio_output_level(epio_system_chip(sys, 1), 0, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 2), 0);
+    drive_low(sys, 0, 0, 0);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 0), 1);
+    assert_int_equal(level(sys, 0, 2), 1);
+    drive_low(sys, 1, 0, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 0), 0);
+    assert_int_equal(level(sys, 0, 2), 0);
+
+    // Connecting resolves the net immediately
+    epio_system_connect(sys, 1, 5, 0, 2);
+    assert_int_equal(level(sys, 1, 5), 0);
+
+    // Chips step in lockstep
+    epio_system_step_cycles(sys, 10);
+    assert_int_equal(epio_get_cycle_count(epio_system_chip(sys, 0)), 14);
+    assert_int_equal(epio_get_cycle_count(epio_system_chip(sys, 1)), 14);
+
+    epio_system_free(sys);
+}
+
+static void system_sm_link(void **state) {
+    (void)state;
+    epio_system_t *sys = create_system(2);
+
+    // Chip 0 SM 0 drives GPIO 0 high for 4 cycles, then low for 4 cycles
+    epio_t *chip0 = epio_system_chip(sys, 0);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12),
+        .pinctrl = (1 << 26),
+    };
+    epio_set_instr(chip0, 0, 0, 0xE301);    // set pins, 1 [3]
+    epio_set_instr(chip0, 0, 1, 0xE300);    // set pins, 0 [3]
+    epio_set_sm_reg(chip0, 0, 0, &reg);
+    epio_set_gpio_output_control(chip0, 0, 0);
+    epio_set_gpio_output(chip0, 0);
+    epio_enable_sm(chip0, 0, 0);
+
+    // Chip 1 SM 0 copies GPIO 5 to GPIO 6
+    epio_t *chip1 = epio_system_chip(sys, 1);
+    reg.execctrl = (3 << 12);
+    reg.pinctrl = (1 << 26) | (6 << 5);
+    epio_set_instr(chip1, 0, 0, 0x2005);    // wait 0 gpio 5
+    epio_set_instr(chip1, 0, 1, 0xE000);    // set pins, 0
+    epio_set_instr(chip1, 0, 2, 0x2085);    // wait 1 gpio 5
+    epio_set_instr(chip1, 0, 3, 0xE001);    // set pins, 1
+    epio_set_sm_reg(chip1, 0, 0, &reg);
+    epio_set_gpio_output_control(chip1, 6, 0);
+    epio_set_gpio_output(chip1, 6);
+    epio_enable_sm(chip1, 0, 0);
+
+    // Chip 0 GPIO 0 goes to chip 1 GPIO 5, and chip 1 GPIO 6 back to chip
+    // 0 GPIO 7
+    epio_system_connect(sys, 0, 0, 1, 5);
+    epio_system_connect(sys, 1, 6, 0, 7);
+
+    // Chip 0 GPIO 0 falls on cycle 4, which chip 1 sees on cycle 5, and
+    // follows on cycle 6, which chip 0 sees from cycle 7
+    epio_system_step_cycles(sys, 6);
+    assert_int_equal(level(sys, 1, 5), 0);
+    assert_int_equal(level(sys, 0, 7), 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 7), 0);
+
+    // And rises on cycle 8, followed on cycle 10
+    epio_system_step_cycles(sys, 3);
+    assert_int_equal(level(sys, 0, 7), 0);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 7), 1);
+
+    epio_system_free(sys);
+}
+
+static void system_merge(void **state) {
+    (void)state;
+    epio_system_t *sys = create_system(3);
+
+    // Three nets
+    epio_system_connect(sys, 0, 1, 1, 1);
+    epio_system_connect(sys, 0, 2, 1, 2);
+    epio_system_connect(sys, 0, 3, 1, 3);
+
+    // Joining a GPIO to an existing net, from either side, and connecting
+    // GPIOs already in the same net
+    epio_system_connect(sys, 2, 1, 0, 1);
+    epio_system_connect(sys, 1, 3, 2, 3);
+    epio_system_connect(sys, 0, 1, 1, 1);
+
+    // Merging the second net into the first, which moves the third
+    epio_system_connect(sys, 0, 1, 0, 2);
+    drive_low(sys, 1, 2, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 1), 0);
+    assert_int_equal(level(sys, 0, 2), 0);
+    assert_int_equal(level(sys, 1, 1), 0);
+    assert_int_equal(level(sys, 2, 1), 0);
+    assert_int_equal(level(sys, 0, 3), 1);
+    assert_int_equal(level(sys, 2, 3), 1);
+    drive_low(sys, 0, 3, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 2, 3), 0);
+
+    // Merging the first net into the last, which is then moved into the
+    // first's slot
+    epio_system_connect(sys, 2, 3, 2, 1);
+    drive_low(sys, 1, 2, 0);
+    drive_low(sys, 0, 3, 0);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 1), 1);
+    assert_int_equal(level(sys, 2, 3), 1);
+    drive_low(sys, 1, 3, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 0, 1), 0);
+    assert_int_equal(level(sys, 2, 1), 0);
+    assert_int_equal(level(sys, 0, 2), 0);
+
+    // Merging the last net into another
+    epio_system_connect(sys, 0, 10, 1, 10);
+    epio_system_connect(sys, 0, 11, 1, 11);
+    epio_system_connect(sys, 1, 1, 1, 11);
+    assert_int_equal(level(sys, 0, 11), 0);
+    assert_int_equal(level(sys, 0, 10), 1);
+    drive_low(sys, 0, 10, 1);
+    epio_system_step_cycles(sys, 1);
+    assert_int_equal(level(sys, 1, 10), 0);
+
+    epio_system_free(sys);
+}
+
+static void system_invalid_args(void **state) {
+    (void)state;
+    epio_system_t *sys = create_system(EPIO_SYSTEM_MAX_CHIPS);
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    assert_int_equal(epio_system_add(sys, epio), -1);
+    expect_assert_failure(epio_system_add(NULL, epio));
+    expect_assert_failure(epio_system_add(sys, NULL));
+    expect_assert_failure(epio_system_add(sys, epio_system_chip(sys, 3)));
+    expect_assert_failure(epio_system_chip(NULL, 0));
+    expect_assert_failure(epio_system_chip(sys, EPIO_SYSTEM_MAX_CHIPS));
+    expect_assert_failure(epio_system_connect(NULL, 0, 0, 1, 0));
+    expect_assert_failure(epio_system_connect(sys, EPIO_SYSTEM_MAX_CHIPS, 0, 1, 0));
+    expect_assert_failure(epio_system_connect(sys, 0, 0, EPIO_SYSTEM_MAX_CHIPS, 0));
+    expect_assert_failure(epio_system_connect(sys, 0, NUM_GPIOS, 1, 0));
+    expect_assert_failure(epio_system_connect(sys, 0, 0, 1, NUM_GPIOS));
+    expect_assert_failure(epio_system_step_cycles(NULL, 1));
+    expect_assert_failure(epio_system_free(NULL));
+
+    epio_free(epio);
+    epio_system_free(sys);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(system_wired_and),
+        cmocka_unit_test(system_sm_link),
+        cmocka_unit_test(system_merge),
+        cmocka_unit_test(system_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,177 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for templates from epio_template.c
+
+#define APIO_LOG_IMPL
+#include <string.h>
+#include "test.h"
+
+static void template_clone_matches_source(void **state) {
+    (void)state;
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    assert_non_null(tmpl);
+
+    epio_t *epio = epio_from_template(tmpl);
+    assert_non_null(epio);
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_sram_resident_pages(epio), 2);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xAABBCCDD);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 5), 0x11223344);
+    assert_int_equal(epio_tx_fifo_depth(epio, 1, 2), 1);
+
+    // And it runs like the source
+    epio_step_cycles(src, 3);
+    epio_step_cycles(epio, 3);
+    assert_int_equal(epio_read_pin_states(epio), epio_read_pin_states(src));
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+
+    epio_free(epio);
+    epio_free(src);
+    epio_template_free(tmpl);
+}
+
+static void template_independent_of_source(void **state) {
+    (void)state;
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    assert_non_null(tmpl);
+
+    // Changing or freeing the source must not affect the template
+    epio_sram_write_word(src, 0x20000000, 0);
+    epio_free(src);
+
+    epio_t *epio = epio_from_template(tmpl);
+    assert_non_null(epio);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xAABBCCDD);
+
+    epio_free(epio);
+    epio_template_free(tmpl);
+}
+
+static void template_sram_copy_on_write(void **state) {
+    (void)state;
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    epio_free(src);
+
+    epio_t *a = epio_from_template(tmpl);
+    epio_t *b = epio_from_template(tmpl);
+    assert_non_null(a);
+    assert_non_null(b);
+
+    // Writes to one instance are not seen by another, or by the template
+    epio_sram_write_byte(a, 0x20000001, 0x55);
+    assert_int_equal(epio_sram_read_word(a, 0x20000000), 0xAABB55DD);
+    assert_int_equal(epio_sram_read_word(b, 0x20000000), 0xAABBCCDD);
+    assert_int_equal(epio_sram_resident_pages(a), 2);
+
+    // A second write to the now private page
+    epio_sram_write_halfword(a, 0x20000002, 0x6677);
+    assert_int_equal(epio_sram_read_word(a, 0x20000000), 0x667755DD);
+
+    // New pages are still allocated on first write
+    epio_sram_write_word(b, 0x20000000 + SRAM_PAGE_SIZE * 9, 1);
+    assert_int_equal(epio_sram_resident_pages(b), 3);
+
+    epio_free(a);
+    epio_free(b);
+
+    epio_t *c = epio_from_template(tmpl);
+    assert_int_equal(epio_sram_read_word(c, 0x20000000), 0xAABBCCDD);
+    assert_int_equal(epio_sram_resident_pages(c), 2);
+    epio_free(c);
+
+    epio_template_free(tmpl);
+}
+
+static void template_reset_drops_shared_pages(void **state) {
+    (void)state;
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    epio_free(src);
+
+    epio_t *epio = epio_from_template(tmpl);
+    assert_non_null(epio);
+
+    // Make one page private, leaving the other shared
+    epio_sram_write_word(epio, 0x20000000, 0x01020304);
+    epio_reset(epio);
+
+    assert_int_equal(epio_sram_resident_pages(epio), 1);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 5), 0);
+    assert_false(epio_is_sm_enabled(epio, 0, 0));
+    epio_free(epio);
+
+    // The template is unaffected
+    epio = epio_from_template(tmpl);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 5), 0x11223344);
+    epio_free(epio);
+
+    epio_template_free(tmpl);
+}
+
+static void template_from_clone(void **state) {
+    (void)state;
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+    epio_free(src);
+
+    // A template made from an instance which shares pages with another
+    // template owns its own copies
+    epio_t *clone = epio_from_template(tmpl);
+    epio_template_t *tmpl2 = epio_template_from_epio(clone);
+    assert_non_null(tmpl2);
+    epio_free(clone);
+    epio_template_free(tmpl);
+
+    epio_t *epio = epio_from_template(tmpl2);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xAABBCCDD);
+    epio_free(epio);
+    epio_template_free(tmpl2);
+}
+
+static void template_clone_in(void **state) {
+    (void)state;
+    static _Alignas(max_align_t) uint8_t buffer[sizeof(epio_t)];
+    epio_t *src = configured_epio();
+    epio_template_t *tmpl = epio_template_from_epio(src);
+
+    epio_t *epio = epio_from_template_in(tmpl, buffer, sizeof(buffer));
+    assert_ptr_equal(epio, buffer);
+    assert_memory_equal(epio, src, EPIO_MACHINE_STATE_SIZE);
+    assert_int_equal(epio_sram_read_word(epio, 0x20000000), 0xAABBCCDD);
+    epio_free(epio);
+
+    epio_free(src);
+    epio_template_free(tmpl);
+}
+
+static void template_invalid(void **state) {
+    (void)state;
+    static _Alignas(max_align_t) uint8_t buffer[sizeof(epio_t)];
+
+    expect_assert_failure(epio_template_from_epio(NULL));
+    expect_assert_failure(epio_from_template(NULL));
+    expect_assert_failure(epio_from_template_in(NULL, buffer, sizeof(buffer)));
+    expect_assert_failure(epio_template_free(NULL));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(template_clone_matches_source),
+        cmocka_unit_test(template_independent_of_source),
+        cmocka_unit_test(template_sram_copy_on_write),
+        cmocka_unit_test(template_reset_drops_shared_pages),
+        cmocka_unit_test(template_from_clone),
+        cmocka_unit_test(template_clone_in),
+        cmocka_unit_test(template_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
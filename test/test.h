@@ -4,10 +4,121 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <cmocka.h>
 #include "epio_priv.h"
 
 extern const struct CMUnitTest init_tests[];
 extern const size_t num_init_tests;
 
+// Shared fixtures.  Each returns or configures an instance with block 0 SM 0
+// running a small program.
+
+// Block 0 SM 0 drives GPIO 0 high for 4 cycles, then low for 4 cycles, so
+// it rises every 8 cycles, from cycle 8
+static inline epio_t *square_wave(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12),              // wrap top 1, wrap bottom 0
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE301);     // set pins, 1 [3]
+    epio_set_instr(epio, 0, 1, 0xE300);     // set pins, 0 [3]
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_set_gpio_output(epio, 0);
+    epio_enable_sm(epio, 0, 0);
+    return epio;
+}
+
+// Block 0 SM 0 toggles GPIO 0 every cycle
+static inline epio_t *toggling_epio(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12),              // wrap top 1, wrap bottom 0
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE001);     // set pins, 1
+    epio_set_instr(epio, 0, 1, 0xE000);     // set pins, 0
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_set_gpio_output(epio, 0);
+    epio_enable_sm(epio, 0, 0);
+    return epio;
+}
+
+// Configures block 0 SM 0 to wait for GPIO 5 to go low, then decrement X
+// every cycle
+static inline void wait_then_count(epio_t *epio) {
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12) | (1 << 7),   // wrap top 1, wrap bottom 1
+    };
+    epio_set_instr(epio, 0, 0, 0x2005);     // wait 0 gpio 5
+    epio_set_instr(epio, 0, 1, 0x0041);     // jmp x--, 1
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_enable_sm(epio, 0, 0);
+}
+
+// Configures block 0 SM 0 to toggle GPIO 0, and preloads some SRAM
+static inline epio_t *configured_epio(void) {
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    epio_sm_reg_t reg = {
+        .clkdiv = 0x00010000,
+        .execctrl = (1 << 12) | (0 << 7),   // wrap top 1, wrap bottom 0
+        .shiftctrl = 0,
+        .pinctrl = (1 << 26),               // set count 1, set base 0
+    };
+    epio_set_instr(epio, 0, 0, 0xE001); // set pins, 1
+    epio_set_instr(epio, 0, 1, 0xE000); // set pins, 0
+    epio_set_sm_reg(epio, 0, 0, &reg);
+    epio_set_gpio_output_control(epio, 0, 0);
+    epio_exec_instr_sm(epio, 0, 0, 0xE081); // set pindirs, 1
+    epio_enable_sm(epio, 0, 0);
+    epio_push_tx_fifo(epio, 1, 2, 0x12345678);
+
+    epio_sram_write_word(epio, 0x20000000, 0xAABBCCDD);
+    epio_sram_write_word(epio, 0x20000000 + SRAM_PAGE_SIZE * 5, 0x11223344);
+
+    return epio;
+}
+
+// Writes size bytes of data to path
+static inline void write_file(const char *path, const void *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    assert_non_null(file);
+    if (size > 0) {
+        assert_int_equal(fwrite(data, size, 1, file), 1);
+    }
+    fclose(file);
+}
+
+// Writes text to path
+static inline void write_text(const char *path, const char *text) {
+    write_file(path, text, strlen(text));
+}
+
+// Reads path, returning its contents, NUL terminated, and their size
+static inline char *read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    assert_non_null(file);
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc(*size + 1);
+    assert_non_null(data);
+    assert_int_equal(fread(data, 1, *size, file), *size);
+    data[*size] = '\0';
+    fclose(file);
+    return data;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,447 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// Unit tests for the VCD trace writer from epio_trace.c
+
+#define APIO_LOG_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+#define TRACE_PATH  "/tmp/epio_test_trace.vcd"
+
+// toggling_epio() at 1GHz, so each cycle is 1000ps, with GPIO 0 left as an
+// input until a test sets its pindir
+static epio_t *toggling_1ghz(void) {
+    epio_t *epio = toggling_epio();
+    epio_set_sys_clock_hz(epio, 1000000000);
+    epio_set_gpio_input(epio, 0);
+    return epio;
+}
+
+static void trace_writes_changes(void **state) {
+    (void)state;
+    epio_t *epio = toggling_1ghz();
+    epio_trace_config_t config = {
+        .gpio_levels = 0x3,
+        .gpio_dirs = 0x1,
+        .sms = 0x1,
+        .sm_signals = EPIO_TRACE_SM_PC | EPIO_TRACE_SM_X | EPIO_TRACE_SM_STALLED,
+        .irq_blocks = 0x1,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_step_cycles(epio, 1);
+    epio_exec_instr_sm(epio, 0, 0, 0xE081);  // set pindirs, 1
+    epio_set_block_irq(epio, 0, 3);
+    epio_step_cycles(epio, 3);
+    epio_drive_gpios_ext(epio, 0x2, 0);
+    epio_step_cycles(epio, 1);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    size_t size;
+    char *text = read_file(TRACE_PATH, &size);
+    const char *expected =
+        "$version epio $end\n"
+        "$timescale 1ps $end\n"
+        "$scope module epio $end\n"
+        "$scope module gpio $end\n"
+        "$var wire 1 ! gpio0 $end\n"
+        "$var wire 1 \" gpio0_oe $end\n"
+        "$var wire 1 # gpio1 $end\n"
+        "$upscope $end\n"
+        "$scope module pio0 $end\n"
+        "$var wire 8 $ irq [7:0] $end\n"
+        "$scope module sm0 $end\n"
+        "$var wire 5 % pc [4:0] $end\n"
+        "$var wire 32 & x [31:0] $end\n"
+        "$var wire 1 ' stalled $end\n"
+        "$upscope $end\n"
+        "$upscope $end\n"
+        "$upscope $end\n"
+        "$enddefinitions $end\n"
+        "#0\n"
+        "$dumpvars\n"
+        "1!\n"
+        "0\"\n"
+        "1#\n"
+        "b0 $\n"
+        "b0 %\n"
+        "b0 &\n"
+        "0'\n"
+        "$end\n"
+        "#1000\n"
+        "b1 %\n"
+        "1\"\n"
+        "b1000 $\n"
+        "#2000\n"
+        "0!\n"
+        "b0 %\n"
+        "#3000\n"
+        "1!\n"
+        "b1 %\n"
+        "#4000\n"
+        "0!\n"
+        "b0 %\n"
+        "0#\n"
+        "#5000\n"
+        "1!\n"
+        "b1 %\n";
+    assert_string_equal(text, expected);
+    free(text);
+
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+static void trace_all_signals(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_set_instr(epio, 2, 1, 0x20C7);      // wait 1 irq 7
+    epio_trace_config_t config = {
+        .gpio_dirs = 1ULL << 47,
+        .sms = 1 << (2 * NUM_SMS_PER_BLOCK + 3),
+        .sm_signals = EPIO_TRACE_SM_ALL,
+        .irq_blocks = 1 << 2,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+
+    // Changes made between cycles are written at that cycle's timestamp
+    epio_set_gpio_output(epio, 47);
+    epio_set_block_irq(epio, 2, 3);
+    epio_push_tx_fifo(epio, 2, 3, 1);
+    epio_push_tx_fifo(epio, 2, 3, 2);
+    epio_push_rx_fifo(epio, 2, 3, 3);
+    epio_exec_instr_sm(epio, 2, 3, 0xE021);  // set x, 1
+    epio_exec_instr_sm(epio, 2, 3, 0xE042);  // set y, 2
+    epio_exec_instr_sm(epio, 2, 3, 0x4001);  // in pins, 1
+    epio_exec_instr_sm(epio, 2, 3, 0x80A0);  // pull block
+    epio_exec_instr_sm(epio, 2, 3, 0x0001);  // jmp 1
+    epio_enable_sm(epio, 2, 3);
+    epio_step_cycles(epio, 2);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    size_t size;
+    char *text = read_file(TRACE_PATH, &size);
+    const char *expected =
+        "$version epio $end\n"
+        "$timescale 1ps $end\n"
+        "$scope module epio $end\n"
+        "$scope module gpio $end\n"
+        "$var wire 1 ! gpio47_oe $end\n"
+        "$upscope $end\n"
+        "$scope module pio2 $end\n"
+        "$var wire 8 \" irq [7:0] $end\n"
+        "$scope module sm3 $end\n"
+        "$var wire 5 # pc [4:0] $end\n"
+        "$var wire 32 $ x [31:0] $end\n"
+        "$var wire 32 % y [31:0] $end\n"
+        "$var wire 6 & isr_count [5:0] $end\n"
+        "$var wire 6 ' osr_count [5:0] $end\n"
+        "$var wire 4 ( tx_level [3:0] $end\n"
+        "$var wire 4 ) rx_level [3:0] $end\n"
+        "$var wire 1 * stalled $end\n"
+        "$upscope $end\n"
+        "$upscope $end\n"
+        "$upscope $end\n"
+        "$enddefinitions $end\n"
+        "#0\n"
+        "$dumpvars\n"
+        "0!\n"
+        "b0 \"\n"
+        "b0 #\n"
+        "b0 $\n"
+        "b0 %\n"
+        "b0 &\n"
+        "b100000 '\n"
+        "b0 (\n"
+        "b0 )\n"
+        "0*\n"
+        "$end\n";
+    assert_memory_equal(text, expected, strlen(expected));
+
+    // Everything but the stall changed before the first cycle
+    assert_string_equal(text + strlen(expected),
+        "1!\n"
+        "b1000 \"\n"
+        "b1 #\n"
+        "b1 $\n"
+        "b10 %\n"
+        "b1 &\n"
+        "b0 '\n"
+        "b1 (\n"
+        "b1 )\n"
+        "#6667\n"
+        "1*\n");
+    free(text);
+
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+static void trace_replays_as_stimulus(void **state) {
+    (void)state;
+
+    // At the default 150MHz, timestamps are not whole picoseconds
+    epio_t *src = toggling_1ghz();
+    epio_set_sys_clock_hz(src, EPIO_DEFAULT_SYS_CLOCK_HZ);
+    epio_exec_instr_sm(src, 0, 0, 0xE081);  // set pindirs, 1
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+    };
+    assert_int_equal(epio_trace_start(src, TRACE_PATH, &config), 0);
+    uint64_t levels[100];
+    for (int ii = 0; ii < 100; ii++) {
+        levels[ii] = epio_read_pin_states(src) & 1;
+        epio_step_cycles(src, 1);
+    }
+    assert_int_equal(epio_trace_stop(src), 0);
+    epio_free(src);
+
+    epio_stimulus_t *stim = epio_stimulus_open_vcd(TRACE_PATH);
+    assert_non_null(stim);
+    assert_int_equal(epio_stimulus_map(stim, "gpio0", 0), 0);
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_stimulus_attach(epio, stim);
+    for (int ii = 0; ii < 100; ii++) {
+        assert_int_equal(epio_read_pin_states(epio) & 1, levels[ii]);
+        epio_step_cycles(epio, 1);
+    }
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+static void trace_large_output(void **state) {
+    (void)state;
+    epio_t *epio = toggling_1ghz();
+    epio_exec_instr_sm(epio, 0, 0, 0xE081);  // set pindirs, 1
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+        .sms = 0x1,
+        .sm_signals = EPIO_TRACE_SM_PC,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_step_cycles(epio, 200000);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    size_t size;
+    char *text = read_file(TRACE_PATH, &size);
+    assert_true(size > 2 * 1024 * 1024);
+    const char *last = strstr(text, "#200000000\n");
+    assert_non_null(last);
+    assert_string_equal(last, "#200000000\n0!\nb0 \"\n");
+    free(text);
+
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+static void trace_idle_is_small(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_trace_config_t config = {
+        .gpio_levels = GPIO_ALL_MASK,
+        .gpio_dirs = GPIO_ALL_MASK,
+        .sms = 0xFFF,
+        .sm_signals = EPIO_TRACE_SM_ALL,
+        .irq_blocks = 0x7,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    size_t size;
+    assert_int_equal(epio_trace_stop(epio), 0);
+    char *text = read_file(TRACE_PATH, &size);
+    free(text);
+
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_step_cycles(epio, 100000);
+    assert_int_equal(epio_trace_stop(epio), 0);
+    size_t idle_size;
+    text = read_file(TRACE_PATH, &idle_size);
+    assert_int_equal(idle_size, size);
+    free(text);
+
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+static void trace_with_history(void **state) {
+    (void)state;
+    epio_t *epio = toggling_1ghz();
+    epio_exec_instr_sm(epio, 0, 0, 0xE081);  // set pindirs, 1
+    assert_int_equal(epio_history_enable(epio, 4), 0);
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_step_cycles(epio, 10);
+
+    // Replayed cycles are not written again, and stepping on continues from
+    // the last written cycle
+    assert_int_equal(epio_seek(epio, 3), 0);
+    epio_step_cycles(epio, 9);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    size_t size;
+    char *text = read_file(TRACE_PATH, &size);
+    unsigned long long last = 0;
+    int count = 0;
+    for (const char *hash = strchr(text, '#'); hash != NULL; hash = strchr(hash + 1, '#')) {
+        unsigned long long time = strtoull(hash + 1, NULL, 10);
+        assert_true((count == 0) || (time > last));
+        last = time;
+        count++;
+    }
+    assert_int_equal(last, 12000);
+    // GPIO 0 is already high at cycle 1, so changes at cycles 0 and 2-12
+    assert_int_equal(count, 12);
+    free(text);
+
+    epio_free(epio);
+    unlink(TRACE_PATH);
+}
+
+// Traces GPIO 0 toggling for 10 cycles, then idle for 10 more, seeking back
+// into the idle cycles and stepping on to the end if seek_to is non-zero,
+// returning the trace written
+static char *trace_toggle_then_idle(uint64_t seek_to, size_t *size) {
+    epio_t *epio = toggling_1ghz();
+    epio_exec_instr_sm(epio, 0, 0, 0xE081);  // set pindirs, 1
+    assert_int_equal(epio_history_enable(epio, 4), 0);
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+    };
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_step_cycles(epio, 10);
+    epio_disable_sm(epio, 0, 0);
+    epio_step_cycles(epio, 10);
+    if (seek_to != 0) {
+        assert_int_equal(epio_seek(epio, seek_to), 0);
+        epio_step_cycles(epio, 20 - seek_to);
+    }
+    assert_int_equal(epio_trace_stop(epio), 0);
+    epio_free(epio);
+
+    char *text = read_file(TRACE_PATH, size);
+    unlink(TRACE_PATH);
+    return text;
+}
+
+static void trace_seek_after_last_change(void **state) {
+    (void)state;
+
+    // Cycles replayed after the last change was written are still not
+    // written again
+    size_t ref_size, size;
+    char *ref = trace_toggle_then_idle(0, &ref_size);
+    char *text = trace_toggle_then_idle(15, &size);
+    assert_int_equal(size, ref_size);
+    assert_string_equal(text, ref);
+
+    free(ref);
+    free(text);
+}
+
+static void trace_restart_and_stop(void **state) {
+    (void)state;
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+    };
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+
+    // Stopping with no trace does nothing
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    // Starting again restarts the trace, and reset and resetting the cycle
+    // count stop it
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_reset(epio);
+    assert_int_equal(epio_trace_stop(epio), 0);
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_reset_cycle_count(epio);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    // Freeing an instance stops its trace
+    assert_int_equal(epio_trace_start(epio, TRACE_PATH, &config), 0);
+    epio_free(epio);
+
+    size_t size;
+    char *text = read_file(TRACE_PATH, &size);
+    assert_non_null(strstr(text, "$enddefinitions $end\n#0\n$dumpvars\n1!\n$end\n"));
+    free(text);
+    unlink(TRACE_PATH);
+}
+
+static void trace_write_failures(void **state) {
+    (void)state;
+    epio_trace_config_t config = {
+        .gpio_levels = 0x1,
+    };
+    epio_t *epio = toggling_1ghz();
+    epio_exec_instr_sm(epio, 0, 0, 0xE081);  // set pindirs, 1
+
+    assert_int_equal(epio_trace_start(epio, "/nonexistent/dir/trace.vcd", &config), -1);
+    assert_int_equal(epio_trace_stop(epio), 0);
+
+    // Failing to write the buffer, or when closing
+    assert_int_equal(epio_trace_start(epio, "/dev/full", &config), 0);
+    epio_step_cycles(epio, 200000);
+    assert_int_equal(epio_trace_stop(epio), -1);
+    assert_int_equal(epio_trace_start(epio, "/dev/full", &config), 0);
+    assert_int_equal(epio_trace_stop(epio), -1);
+
+    epio_free(epio);
+}
+
+static void trace_invalid_args(void **state) {
+    (void)state;
+    epio_t *epio = epio_init();
+    assert_non_null(epio);
+    epio_trace_config_t config = { 0 };
+
+    expect_assert_failure(epio_trace_start(NULL, TRACE_PATH, &config));
+    expect_assert_failure(epio_trace_start(epio, NULL, &config));
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, NULL));
+    config.gpio_levels = 1ULL << NUM_GPIOS;
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, &config));
+    config.gpio_levels = 0;
+    config.gpio_dirs = 1ULL << NUM_GPIOS;
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, &config));
+    config.gpio_dirs = 0;
+    config.sms = 1 << (NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK);
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, &config));
+    config.sms = 0;
+    config.sm_signals = 0x100;
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, &config));
+    config.sm_signals = 0;
+    config.irq_blocks = 1 << NUM_PIO_BLOCKS;
+    expect_assert_failure(epio_trace_start(epio, TRACE_PATH, &config));
+    expect_assert_failure(epio_trace_stop(NULL));
+
+    epio_free(epio);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(trace_writes_changes),
+        cmocka_unit_test(trace_all_signals),
+        cmocka_unit_test(trace_replays_as_stimulus),
+        cmocka_unit_test(trace_large_output),
+        cmocka_unit_test(trace_idle_is_small),
+        cmocka_unit_test(trace_with_history),
+        cmocka_unit_test(trace_seek_after_last_change),
+        cmocka_unit_test(trace_restart_and_stop),
+        cmocka_unit_test(trace_write_failures),
+        cmocka_unit_test(trace_invalid_args),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
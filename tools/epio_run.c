@@ -0,0 +1,495 @@
+// Copyright (C) 2026 Piers Finlayson <piers@piers.rocks>
+//
+// MIT License
+
+// epio - A PIO emulator
+//
+// epio-run - headless runner for scripted simulations
+//
+// Loads a state image or program description, applies any stimulus, runs
+// for a number of cycles or until a condition is met, and then writes any
+// requested stats, FIFO state, SRAM dumps and final state image.  Runs are
+// non-interactive, so many can be run in parallel from the shell.
+//
+// Build with `make epio-run`, and run `build/epio-run --help` for usage.
+
+#define APIO_LOG_IMPL  1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <epio.h>
+
+#define RUN_SRAM_BASE       0x20000000
+#define RUN_SRAM_SIZE       (520 * 1024)
+#define RUN_MAX_MAPS        64
+#define RUN_MAX_DUMPS       16
+#define RUN_IMAGE_MAGIC     "EPIOIMG"
+
+// Exit statuses
+#define RUN_OK              0
+#define RUN_ERROR           1
+#define RUN_NOT_MET         2
+
+typedef enum {
+    UNTIL_NONE,
+    UNTIL_GPIO,
+    UNTIL_PC,
+    UNTIL_RX,
+    UNTIL_TX_EMPTY,
+    UNTIL_IRQ,
+    UNTIL_STIM,
+} run_until_type_t;
+
+typedef struct {
+    run_until_type_t type;
+    uint32_t a;
+    uint32_t b;
+    uint32_t value;
+} run_until_t;
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    const char *path;
+} run_dump_t;
+
+typedef struct {
+    const char *signal;
+    uint8_t gpio;
+} run_map_t;
+
+static void usage(const char *prog) {
+    printf(
+        "Usage: %s [options] FILE\n"
+        "\n"
+        "FILE is a state image, from epio_save_image(), or a program description\n"
+        "- see epio_load_desc().\n"
+        "\n"
+        "Options:\n"
+        "  -c, --cycles N          Run for N cycles, or at most N with --until\n"
+        "  -u, --until COND        Stop once COND is true, checked every cycle:\n"
+        "                            gpio:N=L    GPIO N is at level L\n"
+        "                            pc:B:S=N    Block B SM S has PC N\n"
+        "                            rx:B:S      Block B SM S's RX FIFO is not empty\n"
+        "                            txempty:B:S Block B SM S's TX FIFO is empty\n"
+        "                            irq:B:N     Block B's IRQ flag N is set\n"
+        "                            stim        The stimulus has finished\n"
+        "  -s, --stimulus FILE     Play a VCD or binary edge list stimulus\n"
+        "  -m, --map SIGNAL=GPIO   Map a VCD stimulus signal to a GPIO\n"
+        "  -k, --sysclk HZ         Set the system clock\n"
+        "  -t, --trace FILE        Write a VCD trace of every GPIO, and the\n"
+        "                          enabled SMs and IRQs\n"
+        "  -S, --stats             Print cycles, run time, speed and state hash\n"
+        "  -f, --fifos             Print every SM's state and FIFOs at the end\n"
+        "  -d, --dump ADDR:LEN:FILE\n"
+        "                          Write LEN bytes of SRAM at ADDR to FILE at the end\n"
+        "  -o, --save FILE         Save a state image at the end\n"
+        "  -h, --help              Show this help\n"
+        "\n"
+        "Exits with 0 on success, 1 on error, or 2 if the --until condition was\n"
+        "not met within --cycles.\n",
+        prog);
+}
+
+// Parses an unsigned number, in any base strtoull() accepts, up to max
+static int parse_number(const char *str, uint64_t max, uint64_t *value) {
+    char *end;
+    if ((str[0] == '\0') || (str[0] == '-')) {
+        return -1;
+    }
+    *value = strtoull(str, &end, 0);
+    return ((*end != '\0') || (*value > max)) ? -1 : 0;
+}
+
+static int parse_until(const char *str, run_until_t *until) {
+    char kind[16];
+    int used = 0;
+    memset(until, 0, sizeof(*until));
+
+    if (strcmp(str, "stim") == 0) {
+        until->type = UNTIL_STIM;
+        return 0;
+    }
+    if (sscanf(str, "gpio:%u=%u%n", &until->a, &until->value, &used) == 2 && str[used] == '\0') {
+        until->type = UNTIL_GPIO;
+        return ((until->a < NUM_GPIOS) && (until->value <= 1)) ? 0 : -1;
+    }
+    if (sscanf(str, "pc:%u:%u=%u%n", &until->a, &until->b, &until->value, &used) == 3 && str[used] == '\0') {
+        until->type = UNTIL_PC;
+        return ((until->a < NUM_PIO_BLOCKS) && (until->b < NUM_SMS_PER_BLOCK) && (until->value < NUM_INSTRS_PER_BLOCK)) ? 0 : -1;
+    }
+    if (sscanf(str, "irq:%u:%u%n", &until->a, &until->b, &used) == 2 && str[used] == '\0') {
+        until->type = UNTIL_IRQ;
+        return ((until->a < NUM_PIO_BLOCKS) && (until->b < NUM_IRQS_PER_BLOCK)) ? 0 : -1;
+    }
+    if (sscanf(str, "%15[a-z]:%u:%u%n", kind, &until->a, &until->b, &used) == 3 && str[used] == '\0') {
+        if (strcmp(kind, "rx") == 0) {
+            until->type = UNTIL_RX;
+        } else if (strcmp(kind, "txempty") == 0) {
+            until->type = UNTIL_TX_EMPTY;
+        } else {
+            return -1;
+        }
+        return ((until->a < NUM_PIO_BLOCKS) && (until->b < NUM_SMS_PER_BLOCK)) ? 0 : -1;
+    }
+    return -1;
+}
+
+static int until_met(epio_t *epio, const run_until_t *until) {
+    switch (until->type) {
+        case UNTIL_GPIO:
+            return ((epio_read_pin_states(epio) >> until->a) & 1) == until->value;
+        case UNTIL_PC:
+            return epio_peek_sm_pc(epio, until->a, until->b) == until->value;
+        case UNTIL_RX:
+            return epio_rx_fifo_depth(epio, until->a, until->b) > 0;
+        case UNTIL_TX_EMPTY:
+            return epio_tx_fifo_depth(epio, until->a, until->b) == 0;
+        case UNTIL_IRQ:
+            return epio_peek_block_irq_num(epio, until->a, until->b);
+        case UNTIL_STIM:
+            return epio_stimulus_status(epio) <= 0;
+        default:
+            return 0;
+    }
+}
+
+static int parse_dump(char *str, run_dump_t *dump) {
+    char *len = strchr(str, ':');
+    char *path = (len != NULL) ? strchr(len + 1, ':') : NULL;
+    if (path == NULL) {
+        return -1;
+    }
+    *len++ = '\0';
+    *path++ = '\0';
+
+    uint64_t addr, size;
+    if ((parse_number(str, UINT32_MAX, &addr) < 0) ||
+        (parse_number(len, RUN_SRAM_SIZE, &size) < 0) ||
+        (size == 0) || (*path == '\0') ||
+        (addr < RUN_SRAM_BASE) || (addr + size > RUN_SRAM_BASE + RUN_SRAM_SIZE)) {
+        return -1;
+    }
+    dump->addr = addr;
+    dump->len = size;
+    dump->path = path;
+    return 0;
+}
+
+static int write_dump(epio_t *epio, const run_dump_t *dump) {
+    FILE *file = fopen(dump->path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    uint8_t buf[SRAM_PAGE_SIZE];
+    uint32_t done = 0;
+    int rc = 0;
+    while ((done < dump->len) && (rc == 0)) {
+        uint32_t chunk = dump->len - done;
+        if (chunk > sizeof(buf)) {
+            chunk = sizeof(buf);
+        }
+        for (uint32_t ii = 0; ii < chunk; ii++) {
+            buf[ii] = epio_sram_read_byte(epio, dump->addr + done + ii);
+        }
+        if (fwrite(buf, 1, chunk, file) != chunk) {
+            rc = -1;
+        }
+        done += chunk;
+    }
+    if (fclose(file) != 0) {
+        rc = -1;
+    }
+    return rc;
+}
+
+// Loads FILE as an image if it starts with the image magic, otherwise as a
+// description
+static epio_t *load(const char *path) {
+    char magic[sizeof(RUN_IMAGE_MAGIC)] = { 0 };
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return NULL;
+    }
+    size_t len = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if ((len == sizeof(magic)) && (memcmp(magic, RUN_IMAGE_MAGIC, sizeof(magic)) == 0)) {
+        epio_t *epio = epio_load_image(path);
+        if (epio == NULL) {
+            fprintf(stderr, "%s is not a valid image for this host\n", path);
+        }
+        return epio;
+    }
+
+    uint32_t error_line;
+    epio_t *epio = epio_load_desc(path, &error_line);
+    if (epio == NULL) {
+        fprintf(stderr, "%s:%u: invalid directive\n", path, error_line);
+    }
+    return epio;
+}
+
+static int attach_stimulus(epio_t *epio, const char *path, const run_map_t *maps, int num_maps) {
+    epio_stimulus_t *stim = epio_stimulus_open_edges(path);
+    if (stim == NULL) {
+        stim = epio_stimulus_open_vcd(path);
+        if (stim == NULL) {
+            fprintf(stderr, "Cannot open stimulus %s\n", path);
+            return -1;
+        }
+        for (int ii = 0; ii < num_maps; ii++) {
+            if (epio_stimulus_map(stim, maps[ii].signal, maps[ii].gpio) < 0) {
+                fprintf(stderr, "Cannot map %s to GPIO %u\n", maps[ii].signal, maps[ii].gpio);
+                epio_stimulus_free(stim);
+                return -1;
+            }
+        }
+    } else if (num_maps > 0) {
+        fprintf(stderr, "--map only applies to VCD stimuli\n");
+        epio_stimulus_free(stim);
+        return -1;
+    }
+    epio_stimulus_attach(epio, stim);
+    return 0;
+}
+
+static int start_trace(epio_t *epio, const char *path) {
+    epio_trace_config_t config = {
+        .gpio_levels = (1ULL << NUM_GPIOS) - 1,
+        .gpio_dirs = (1ULL << NUM_GPIOS) - 1,
+        .sm_signals = EPIO_TRACE_SM_ALL,
+        .irq_blocks = (1 << NUM_PIO_BLOCKS) - 1,
+    };
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            if (epio_is_sm_enabled(epio, block, sm)) {
+                config.sms |= 1 << (block * NUM_SMS_PER_BLOCK + sm);
+            }
+        }
+    }
+    if (epio_trace_start(epio, path, &config) < 0) {
+        fprintf(stderr, "Cannot create trace %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Runs for up to cycles, stopping early if until is met.  Returns 1 if
+// until was met, or there is no until.
+static int run(epio_t *epio, uint64_t cycles, const run_until_t *until) {
+    if (until->type == UNTIL_NONE) {
+        while (cycles > 0) {
+            uint32_t chunk = (cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)cycles;
+            epio_step_cycles(epio, chunk);
+            cycles -= chunk;
+        }
+        return 1;
+    }
+
+    while (!until_met(epio, until)) {
+        if (cycles == 0) {
+            return 0;
+        }
+        epio_step_cycles(epio, 1);
+        cycles--;
+    }
+    return 1;
+}
+
+static void print_fifo(const char *name, const uint32_t *fifo, uint8_t count) {
+    printf(" %s=[", name);
+    for (uint8_t ii = 0; ii < count; ii++) {
+        printf("%s0x%08X", ii ? " " : "", fifo[ii]);
+    }
+    printf("]");
+}
+
+static void print_fifos(epio_t *epio) {
+    epio_sm_snapshot_t snapshots[NUM_PIO_BLOCKS * NUM_SMS_PER_BLOCK];
+    epio_peek_sms(epio, snapshots);
+    for (uint8_t block = 0; block < NUM_PIO_BLOCKS; block++) {
+        for (uint8_t sm = 0; sm < NUM_SMS_PER_BLOCK; sm++) {
+            const epio_sm_snapshot_t *snap = &snapshots[block * NUM_SMS_PER_BLOCK + sm];
+            printf("pio%u.sm%u: %s pc=%u x=0x%08X y=0x%08X isr=0x%08X/%u osr=0x%08X/%u%s",
+                   block, sm, snap->enabled ? "enabled" : "disabled",
+                   snap->pc, snap->x, snap->y,
+                   snap->isr, snap->isr_count, snap->osr, snap->osr_count,
+                   snap->stalled ? " stalled" : "");
+            print_fifo("tx", snap->tx_fifo, snap->tx_fifo_count);
+            print_fifo("rx", snap->rx_fifo, snap->rx_fifo_count);
+            printf("\n");
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "cycles", required_argument, NULL, 'c' },
+        { "until", required_argument, NULL, 'u' },
+        { "stimulus", required_argument, NULL, 's' },
+        { "map", required_argument, NULL, 'm' },
+        { "sysclk", required_argument, NULL, 'k' },
+        { "trace", required_argument, NULL, 't' },
+        { "stats", no_argument, NULL, 'S' },
+        { "fifos", no_argument, NULL, 'f' },
+        { "dump", required_argument, NULL, 'd' },
+        { "save", required_argument, NULL, 'o' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    uint64_t cycles = 0;
+    uint8_t cycles_set = 0;
+    run_until_t until = { .type = UNTIL_NONE };
+    const char *stim_path = NULL;
+    run_map_t maps[RUN_MAX_MAPS];
+    int num_maps = 0;
+    uint64_t sysclk = 0;
+    const char *trace_path = NULL;
+    uint8_t stats = 0, fifos = 0;
+    run_dump_t dumps[RUN_MAX_DUMPS];
+    int num_dumps = 0;
+    const char *save_path = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:u:s:m:k:t:Sfd:o:h", options, NULL)) != -1) {
+        uint64_t value;
+        char *eq;
+        switch (opt) {
+            case 'c':
+                if (parse_number(optarg, UINT64_MAX, &cycles) < 0) {
+                    fprintf(stderr, "Invalid cycle count %s\n", optarg);
+                    return RUN_ERROR;
+                }
+                cycles_set = 1;
+                break;
+            case 'u':
+                if (parse_until(optarg, &until) < 0) {
+                    fprintf(stderr, "Invalid condition %s\n", optarg);
+                    return RUN_ERROR;
+                }
+                break;
+            case 's':
+                stim_path = optarg;
+                break;
+            case 'm':
+                eq = strrchr(optarg, '=');
+                if ((num_maps == RUN_MAX_MAPS) || (eq == NULL) || (eq == optarg) ||
+                    (parse_number(eq + 1, NUM_GPIOS - 1, &value) < 0)) {
+                    fprintf(stderr, "Invalid mapping %s\n", optarg);
+                    return RUN_ERROR;
+                }
+                *eq = '\0';
+                maps[num_maps].signal = optarg;
+                maps[num_maps].gpio = value;
+                num_maps++;
+                break;
+            case 'k':
+                if ((parse_number(optarg, UINT32_MAX, &sysclk) < 0) || (sysclk == 0)) {
+                    fprintf(stderr, "Invalid system clock %s\n", optarg);
+                    return RUN_ERROR;
+                }
+                break;
+            case 't':
+                trace_path = optarg;
+                break;
+            case 'S':
+                stats = 1;
+                break;
+            case 'f':
+                fifos = 1;
+                break;
+            case 'd':
+                if ((num_dumps == RUN_MAX_DUMPS) || (parse_dump(optarg, &dumps[num_dumps]) < 0)) {
+                    fprintf(stderr, "Invalid SRAM dump %s\n", optarg);
+                    return RUN_ERROR;
+                }
+                num_dumps++;
+                break;
+            case 'o':
+                save_path = optarg;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return RUN_OK;
+            default:
+                usage(argv[0]);
+                return RUN_ERROR;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return RUN_ERROR;
+    }
+    if ((until.type != UNTIL_NONE) && !cycles_set) {
+        cycles = UINT64_MAX;
+    }
+
+    epio_t *epio = load(argv[optind]);
+    if (epio == NULL) {
+        return RUN_ERROR;
+    }
+    if (sysclk != 0) {
+        epio_set_sys_clock_hz(epio, sysclk);
+    }
+
+    int rc = RUN_ERROR;
+    if ((stim_path != NULL) && (attach_stimulus(epio, stim_path, maps, num_maps) < 0)) {
+        goto out;
+    }
+    if ((trace_path != NULL) && (start_trace(epio, trace_path) < 0)) {
+        goto out;
+    }
+
+    struct timespec start, end;
+    uint64_t start_cycle = epio_get_cycle_count(epio);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int met = run(epio, cycles, &until);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t ran = epio_get_cycle_count(epio) - start_cycle;
+
+    if ((trace_path != NULL) && (epio_trace_stop(epio) < 0)) {
+        fprintf(stderr, "Error writing trace %s\n", trace_path);
+        goto out;
+    }
+
+    if (stats) {
+        double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("cycles: %llu\n", (unsigned long long)ran);
+        printf("cycle_count: %llu\n", (unsigned long long)epio_get_cycle_count(epio));
+        printf("time: %.6f s\n", secs);
+        printf("speed: %.3f Mcycles/s\n", (secs > 0) ? (ran / secs / 1e6) : 0.0);
+        printf("hash: 0x%016llX\n", (unsigned long long)epio_state_hash(epio));
+        printf("pins: 0x%012llX\n", (unsigned long long)epio_read_pin_states(epio));
+        if (until.type != UNTIL_NONE) {
+            printf("until: %s\n", met ? "met" : "not met");
+        }
+        if (stim_path != NULL) {
+            int status = epio_stimulus_status(epio);
+            printf("stimulus: %s\n", (status > 0) ? "playing" : (status == 0) ? "finished" : "error");
+        }
+    }
+    if (fifos) {
+        print_fifos(epio);
+    }
+    for (int ii = 0; ii < num_dumps; ii++) {
+        if (write_dump(epio, &dumps[ii]) < 0) {
+            fprintf(stderr, "Cannot write SRAM dump %s\n", dumps[ii].path);
+            goto out;
+        }
+    }
+    if ((save_path != NULL) && (epio_save_image(epio, save_path) < 0)) {
+        fprintf(stderr, "Cannot save image %s\n", save_path);
+        goto out;
+    }
+
+    rc = met ? RUN_OK : RUN_NOT_MET;
+
+out:
+    epio_free(epio);
+    return rc;
+}
@@ -12,13 +12,47 @@
 EPIO_WASM_EXPORTS := \
 	"_malloc","_free",\
 	"_epio_init","_epio_free","_epio_set_sm_debug",\
+	"_epio_sizeof","_epio_init_in","_epio_reset",\
+	"_epio_template_from_epio","_epio_from_template",\
+	"_epio_from_template_in","_epio_template_free",\
+	"_epio_state_hash","_epio_history_enable","_epio_history_disable",\
+	"_epio_seek","_epio_step_back",\
+	"_epio_stimulus_open_vcd","_epio_stimulus_open_edges",\
+	"_epio_stimulus_map","_epio_stimulus_attach","_epio_stimulus_detach",\
+	"_epio_stimulus_status","_epio_stimulus_free",\
+	"_epio_load_desc",\
+	"_epio_device_attach","_epio_device_detach","_epio_device_drive","_epio_device_release",\
+	"_epio_mem_attach","_epio_mem_attach_file",\
+	"_epio_system_create","_epio_system_free","_epio_system_add","_epio_system_chip",\
+	"_epio_system_connect","_epio_system_step_cycles",\
+	"_epio_check_period","_epio_check_response","_epio_check_rx_overflow",\
+	"_epio_check_tx_underrun","_epio_check_max_stall","_epio_check_violations",\
+	"_epio_check_clear",\
+	"_epio_schedule_at","_epio_schedule_in","_epio_schedule_pending","_epio_schedule_clear",\
+	"_epio_stream_tx_buffer","_epio_stream_tx_callback","_epio_stream_rx_buffer",\
+	"_epio_stream_rx_callback","_epio_stream_stats","_epio_stream_detach",\
+	"_epio_fifo_stats_enable","_epio_fifo_stats_disable","_epio_fifo_stats",\
+	"_epio_trace_start","_epio_trace_stop",\
+	"_epio_recorder_enable","_epio_recorder_disable","_epio_recorder_count",\
+	"_epio_recorder_total","_epio_recorder_read",\
+	"_epio_capture_start","_epio_capture_stop",\
+	"_epio_index_build","_epio_index_free","_epio_index_level",\
+	"_epio_index_next_edge","_epio_index_prev_edge",\
+	"_epio_index_pulse_width","_epio_index_period",\
+	"_epio_decoder_uart","_epio_decoder_spi","_epio_decoder_i2c",\
+	"_epio_decoder_parallel","_epio_decoder_feed","_epio_decoder_capture",\
+	"_epio_decoder_flush","_epio_decoder_free",\
+	"_epio_sigrok_open","_epio_sigrok_write","_epio_sigrok_capture",\
+	"_epio_sigrok_close",\
 	"_epio_set_gpiobase","_epio_get_gpiobase",\
 	"_epio_set_sm_reg","_epio_get_sm_reg","_epio_enable_sm",\
 	"_epio_set_instr","_epio_get_instr","_epio_step_cycles",\
 	"_epio_get_cycle_count","_epio_reset_cycle_count",\
+	"_epio_set_sys_clock_hz","_epio_get_sys_clock_hz",\
 	"_epio_wait_tx_fifo","_epio_tx_fifo_depth","_epio_rx_fifo_depth",\
 	"_epio_pop_rx_fifo","_epio_push_tx_fifo","_epio_push_rx_fifo",\
-	"_epio_pop_tx_fifo",\
+	"_epio_pop_tx_fifo","_epio_tx_fifo_capacity","_epio_rx_fifo_capacity",\
+	"_epio_get_rx_putget","_epio_set_rx_putget",\
 	"_epio_drive_gpios_ext",\
 	"_epio_get_gpio_input","_epio_init_gpios",\
 	"_epio_set_gpio_input","_epio_set_gpio_output",\
@@ -27,6 +61,7 @@ EPIO_WASM_EXPORTS := \
 	"_epio_sram_read_byte","_epio_sram_set",\
 	"_epio_sram_read_halfword","_epio_sram_read_word",\
 	"_epio_sram_write_byte","_epio_sram_write_halfword","_epio_sram_write_word",\
+	"_epio_sram_resident_pages","_epio_sram_page",\
 	"_epio_disassemble_sm","_epio_is_sm_enabled","_epio_get_sm_debug",\
 	"_epio_peek_sm_pc","_epio_peek_sm_x","_epio_peek_sm_y",\
 	"_epio_peek_sm_isr","_epio_peek_sm_osr",\
@@ -35,7 +70,7 @@ EPIO_WASM_EXPORTS := \
 	"_epio_peek_sm_exec_pending","_epio_peek_sm_exec_instr",\
 	"_epio_peek_block_irq","_epio_peek_sm_osr_empty",\
 	"_epio_set_block_irq","_epio_clear_block_irq","_epio_peek_block_irq_num", \
-	"_epio_peek_rx_fifo","_epio_peek_tx_fifo",\
+	"_epio_peek_rx_fifo","_epio_peek_tx_fifo","_epio_peek_sms",\
 	"_epio_set_gpio_input_inverted","_epio_get_gpio_input_inverted",\
 	"_epio_set_gpio_output_control","_epio_get_gpio_output_control",\
 	"_epio_clear_gpio_output_control","_epio_disable_sm",\